@@ -0,0 +1,372 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import min and max.
+#include <cmath> // Import the trigonometric functions and sqrt.
+#include <cstring> // Import strcmp.
+#include <iomanip> // Import stream formatting.
+#include <iostream> // Import the IO stream libraries.
+#include <memory> // Import the smart pointers.
+
+#include "BehaviorTree.h" // Import the behavior tree runtime.
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "Jobs.h" // Import the job system.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+const uint32_t BehaviorTreeRunner::BatchSize;
+
+#pragma region Blackboard
+
+uint32_t BehaviorBlackboard::addFloatKey(const char* name)
+{
+	names.push_back(name);
+	columns.emplace_back(lods.size(), 0.0f);
+	return (uint32_t)columns.size() - 1;
+}
+
+uint32_t BehaviorBlackboard::findKey(const char* name) const
+{
+	for (uint32_t i = 0; i < names.size(); i++) {
+		if (strcmp(names[i].c_str(), name) == 0)
+			return i;
+	}
+	return UINT32_MAX;
+}
+
+uint32_t BehaviorBlackboard::addAgent()
+{
+	for (HeapVector<float, BehaviorTreeMemory>& column : columns)
+		column.push_back(0.0f);
+	lods.push_back(0);
+	return (uint32_t)lods.size() - 1;
+}
+
+#pragma endregion
+
+#pragma region Tree
+
+BehaviorStatus BehaviorTree::tick(const BehaviorTickContext& context, uint32_t agent) const
+{
+	return tickNode(0, context, agent);
+}
+
+BehaviorStatus BehaviorTree::tickNode(uint32_t index, const BehaviorTickContext& context, uint32_t agent) const
+{
+	const Node& node = nodes[index];
+	switch (node.type) {
+	case NodeType::Leaf:
+		return node.leaf(context, agent);
+	case NodeType::Inverter: {
+		BehaviorStatus status = tickNode(index + 1, context, agent);
+		if (status == BehaviorStatus::Running)
+			return status;
+		return status == BehaviorStatus::Success ? BehaviorStatus::Failure : BehaviorStatus::Success;
+	}
+	case NodeType::Sequence:
+	case NodeType::Selector: {
+		// A sequence stops at the first child that does not succeed, a selector at the first that does not fail.
+		BehaviorStatus carryOn = node.type == NodeType::Sequence ? BehaviorStatus::Success : BehaviorStatus::Failure;
+		for (uint32_t child = index + 1; child < node.subtreeEnd; child = nodes[child].subtreeEnd) {
+			BehaviorStatus status = tickNode(child, context, agent);
+			if (status != carryOn)
+				return status;
+		}
+		return carryOn;
+	}
+	}
+	return BehaviorStatus::Failure;
+}
+
+BehaviorTreeBuilder& BehaviorTreeBuilder::open(BehaviorTree::NodeType type)
+{
+	BehaviorTree::Node node;
+	node.type = type;
+	node.subtreeEnd = 0; // Set by end().
+	node.leaf = nullptr;
+	openNodes.push_back((uint32_t)nodes.size());
+	nodes.push_back(node);
+	return *this;
+}
+
+BehaviorTreeBuilder& BehaviorTreeBuilder::leaf(BehaviorLeaf function)
+{
+	BehaviorTree::Node node;
+	node.type = BehaviorTree::NodeType::Leaf;
+	node.subtreeEnd = (uint32_t)nodes.size() + 1;
+	node.leaf = function;
+	if (!function)
+		valid = false;
+	nodes.push_back(node);
+	return *this;
+}
+
+BehaviorTreeBuilder& BehaviorTreeBuilder::end()
+{
+	if (openNodes.empty()) {
+		valid = false;
+		return *this;
+	}
+	uint32_t index = openNodes.back();
+	openNodes.pop_back();
+	BehaviorTree::Node& node = nodes[index];
+	node.subtreeEnd = (uint32_t)nodes.size();
+
+	uint32_t children = 0;
+	for (uint32_t child = index + 1; child < node.subtreeEnd; child = nodes[child].subtreeEnd)
+		children++;
+	if (children == 0 || (node.type == BehaviorTree::NodeType::Inverter && children != 1))
+		valid = false;
+	return *this;
+}
+
+bool BehaviorTreeBuilder::build(BehaviorTree& tree)
+{
+	// Exactly one root, spanning every node.
+	if (!valid || !openNodes.empty() || nodes.empty() || nodes[0].subtreeEnd != nodes.size()) {
+		cout << "ERROR::BEHAVIOR_TREE::INVALID_STRUCTURE\n" << nodes.size() << " nodes, " << openNodes.size() << " left open" << endl;
+		return false;
+	}
+	tree.nodes.swap(nodes);
+	nodes.clear();
+	valid = true;
+	return true;
+}
+
+#pragma endregion
+
+#pragma region Runner
+
+BehaviorTreeRunner::BehaviorTreeRunner(JobSystem* jobSystem) : jobs(jobSystem)
+{
+}
+
+unsigned int BehaviorTreeRunner::getThreadCount() const
+{
+	return (jobs ? jobs->getThreadCount() : 0) + 1; // The ticking thread works too.
+}
+
+void BehaviorTreeRunner::runBatches()
+{
+	const vector<uint32_t>& intervals = currentLods->tickIntervals;
+	uint64_t ticked = 0;
+	for (uint32_t index = nextBatch.fetch_add(1); index < batches.size(); index = nextBatch.fetch_add(1)) {
+		const Batch& batch = batches[index];
+		BehaviorAgentGroup& group = (*currentGroups)[batch.group];
+		const uint8_t* lods = group.blackboard.getLods();
+		BehaviorTickContext context = { &group.blackboard, group.shared, currentDeltaTime, frame };
+		for (uint32_t agent = batch.first; agent < batch.first + batch.count; agent++) {
+			// Offsetting by the agent staggers each LOD's agents evenly over its interval.
+			uint32_t interval = intervals.empty() ? 1 : intervals[min<size_t>(lods[agent], intervals.size() - 1)];
+			if ((frame + agent) % interval != 0)
+				continue;
+			context.deltaTime = currentDeltaTime * interval;
+			group.tree->tick(context, agent);
+			ticked++;
+		}
+	}
+	agentsTicked.fetch_add(ticked);
+}
+
+uint64_t BehaviorTreeRunner::tick(vector<BehaviorAgentGroup>& groups, const BehaviorLodSettings& lods, float deltaTime)
+{
+	batches.clear();
+	for (uint32_t group = 0; group < groups.size(); group++) {
+		if (!groups[group].tree)
+			continue;
+		uint32_t agentCount = groups[group].blackboard.getAgentCount();
+		for (uint32_t first = 0; first < agentCount; first += BatchSize)
+			batches.push_back({ group, first, min(BatchSize, agentCount - first) });
+	}
+
+	currentGroups = &groups;
+	currentLods = &lods;
+	currentDeltaTime = deltaTime;
+	agentsTicked.store(0);
+	nextBatch.store(0);
+	// One job per worker, at most one per batch after the first; a job that starts once the batches are all claimed
+	// returns at once.
+	vector<shared_ptr<JobCounter>> helpers;
+	unsigned int helperCount = jobs && !batches.empty() ? min(jobs->getThreadCount(), (unsigned int)batches.size() - 1) : 0;
+	for (unsigned int i = 0; i < helperCount; i++) {
+		helpers.push_back(jobs->run([this] {
+			runBatches();
+			return JobStep::done();
+		}));
+	}
+	runBatches(); // The calling thread works too.
+	for (shared_ptr<JobCounter>& helper : helpers)
+		helper->wait();
+
+	frame++;
+	return agentsTicked.load();
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+// Blackboard columns of the benchmark's guards, set once before ticking; every group has the same layout.
+static uint32_t keyX, keyZ, keyHealth, keyHeading, keyFleeing;
+
+// What every guard can see: where the player is.
+struct GuardWorld
+{
+	float playerX = 0.0f, playerZ = 0.0f;
+};
+
+static BehaviorStatus isHurt(const BehaviorTickContext& context, uint32_t agent)
+{
+	return context.blackboard->floats(keyHealth)[agent] < 30.0f ? BehaviorStatus::Success : BehaviorStatus::Failure;
+}
+
+static BehaviorStatus isFleeing(const BehaviorTickContext& context, uint32_t agent)
+{
+	return context.blackboard->floats(keyFleeing)[agent] != 0.0f ? BehaviorStatus::Success : BehaviorStatus::Failure;
+}
+
+// Move an agent along a direction at a speed in units per second.
+static void moveAgent(const BehaviorTickContext& context, uint32_t agent, float directionX, float directionZ, float speed)
+{
+	float length = sqrt(directionX * directionX + directionZ * directionZ);
+	if (length < 1e-4f)
+		return;
+	float step = speed * context.deltaTime / length;
+	context.blackboard->floats(keyX)[agent] += directionX * step;
+	context.blackboard->floats(keyZ)[agent] += directionZ * step;
+}
+
+static BehaviorStatus flee(const BehaviorTickContext& context, uint32_t agent)
+{
+	const GuardWorld& world = *(const GuardWorld*)context.shared;
+	float playerX = world.playerX, playerZ = world.playerZ;
+	moveAgent(context, agent, context.blackboard->floats(keyX)[agent] - playerX, context.blackboard->floats(keyZ)[agent] - playerZ, 6.0f);
+	float& health = context.blackboard->floats(keyHealth)[agent];
+	health = min(100.0f, health + 20.0f * context.deltaTime);
+	context.blackboard->floats(keyFleeing)[agent] = health < 100.0f ? 1.0f : 0.0f; // Keep running until healed.
+	return health < 100.0f ? BehaviorStatus::Running : BehaviorStatus::Success;
+}
+
+static BehaviorStatus canSeePlayer(const BehaviorTickContext& context, uint32_t agent)
+{
+	const GuardWorld& world = *(const GuardWorld*)context.shared;
+	float playerX = world.playerX, playerZ = world.playerZ;
+	float dx = playerX - context.blackboard->floats(keyX)[agent], dz = playerZ - context.blackboard->floats(keyZ)[agent];
+	return dx * dx + dz * dz < 60.0f * 60.0f ? BehaviorStatus::Success : BehaviorStatus::Failure;
+}
+
+static BehaviorStatus chase(const BehaviorTickContext& context, uint32_t agent)
+{
+	const GuardWorld& world = *(const GuardWorld*)context.shared;
+	float playerX = world.playerX, playerZ = world.playerZ;
+	moveAgent(context, agent, playerX - context.blackboard->floats(keyX)[agent], playerZ - context.blackboard->floats(keyZ)[agent], 5.0f);
+	float& health = context.blackboard->floats(keyHealth)[agent];
+	health -= 15.0f * context.deltaTime; // The player fights back.
+	return BehaviorStatus::Running;
+}
+
+static BehaviorStatus wander(const BehaviorTickContext& context, uint32_t agent)
+{
+	// Turn a little each tick, by an amount hashed from the agent and frame.
+	uint32_t hash = (agent * 2654435761u) ^ (uint32_t)context.frame * 40503u;
+	hash ^= hash >> 15;
+	float& heading = context.blackboard->floats(keyHeading)[agent];
+	heading += ((float)(hash & 1023) / 1023.0f - 0.5f) * 2.0f * context.deltaTime;
+	moveAgent(context, agent, cos(heading), sin(heading), 2.0f);
+	float& health = context.blackboard->floats(keyHealth)[agent];
+	health = min(100.0f, health + 5.0f * context.deltaTime);
+	return BehaviorStatus::Running;
+}
+
+void runBehaviorTreeBenchmark(int agentCount, int frames)
+{
+	// Guards: once hurt, flee until fully healed; otherwise chase the player if in sight, else wander.
+	BehaviorTree tree;
+	BehaviorTreeBuilder builder;
+	builder.selector();
+		builder.sequence();
+			builder.selector(); builder.leaf(isHurt); builder.leaf(isFleeing); builder.end();
+			builder.leaf(flee);
+		builder.end();
+		builder.sequence(); builder.leaf(canSeePlayer); builder.leaf(chase); builder.end();
+		builder.leaf(wander);
+	builder.end();
+	if (!builder.build(tree))
+		return;
+
+	const float worldSize = 1024.0f, lodDistance = 128.0f; // Each LOD ring is this much further from the origin.
+	const float deltaTime = 1.0f / 60.0f;
+	unsigned int hardwareThreads = max(1u, std::thread::hardware_concurrency());
+	cout << "BENCH::BEHAVIOR_TREE " << agentCount << " agents, " << tree.getNodes().size() << " nodes, " << frames << " frames" << endl;
+
+	struct Mode { const char* name; unsigned int threads; bool lods; };
+	Mode modes[] = {
+		{ "BEHAVIOR_TREE::ONE_THREAD", 1, false },
+		{ "BEHAVIOR_TREE::ALL_THREADS", hardwareThreads, false },
+		{ "BEHAVIOR_TREE::ALL_THREADS_LOD", hardwareThreads, true },
+	};
+	for (const Mode& mode : modes) {
+		// Split the agents into a few groups so batches cross group boundaries, as they would with several trees.
+		GuardWorld world;
+		vector<BehaviorAgentGroup> groups(4);
+		for (BehaviorAgentGroup& group : groups) {
+			group.tree = &tree;
+			group.shared = &world;
+			keyX = group.blackboard.addFloatKey("x");
+			keyZ = group.blackboard.addFloatKey("z");
+			keyHealth = group.blackboard.addFloatKey("health");
+			keyHeading = group.blackboard.addFloatKey("heading");
+			keyFleeing = group.blackboard.addFloatKey("fleeing");
+		}
+		uint32_t random = 12345;
+		for (int i = 0; i < agentCount; i++) {
+			BehaviorAgentGroup& group = groups[i % groups.size()];
+			uint32_t agent = group.blackboard.addAgent();
+			random = random * 1664525u + 1013904223u;
+			group.blackboard.floats(keyX)[agent] = ((float)(random >> 8) / 16777216.0f - 0.5f) * worldSize;
+			random = random * 1664525u + 1013904223u;
+			group.blackboard.floats(keyZ)[agent] = ((float)(random >> 8) / 16777216.0f - 0.5f) * worldSize;
+			group.blackboard.floats(keyHealth)[agent] = 100.0f;
+			group.blackboard.floats(keyHeading)[agent] = (float)(random & 255) / 40.0f;
+		}
+
+		BehaviorLodSettings lods;
+		if (!mode.lods)
+			lods.tickIntervals = { 1 };
+		unique_ptr<JobSystem> jobs(mode.threads > 1 ? new JobSystem(mode.threads - 1) : nullptr);
+		BehaviorTreeRunner runner(jobs.get());
+		vector<double> samples;
+		uint64_t ticked = 0;
+		for (int frame = 0; frame < frames; frame++) {
+			// The player circles the origin.
+			world.playerX = 200.0f * cos(frame * 0.002f);
+			world.playerZ = 200.0f * sin(frame * 0.002f);
+			if (mode.lods) { // By distance from a camera at the origin, as a game would before ticking. Not timed.
+				for (BehaviorAgentGroup& group : groups) {
+					const float* x = group.blackboard.floats(keyX);
+					const float* z = group.blackboard.floats(keyZ);
+					uint8_t* agentLods = group.blackboard.getLods();
+					for (uint32_t agent = 0; agent < group.blackboard.getAgentCount(); agent++)
+						agentLods[agent] = (uint8_t)min(3.0f, sqrt(x[agent] * x[agent] + z[agent] * z[agent]) / lodDistance);
+				}
+			}
+			BenchmarkTimer timer;
+			ticked += runner.tick(groups, lods, deltaTime);
+			samples.push_back(timer.elapsedMs());
+		}
+
+		BenchmarkStats stats = computeBenchmarkStats(samples);
+		printBenchmarkStats(mode.name, stats);
+		ios::fmtflags flags = cout.flags();
+		streamsize precision = cout.precision();
+		cout << "  " << runner.getThreadCount() << " threads, " << fixed << setprecision(0)
+			<< (double)ticked / frames << " agents ticked per frame, "
+			<< (double)ticked / (stats.meanMs * frames) << " agents ticked per ms, "
+			<< (double)agentCount / stats.meanMs << " agents updated per ms" << endl;
+		cout.flags(flags);
+		cout.precision(precision);
+	}
+}
+
+#pragma endregion
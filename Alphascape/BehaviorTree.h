@@ -0,0 +1,181 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <atomic> // Import the atomics.
+#include <cstdint> // Import the fixed width integers.
+#include <string> // Import the string class.
+#include <vector> // Import the vector container.
+
+#include "MemoryProfiler.h" // Import the memory heaps.
+
+#pragma endregion
+
+DECLARE_MEMORY_HEAP(BehaviorTreeMemory, "AI", 256 << 20)
+
+enum class BehaviorStatus : uint8_t
+{
+	Success,
+	Failure,
+	Running
+};
+
+// Per-agent state, stored as one array per key (structure of arrays) so a batch of agents reads each key from
+// contiguous memory. Keys are added up front; agents are rows.
+class BehaviorBlackboard
+{
+public:
+	// Add a key of floats, zero for every agent. Returns its column.
+	uint32_t addFloatKey(const char* name);
+
+	// Look a key up by name. Returns UINT32_MAX if there is none.
+	uint32_t findKey(const char* name) const;
+
+	// Add an agent with every key zero and LOD 0. Returns its row.
+	uint32_t addAgent();
+
+	uint32_t getAgentCount() const { return (uint32_t)lods.size(); }
+
+	float* floats(uint32_t key) { return columns[key].data(); }
+	const float* floats(uint32_t key) const { return columns[key].data(); }
+
+	// Each agent's level of detail, which picks its tick rate. Set by the caller, e.g. from distance to the camera.
+	uint8_t* getLods() { return lods.data(); }
+
+private:
+	std::vector<std::string> names;
+	std::vector<HeapVector<float, BehaviorTreeMemory>> columns;
+	HeapVector<uint8_t, BehaviorTreeMemory> lods;
+};
+
+// What a leaf sees while ticking an agent.
+struct BehaviorTickContext
+{
+	BehaviorBlackboard* blackboard;
+	const void* shared; // The group's read-only data shared by all its agents, e.g. where the player is.
+	float deltaTime; // Seconds since this agent last ticked, so agents ticked less often still move at full speed.
+	uint64_t frame;
+};
+
+// A condition or action: reads and writes the agent's row of the blackboard and reports how it went. Must only touch
+// that row, since agents are ticked on several threads at once.
+typedef BehaviorStatus (*BehaviorLeaf)(const BehaviorTickContext& context, uint32_t agent);
+
+// A behavior tree compiled to a flat array of nodes in depth-first order. A node's children follow it directly, and
+// each node stores where its subtree ends, so a composite walks its children by jumping from one subtree end to the
+// next: no child pointers and no per-node allocations.
+//
+// Trees are reactive: every tick starts at the root, so a higher priority branch can interrupt a running one.
+class BehaviorTree
+{
+public:
+	enum class NodeType : uint8_t
+	{
+		Sequence, // Runs children in order until one does not succeed.
+		Selector, // Runs children in order until one does not fail.
+		Inverter, // Swaps the success and failure of its only child.
+		Leaf
+	};
+
+	struct Node
+	{
+		NodeType type;
+		uint32_t subtreeEnd; // Index one past the last node of this subtree.
+		BehaviorLeaf leaf; // Leaves only.
+	};
+
+	// Tick one agent from the root.
+	BehaviorStatus tick(const BehaviorTickContext& context, uint32_t agent) const;
+
+	const std::vector<Node>& getNodes() const { return nodes; }
+
+private:
+	friend class BehaviorTreeBuilder;
+
+	BehaviorStatus tickNode(uint32_t index, const BehaviorTickContext& context, uint32_t agent) const;
+
+	std::vector<Node> nodes;
+};
+
+// Builds a BehaviorTree depth first:
+//
+//   builder.selector();
+//       builder.sequence(); builder.leaf(isHurt); builder.leaf(flee); builder.end();
+//       builder.leaf(wander);
+//   builder.end();
+class BehaviorTreeBuilder
+{
+public:
+	BehaviorTreeBuilder& sequence() { return open(BehaviorTree::NodeType::Sequence); }
+	BehaviorTreeBuilder& selector() { return open(BehaviorTree::NodeType::Selector); }
+	BehaviorTreeBuilder& inverter() { return open(BehaviorTree::NodeType::Inverter); }
+	BehaviorTreeBuilder& leaf(BehaviorLeaf function);
+
+	// Close the innermost open composite or inverter.
+	BehaviorTreeBuilder& end();
+
+	// Take the finished tree. Prints an error and returns false if composites are left open or empty, or an inverter
+	// does not have exactly one child.
+	bool build(BehaviorTree& tree);
+
+private:
+	BehaviorTreeBuilder& open(BehaviorTree::NodeType type);
+
+	std::vector<BehaviorTree::Node> nodes;
+	std::vector<uint32_t> openNodes;
+	bool valid = true;
+};
+
+// How often agents tick at each level of detail. Agents at LOD n tick every tickIntervals[n] frames, staggered by
+// agent so the work is spread evenly over the frames; LODs past the end use the last entry.
+struct BehaviorLodSettings
+{
+	std::vector<uint32_t> tickIntervals = { 1, 2, 4, 8 };
+};
+
+// A group of agents that share a tree: the unit the runner batches over.
+struct BehaviorAgentGroup
+{
+	const BehaviorTree* tree = nullptr;
+	BehaviorBlackboard blackboard;
+	const void* shared = nullptr; // Passed to the leaves; must not change during a tick.
+};
+
+class JobSystem;
+
+// Ticks agent groups on the job system's workers. Each group's agents are split into fixed size batches that the
+// workers and the ticking thread claim from an atomic counter, so each batch walks one tree over contiguous rows of
+// the blackboard.
+class BehaviorTreeRunner
+{
+public:
+	static const uint32_t BatchSize = 256;
+
+	// Without a job system, every batch runs on the ticking thread.
+	explicit BehaviorTreeRunner(JobSystem* jobs = nullptr);
+
+	unsigned int getThreadCount() const;
+
+	// Tick every agent in the groups that is due this frame. Blocks until all are done, so it must not be called from
+	// a job. Returns the agents ticked.
+	uint64_t tick(std::vector<BehaviorAgentGroup>& groups, const BehaviorLodSettings& lods, float deltaTime);
+
+private:
+	struct Batch { uint32_t group, first, count; };
+
+	void runBatches();
+
+	std::vector<Batch> batches; // Reused every frame.
+	std::vector<BehaviorAgentGroup>* currentGroups = nullptr;
+	const BehaviorLodSettings* currentLods = nullptr;
+	float currentDeltaTime = 0.0f;
+	uint64_t frame = 0;
+	std::atomic<uint64_t> agentsTicked{ 0 };
+
+	JobSystem* jobs;
+	std::atomic<uint32_t> nextBatch{ 0 };
+};
+
+// Tick agentCount guards (flee when hurt, chase a visible target, otherwise wander) for the given number of frames on
+// one thread and on every thread, with every agent at LOD 0 and with LODs by distance, and print agents per ms.
+void runBehaviorTreeBenchmark(int agentCount, int frames);
@@ -0,0 +1,82 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <algorithm> // Import min/max.
+#include <chrono> // Import the high resolution clock.
+#include <cmath> // Import sqrt.
+#include <iomanip> // Import stream formatting.
+#include <iostream> // Import the IO stream libraries.
+#include <vector> // Import the vector container.
+
+#pragma endregion
+
+// Small helpers shared by the engine's --bench-* command line modes.
+// Samples are collected in milliseconds and summarised as mean/min/max/standard deviation.
+
+// A stopwatch around the high resolution clock.
+class BenchmarkTimer
+{
+public:
+	BenchmarkTimer() : start(std::chrono::high_resolution_clock::now()) {}
+
+	// Restart the stopwatch.
+	void reset() { start = std::chrono::high_resolution_clock::now(); }
+
+	// Milliseconds elapsed since construction or the last reset.
+	double elapsedMs() const
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+private:
+	std::chrono::high_resolution_clock::time_point start;
+};
+
+// Summary of a set of timing samples.
+struct BenchmarkStats
+{
+	double meanMs = 0.0;
+	double minMs = 0.0;
+	double maxMs = 0.0;
+	double stdDevMs = 0.0;
+	size_t samples = 0;
+};
+
+// Summarise a set of millisecond samples.
+inline BenchmarkStats computeBenchmarkStats(const std::vector<double>& samplesMs)
+{
+	BenchmarkStats stats;
+	stats.samples = samplesMs.size();
+	if (samplesMs.empty())
+		return stats;
+
+	stats.minMs = samplesMs[0];
+	stats.maxMs = samplesMs[0];
+	double sum = 0.0;
+	for (double sample : samplesMs) {
+		sum += sample;
+		stats.minMs = std::min(stats.minMs, sample);
+		stats.maxMs = std::max(stats.maxMs, sample);
+	}
+	stats.meanMs = sum / samplesMs.size();
+
+	double variance = 0.0;
+	for (double sample : samplesMs)
+		variance += (sample - stats.meanMs) * (sample - stats.meanMs);
+	stats.stdDevMs = std::sqrt(variance / samplesMs.size());
+	return stats;
+}
+
+// Print one benchmark line, e.g. "BENCH::OIT::WEIGHTED_BLENDED mean 1.234 ms (min ..., max ..., sd ...) over 100 samples".
+inline void printBenchmarkStats(const char* name, const BenchmarkStats& stats)
+{
+	std::ios::fmtflags flags = std::cout.flags();
+	std::streamsize precision = std::cout.precision();
+	std::cout << "BENCH::" << name << std::fixed << std::setprecision(3)
+		<< " mean " << stats.meanMs << " ms"
+		<< " (min " << stats.minMs << ", max " << stats.maxMs << ", sd " << stats.stdDevMs << ")"
+		<< " over " << stats.samples << " samples" << std::endl;
+	std::cout.flags(flags);
+	std::cout.precision(precision);
+}
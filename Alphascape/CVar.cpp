@@ -0,0 +1,198 @@
+#pragma region Library Imports
+
+#include <cstdio> // Import snprintf.
+#include <cstring> // Import strcmp.
+#include <fstream> // Import the file streams.
+#include <iostream> // Import the IO stream libraries.
+#include <sstream> // Import the string streams.
+
+#include "CVar.h" // Import the cvar declarations.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Value Conversion
+
+// Remove leading and trailing whitespace.
+static string trim(const string& text)
+{
+	size_t first = text.find_first_not_of(" \t\r\n");
+	if (first == string::npos)
+		return "";
+	size_t last = text.find_last_not_of(" \t\r\n");
+	return text.substr(first, last - first + 1);
+}
+
+bool parseCVarValue(const string& text, bool& value)
+{
+	if (text == "1" || text == "true" || text == "on") { value = true; return true; }
+	if (text == "0" || text == "false" || text == "off") { value = false; return true; }
+	return false;
+}
+
+bool parseCVarValue(const string& text, int& value)
+{
+	istringstream stream(text);
+	return (stream >> value) && stream.eof();
+}
+
+bool parseCVarValue(const string& text, float& value)
+{
+	istringstream stream(text);
+	return (stream >> value) && stream.eof();
+}
+
+bool parseCVarValue(const string& text, string& value)
+{
+	value = text;
+	if (value.size() >= 2 && value.front() == '"' && value.back() == '"') // Allow quoted strings.
+		value = value.substr(1, value.size() - 2);
+	return true;
+}
+
+bool parseCVarValue(const string& text, CVarColor& value)
+{
+	istringstream stream(text);
+	CVarColor parsed = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+	if (!(stream >> parsed.rgba[0] >> parsed.rgba[1] >> parsed.rgba[2]))
+		return false;
+	if (!(stream >> ws).eof() && !(stream >> parsed.rgba[3])) // Alpha is optional.
+		return false;
+	if (!(stream >> ws).eof()) // Nothing may follow it.
+		return false;
+	value = parsed;
+	return true;
+}
+
+string formatCVarValue(bool value) { return value ? "1" : "0"; }
+string formatCVarValue(int value) { return to_string(value); }
+string formatCVarValue(const string& value) { return "\"" + value + "\""; }
+
+string formatCVarValue(float value)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%g", value);
+	return buffer;
+}
+
+string formatCVarValue(const CVarColor& value)
+{
+	return formatCVarValue(value.rgba[0]) + " " + formatCVarValue(value.rgba[1]) + " "
+		+ formatCVarValue(value.rgba[2]) + " " + formatCVarValue(value.rgba[3]);
+}
+
+#pragma endregion
+
+#pragma region CVarBase
+
+CVarBase::CVarBase(const char* cvarName, const char* cvarDescription)
+	: name(cvarName), description(cvarDescription)
+{
+	CVarRegistry::instance().add(this);
+}
+
+void CVarBase::markPending()
+{
+	CVarRegistry::instance().markPending();
+}
+
+#pragma endregion
+
+#pragma region CVarRegistry
+
+CVarRegistry& CVarRegistry::instance()
+{
+	static CVarRegistry registry;
+	return registry;
+}
+
+void CVarRegistry::add(CVarBase* cvar)
+{
+	if (cvars.count(cvar->getName()))
+		cout << "ERROR::CVAR::DUPLICATE_NAME\n" << cvar->getName() << endl;
+	cvars[cvar->getName()] = cvar;
+	auto added = cvarsById.insert(make_pair(StringId::fromString(cvar->getName()), cvar));
+	if (!added.second && strcmp(added.first->second->getName(), cvar->getName()) != 0)
+		cout << "ERROR::CVAR::NAME_HASH_COLLISION\n" << cvar->getName() << " " << added.first->second->getName() << endl;
+}
+
+CVarBase* CVarRegistry::find(const string& name) const
+{
+	CVarBase* cvar = findById(StringId(hashNameAtRuntime(name.data(), name.size()))); // Not interned: names may be typos.
+	if (!cvar || name == cvar->getName())
+		return cvar;
+	auto found = cvars.find(name); // Another name with the same hash: only the ordered map can tell them apart.
+	return found == cvars.end() ? nullptr : found->second;
+}
+
+CVarBase* CVarRegistry::findById(StringId id) const
+{
+	auto found = cvarsById.find(id);
+	return found == cvarsById.end() ? nullptr : found->second;
+}
+
+bool CVarRegistry::set(const string& name, const string& value)
+{
+	CVarBase* cvar = find(name);
+	if (!cvar) {
+		cout << "ERROR::CVAR::UNKNOWN_NAME\n" << name << endl;
+		return false;
+	}
+	if (!cvar->setFromString(value)) {
+		cout << "ERROR::CVAR::INVALID_VALUE\n" << name << " " << value << endl;
+		return false;
+	}
+	return true;
+}
+
+bool CVarRegistry::setFromAssignment(const string& assignment)
+{
+	size_t split = assignment.find_first_of("= \t");
+	if (split == string::npos) {
+		cout << "ERROR::CVAR::MISSING_VALUE\n" << assignment << endl;
+		return false;
+	}
+	return set(trim(assignment.substr(0, split)), trim(assignment.substr(split + 1)));
+}
+
+bool CVarRegistry::loadFile(const string& path)
+{
+	ifstream file(path);
+	if (!file)
+		return false;
+	string line;
+	while (getline(file, line)) {
+		line = trim(line.substr(0, line.find('#'))); // Strip comments.
+		if (!line.empty())
+			setFromAssignment(line);
+	}
+	return true;
+}
+
+bool CVarRegistry::saveFile(const string& path) const
+{
+	ofstream file(path);
+	if (!file)
+		return false;
+	for (const auto& entry : cvars)
+		file << "# " << entry.second->getDescription() << "\n" << entry.first << " " << entry.second->toString() << "\n";
+	return true;
+}
+
+void CVarRegistry::applyPending()
+{
+	if (!pending.exchange(false))
+		return; // The common case: nothing was set this frame.
+
+	// Commit every value first, so callbacks that read several cvars see a consistent set.
+	vector<CVarBase*> changed;
+	for (const auto& entry : cvars) {
+		if (entry.second->commitPending())
+			changed.push_back(entry.second);
+	}
+	for (CVarBase* cvar : changed)
+		cvar->notifyChanged();
+}
+
+#pragma endregion
@@ -0,0 +1,176 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <atomic> // Import the atomics.
+#include <functional> // Import std::function for change callbacks.
+#include <map> // Import the ordered map.
+#include <mutex> // Import the mutex guarding pending changes.
+#include <string> // Import the string class.
+#include <unordered_map> // Import the hash map.
+#include <vector> // Import the vector container.
+
+#include "StringId.h" // Import the string IDs.
+
+#pragma endregion
+
+// Runtime configuration variables ("cvars").
+//
+// A cvar is a typed global declared once at file scope, e.g.
+//     CVar<bool> wireframe("r_wireframe", false, "Draw the scene as lines.");
+// Reading it (wireframe.get(), or implicitly as a bool) is a plain load of a cached member: there is no lookup.
+// Writes go through set(), which only queues the new value; CVarRegistry::applyPending() commits all queued values
+// at a frame boundary and then runs the change callbacks, so a value never changes in the middle of a frame.
+// Values can come from a config file ("name value" per line, # starts a comment) or from the command line.
+
+// An RGBA colour cvar value.
+struct CVarColor
+{
+	float rgba[4];
+};
+
+// Text conversion for each supported cvar type. Returns false if the text is not a valid value.
+bool parseCVarValue(const std::string& text, bool& value);
+bool parseCVarValue(const std::string& text, int& value);
+bool parseCVarValue(const std::string& text, float& value);
+bool parseCVarValue(const std::string& text, std::string& value);
+bool parseCVarValue(const std::string& text, CVarColor& value);
+std::string formatCVarValue(bool value);
+std::string formatCVarValue(int value);
+std::string formatCVarValue(float value);
+std::string formatCVarValue(const std::string& value);
+std::string formatCVarValue(const CVarColor& value);
+
+// The untyped part of a cvar, used by the registry.
+class CVarBase
+{
+public:
+	CVarBase(const char* name, const char* description);
+	virtual ~CVarBase() {}
+
+	const char* getName() const { return name; }
+	const char* getDescription() const { return description; }
+
+	// Queue a value given as text. Returns false if it could not be parsed.
+	virtual bool setFromString(const std::string& text) = 0;
+
+	// The current (committed) value as text.
+	virtual std::string toString() const = 0;
+
+protected:
+	friend class CVarRegistry;
+
+	// Commit the queued value. Returns true if the value changed and callbacks need to run.
+	virtual bool commitPending() = 0;
+
+	// Run the change callbacks for the committed value.
+	virtual void notifyChanged() = 0;
+
+	void markPending(); // Tell the registry there is something to commit.
+
+	const char* name;
+	const char* description;
+};
+
+// A typed cvar.
+template <typename T>
+class CVar : public CVarBase
+{
+public:
+	typedef std::function<void(const T&)> ChangeCallback;
+
+	CVar(const char* name, const T& defaultValue, const char* description)
+		: CVarBase(name, description), value(defaultValue), pendingValue(defaultValue) {}
+
+	// Hot-path read: a plain load of the committed value.
+	const T& get() const { return value; }
+	operator const T&() const { return value; }
+
+	// Queue a new value, committed at the next frame boundary.
+	void set(const T& newValue)
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		pendingValue = newValue;
+		hasPending = true;
+		markPending();
+	}
+
+	// Call callback with the new value every time a change is committed.
+	void onChange(const ChangeCallback& callback) { callbacks.push_back(callback); }
+
+	bool setFromString(const std::string& text) override
+	{
+		T parsed;
+		if (!parseCVarValue(text, parsed))
+			return false;
+		set(parsed);
+		return true;
+	}
+
+	std::string toString() const override { return formatCVarValue(value); }
+
+protected:
+	bool commitPending() override
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		if (!hasPending)
+			return false;
+		hasPending = false;
+		bool changed = formatCVarValue(pendingValue) != formatCVarValue(value); // Works for every supported type.
+		value = pendingValue;
+		return changed;
+	}
+
+	void notifyChanged() override
+	{
+		for (const ChangeCallback& callback : callbacks)
+			callback(value);
+	}
+
+private:
+	T value; // Committed value, read on the hot path.
+	T pendingValue; // Queued value, guarded by pendingMutex.
+	bool hasPending = false;
+	std::mutex pendingMutex;
+	std::vector<ChangeCallback> callbacks;
+};
+
+// Every cvar in the program, by name.
+class CVarRegistry
+{
+public:
+	// The registry. Constructed on first use, so cvars in any translation unit can register during static initialisation.
+	static CVarRegistry& instance();
+
+	void add(CVarBase* cvar);
+
+	// Find by name. Looks the hash up, then checks the name, so a typo that hashes the same finds nothing.
+	CVarBase* find(const std::string& name) const;
+
+	// Find by hashed name, comparing integers only: findById(StringId("r_vsync")) hashes the literal at compile time.
+	// Use it with the names of registered cvars; if two of them hash the same, add() reports it and the first keeps
+	// the ID.
+	CVarBase* findById(StringId id) const;
+
+	// Queue a value by name. Prints an ERROR::CVAR message and returns false on an unknown name or bad value.
+	bool set(const std::string& name, const std::string& value);
+
+	// Queue "name value" or "name=value".
+	bool setFromAssignment(const std::string& assignment);
+
+	// Queue every assignment in a config file. Returns false if the file could not be opened.
+	bool loadFile(const std::string& path);
+
+	// Write every cvar with its current value and description to a config file.
+	bool saveFile(const std::string& path) const;
+
+	// Commit all queued values, then run the callbacks of the cvars that changed. Call once per frame, between frames.
+	void applyPending();
+
+	void markPending() { pending.store(true); }
+
+private:
+	std::map<std::string, CVarBase*> cvars; // Ordered, so saved config files are sorted.
+	std::unordered_map<StringId, CVarBase*> cvarsById;
+	std::atomic<bool> pending{ false }; // Set by any thread calling set(), cleared by applyPending().
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Graphics.h" // Import GLEW and GLFW.
+#include "OpaquePass.h" // Import the opaque pass settings.
+#include "Transparency.h" // Import the transparency modes.
+
+// Everything the render thread needs to draw one frame. Built by the main thread after simulation
+// and copied through the render queue, so the two threads never share mutable state.
+struct FrameData
+{
+	unsigned long long frameNumber = 0;
+	GLfloat time = 0.0f; // Seconds since start, for effects that always animate.
+	GLfloat animationTime = 0.0f; // Seconds of unpaused animation.
+	GLfloat objectColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f }; // The simulated colour of the quads.
+	int framebufferWidth = 0, framebufferHeight = 0;
+	TransparencyMode transparencyMode = TransparencyMode::WeightedBlended;
+	GLfloat clearColor[4] = { 0.529f, 0.808f, 0.980f, 1.0f }; // From r_clearColor.
+	bool wireframe = false; // From r_wireframe.
+	OpaquePassSettings opaque; // From r_depthPrePass, r_sortOpaque and r_showOverdraw.
+	bool pick = false; // Pick on the GPU at (pickX, pickY), in framebuffer pixels from the bottom left (a click).
+	int pickX = 0, pickY = 0;
+	int swapInterval = 1; // From r_vsync.
+};
@@ -0,0 +1,61 @@
+#pragma region Library Imports
+
+#include "FramePacer.h" // Import the frame pacer.
+
+#pragma endregion
+
+bool FramePacer::waitForFrame()
+{
+	if (!powerSaving) { // Busy loop, exactly like the original main loop.
+		glfwPollEvents(); // Check if any events have been called.
+		lastFrameTime = glfwGetTime();
+		dirty = false;
+		return true;
+	}
+
+	if (iconified) { // Nothing is visible: sleep until the window is restored or closed.
+		if (maxWait > 0.0)
+			glfwWaitEventsTimeout(maxWait);
+		else
+			glfwWaitEvents();
+		skipped++;
+		return false; // Re-check the window state before rendering.
+	}
+
+	if (animating && focused) { // Foreground animation: render every iteration.
+		glfwPollEvents();
+		lastFrameTime = glfwGetTime();
+		dirty = false;
+		return true;
+	}
+
+	if (animating) { // Background animation: wait until the next throttled frame is due, or an event arrives.
+		double nextFrameTime = lastFrameTime + 1.0 / backgroundFrameRate;
+		double now = glfwGetTime();
+		if (now < nextFrameTime)
+			glfwWaitEventsTimeout(limitWait(nextFrameTime - now));
+		else
+			glfwPollEvents();
+		now = glfwGetTime();
+		if (!dirty && now < nextFrameTime) { // Woken early by an event that changed nothing.
+			skipped++;
+			return false;
+		}
+		lastFrameTime = now;
+		dirty = false;
+		return true;
+	}
+
+	// Static scene: only render when something requested it.
+	if (!dirty)
+		glfwWaitEventsTimeout(limitWait(idleTimeout));
+	else
+		glfwPollEvents();
+	if (!dirty) {
+		skipped++;
+		return false;
+	}
+	lastFrameTime = glfwGetTime();
+	dirty = false;
+	return true;
+}
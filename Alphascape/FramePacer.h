@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Graphics.h" // Import GLEW and GLFW.
+
+// Decides, once per main loop iteration, how to process events and whether to render.
+//
+// With power saving enabled:
+//  - while iconified nothing is rendered and the loop blocks in glfwWaitEvents until something happens;
+//  - while nothing animates, the loop blocks in glfwWaitEventsTimeout and only renders after a redraw request;
+//  - while unfocused, animation is throttled to backgroundFrameRate;
+//  - otherwise events are polled and every iteration renders, exactly as before.
+// Any GLFW event wakes the wait immediately, so input stays responsive. maxWait caps every wait, for loops that also
+// step a simulation which must keep time whether or not anything is drawn.
+class FramePacer
+{
+public:
+	bool powerSaving = true; // When false, always poll and always render.
+	double backgroundFrameRate = 10.0; // Frames per second while unfocused but animating.
+	double idleTimeout = 0.5; // Seconds to block at most while idle, so timers can still be checked.
+	double maxWait = 0.0; // When positive, seconds to block at most in any state, so a simulation keeps stepping.
+
+	// Window state, normally driven from the GLFW callbacks.
+	void setIconified(bool value) { iconified = value; requestRedraw(); }
+	void setFocused(bool value) { focused = value; requestRedraw(); }
+	void setAnimating(bool value) { animating = value; requestRedraw(); }
+	bool isAnimating() const { return animating; }
+
+	// Mark the scene as changed, so the next iteration renders even if nothing animates.
+	void requestRedraw() { dirty = true; }
+
+	// Process pending events, blocking when allowed to. Returns true if a frame should be rendered.
+	bool waitForFrame();
+
+	// Number of loop iterations that skipped rendering, for diagnostics.
+	unsigned long long skippedFrames() const { return skipped; }
+
+private:
+	// Cap a wait at maxWait.
+	double limitWait(double seconds) const { return maxWait > 0.0 && maxWait < seconds ? maxWait : seconds; }
+
+	bool iconified = false;
+	bool focused = true;
+	bool animating = true;
+	bool dirty = true; // Render the first frame.
+	double lastFrameTime = 0.0;
+	unsigned long long skipped = 0;
+};
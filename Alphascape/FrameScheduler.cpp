@@ -0,0 +1,208 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import max and stable_sort.
+#include <iomanip> // Import stream formatting.
+#include <iostream> // Import the IO stream libraries.
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "FrameScheduler.h" // Import the frame scheduler.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+constexpr double FrameScheduler::MinSliceMs;
+constexpr double FrameScheduler::OverrunDecay;
+
+static double millisecondsBetween(chrono::high_resolution_clock::time_point from, chrono::high_resolution_clock::time_point to)
+{
+	return chrono::duration<double, milli>(to - from).count();
+}
+
+#pragma region Frame Scheduler
+
+uint32_t FrameScheduler::addTask(const char* name, TaskFunction function, float weight)
+{
+	Task task;
+	task.name = name;
+	task.function = function;
+	task.weight = weight;
+	task.lastSlice = Clock::now();
+	tasks.push_back(task);
+	return (uint32_t)tasks.size() - 1;
+}
+
+void FrameScheduler::run(double budgetMs)
+{
+	Clock::time_point start = Clock::now();
+	Clock::time_point end = start + chrono::duration_cast<Clock::duration>(chrono::duration<double, milli>(budgetMs));
+
+	// Most overdue first: weight times the time since the last slice.
+	order.resize(tasks.size());
+	for (uint32_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	stable_sort(order.begin(), order.end(), [this, start](uint32_t a, uint32_t b) {
+		return tasks[a].weight * millisecondsBetween(tasks[a].lastSlice, start) > tasks[b].weight * millisecondsBetween(tasks[b].lastSlice, start);
+	});
+
+	// Hand out slices until the budget is spent or no task has work left. The first pass offers every task a slice
+	// (an idle one returns at once); later passes share what is left between the tasks that still have a backlog.
+	frame++;
+	stats.tasksRun = stats.tasksDeferred = 0;
+	for (bool firstPass = true; ; firstPass = false) {
+		size_t waiting = 0; // Tasks still to get a slice in this pass.
+		for (uint32_t index : order)
+			waiting += firstPass || tasks[index].backlog > 0 ? 1 : 0;
+		if (waiting == 0)
+			break;
+
+		bool ranAny = false;
+		for (uint32_t index : order) {
+			Task& task = tasks[index];
+			if (!firstPass && task.backlog == 0)
+				continue;
+			Clock::time_point now = Clock::now();
+			double remainingMs = millisecondsBetween(now, end);
+			if (remainingMs < MinSliceMs) // Too late for a useful slice: the rest wait, and are first next frame.
+				break;
+
+			// An even share of what is left; a task that finishes early leaves its unused share to the next. A task runs
+			// past its deadline by the unit of work it is in the middle of, so its deadline is brought forward by the
+			// most it has overrun lately, and if that leaves too little, it waits for a frame with more time left.
+			double sliceMs = remainingMs / waiting--;
+			double aimMs = min(max(sliceMs, MinSliceMs + task.overrunMs), remainingMs) - task.overrunMs;
+			if (aimMs < MinSliceMs) {
+				task.overrunMs *= OverrunDecay; // Or one slow unit could keep it waiting for good.
+				continue;
+			}
+			Clock::time_point aim = now + chrono::duration_cast<Clock::duration>(chrono::duration<double, milli>(aimMs));
+			size_t backlogBefore = task.backlog;
+			task.backlog = task.function(SliceDeadline(aim));
+			Clock::time_point after = Clock::now();
+			task.overrunMs = max(millisecondsBetween(aim, after), task.overrunMs * OverrunDecay);
+			task.totalMs += millisecondsBetween(now, after);
+			task.slices++;
+			task.lastSlice = after;
+			if (task.lastFrame != frame && (backlogBefore > 0 || task.backlog > 0))
+				stats.tasksRun++; // Not idle tasks, which are offered a slice only to pick up new work.
+			task.lastFrame = frame;
+			ranAny = true;
+		}
+		if (!ranAny || millisecondsBetween(Clock::now(), end) < MinSliceMs)
+			break;
+	}
+	for (const Task& task : tasks)
+		stats.tasksDeferred += task.lastFrame != frame && task.backlog > 0 ? 1 : 0;
+
+	Clock::time_point finish = Clock::now();
+	stats.usedMs = millisecondsBetween(start, finish);
+	if (stats.usedMs > budgetMs + MinSliceMs) // A slice can overshoot by its last unit of work; only count real overruns.
+		stats.overruns++;
+	stats.backlog = 0;
+	stats.maxStalenessMs = 0.0;
+	for (const Task& task : tasks) {
+		stats.backlog += task.backlog;
+		if (task.backlog > 0)
+			stats.maxStalenessMs = max(stats.maxStalenessMs, millisecondsBetween(task.lastSlice, finish));
+	}
+}
+
+void FrameScheduler::printReport() const
+{
+	ios::fmtflags flags = cout.flags();
+	streamsize precision = cout.precision();
+	Clock::time_point now = Clock::now();
+	for (const Task& task : tasks) {
+		cout << "SCHEDULER::" << task.name << fixed << setprecision(3)
+			<< " backlog " << task.backlog
+			<< ", waited " << (task.backlog > 0 ? millisecondsBetween(task.lastSlice, now) : 0.0) << " ms"
+			<< ", " << task.slices << " slices, " << task.totalMs << " ms in total" << endl;
+	}
+	cout.flags(flags);
+	cout.precision(precision);
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+// Burn CPU for a unit of synthetic work.
+static void spinMicroseconds(double microseconds)
+{
+	chrono::high_resolution_clock::time_point end = chrono::high_resolution_clock::now() + chrono::duration_cast<chrono::high_resolution_clock::duration>(chrono::duration<double, micro>(microseconds));
+	while (chrono::high_resolution_clock::now() < end) {}
+}
+
+// A queue of identical units of work that grows by a fixed demand per frame.
+struct SyntheticWork
+{
+	const char* name;
+	size_t demandPerFrame;
+	double unitMicroseconds;
+	size_t queued = 0;
+
+	// Do units until the deadline expires (at least one), and return what is left.
+	size_t step(const SliceDeadline& deadline)
+	{
+		while (queued > 0) {
+			spinMicroseconds(unitMicroseconds);
+			queued--;
+			if (deadline.expired())
+				break;
+		}
+		return queued;
+	}
+};
+
+void runFrameSchedulerBenchmark(int frames, double budgetMs)
+{
+	// Normal demand is about 1.6 ms of work a frame; for 20 frames it is five times that.
+	const int spikeStart = 100, spikeEnd = 120, spikeFactor = 5;
+	cout << "BENCH::SCHEDULER " << frames << " frames, budget " << budgetMs << " ms, demand x" << spikeFactor
+		<< " for frames " << spikeStart << " to " << spikeEnd << endl;
+
+	for (int budgeted = 0; budgeted < 2; budgeted++) {
+		SyntheticWork work[3] = { { "AI_UPDATES", 100, 10.0 }, { "STREAMING", 20, 20.0 }, { "CACHE_TRIM", 5, 40.0 } };
+		FrameScheduler scheduler;
+		scheduler.addTask(work[0].name, [&work](const SliceDeadline& deadline) { return work[0].step(deadline); }, 2.0f); // AI goes stale fastest.
+		scheduler.addTask(work[1].name, [&work](const SliceDeadline& deadline) { return work[1].step(deadline); });
+		scheduler.addTask(work[2].name, [&work](const SliceDeadline& deadline) { return work[2].step(deadline); }, 0.5f);
+
+		vector<double> samples;
+		size_t peakBacklog = 0;
+		int drainedFrame = -1;
+		for (int frame = 0; frame < frames; frame++) {
+			for (SyntheticWork& task : work)
+				task.queued += task.demandPerFrame * (frame >= spikeStart && frame < spikeEnd ? spikeFactor : 1);
+
+			BenchmarkTimer timer;
+			if (budgeted) {
+				scheduler.run(budgetMs);
+			}
+			else { // Everything, every frame.
+				SliceDeadline never(chrono::high_resolution_clock::time_point::max());
+				for (SyntheticWork& task : work)
+					task.step(never);
+			}
+			samples.push_back(timer.elapsedMs());
+
+			size_t backlog = work[0].queued + work[1].queued + work[2].queued;
+			peakBacklog = max(peakBacklog, backlog);
+			if (frame >= spikeEnd && drainedFrame < 0 && backlog <= work[0].demandPerFrame + work[1].demandPerFrame + work[2].demandPerFrame)
+				drainedFrame = frame;
+		}
+
+		printBenchmarkStats(budgeted ? "SCHEDULER::BUDGETED" : "SCHEDULER::ALL_WORK_EVERY_FRAME", computeBenchmarkStats(samples));
+		if (budgeted) {
+			cout << "  peak backlog " << peakBacklog << " units, ";
+			if (drainedFrame < 0)
+				cout << "not back to normal by the end";
+			else
+				cout << "back to normal " << drainedFrame - spikeEnd << " frames after the spike";
+			cout << ", over budget in " << scheduler.getStats().overruns << " frames" << endl;
+			scheduler.printReport();
+		}
+	}
+}
+
+#pragma endregion
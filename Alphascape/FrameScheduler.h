@@ -0,0 +1,92 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <chrono> // Import the high resolution clock.
+#include <cstddef> // Import size_t.
+#include <cstdint> // Import the fixed width integers.
+#include <functional> // Import function.
+#include <string> // Import the string class.
+#include <vector> // Import the vector container.
+
+#pragma endregion
+
+// When a slice of deferrable work has to stop. Tasks check it between units of work.
+class SliceDeadline
+{
+public:
+	explicit SliceDeadline(std::chrono::high_resolution_clock::time_point end) : end(end) {}
+
+	bool expired() const { return std::chrono::high_resolution_clock::now() >= end; }
+
+private:
+	std::chrono::high_resolution_clock::time_point end;
+};
+
+// What the last run() did.
+struct FrameSchedulerStats
+{
+	double usedMs = 0.0; // Time spent in tasks.
+	uint32_t tasksRun = 0; // Tasks that had work, or still have some, when given a slice.
+	uint32_t tasksDeferred = 0; // Tasks with work left that got no slice this frame.
+	size_t backlog = 0; // Units of work left across all tasks, as they last reported.
+	double maxStalenessMs = 0.0; // The longest any task with work left has gone without a slice.
+	uint64_t overruns = 0; // Frames, since the scheduler was created, in which the tasks overran the budget by over MinSliceMs.
+};
+
+// Runs deferrable work (AI updates, streaming decisions, cache trimming) within a per-frame time budget.
+//
+// A task is a function that does units of work until its deadline expires and returns how many units it still has
+// queued. Each frame, run() hands out the budget in slices, most overdue task first: a task's priority is its weight
+// times how long it has waited since its last slice, so anything left out one frame is first in line the next. Each
+// task gets an even share of what is left of the budget, leftovers flow to the tasks after it, and time left at the
+// end goes round again to the tasks that still have work. Once too little is left for a useful slice, the remaining
+// tasks are deferred rather than run late, so demand spikes stretch the backlog instead of the frame.
+//
+// Tasks must check their deadline between small units of work; a task always completes at least one unit per
+// slice, so it can exceed its slice by that unit's cost. The scheduler tracks how far past its deadline each task has
+// run lately and gives it a deadline that much earlier, so the frame as a whole stays within the budget.
+class FrameScheduler
+{
+public:
+	typedef std::function<size_t(const SliceDeadline& deadline)> TaskFunction;
+
+	static constexpr double MinSliceMs = 0.05; // Less than this left and the rest of the tasks wait a frame.
+	static constexpr double OverrunDecay = 0.95; // Per slice or deferral, how much of a task's worst overrun it still expects.
+
+	// Register a task. weight scales how quickly it becomes overdue. Returns the task index.
+	uint32_t addTask(const char* name, TaskFunction function, float weight = 1.0f);
+
+	// Run tasks for at most budgetMs, most overdue first.
+	void run(double budgetMs);
+
+	const FrameSchedulerStats& getStats() const { return stats; }
+
+	// Print one line per task: its backlog, staleness and share of the time.
+	void printReport() const;
+
+private:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	struct Task
+	{
+		std::string name;
+		TaskFunction function;
+		float weight = 1.0f;
+		Clock::time_point lastSlice; // When it last got a slice (or was added).
+		size_t backlog = 1; // As last reported; assume there is work until told otherwise.
+		double totalMs = 0.0;
+		uint64_t slices = 0;
+		uint64_t lastFrame = 0; // The run() that last gave it a slice.
+		double overrunMs = 0.0; // How far past its deadline it has run lately (decaying peak).
+	};
+
+	std::vector<Task> tasks;
+	std::vector<uint32_t> order; // Reused every frame.
+	FrameSchedulerStats stats;
+	uint64_t frame = 0; // Calls to run().
+};
+
+// Run a frame loop with three synthetic deferrable tasks whose demand spikes fivefold for a while, once running all
+// work every frame and once through a FrameScheduler with a fixed budget, and print the frame times and backlog.
+void runFrameSchedulerBenchmark(int frames, double budgetMs);
@@ -0,0 +1,573 @@
+#pragma region Library Imports
+
+#include <cstring> // Import memcpy.
+#include <iostream> // Import the IO stream libraries.
+
+#include "GLRenderDevice.h" // Import the GL render device.
+#include "Shader.h" // Import the shader compiler.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Command List
+
+// A command list that records into memory and is replayed by GLRenderDevice::submit.
+class GLCommandList : public CommandList
+{
+public:
+	enum class Op : uint8_t { BindPipeline, BindVertexBuffer, BindIndexBuffer, BindTexture, BindUniformBuffer, SetConstants, Draw, DrawIndexed };
+
+	struct Command
+	{
+		Op op;
+		uint32_t a, b, c; // Operands; meaning depends on op.
+		size_t offset; // Buffer offset, or offset into constants for SetConstants.
+	};
+
+	void begin() override { commands.clear(); constants.clear(); }
+	void end() override {}
+
+	void bindPipeline(PipelineHandle pipeline) override { push(Op::BindPipeline, pipeline.id); }
+	void bindVertexBuffer(uint32_t binding, BufferHandle buffer, size_t offset) override { push(Op::BindVertexBuffer, binding, buffer.id, 0, offset); }
+	void bindIndexBuffer(BufferHandle buffer) override { push(Op::BindIndexBuffer, buffer.id); }
+	void bindTexture(uint32_t unit, TextureHandle texture, SamplerHandle sampler) override { push(Op::BindTexture, unit, texture.id, sampler.id); }
+	void bindUniformBuffer(uint32_t slot, BufferHandle buffer) override { push(Op::BindUniformBuffer, slot, buffer.id); }
+
+	void setConstants(const void* data, size_t size) override
+	{
+		if (size > MaxConstantsSize) {
+			cout << "ERROR::RENDER_DEVICE::CONSTANTS_TOO_LARGE\n" << size << endl;
+			return;
+		}
+		push(Op::SetConstants, (uint32_t)size, 0, 0, constants.size());
+		constants.insert(constants.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+	}
+
+	void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex) override { push(Op::Draw, vertexCount, instanceCount, firstVertex); }
+	void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex) override { push(Op::DrawIndexed, indexCount, instanceCount, firstIndex); }
+
+	vector<Command> commands;
+	vector<uint8_t> constants;
+
+private:
+	void push(Op op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0, size_t offset = 0)
+	{
+		Command command = { op, a, b, c, offset };
+		commands.push_back(command);
+	}
+};
+
+#pragma endregion
+
+#pragma region Format Tables
+
+static GLenum bufferTarget(BufferUsage usage)
+{
+	switch (usage)
+	{
+	case BufferUsage::Index: return GL_ELEMENT_ARRAY_BUFFER;
+	case BufferUsage::Uniform: return GL_UNIFORM_BUFFER;
+	default: return GL_ARRAY_BUFFER;
+	}
+}
+
+static GLenum depthFunction(DepthCompare compare)
+{
+	switch (compare)
+	{
+	case DepthCompare::LessEqual: return GL_LEQUAL;
+	case DepthCompare::Equal: return GL_EQUAL;
+	case DepthCompare::Always: return GL_ALWAYS;
+	default: return GL_LESS;
+	}
+}
+
+static GLint samplerWrap(SamplerWrap wrap)
+{
+	switch (wrap)
+	{
+	case SamplerWrap::ClampToEdge: return GL_CLAMP_TO_EDGE;
+	case SamplerWrap::MirroredRepeat: return GL_MIRRORED_REPEAT;
+	default: return GL_REPEAT;
+	}
+}
+
+static void textureFormat(TextureFormat format, GLint& internalFormat, GLenum& pixelFormat, GLenum& type)
+{
+	switch (format)
+	{
+	case TextureFormat::RGBA16F: internalFormat = GL_RGBA16F; pixelFormat = GL_RGBA; type = GL_HALF_FLOAT; break;
+	case TextureFormat::R16F: internalFormat = GL_R16F; pixelFormat = GL_RED; type = GL_HALF_FLOAT; break;
+	default: internalFormat = GL_RGBA8; pixelFormat = GL_RGBA; type = GL_UNSIGNED_BYTE; break;
+	}
+}
+
+#pragma endregion
+
+GLRenderDevice::GLRenderDevice()
+{
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &constantsAlignment);
+	glGenBuffers(1, &constantsBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, constantsBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, ConstantsBufferSize, NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+GLRenderDevice::~GLRenderDevice()
+{
+	for (size_t i = 0; i < buffers.size(); i++)
+		destroyBuffer(BufferHandle{ (uint32_t)i + 1 });
+	for (size_t i = 0; i < textures.size(); i++)
+		destroyTexture(TextureHandle{ (uint32_t)i + 1 });
+	for (size_t i = 0; i < pipelines.size(); i++)
+		destroyPipeline(PipelineHandle{ (uint32_t)i + 1 });
+	if (!samplers.empty())
+		glDeleteSamplers((GLsizei)samplers.size(), samplers.data());
+	glDeleteBuffers(1, &constantsBuffer);
+}
+
+#pragma region Resources
+
+BufferHandle GLRenderDevice::createBuffer(const BufferDesc& desc)
+{
+	GLBuffer buffer;
+	buffer.target = bufferTarget(desc.usage);
+	buffer.size = desc.size;
+	glGenBuffers(1, &buffer.name);
+	glBindVertexArray(0); // Never disturb a VAO's element buffer binding.
+	glBindBuffer(buffer.target, buffer.name);
+	glBufferData(buffer.target, desc.size, desc.initialData, desc.dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+	glBindBuffer(buffer.target, 0);
+	buffers.push_back(buffer);
+	return BufferHandle{ (uint32_t)buffers.size() };
+}
+
+void GLRenderDevice::updateBuffer(BufferHandle handle, size_t offset, const void* data, size_t size)
+{
+	const GLBuffer& buffer = buffers[handle.id - 1];
+	glBindVertexArray(0);
+	glBindBuffer(buffer.target, buffer.name);
+	glBufferSubData(buffer.target, offset, size, data);
+	glBindBuffer(buffer.target, 0);
+}
+
+void GLRenderDevice::destroyBuffer(BufferHandle handle)
+{
+	if (!handle.valid())
+		return;
+	glDeleteBuffers(1, &buffers[handle.id - 1].name); // Deleting name 0 is a no-op, so double destroys are harmless.
+	buffers[handle.id - 1].name = 0;
+}
+
+TextureHandle GLRenderDevice::createTexture(const TextureDesc& desc)
+{
+	GLTexture texture;
+	texture.target = desc.layers > 1 || desc.array ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+	GLint internalFormat;
+	GLenum pixelFormat, type;
+	textureFormat(desc.format, internalFormat, pixelFormat, type);
+
+	glGenTextures(1, &texture.name);
+	glBindTexture(texture.target, texture.name);
+	if (texture.target == GL_TEXTURE_2D_ARRAY)
+		glTexImage3D(texture.target, 0, internalFormat, desc.width, desc.height, desc.layers, 0, pixelFormat, type, desc.initialData);
+	else
+		glTexImage2D(texture.target, 0, internalFormat, desc.width, desc.height, 0, pixelFormat, type, desc.initialData);
+	if (desc.generateMipmaps)
+		glGenerateMipmap(texture.target);
+	GLint magFilter = desc.linearFilter ? GL_LINEAR : GL_NEAREST;
+	GLint minFilter = desc.generateMipmaps ? (desc.linearFilter ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_NEAREST) : magFilter;
+	glTexParameteri(texture.target, GL_TEXTURE_MIN_FILTER, minFilter);
+	glTexParameteri(texture.target, GL_TEXTURE_MAG_FILTER, magFilter);
+	glTexParameteri(texture.target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(texture.target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glBindTexture(texture.target, 0);
+
+	textures.push_back(texture);
+	return TextureHandle{ (uint32_t)textures.size() };
+}
+
+void GLRenderDevice::destroyTexture(TextureHandle handle)
+{
+	if (!handle.valid())
+		return;
+	GLTexture& texture = textures[handle.id - 1];
+	if (texture.bindlessHandle != 0)
+		glMakeTextureHandleNonResidentARB(texture.bindlessHandle); // The texture cannot be deleted while resident.
+	glDeleteTextures(1, &texture.name);
+	texture.name = 0;
+	texture.bindlessHandle = 0;
+}
+
+PipelineHandle GLRenderDevice::createPipeline(const PipelineDesc& desc)
+{
+	if (!desc.vertexSource || !desc.fragmentSource) {
+		cout << "ERROR::RENDER_DEVICE::MISSING_GLSL_SOURCE" << endl;
+		return PipelineHandle();
+	}
+
+	GLPipeline pipeline;
+	pipeline.desc = desc;
+	pipeline.program = compileShaderProgram(desc.vertexSource, desc.fragmentSource);
+	GLint linked;
+	glGetProgramiv(pipeline.program, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		glDeleteProgram(pipeline.program);
+		return PipelineHandle();
+	}
+
+	// Resolve the fixed-function state once; binding the pipeline then only compares enums.
+	pipeline.state.blend = desc.blend != BlendMode::Opaque;
+	if (desc.blend == BlendMode::Alpha) {
+		pipeline.state.blendSource = GL_SRC_ALPHA;
+		pipeline.state.blendDestination = GL_ONE_MINUS_SRC_ALPHA;
+	} else if (desc.blend == BlendMode::Additive) {
+		pipeline.state.blendSource = GL_ONE;
+		pipeline.state.blendDestination = GL_ONE;
+	}
+	pipeline.state.depthTest = desc.depthTest;
+	pipeline.state.depthWrite = desc.depthWrite;
+	pipeline.state.depthFunc = depthFunction(desc.depthCompare);
+	pipeline.state.colorWrite = desc.colorWrite;
+	pipeline.state.polygonMode = desc.wireframe ? GL_LINE : GL_FILL;
+	pipeline.topology = desc.topology == PrimitiveTopology::TriangleStrip ? GL_TRIANGLE_STRIP : GL_TRIANGLES;
+
+	// Per-draw constants always come from uniform block binding 0; bindUniformBuffer slots from 1 up.
+	GLuint constantsBlock = glGetUniformBlockIndex(pipeline.program, "Constants");
+	if (constantsBlock != GL_INVALID_INDEX)
+		glUniformBlockBinding(pipeline.program, constantsBlock, 0);
+	for (int slot = 0; slot < PipelineDesc::MaxUniformBlocks; slot++) {
+		if (!desc.uniformBlocks[slot])
+			continue;
+		GLuint block = glGetUniformBlockIndex(pipeline.program, desc.uniformBlocks[slot]);
+		if (block != GL_INVALID_INDEX)
+			glUniformBlockBinding(pipeline.program, block, slot + 1);
+		else
+			cout << "ERROR::RENDER_DEVICE::UNIFORM_BLOCK_NOT_FOUND\n" << desc.uniformBlocks[slot] << endl;
+	}
+
+	// The vertex array holds the attribute enables and divisors; pointers are set when buffers are bound.
+	glGenVertexArrays(1, &pipeline.vertexArray);
+	glBindVertexArray(pipeline.vertexArray);
+	for (uint32_t i = 0; i < desc.layout.attributeCount; i++) {
+		const VertexAttribute& attribute = desc.layout.attributes[i];
+		glEnableVertexAttribArray(attribute.location);
+		glVertexAttribDivisor(attribute.location, attribute.binding == 1 ? 1 : 0);
+	}
+	glBindVertexArray(0);
+
+	pipelines.push_back(pipeline);
+	return PipelineHandle{ (uint32_t)pipelines.size() };
+}
+
+void GLRenderDevice::destroyPipeline(PipelineHandle handle)
+{
+	if (!handle.valid())
+		return;
+	GLPipeline& pipeline = pipelines[handle.id - 1];
+	if (current.program == pipeline.program || current.vertexArray == pipeline.vertexArray)
+		current.known = false; // GL may reuse the names.
+	glDeleteProgram(pipeline.program);
+	glDeleteVertexArrays(1, &pipeline.vertexArray);
+	pipeline.program = pipeline.vertexArray = 0;
+}
+
+SamplerHandle GLRenderDevice::createSamplerObject(const SamplerDesc& desc)
+{
+	GLuint sampler;
+	glGenSamplers(1, &sampler);
+	GLint magFilter = desc.magFilter == SamplerFilter::Linear ? GL_LINEAR : GL_NEAREST;
+	GLint minFilter = desc.minFilter == SamplerFilter::Linear
+		? (desc.mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR)
+		: (desc.mipmaps ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
+	glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, minFilter);
+	glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, magFilter);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, samplerWrap(desc.wrapU));
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, samplerWrap(desc.wrapV));
+	if (desc.maxAnisotropy > 1.0f && GLEW_EXT_texture_filter_anisotropic) {
+		GLfloat maxSupported = 1.0f;
+		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxSupported);
+		glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, desc.maxAnisotropy < maxSupported ? desc.maxAnisotropy : maxSupported);
+	}
+	samplers.push_back(sampler);
+	return SamplerHandle{ (uint32_t)samplers.size() };
+}
+
+CommandList* GLRenderDevice::createCommandList()
+{
+	commandLists.emplace_back(new GLCommandList());
+	return commandLists.back().get();
+}
+
+#pragma endregion
+
+#pragma region Frames
+
+void GLRenderDevice::beginFrame(int width, int height, const float clearColor[4])
+{
+	glViewport(0, 0, width, height);
+	glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]); // Set the clear colour.
+	glDepthMask(GL_TRUE); // Depth writes must be on for the clear to reach the depth buffer.
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT); // Clear the buffers.
+}
+
+void GLRenderDevice::submit(CommandList* const* lists, size_t count)
+{
+	current = GLStateShadow(); // Raw GL code may have run since the last submit.
+	for (size_t i = 0; i < count; i++)
+		execute(*static_cast<GLCommandList*>(lists[i]));
+
+	// Leave the context the way raw GL code expects to find it (only what the lists actually changed).
+	for (uint32_t unit = 0; unit < GLStateShadow::TextureUnits; unit++) {
+		if (current.samplers[unit] != 0)
+			glBindSampler(unit, 0); // Raw GL code relies on the textures' own parameters.
+	}
+	if (!current.known || current.vertexArray != 0)
+		glBindVertexArray(0);
+	if (!current.known || current.program != 0)
+		glUseProgram(0);
+	if (current.depthFuncKnown && current.state.depthFunc != GL_LESS)
+		glDepthFunc(GL_LESS); // Not covered below, since the default state has depth testing off.
+	if (current.blendFuncKnown && (current.state.blendSource != GL_ONE || current.state.blendDestination != GL_ZERO))
+		glBlendFunc(GL_ONE, GL_ZERO);
+	applyFixedState(GLFixedState());
+	current = GLStateShadow();
+}
+
+void GLRenderDevice::endFrame()
+{
+}
+
+bool GLRenderDevice::readPixels(int x, int y, int width, int height, void* rgba)
+{
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+	return glGetError() == GL_NO_ERROR;
+}
+
+bool GLRenderDevice::supportsBindless() const
+{
+	return GLEW_ARB_bindless_texture != GL_FALSE;
+}
+
+GLuint64 GLRenderDevice::getBindlessHandle(TextureHandle handle)
+{
+	if (!handle.valid() || !supportsBindless())
+		return 0;
+	GLTexture& texture = textures[handle.id - 1];
+	if (texture.bindlessHandle == 0) { // The texture's sampling state is frozen from here on.
+		texture.bindlessHandle = glGetTextureHandleARB(texture.name);
+		glMakeTextureHandleResidentARB(texture.bindlessHandle);
+	}
+	return texture.bindlessHandle;
+}
+
+GLintptr GLRenderDevice::writeConstants(const void* data, size_t size)
+{
+	if (constantsOffset + (GLintptr)size > ConstantsBufferSize) { // Wrap: orphan so in-flight draws keep their data.
+		glBufferData(GL_UNIFORM_BUFFER, ConstantsBufferSize, NULL, GL_STREAM_DRAW);
+		constantsOffset = 0;
+	}
+	GLintptr offset = constantsOffset;
+	glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+	constantsOffset = (offset + (GLintptr)size + constantsAlignment - 1) / constantsAlignment * constantsAlignment;
+	return offset;
+}
+
+void GLRenderDevice::applyPipeline(const GLPipeline& pipeline)
+{
+	stats.pipelineBinds++;
+	if (current.known && current.program == pipeline.program) {
+		stats.stateChangesSkipped++;
+	} else {
+		glUseProgram(pipeline.program);
+		current.program = pipeline.program;
+		stats.stateChanges++;
+	}
+	if (current.known && current.vertexArray == pipeline.vertexArray) {
+		stats.stateChangesSkipped++;
+	} else {
+		glBindVertexArray(pipeline.vertexArray);
+		current.vertexArray = pipeline.vertexArray;
+		stats.stateChanges++;
+	}
+	applyFixedState(pipeline.state);
+	current.known = true;
+}
+
+void GLRenderDevice::applyFixedState(const GLFixedState& state)
+{
+	// Emit a GL call only where the wanted state differs from the shadow (or the shadow is unknown).
+	GLFixedState& shadow = current.state;
+	bool known = current.known;
+	if (!known || shadow.blend != state.blend) {
+		if (state.blend)
+			glEnable(GL_BLEND);
+		else
+			glDisable(GL_BLEND);
+		shadow.blend = state.blend;
+		stats.stateChanges++;
+	} else {
+		stats.stateChangesSkipped++;
+	}
+	if (state.blend) { // The blend function is irrelevant while blending is off.
+		if (!known || !current.blendFuncKnown || shadow.blendSource != state.blendSource || shadow.blendDestination != state.blendDestination) {
+			glBlendFunc(state.blendSource, state.blendDestination);
+			shadow.blendSource = state.blendSource;
+			shadow.blendDestination = state.blendDestination;
+			current.blendFuncKnown = true;
+			stats.stateChanges++;
+		} else {
+			stats.stateChangesSkipped++;
+		}
+	}
+	if (!known || shadow.depthTest != state.depthTest) {
+		if (state.depthTest)
+			glEnable(GL_DEPTH_TEST);
+		else
+			glDisable(GL_DEPTH_TEST);
+		shadow.depthTest = state.depthTest;
+		stats.stateChanges++;
+	} else {
+		stats.stateChangesSkipped++;
+	}
+	if (!known || shadow.depthWrite != state.depthWrite) {
+		glDepthMask(state.depthWrite ? GL_TRUE : GL_FALSE);
+		shadow.depthWrite = state.depthWrite;
+		stats.stateChanges++;
+	} else {
+		stats.stateChangesSkipped++;
+	}
+	if (state.depthTest) { // The depth function is irrelevant while testing is off.
+		if (!known || !current.depthFuncKnown || shadow.depthFunc != state.depthFunc) {
+			glDepthFunc(state.depthFunc);
+			shadow.depthFunc = state.depthFunc;
+			current.depthFuncKnown = true;
+			stats.stateChanges++;
+		} else {
+			stats.stateChangesSkipped++;
+		}
+	}
+	if (!known || shadow.colorWrite != state.colorWrite) {
+		GLboolean write = state.colorWrite ? GL_TRUE : GL_FALSE;
+		glColorMask(write, write, write, write);
+		shadow.colorWrite = state.colorWrite;
+		stats.stateChanges++;
+	} else {
+		stats.stateChangesSkipped++;
+	}
+	if (!known || shadow.polygonMode != state.polygonMode) {
+		glPolygonMode(GL_FRONT_AND_BACK, state.polygonMode);
+		shadow.polygonMode = state.polygonMode;
+		stats.stateChanges++;
+	} else {
+		stats.stateChangesSkipped++;
+	}
+}
+
+void GLRenderDevice::execute(const GLCommandList& list)
+{
+	GLPipeline* pipeline = nullptr;
+	GLenum topology = GL_TRIANGLES;
+	glBindBuffer(GL_UNIFORM_BUFFER, constantsBuffer);
+
+	for (const GLCommandList::Command& command : list.commands) {
+		switch (command.op)
+		{
+		case GLCommandList::Op::BindPipeline:
+			pipeline = &pipelines[command.a - 1];
+			topology = pipeline->topology;
+			applyPipeline(*pipeline);
+			break;
+
+		case GLCommandList::Op::BindVertexBuffer: {
+			if (!pipeline || command.a > 1)
+				break;
+			if (pipeline->vertexBuffers[command.a] == command.b && pipeline->vertexOffsets[command.a] == command.offset) {
+				stats.stateChangesSkipped++; // The vertex array already points there.
+				break;
+			}
+			pipeline->vertexBuffers[command.a] = command.b;
+			pipeline->vertexOffsets[command.a] = command.offset;
+			stats.bufferBinds++;
+			const VertexLayout& layout = pipeline->desc.layout;
+			glBindBuffer(GL_ARRAY_BUFFER, buffers[command.b - 1].name);
+			for (uint32_t i = 0; i < layout.attributeCount; i++) { // Point every attribute of this binding at the buffer.
+				const VertexAttribute& attribute = layout.attributes[i];
+				if (attribute.binding == command.a)
+					glVertexAttribPointer(attribute.location, attribute.components, GL_FLOAT, GL_FALSE, layout.strides[attribute.binding], (GLvoid*)(command.offset + attribute.offset));
+			}
+			break;
+		}
+
+		case GLCommandList::Op::BindIndexBuffer:
+			if (!pipeline)
+				break;
+			if (pipeline->indexBuffer == command.a) {
+				stats.stateChangesSkipped++;
+				break;
+			}
+			pipeline->indexBuffer = command.a;
+			stats.bufferBinds++;
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[command.a - 1].name); // Recorded in the bound VAO.
+			break;
+
+		case GLCommandList::Op::BindTexture: {
+			if (command.b == 0)
+				break;
+			uint32_t unit = command.a;
+			bool shadowed = unit < GLStateShadow::TextureUnits;
+			const GLTexture& texture = textures[command.b - 1];
+			if (shadowed && current.textures[unit] == texture.name) {
+				stats.stateChangesSkipped++;
+			} else {
+				glActiveTexture(GL_TEXTURE0 + unit);
+				glBindTexture(texture.target, texture.name);
+				glActiveTexture(GL_TEXTURE0);
+				if (shadowed)
+					current.textures[unit] = texture.name;
+				stats.textureBinds++;
+			}
+			GLuint sampler = command.c != 0 ? samplers[command.c - 1] : 0;
+			if (shadowed && current.samplers[unit] == sampler) {
+				stats.stateChangesSkipped++;
+			} else {
+				glBindSampler(unit, sampler);
+				if (shadowed)
+					current.samplers[unit] = sampler;
+				stats.samplerBinds++;
+			}
+			break;
+		}
+
+		case GLCommandList::Op::BindUniformBuffer:
+			if (command.a >= PipelineDesc::MaxUniformBlocks || command.b == 0)
+				break;
+			glBindBufferBase(GL_UNIFORM_BUFFER, command.a + 1, buffers[command.b - 1].name);
+			glBindBuffer(GL_UNIFORM_BUFFER, constantsBuffer); // glBindBufferBase also moved the generic binding.
+			stats.bufferBinds++;
+			break;
+
+		case GLCommandList::Op::SetConstants: {
+			GLintptr offset = writeConstants(list.constants.data() + command.offset, command.a);
+			glBindBufferRange(GL_UNIFORM_BUFFER, 0, constantsBuffer, offset, command.a);
+			break;
+		}
+
+		case GLCommandList::Op::Draw:
+			glDrawArraysInstanced(topology, command.c, command.a, command.b);
+			stats.drawCalls++;
+			break;
+
+		case GLCommandList::Op::DrawIndexed:
+			glDrawElementsInstanced(topology, command.a, GL_UNSIGNED_INT, (GLvoid*)(command.c * sizeof(GLuint)), command.b);
+			stats.drawCalls++;
+			break;
+		}
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+#pragma endregion
@@ -0,0 +1,117 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <memory> // Import unique_ptr.
+#include <vector> // Import the vector container.
+
+#include "Graphics.h" // Import GLEW and GLFW.
+#include "RenderDevice.h" // Import the render device interface.
+
+#pragma endregion
+
+// The GL 3.3 backend of RenderDevice: the engine's existing GL path behind the device interface.
+//
+// Command lists record into plain memory (so they can be recorded on any thread) and are replayed with GL calls
+// by submit() on the thread that owns the context. Per-draw constants are written to a ring of uniform buffer
+// memory and bound to uniform block binding 0 with glBindBufferRange.
+//
+// Pipelines are resolved into GL enums once, at creation. The device shadows the GL state it has set, so binding a
+// pipeline only emits the calls that differ from the current state; each pipeline's vertex array also remembers
+// which buffers it points at, so rebinding the same buffer is free. The shadow is discarded at the start of every
+// submit(), because raw GL code (the transparency pass) may have changed state in between.
+class GLRenderDevice : public RenderDevice
+{
+public:
+	GLRenderDevice();
+	~GLRenderDevice() override;
+
+	const char* getBackendName() const override { return "OpenGL 3.3"; }
+
+	BufferHandle createBuffer(const BufferDesc& desc) override;
+	void updateBuffer(BufferHandle buffer, size_t offset, const void* data, size_t size) override;
+	void destroyBuffer(BufferHandle buffer) override;
+
+	TextureHandle createTexture(const TextureDesc& desc) override;
+	void destroyTexture(TextureHandle texture) override;
+
+	PipelineHandle createPipeline(const PipelineDesc& desc) override;
+	void destroyPipeline(PipelineHandle pipeline) override;
+
+	CommandList* createCommandList() override;
+
+	void beginFrame(int width, int height, const float clearColor[4]) override;
+	void submit(CommandList* const* lists, size_t count) override;
+	void endFrame() override;
+	bool readPixels(int x, int y, int width, int height, void* rgba) override;
+
+	// GL names, for code that still mixes raw GL with the device.
+	GLuint getGLBuffer(BufferHandle buffer) const { return buffer.valid() ? buffers[buffer.id - 1].name : 0; }
+	GLuint getGLTexture(TextureHandle texture) const { return texture.valid() ? textures[texture.id - 1].name : 0; }
+	GLuint getGLProgram(PipelineHandle pipeline) const { return pipeline.valid() ? pipelines[pipeline.id - 1].program : 0; }
+
+	// ARB_bindless_texture: a resident 64-bit handle shaders can sample without any bind. Returns 0 if unsupported.
+	bool supportsBindless() const;
+	GLuint64 getBindlessHandle(TextureHandle texture);
+
+protected:
+	SamplerHandle createSamplerObject(const SamplerDesc& desc) override;
+
+private:
+	struct GLBuffer { GLuint name = 0; GLenum target = GL_ARRAY_BUFFER; size_t size = 0; };
+	struct GLTexture { GLuint name = 0; GLenum target = GL_TEXTURE_2D; GLuint64 bindlessHandle = 0; };
+	// Fixed-function state in GL terms.
+	struct GLFixedState
+	{
+		bool blend = false;
+		GLenum blendSource = GL_ONE, blendDestination = GL_ZERO;
+		bool depthTest = false;
+		bool depthWrite = true;
+		GLenum depthFunc = GL_LESS;
+		bool colorWrite = true;
+		GLenum polygonMode = GL_FILL;
+	};
+	struct GLPipeline
+	{
+		GLuint program = 0;
+		GLuint vertexArray = 0;
+		PipelineDesc desc;
+		GLFixedState state; // Resolved from desc at creation.
+		GLenum topology = GL_TRIANGLES;
+		// What the vertex array currently points at (0: nothing yet).
+		uint32_t vertexBuffers[2] = { 0, 0 };
+		size_t vertexOffsets[2] = { 0, 0 };
+		uint32_t indexBuffer = 0;
+	};
+	// The GL state last set by the device. Unknown state is always re-emitted.
+	struct GLStateShadow
+	{
+		bool known = false;
+		GLuint program = 0;
+		GLuint vertexArray = 0;
+		GLFixedState state;
+		bool blendFuncKnown = false, depthFuncKnown = false; // Only set while blending or depth testing is on.
+		static const uint32_t TextureUnits = 16;
+		GLuint textures[TextureUnits] = {}; // 0: unknown.
+		GLuint samplers[TextureUnits] = {}; // 0: none (raw GL code never binds sampler objects).
+	};
+
+	friend class GLCommandList;
+	void execute(const class GLCommandList& list);
+	void applyPipeline(const GLPipeline& pipeline);
+	void applyFixedState(const GLFixedState& state);
+	GLintptr writeConstants(const void* data, size_t size);
+
+	std::vector<GLBuffer> buffers;
+	std::vector<GLTexture> textures;
+	std::vector<GLPipeline> pipelines;
+	std::vector<GLuint> samplers;
+	std::vector<std::unique_ptr<CommandList>> commandLists;
+	GLStateShadow current;
+
+	// Ring of uniform memory for setConstants.
+	GLuint constantsBuffer = 0;
+	GLintptr constantsOffset = 0;
+	GLint constantsAlignment = 256;
+	static const GLsizeiptr ConstantsBufferSize = 256 * 1024;
+};
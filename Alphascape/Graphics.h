@@ -0,0 +1,13 @@
+#pragma once
+
+// Shared graphics imports: every module that talks to OpenGL or GLFW includes this header,
+// so GLEW is always configured the same way as in main.cpp.
+
+// Define and import GLEW, the extension management system.
+#ifndef GLEW_STATIC
+#define GLEW_STATIC // Use GLEW statically.
+#endif
+#include <GL/glew.h> // Import the GLEW library.
+
+// Import GLFW, the modern window management system.
+#include <GLFW/glfw3.h> // Import the GLFW library.
@@ -0,0 +1,560 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import max.
+#include <chrono> // Import the durations, for polling bakes.
+#include <cmath> // Import the C maths libraries.
+#include <cstring> // Import memcpy.
+#include <iostream> // Import the IO stream libraries.
+#include <random> // Import the random number generators.
+#include <string> // Import the string class.
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "GLRenderDevice.h" // Import the GL render device.
+#include "Impostor.h" // Import the impostor renderer.
+#include "Math3D.h" // Import the vector and matrix maths.
+#include "SoftwareRasterizer.h" // Import the CPU rasterizer, for baking.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Helpers
+
+// The light both the bake and the near geometry are shaded with, so impostors match the meshes they replace.
+static const float lightDirection[3] = { 0.424f, 0.848f, 0.318f };
+static const float ambientLight = 0.35f;
+
+// How much larger than the bounding sphere each frame is, so mip levels average in empty space, not the next frame.
+static const float frameMargin = 1.1f;
+
+// The unit direction octahedrally encoded (around the y axis) at (u, v) in [-1, 1]^2; the inverse of octEncode in the
+// billboard shader.
+static Vec3 octahedralDecode(float u, float v)
+{
+	Vec3 d(u, 1.0f - fabs(u) - fabs(v), v);
+	if (d.y < 0.0f) {
+		d.x = (1.0f - fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+		d.z = (1.0f - fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+	}
+	return normalize(d);
+}
+
+// The billboard's axes for a view from direction (pointing at the viewer). Must match the shader.
+static void billboardBasis(const Vec3& direction, Vec3& right, Vec3& up)
+{
+	Vec3 worldUp = fabs(direction.y) > 0.999f ? Vec3(0.0f, 0.0f, 1.0f) : Vec3(0.0f, 1.0f, 0.0f);
+	right = normalize(cross(worldUp, direction));
+	up = cross(direction, right);
+}
+
+// The centre of the mesh's bounding box and the radius around it that contains every vertex.
+static void boundingSphere(const ImpostorMesh& mesh, float center[3], float& radius)
+{
+	Vec3 low(1e30f, 1e30f, 1e30f), high(-1e30f, -1e30f, -1e30f);
+	for (size_t i = 0; i + 5 < mesh.vertices.size(); i += 6) {
+		low = Vec3(min(low.x, mesh.vertices[i]), min(low.y, mesh.vertices[i + 1]), min(low.z, mesh.vertices[i + 2]));
+		high = Vec3(max(high.x, mesh.vertices[i]), max(high.y, mesh.vertices[i + 1]), max(high.z, mesh.vertices[i + 2]));
+	}
+	Vec3 middle = (low + high) * 0.5f;
+	radius = 0.0f;
+	for (size_t i = 0; i + 5 < mesh.vertices.size(); i += 6)
+		radius = max(radius, length(Vec3(&mesh.vertices[i]) - middle));
+	center[0] = middle.x;
+	center[1] = middle.y;
+	center[2] = middle.z;
+}
+
+#pragma endregion
+
+#pragma region Baking
+
+struct BakeUniforms
+{
+	Vec3 right, up, direction; // The frame's view: direction points at the viewer.
+	Vec3 center;
+	float inverseRadius;
+	float frameX, frameY, frames;
+	float color[3];
+};
+
+// Project onto the frame's axes, then into the frame's cell of the atlas. Rows are flipped so that the colour
+// buffer (row 0 at the top) uploads with row 0 at t = 0.
+static void bakeVertexStage(const float* attributes, const void* uniforms, SoftwareVertex& out)
+{
+	const BakeUniforms& bake = *(const BakeUniforms*)uniforms;
+	Vec3 position = Vec3(attributes) - bake.center;
+	float x = dot(position, bake.right) * bake.inverseRadius;
+	float y = dot(position, bake.up) * bake.inverseRadius;
+	float z = dot(position, bake.direction) * bake.inverseRadius;
+	out.position[0] = (bake.frameX + x * 0.5f + 0.5f) / bake.frames * 2.0f - 1.0f;
+	out.position[1] = 1.0f - (bake.frameY + y * 0.5f + 0.5f) / bake.frames * 2.0f;
+	out.position[2] = -z; // Nearer the viewer is smaller depth.
+	out.position[3] = 1.0f;
+	for (int i = 0; i < 3; i++)
+		out.varyings[i] = attributes[3 + i]; // The normal.
+}
+
+// The same shading as meshFragmentShaderSource.
+static void bakeFragmentStage(const float* varyings, const void* uniforms, float outColor[4])
+{
+	const BakeUniforms& bake = *(const BakeUniforms*)uniforms;
+	float diffuse = max(dot(normalize(Vec3(varyings)), Vec3(lightDirection)), 0.0f);
+	float light = ambientLight + (1.0f - ambientLight) * diffuse;
+	for (int i = 0; i < 3; i++)
+		outColor[i] = bake.color[i] * light;
+	outColor[3] = 1.0f;
+}
+
+ImpostorAtlasImage bakeImpostorAtlas(const ImpostorMesh& mesh, int frames, int frameSize)
+{
+	ImpostorAtlasImage image;
+	image.frames = frames;
+	image.frameSize = frameSize;
+	boundingSphere(mesh, image.center, image.radius);
+	image.radius *= frameMargin;
+
+	int size = frames * frameSize;
+	SoftwareRasterizer rasterizer(size, size, 1); // One thread: baking runs beside the frame, not instead of it.
+	const float transparent[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	rasterizer.clear(transparent);
+
+	// One draw per frame; the uniforms must outlive the flush.
+	vector<BakeUniforms> views((size_t)frames * frames);
+	for (int j = 0; j < frames; j++) {
+		for (int i = 0; i < frames; i++) {
+			BakeUniforms& view = views[(size_t)j * frames + i];
+			float step = frames > 1 ? 2.0f / (frames - 1) : 0.0f;
+			view.direction = octahedralDecode(i * step - 1.0f, j * step - 1.0f);
+			billboardBasis(view.direction, view.right, view.up);
+			view.center = Vec3(image.center);
+			view.inverseRadius = 1.0f / image.radius;
+			view.frameX = (float)i;
+			view.frameY = (float)j;
+			view.frames = (float)frames;
+			memcpy(view.color, mesh.color, sizeof(view.color));
+
+			SoftwareDrawCall draw;
+			draw.vertices = mesh.vertices.data();
+			draw.vertexStride = 6;
+			draw.vertexCount = (unsigned int)(mesh.vertices.size() / 6);
+			draw.indices = mesh.indices.data();
+			draw.indexCount = (unsigned int)mesh.indices.size();
+			draw.vertexStage = bakeVertexStage;
+			draw.fragmentStage = bakeFragmentStage;
+			draw.uniforms = &view;
+			draw.varyingCount = 3;
+			rasterizer.drawIndexed(draw);
+		}
+	}
+	rasterizer.flush();
+
+	// The colour buffer is RGBA8 with red in the lowest byte, so its rows copy straight out.
+	image.rgba.resize((size_t)size * size * 4);
+	for (int row = 0; row < size; row++)
+		memcpy(&image.rgba[(size_t)row * size * 4], rasterizer.getColorBuffer() + (size_t)row * rasterizer.getPitch(), (size_t)size * 4);
+	return image;
+}
+
+#pragma endregion
+
+#pragma region Shaders
+
+static const GLchar* meshVertexShaderSource =
+"#version 330 core\n"
+"layout(std140) uniform Constants { mat4 viewProjection; vec4 color; };\n"
+"layout(location = 0) in vec3 position;\n"
+"layout(location = 1) in vec3 normal;\n"
+"layout(location = 2) in vec4 instance;\n" // Translation and scale.
+"out vec3 worldNormal;\n"
+"void main()\n"
+"{\n"
+"worldNormal = normal;\n"
+"gl_Position = viewProjection * vec4(instance.xyz + position * instance.w, 1.0);\n"
+"}\n\0";
+static const GLchar* meshFragmentShaderSource =
+"#version 330 core\n"
+"layout(std140) uniform Constants { mat4 viewProjection; vec4 color; };\n"
+"in vec3 worldNormal;\n"
+"out vec4 fragmentColor;\n"
+"void main()\n"
+"{\n"
+"float diffuse = max(dot(normalize(worldNormal), vec3(0.424, 0.848, 0.318)), 0.0);\n"
+"fragmentColor = vec4(color.rgb * (0.35 + 0.65 * diffuse), 1.0);\n"
+"}\n\0";
+
+// Pick the frame baked nearest to the direction of the camera and face the camera with it.
+static const GLchar* billboardVertexShaderSource =
+"#version 330 core\n"
+"layout(std140) uniform Constants { mat4 viewProjection; vec4 cameraPosition; vec4 sphere; vec4 atlasFrames; };\n"
+"layout(location = 0) in vec2 corner;\n"
+"layout(location = 2) in vec4 instance;\n"
+"out vec2 uv;\n"
+"vec2 octEncode(vec3 d)\n"
+"{\n"
+"d /= abs(d.x) + abs(d.y) + abs(d.z);\n"
+"if (d.y >= 0.0) return d.xz;\n"
+"return (1.0 - abs(d.zx)) * vec2(d.x >= 0.0 ? 1.0 : -1.0, d.z >= 0.0 ? 1.0 : -1.0);\n"
+"}\n"
+"void main()\n"
+"{\n"
+"vec3 center = instance.xyz + sphere.xyz * instance.w;\n"
+"vec3 direction = normalize(cameraPosition.xyz - center);\n"
+"float frames = atlasFrames.x;\n"
+"vec2 frame = floor((octEncode(direction) * 0.5 + 0.5) * (frames - 1.0) + 0.5);\n"
+"vec3 worldUp = abs(direction.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);\n"
+"vec3 right = normalize(cross(worldUp, direction));\n"
+"vec3 up = cross(direction, right);\n"
+"uv = (frame + corner * 0.5 + 0.5) / frames;\n"
+"gl_Position = viewProjection * vec4(center + (right * corner.x + up * corner.y) * sphere.w * instance.w, 1.0);\n"
+"}\n\0";
+static const GLchar* billboardFragmentShaderSource =
+"#version 330 core\n"
+"uniform sampler2D impostorAtlas;\n"
+"in vec2 uv;\n"
+"out vec4 fragmentColor;\n"
+"void main()\n"
+"{\n"
+"vec4 texel = texture(impostorAtlas, uv);\n"
+"if (texel.a < 0.5) discard;\n" // Alpha tested, so impostors stay opaque and depth sorted.
+"fragmentColor = vec4(texel.rgb, 1.0);\n"
+"}\n\0";
+
+#pragma endregion
+
+#pragma region Impostor Renderer
+
+ImpostorRenderer::ImpostorRenderer(RenderDevice& renderDevice) : device(renderDevice)
+{
+}
+
+ImpostorRenderer::~ImpostorRenderer()
+{
+	for (unique_ptr<Mesh>& mesh : meshes) {
+		if (mesh->bake.valid())
+			mesh->bake.wait(); // The bake reads nothing of ours, but must not outlive the process's teardown.
+		device.destroyBuffer(mesh->vertexBuffer);
+		device.destroyBuffer(mesh->indexBuffer);
+		device.destroyBuffer(mesh->nearInstances.buffer);
+		device.destroyBuffer(mesh->farInstances.buffer);
+		device.destroyTexture(mesh->atlas);
+	}
+	device.destroyBuffer(quadBuffer);
+	device.destroyPipeline(meshPipeline);
+	device.destroyPipeline(billboardPipeline);
+}
+
+bool ImpostorRenderer::init()
+{
+	PipelineDesc meshDesc;
+	meshDesc.vertexSource = meshVertexShaderSource;
+	meshDesc.fragmentSource = meshFragmentShaderSource;
+	meshDesc.layout.add(0, 3, 0, 0).add(1, 3, 0, 3 * sizeof(float)).add(2, 4, 1, 0);
+	meshDesc.layout.strides[0] = 6 * sizeof(float);
+	meshDesc.layout.strides[1] = sizeof(ImpostorInstance);
+	meshDesc.depthTest = true;
+	meshDesc.depthWrite = true;
+	meshPipeline = device.createPipeline(meshDesc);
+
+	PipelineDesc billboardDesc = meshDesc;
+	billboardDesc.vertexSource = billboardVertexShaderSource;
+	billboardDesc.fragmentSource = billboardFragmentShaderSource;
+	billboardDesc.layout = VertexLayout();
+	billboardDesc.layout.add(0, 2, 0, 0).add(2, 4, 1, 0);
+	billboardDesc.layout.strides[0] = 2 * sizeof(float);
+	billboardDesc.layout.strides[1] = sizeof(ImpostorInstance);
+	billboardDesc.topology = PrimitiveTopology::TriangleStrip;
+	billboardPipeline = device.createPipeline(billboardDesc);
+	if (!meshPipeline.valid() || !billboardPipeline.valid())
+		return false;
+
+	const float corners[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+	BufferDesc quadDesc;
+	quadDesc.size = sizeof(corners);
+	quadDesc.initialData = corners;
+	quadBuffer = device.createBuffer(quadDesc);
+
+	// Trilinear and clamped: far impostors are heavily minified, and frames must not wrap into each other.
+	SamplerDesc samplerDesc;
+	samplerDesc.mipmaps = true;
+	samplerDesc.wrapU = samplerDesc.wrapV = SamplerWrap::ClampToEdge;
+	atlasSampler = device.getSampler(samplerDesc);
+	return true;
+}
+
+uint32_t ImpostorRenderer::addMesh(const ImpostorMesh& source, int frames, int frameSize)
+{
+	unique_ptr<Mesh> mesh(new Mesh());
+	BufferDesc vertexDesc;
+	vertexDesc.size = source.vertices.size() * sizeof(float);
+	vertexDesc.initialData = source.vertices.data();
+	mesh->vertexBuffer = device.createBuffer(vertexDesc);
+	BufferDesc indexDesc;
+	indexDesc.usage = BufferUsage::Index;
+	indexDesc.size = source.indices.size() * sizeof(uint32_t);
+	indexDesc.initialData = source.indices.data();
+	mesh->indexBuffer = device.createBuffer(indexDesc);
+	mesh->indexCount = (uint32_t)source.indices.size();
+	memcpy(mesh->color, source.color, sizeof(mesh->color));
+
+	// The bake gets its own copy of the mesh, so the caller's may go away.
+	mesh->bake = async(launch::async, [source, frames, frameSize]() { return bakeImpostorAtlas(source, frames, frameSize); });
+	meshes.push_back(move(mesh));
+	return (uint32_t)meshes.size() - 1;
+}
+
+void ImpostorRenderer::update()
+{
+	for (unique_ptr<Mesh>& mesh : meshes) {
+		if (!mesh->bake.valid() || mesh->bake.wait_for(chrono::seconds(0)) != future_status::ready)
+			continue;
+		ImpostorAtlasImage image = mesh->bake.get();
+		TextureDesc desc;
+		desc.width = desc.height = image.frames * image.frameSize;
+		desc.initialData = image.rgba.data();
+		desc.generateMipmaps = true;
+		mesh->atlas = device.createTexture(desc);
+		if (!mesh->atlas.valid()) {
+			cout << "ERROR::IMPOSTOR::ATLAS_UPLOAD_FAILED\n" << desc.width << " x " << desc.height << endl;
+			mesh->bakeFailed = true;
+			continue;
+		}
+		memcpy(mesh->center, image.center, sizeof(mesh->center));
+		mesh->radius = image.radius;
+		mesh->frames = image.frames;
+	}
+}
+
+bool ImpostorRenderer::isBaked(uint32_t mesh) const
+{
+	return mesh < meshes.size() && meshes[mesh]->atlas.valid();
+}
+
+bool ImpostorRenderer::hasBakeFailed(uint32_t mesh) const
+{
+	return mesh < meshes.size() && meshes[mesh]->bakeFailed;
+}
+
+void ImpostorRenderer::prepare(uint32_t meshIndex, const vector<ImpostorInstance>& instances, const ImpostorView& view)
+{
+	if (meshIndex >= meshes.size())
+		return;
+	Mesh& mesh = *meshes[meshIndex];
+
+	// Classify by the distance to each instance's bounding sphere centre; without an atlas, everything is near.
+	nearScratch.clear();
+	farScratch.clear();
+	float thresholdSquared = mesh.atlas.valid() ? view.impostorDistance * view.impostorDistance : INFINITY;
+	Vec3 camera(view.cameraPosition), center(mesh.center);
+	for (const ImpostorInstance& instance : instances) {
+		Vec3 offset = Vec3(instance.position) + center * instance.scale - camera;
+		if (dot(offset, offset) < thresholdSquared)
+			nearScratch.push_back(instance);
+		else
+			farScratch.push_back(instance);
+	}
+	upload(mesh.nearInstances, nearScratch);
+	upload(mesh.farInstances, farScratch);
+}
+
+void ImpostorRenderer::upload(InstanceBuffer& target, const vector<ImpostorInstance>& instances)
+{
+	target.count = (uint32_t)instances.size();
+	if (instances.empty())
+		return;
+	if (target.capacity < instances.size()) { // Grow geometrically, so steady camera motion stops reallocating.
+		device.destroyBuffer(target.buffer);
+		target.capacity = max((uint32_t)instances.size(), target.capacity * 2);
+		BufferDesc desc;
+		desc.size = target.capacity * sizeof(ImpostorInstance);
+		desc.dynamic = true;
+		target.buffer = device.createBuffer(desc);
+	}
+	device.updateBuffer(target.buffer, 0, instances.data(), instances.size() * sizeof(ImpostorInstance));
+}
+
+void ImpostorRenderer::record(CommandList& list, const ImpostorView& view)
+{
+	for (unique_ptr<Mesh>& mesh : meshes) {
+		if (mesh->nearInstances.count > 0) {
+			float constants[20];
+			memcpy(constants, view.viewProjection, sizeof(view.viewProjection));
+			memcpy(constants + 16, mesh->color, sizeof(mesh->color));
+			constants[19] = 1.0f;
+			list.bindPipeline(meshPipeline);
+			list.bindVertexBuffer(0, mesh->vertexBuffer);
+			list.bindVertexBuffer(1, mesh->nearInstances.buffer);
+			list.bindIndexBuffer(mesh->indexBuffer);
+			list.setConstants(constants, sizeof(constants));
+			list.drawIndexed(mesh->indexCount, mesh->nearInstances.count);
+		}
+		if (mesh->farInstances.count > 0) {
+			float constants[28] = {};
+			memcpy(constants, view.viewProjection, sizeof(view.viewProjection));
+			memcpy(constants + 16, view.cameraPosition, sizeof(view.cameraPosition));
+			memcpy(constants + 20, mesh->center, sizeof(mesh->center));
+			constants[23] = mesh->radius;
+			constants[24] = (float)mesh->frames;
+			list.bindPipeline(billboardPipeline);
+			list.bindVertexBuffer(0, quadBuffer);
+			list.bindVertexBuffer(1, mesh->farInstances.buffer);
+			list.bindTexture(0, mesh->atlas, atlasSampler);
+			list.setConstants(constants, sizeof(constants));
+			list.draw(4, mesh->farInstances.count);
+		}
+	}
+}
+
+uint64_t ImpostorRenderer::getPreparedTriangles() const
+{
+	uint64_t triangles = 0;
+	for (const unique_ptr<Mesh>& mesh : meshes)
+		triangles += (uint64_t)mesh->nearInstances.count * (mesh->indexCount / 3) + (uint64_t)mesh->farInstances.count * 2;
+	return triangles;
+}
+
+uint32_t ImpostorRenderer::getNearCount() const
+{
+	uint32_t count = 0;
+	for (const unique_ptr<Mesh>& mesh : meshes)
+		count += mesh->nearInstances.count;
+	return count;
+}
+
+uint32_t ImpostorRenderer::getFarCount() const
+{
+	uint32_t count = 0;
+	for (const unique_ptr<Mesh>& mesh : meshes)
+		count += mesh->farInstances.count;
+	return count;
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+// A stylised pine: a profile of (radius, height) points revolved around the y axis, trunk and three tiers.
+static ImpostorMesh makeTreeMesh(int segments)
+{
+	const float profile[][2] = { { 0.15f, 0.0f }, { 0.15f, 1.0f }, { 1.1f, 1.0f }, { 0.2f, 2.0f }, { 0.85f, 2.0f }, { 0.15f, 3.0f }, { 0.6f, 3.0f }, { 0.0f, 4.0f } };
+	const int points = sizeof(profile) / sizeof(profile[0]);
+	const float pi = 3.14159265f;
+
+	ImpostorMesh mesh;
+	mesh.color[0] = 0.22f;
+	mesh.color[1] = 0.5f;
+	mesh.color[2] = 0.24f;
+	for (int point = 0; point < points; point++) {
+		// The normal is perpendicular to the profile's tangent, pointing outwards.
+		const float* previous = profile[max(point - 1, 0)];
+		const float* next = profile[min(point + 1, points - 1)];
+		float tangentR = next[0] - previous[0], tangentY = next[1] - previous[1];
+		float normalLength = sqrt(tangentR * tangentR + tangentY * tangentY);
+		float normalR = tangentY / normalLength, normalY = -tangentR / normalLength;
+		for (int segment = 0; segment < segments; segment++) {
+			float angle = 2.0f * pi * segment / segments;
+			float c = cos(angle), s = sin(angle);
+			const float vertex[6] = { profile[point][0] * c, profile[point][1], profile[point][0] * s, normalR * c, normalY, normalR * s };
+			mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + 6);
+		}
+	}
+	for (int point = 0; point + 1 < points; point++) {
+		for (int segment = 0; segment < segments; segment++) {
+			uint32_t a = point * segments + segment, b = point * segments + (segment + 1) % segments;
+			uint32_t c = a + segments, d = b + segments;
+			const uint32_t quad[] = { a, b, d, a, d, c };
+			mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+		}
+	}
+	return mesh;
+}
+
+void runImpostorBenchmark(GLFWwindow* window, int instanceCount, int frames)
+{
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+	glfwSwapInterval(0); // Never wait for vertical sync while measuring.
+
+	GLRenderDevice device;
+	ImpostorRenderer impostors(device);
+	if (!impostors.init())
+		return;
+	const float clearColor[4] = { 0.529f, 0.808f, 0.980f, 1.0f };
+
+	// Bake on the background thread, drawing frames meanwhile as a real load would.
+	BenchmarkTimer bakeTimer;
+	ImpostorMesh tree = makeTreeMesh(72);
+	uint32_t mesh = impostors.addMesh(tree);
+	while (!impostors.isBaked(mesh)) {
+		if (impostors.hasBakeFailed(mesh))
+			return; // Nothing to compare against.
+		impostors.update();
+		device.beginFrame(width, height, clearColor);
+		device.endFrame();
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+	cout << "BENCH::IMPOSTORS " << instanceCount << " trees of " << tree.indices.size() / 3 << " triangles, atlas baked in "
+		<< bakeTimer.elapsedMs() << " ms" << endl;
+
+	// A square forest with roughly one tree per 16 square units, seen from one corner.
+	mt19937 random(1234); // Fixed seed, so runs are comparable.
+	float side = sqrt((float)instanceCount) * 4.0f;
+	uniform_real_distribution<float> coordinate(0.0f, side), scale(0.8f, 1.3f);
+	vector<ImpostorInstance> instances(instanceCount);
+	for (ImpostorInstance& instance : instances) {
+		instance.position[0] = coordinate(random);
+		instance.position[2] = coordinate(random);
+		instance.scale = scale(random);
+	}
+
+	float projection[16];
+	perspectiveMatrix(1.047f, (float)width / height, 0.1f, side * 2.0f, projection);
+	GLuint query;
+	glGenQueries(1, &query);
+	CommandList* list = device.createCommandList();
+
+	const char* names[2] = { "IMPOSTORS::ALL_GEOMETRY", "IMPOSTORS::BEYOND_40" };
+	const float distances[2] = { INFINITY, 40.0f };
+	for (int mode = 0; mode < 2; mode++) {
+		vector<double> cpuSamples, gpuSamples;
+		for (int frame = 0; frame < frames; frame++) {
+			// Walk into the forest and back, so instances keep crossing the threshold.
+			float walk = side * 0.25f * (1.0f - cos(frame * 0.05f));
+			Vec3 eye(-5.0f + walk, 3.0f, -5.0f + walk), target(side * 0.5f, 1.0f, side * 0.5f);
+			ImpostorView view;
+			float viewMatrix[16];
+			lookAtMatrix(eye, target, Vec3(0.0f, 1.0f, 0.0f), viewMatrix);
+			multiplyMatrix(projection, viewMatrix, view.viewProjection);
+			view.cameraPosition[0] = eye.x;
+			view.cameraPosition[1] = eye.y;
+			view.cameraPosition[2] = eye.z;
+			view.impostorDistance = distances[mode];
+
+			BenchmarkTimer cpuTimer;
+			impostors.prepare(mesh, instances, view);
+			list->begin();
+			impostors.record(*list, view);
+			list->end();
+			device.beginFrame(width, height, clearColor);
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			device.submit(&list, 1);
+			glEndQuery(GL_TIME_ELAPSED);
+			device.endFrame();
+			cpuSamples.push_back(cpuTimer.elapsedMs());
+			GLuint64 gpuNanoseconds = 0; // Waits for the frame; fine while benchmarking.
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpuNanoseconds);
+			gpuSamples.push_back(gpuNanoseconds / 1.0e6);
+			glfwSwapBuffers(window);
+			glfwPollEvents();
+		}
+		string cpuName = string(names[mode]) + "::CPU", gpuName = string(names[mode]) + "::GPU";
+		printBenchmarkStats(cpuName.c_str(), computeBenchmarkStats(cpuSamples));
+		printBenchmarkStats(gpuName.c_str(), computeBenchmarkStats(gpuSamples));
+		cout << "  last frame: " << impostors.getNearCount() << " meshes, " << impostors.getFarCount() << " impostors, "
+			<< impostors.getPreparedTriangles() << " triangles" << endl;
+	}
+
+	glDeleteQueries(1, &query);
+}
+
+#pragma endregion
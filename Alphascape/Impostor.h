@@ -0,0 +1,113 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <cstdint> // Import the fixed width integers.
+#include <future> // Import future, for background bakes.
+#include <memory> // Import unique_ptr.
+#include <vector> // Import the vector container.
+
+#include "Graphics.h" // Import GLEW and GLFW.
+#include "RenderDevice.h" // Import the render device interface.
+
+#pragma endregion
+
+// A mesh to draw instanced, near as geometry and far as an impostor.
+struct ImpostorMesh
+{
+	std::vector<float> vertices; // Position x, y, z and normal x, y, z per vertex.
+	std::vector<uint32_t> indices; // Triangle list.
+	float color[3] = { 1.0f, 1.0f, 1.0f };
+};
+
+// A baked impostor: frames x frames views of a mesh, each frameSize pixels square, laid out on an octahedral grid
+// (frame (i, j) is the view from the direction octahedrally encoded at (i, j) / (frames - 1)). Covered pixels have
+// alpha 1, the rest 0. Rows run bottom to top, ready to upload as a GL texture.
+struct ImpostorAtlasImage
+{
+	int frames = 0, frameSize = 0;
+	float center[3] = {}; // Bounding sphere of the mesh, with a margin so mipmaps do not bleed between frames.
+	float radius = 0.0f;
+	std::vector<uint8_t> rgba; // (frames * frameSize) squared pixels.
+};
+
+// Bake an impostor atlas with the software rasterizer, so any thread can bake without a GL context.
+ImpostorAtlasImage bakeImpostorAtlas(const ImpostorMesh& mesh, int frames, int frameSize);
+
+// One placed copy of a mesh: a translation and a uniform scale.
+struct ImpostorInstance
+{
+	float position[3] = {};
+	float scale = 1.0f;
+};
+
+struct ImpostorView
+{
+	float viewProjection[16] = {}; // Column-major.
+	float cameraPosition[3] = {};
+	float impostorDistance = 50.0f; // Instances at least this far from the camera are drawn as impostors.
+};
+
+// Draws many instances of a few meshes: instances near the camera as instanced geometry, those beyond the view's
+// impostor distance as instanced camera-facing quads textured with the frame of the mesh's atlas baked nearest to
+// the view direction. Each far instance costs two triangles, whatever its mesh.
+//
+// Atlases are baked on a background thread when a mesh is added; until a mesh's atlas is uploaded, all its instances
+// are drawn as geometry. Everything except baking runs on the thread that owns the device.
+class ImpostorRenderer
+{
+public:
+	explicit ImpostorRenderer(RenderDevice& device);
+	~ImpostorRenderer(); // Waits for unfinished bakes.
+
+	// Create the pipelines. Returns false if they do not compile.
+	bool init();
+
+	// Upload a mesh and start baking its atlas. Returns the mesh index.
+	uint32_t addMesh(const ImpostorMesh& mesh, int frames = 8, int frameSize = 128);
+
+	// Upload the atlases that finished baking. Call once per frame, before prepare().
+	void update();
+	bool isBaked(uint32_t mesh) const;
+	bool hasBakeFailed(uint32_t mesh) const; // The atlas could not be uploaded; the mesh stays geometry.
+
+	// Split a mesh's instances into near and far and upload them. Once per mesh per frame, before recording.
+	void prepare(uint32_t mesh, const std::vector<ImpostorInstance>& instances, const ImpostorView& view);
+
+	// Record every prepared mesh: one instanced draw for its near instances, one for its far instances.
+	void record(CommandList& list, const ImpostorView& view);
+
+	// Triangles and instances of the last prepare() calls.
+	uint64_t getPreparedTriangles() const;
+	uint32_t getNearCount() const;
+	uint32_t getFarCount() const;
+
+private:
+	struct InstanceBuffer { BufferHandle buffer; uint32_t capacity = 0, count = 0; };
+	struct Mesh
+	{
+		BufferHandle vertexBuffer, indexBuffer;
+		uint32_t indexCount = 0;
+		float color[3] = {};
+		std::future<ImpostorAtlasImage> bake; // Valid until the atlas is uploaded.
+		TextureHandle atlas;
+		bool bakeFailed = false;
+		float center[3] = {}, radius = 0.0f;
+		int frames = 0;
+		InstanceBuffer nearInstances, farInstances; // As prepared for this frame.
+	};
+
+	void upload(InstanceBuffer& target, const std::vector<ImpostorInstance>& instances);
+
+	RenderDevice& device;
+	PipelineHandle meshPipeline, billboardPipeline;
+	BufferHandle quadBuffer; // The billboard's four corners, as a triangle strip.
+	SamplerHandle atlasSampler;
+	std::vector<std::unique_ptr<Mesh>> meshes;
+	std::vector<ImpostorInstance> nearScratch, farScratch;
+};
+
+// Draw a forest of instanceCount procedural trees (about a thousand triangles each) from a camera skimming the
+// ground, entirely as geometry and with impostors beyond a distance, and print CPU and GPU frame times and triangle
+// counts for both.
+void runImpostorBenchmark(GLFWwindow* window, int instanceCount, int frames);
@@ -0,0 +1,584 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import min and max.
+#include <cerrno> // Import the error numbers.
+#include <condition_variable> // Import the condition variable.
+#include <cstdio> // Import remove.
+#include <cstring> // Import memset.
+#include <fstream> // Import the file streams.
+#include <iomanip> // Import stream formatting.
+#include <iostream> // Import the IO stream libraries.
+#include <mutex> // Import the mutex.
+#include <thread> // Import the threads.
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "IoService.h" // Import the I/O service.
+#include "Threading.h" // Import the thread placement.
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h> // Import CreateFile and ReadFile.
+#else
+#include <fcntl.h> // Import open.
+#include <sys/stat.h> // Import fstat.
+#include <unistd.h> // Import pread and close.
+#endif
+
+#if defined(ALPHASCAPE_IO_URING) && defined(__linux__)
+#include <linux/io_uring.h> // Import the io_uring structures; the system calls are made directly, with no liburing.
+#include <sys/mman.h> // Import mmap.
+#include <sys/syscall.h> // Import the system call numbers.
+#define IO_SERVICE_URING
+#endif
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+// One read, from queue to callback.
+struct IoRequest
+{
+	IoFileHandle file = InvalidIoFile;
+	uint64_t offset = 0;
+	uint32_t size = 0;
+	void* destination = nullptr;
+	IoCallback onComplete;
+	int64_t result = 0;
+	uint32_t bytesDone = 0; // So far, by backends that resubmit short reads.
+};
+
+#pragma region Platform Reads
+
+// A blocking read of size bytes at offset that does not move any shared file position, so threads can share a file.
+// Returns size, or fewer bytes only at the end of the file, or -1 on an error.
+static int64_t readAt(IoFileHandle file, uint64_t offset, uint32_t size, void* destination)
+{
+#ifdef _WIN32
+	uint32_t total = 0;
+	while (total < size) { // ReadFile may return less than asked, like pread.
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = (DWORD)(offset + total);
+		overlapped.OffsetHigh = (DWORD)((offset + total) >> 32);
+		DWORD bytesRead = 0;
+		if (!ReadFile((HANDLE)file, (char*)destination + total, size - total, &bytesRead, &overlapped)) {
+			if (GetLastError() == ERROR_HANDLE_EOF)
+				break;
+			return -1;
+		}
+		if (bytesRead == 0)
+			break;
+		total += bytesRead;
+	}
+	return total;
+#else
+	uint32_t total = 0;
+	while (total < size) { // pread may return less than asked, e.g. when interrupted.
+		ssize_t bytesRead = pread((int)file, (char*)destination + total, size - total, (off_t)(offset + total));
+		if (bytesRead < 0)
+			return -1;
+		if (bytesRead == 0)
+			break;
+		total += (uint32_t)bytesRead;
+	}
+	return total;
+#endif
+}
+
+#pragma endregion
+
+#pragma region Backends
+
+// Where submitted reads go. push() starts a read or returns false if the backend is full; reap() collects finished
+// ones, optionally blocking until at least one is.
+class IoBackend
+{
+public:
+	virtual ~IoBackend() {}
+	virtual const char* getName() const = 0;
+	virtual bool push(IoRequest* request) = 0;
+	virtual void flush() {} // Hand pushed reads to the system, if push() only batched them.
+	virtual void reap(vector<IoRequest*>& finished, bool wait) = 0;
+};
+
+// Blocking positional reads on a few threads.
+class ThreadPoolIoBackend : public IoBackend
+{
+public:
+	explicit ThreadPoolIoBackend(unsigned int threadCount)
+	{
+		for (unsigned int i = 0; i < max(1u, threadCount); i++)
+			threads.emplace_back([this] {
+				placeCurrentThread(ThreadRole::Io);
+				workerLoop();
+			});
+	}
+
+	~ThreadPoolIoBackend()
+	{
+		{
+			lock_guard<mutex> lock(poolMutex);
+			shuttingDown = true;
+		}
+		workCondition.notify_all();
+		for (std::thread& thread : threads)
+			thread.join();
+	}
+
+	const char* getName() const override { return "thread pool"; }
+
+	bool push(IoRequest* request) override
+	{
+		{
+			lock_guard<mutex> lock(poolMutex);
+			pending.push_back(request);
+		}
+		workCondition.notify_one();
+		return true;
+	}
+
+	void reap(vector<IoRequest*>& finished, bool wait) override
+	{
+		unique_lock<mutex> lock(poolMutex);
+		if (wait)
+			doneCondition.wait(lock, [this] { return !done.empty(); });
+		finished.insert(finished.end(), done.begin(), done.end());
+		done.clear();
+	}
+
+private:
+	void workerLoop()
+	{
+		for (;;) {
+			IoRequest* request;
+			{
+				unique_lock<mutex> lock(poolMutex);
+				workCondition.wait(lock, [this] { return shuttingDown || !pending.empty(); });
+				if (pending.empty())
+					return;
+				request = pending.front();
+				pending.pop_front();
+			}
+			request->result = readAt(request->file, request->offset, request->size, request->destination);
+			{
+				lock_guard<mutex> lock(poolMutex);
+				done.push_back(request);
+			}
+			doneCondition.notify_one();
+		}
+	}
+
+	vector<std::thread> threads;
+	mutex poolMutex;
+	condition_variable workCondition, doneCondition;
+	deque<IoRequest*> pending;
+	vector<IoRequest*> done;
+	bool shuttingDown = false;
+};
+
+#ifdef IO_SERVICE_URING
+
+// io_uring through the raw system calls: reads are written into the shared submission ring and handed to the kernel
+// in one io_uring_enter per flush; completions are read straight out of the completion ring. A read that comes back
+// short, or interrupted, is submitted again for the rest, so reads complete in full or at the end of the file as they
+// do on the thread pool.
+class UringIoBackend : public IoBackend
+{
+public:
+	~UringIoBackend()
+	{
+		if (submissionQueueEntries)
+			munmap(submissionQueueEntries, entryMapSize);
+		if (completionRing && completionRing != submissionRing)
+			munmap(completionRing, completionMapSize);
+		if (submissionRing)
+			munmap(submissionRing, submissionMapSize);
+		if (ringFd >= 0)
+			close(ringFd);
+	}
+
+	// Set up a ring of the given depth. Returns false if the kernel does not support io_uring (or forbids it), or
+	// predates IORING_OP_READ (Linux 5.6).
+	bool init(unsigned int depth)
+	{
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+		ringFd = (int)syscall(__NR_io_uring_setup, depth, &params);
+		if (ringFd < 0)
+			return false;
+
+		submissionMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		completionMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (singleMap)
+			submissionMapSize = completionMapSize = max(submissionMapSize, completionMapSize);
+		submissionRing = mmap(nullptr, submissionMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+		if (submissionRing == MAP_FAILED) {
+			submissionRing = nullptr;
+			return false;
+		}
+		completionRing = singleMap ? submissionRing : mmap(nullptr, completionMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+		if (completionRing == MAP_FAILED) {
+			completionRing = nullptr;
+			return false;
+		}
+		entryMapSize = params.sq_entries * sizeof(io_uring_sqe);
+		void* entries = mmap(nullptr, entryMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+		if (entries == MAP_FAILED)
+			return false;
+		submissionQueueEntries = (io_uring_sqe*)entries;
+
+		char* sq = (char*)submissionRing;
+		submissionHead = (unsigned*)(sq + params.sq_off.head);
+		submissionTail = (unsigned*)(sq + params.sq_off.tail);
+		submissionMask = *(unsigned*)(sq + params.sq_off.ring_mask);
+		submissionArray = (unsigned*)(sq + params.sq_off.array);
+		submissionCapacity = params.sq_entries;
+		char* cq = (char*)completionRing;
+		completionHead = (unsigned*)(cq + params.cq_off.head);
+		completionTail = (unsigned*)(cq + params.cq_off.tail);
+		completionMask = *(unsigned*)(cq + params.cq_off.ring_mask);
+		completions = (io_uring_cqe*)(cq + params.cq_off.cqes);
+		completionCapacity = params.cq_entries;
+		return supportsRead();
+	}
+
+	const char* getName() const override { return "io_uring"; }
+
+	bool push(IoRequest* request) override
+	{
+		return retries.empty() && pushRemainder(request); // Resubmissions go first.
+	}
+
+	void flush() override
+	{
+		pushRetries();
+		enter(0, 0);
+	}
+
+	void reap(vector<IoRequest*>& finished, bool wait) override
+	{
+		pushRetries();
+		if (wait && inFlight > 0 && __atomic_load_n(completionTail, __ATOMIC_ACQUIRE) == *completionHead)
+			enter(1, IORING_ENTER_GETEVENTS);
+		else
+			enter(0, 0);
+
+		unsigned head = *completionHead; // Only this thread writes the head.
+		unsigned tail = __atomic_load_n(completionTail, __ATOMIC_ACQUIRE);
+		for (; head != tail; head++) {
+			const io_uring_cqe& completion = completions[head & completionMask];
+			IoRequest* request = (IoRequest*)(uintptr_t)completion.user_data;
+			inFlight--;
+			if (completion.res == -EINTR || completion.res == -EAGAIN) {
+				retries.push_back(request);
+				continue;
+			}
+			if (completion.res > 0) {
+				request->bytesDone += (uint32_t)completion.res;
+				if (request->bytesDone < request->size) {
+					retries.push_back(request); // Short: read the rest, until it is done or at the end of the file.
+					continue;
+				}
+			}
+			request->result = completion.res < 0 ? completion.res : request->bytesDone; // -errno, or bytes read.
+			finished.push_back(request);
+		}
+		__atomic_store_n(completionHead, head, __ATOMIC_RELEASE);
+		pushRetries(); // Submitted by the next flush or reap.
+	}
+
+private:
+	// Ask the kernel which operations it supports. Kernels before IORING_REGISTER_PROBE also lack IORING_OP_READ.
+	bool supportsRead()
+	{
+		const unsigned int opCount = 256;
+		vector<char> buffer(sizeof(io_uring_probe) + opCount * sizeof(io_uring_probe_op), 0);
+		io_uring_probe* probe = (io_uring_probe*)buffer.data();
+		if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, opCount) < 0)
+			return false;
+		return probe->last_op >= IORING_OP_READ && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) != 0;
+	}
+
+	// Write a read of what is left of the request into the submission ring. Returns false if the ring is full.
+	bool pushRemainder(IoRequest* request)
+	{
+		unsigned tail = *submissionTail; // Only this thread writes the tail.
+		unsigned head = __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE);
+		if (tail - head >= submissionCapacity || inFlight >= completionCapacity)
+			return false;
+
+		unsigned index = tail & submissionMask;
+		io_uring_sqe& entry = submissionQueueEntries[index];
+		memset(&entry, 0, sizeof(entry));
+		entry.opcode = IORING_OP_READ;
+		entry.fd = (int)request->file;
+		entry.addr = (uint64_t)(uintptr_t)((char*)request->destination + request->bytesDone);
+		entry.len = request->size - request->bytesDone;
+		entry.off = request->offset + request->bytesDone;
+		entry.user_data = (uint64_t)(uintptr_t)request;
+		submissionArray[index] = index;
+		__atomic_store_n(submissionTail, tail + 1, __ATOMIC_RELEASE);
+		unsubmitted++;
+		inFlight++;
+		return true;
+	}
+
+	void pushRetries()
+	{
+		while (!retries.empty() && pushRemainder(retries.front()))
+			retries.pop_front();
+	}
+
+	// Submit the reads pushed since the last call and optionally wait for completions, in one system call.
+	void enter(unsigned int minComplete, unsigned int flags)
+	{
+		if (unsubmitted == 0 && minComplete == 0)
+			return;
+		int submitted = (int)syscall(__NR_io_uring_enter, ringFd, unsubmitted, minComplete, flags, nullptr, 0);
+		if (submitted > 0)
+			unsubmitted -= min(unsubmitted, (unsigned int)submitted);
+	}
+
+	int ringFd = -1;
+	void* submissionRing = nullptr;
+	void* completionRing = nullptr;
+	io_uring_sqe* submissionQueueEntries = nullptr;
+	size_t submissionMapSize = 0, completionMapSize = 0, entryMapSize = 0;
+	unsigned* submissionHead = nullptr;
+	unsigned* submissionTail = nullptr;
+	unsigned* submissionArray = nullptr;
+	unsigned submissionMask = 0, submissionCapacity = 0;
+	unsigned* completionHead = nullptr;
+	unsigned* completionTail = nullptr;
+	io_uring_cqe* completions = nullptr;
+	unsigned completionMask = 0, completionCapacity = 0;
+	unsigned int unsubmitted = 0, inFlight = 0;
+	deque<IoRequest*> retries; // Short or interrupted reads waiting for room in the ring.
+};
+
+#endif
+
+#pragma endregion
+
+#pragma region I/O Service
+
+IoService::IoService(IoBackendKind kind, unsigned int threadCount, unsigned int newQueueDepth)
+	: queueDepth(max(1u, newQueueDepth))
+{
+#ifdef IO_SERVICE_URING
+	if (kind == IoBackendKind::Native) {
+		unique_ptr<UringIoBackend> uring(new UringIoBackend());
+		if (uring->init(queueDepth))
+			backend = move(uring);
+	}
+#else
+	(void)kind;
+#endif
+	if (!backend)
+		backend.reset(new ThreadPoolIoBackend(threadCount));
+}
+
+IoService::~IoService()
+{
+	waitAll();
+}
+
+const char* IoService::getBackendName() const
+{
+	return backend->getName();
+}
+
+IoFileHandle IoService::openFile(const char* path, uint64_t* size)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		cout << "ERROR::IO::FILE_NOT_OPENED\n" << path << endl;
+		return InvalidIoFile;
+	}
+	if (size) {
+		LARGE_INTEGER fileSize;
+		*size = GetFileSizeEx(file, &fileSize) ? (uint64_t)fileSize.QuadPart : 0;
+	}
+	return (IoFileHandle)file;
+#else
+	int file = open(path, O_RDONLY);
+	if (file < 0) {
+		cout << "ERROR::IO::FILE_NOT_OPENED\n" << path << endl;
+		return InvalidIoFile;
+	}
+	if (size) {
+		struct stat status;
+		*size = fstat(file, &status) == 0 ? (uint64_t)status.st_size : 0;
+	}
+	return file;
+#endif
+}
+
+void IoService::closeFile(IoFileHandle file)
+{
+	if (file == InvalidIoFile)
+		return;
+#ifdef _WIN32
+	CloseHandle((HANDLE)file);
+#else
+	close((int)file);
+#endif
+}
+
+void IoService::read(IoFileHandle file, uint64_t offset, uint32_t size, void* destination, IoCallback onComplete)
+{
+	IoRequest* request;
+	if (freeRequests.empty()) {
+		requests.emplace_back(new IoRequest());
+		request = requests.back().get();
+	}
+	else {
+		request = freeRequests.back();
+		freeRequests.pop_back();
+	}
+	request->file = file;
+	request->offset = offset;
+	request->size = size;
+	request->destination = destination;
+	request->onComplete = onComplete;
+	request->result = 0;
+	request->bytesDone = 0;
+	queued.push_back(request);
+}
+
+shared_ptr<JobCounter> IoService::read(IoFileHandle file, uint64_t offset, uint32_t size, void* destination, int64_t* bytesRead)
+{
+	shared_ptr<JobCounter> counter = make_shared<JobCounter>(1);
+	read(file, offset, size, destination, [counter, bytesRead](int64_t result) {
+		if (bytesRead)
+			*bytesRead = result;
+		counter->signal();
+	});
+	return counter;
+}
+
+void IoService::submit()
+{
+	while (!queued.empty() && inFlight < queueDepth && backend->push(queued.front())) {
+		queued.pop_front();
+		inFlight++;
+	}
+	backend->flush();
+}
+
+size_t IoService::complete(bool wait)
+{
+	finished.clear();
+	backend->reap(finished, wait);
+	inFlight -= finished.size();
+	submit(); // Refill the queue before running callbacks, so the device stays busy meanwhile.
+
+	vector<IoRequest*> completed;
+	completed.swap(finished); // A callback may queue more reads, or even poll.
+	for (IoRequest* request : completed) {
+		IoCallback onComplete;
+		onComplete.swap(request->onComplete);
+		freeRequests.push_back(request); // Free before the callback, which may queue another read.
+		if (onComplete)
+			onComplete(request->result);
+	}
+	return completed.size();
+}
+
+size_t IoService::poll()
+{
+	return complete(false);
+}
+
+void IoService::waitAll()
+{
+	submit();
+	while (getPendingCount() > 0)
+		complete(true);
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+void runIoBenchmark(int fileSizeMb, int chunkKb)
+{
+	const char* path = "io_benchmark.tmp";
+	const uint64_t fileSize = (uint64_t)fileSizeMb * 1024 * 1024;
+	const uint32_t chunkSize = (uint32_t)chunkKb * 1024;
+	{
+		ofstream file(path, ios::binary);
+		vector<char> block(1024 * 1024);
+		for (size_t i = 0; i < block.size(); i++)
+			block[i] = (char)(i * 131 >> 3);
+		for (int i = 0; i < fileSizeMb && file; i++)
+			file.write(block.data(), block.size());
+		if (!file) {
+			cout << "ERROR::IO::BENCHMARK_FILE_NOT_WRITTEN\n" << path << endl;
+			return;
+		}
+	}
+	cout << "BENCH::IO " << fileSizeMb << " MB in " << chunkKb << " KB reads (the file was just written, so it is likely"
+		<< " cached: this measures per-read overhead more than the device)" << endl;
+
+	// One staging buffer the size of the file, as streaming into a large mapped buffer would.
+	vector<char> staging(fileSize);
+	auto report = [&](const char* name, double ms, unsigned int threads, uint64_t bytes) {
+		ios::fmtflags flags = cout.flags();
+		streamsize precision = cout.precision();
+		cout << "BENCH::IO::" << name << fixed << setprecision(3) << " " << ms << " ms, "
+			<< setprecision(0) << bytes / (1024.0 * 1024.0) / (ms / 1000.0) << " MB/s, "
+			<< threads << " thread" << (threads == 1 ? "" : "s") << " waiting on reads" << endl;
+		cout.flags(flags);
+		cout.precision(precision);
+	};
+
+	// Blocking reads on the requesting thread.
+	{
+		BenchmarkTimer timer;
+		ifstream file(path, ios::binary);
+		uint64_t bytesRead = 0;
+		for (uint64_t offset = 0; offset < fileSize && file; offset += chunkSize) {
+			file.read(staging.data() + offset, min<uint64_t>(chunkSize, fileSize - offset));
+			bytesRead += file.gcount();
+		}
+		report("BLOCKING", timer.elapsedMs(), 1, bytesRead);
+	}
+
+	IoBackendKind kinds[] = { IoBackendKind::ThreadPool, IoBackendKind::Native };
+	for (IoBackendKind kind : kinds) {
+		const unsigned int poolThreads = 2;
+		IoService io(kind, poolThreads, 64);
+		if (kind == IoBackendKind::Native && strcmp(io.getBackendName(), "io_uring") != 0) {
+			cout << "BENCH::IO::IO_URING not available (not built with ALPHASCAPE_IO_URING, or the kernel lacks IORING_OP_READ)" << endl;
+			break;
+		}
+		IoFileHandle file = io.openFile(path);
+		if (file == InvalidIoFile)
+			break;
+
+		uint64_t bytesRead = 0;
+		bool failed = false;
+		BenchmarkTimer timer;
+		for (uint64_t offset = 0; offset < fileSize; offset += chunkSize) {
+			io.read(file, offset, (uint32_t)min<uint64_t>(chunkSize, fileSize - offset), staging.data() + offset, [&](int64_t result) {
+				if (result < 0)
+					failed = true;
+				else
+					bytesRead += result;
+			});
+		}
+		io.waitAll();
+		double ms = timer.elapsedMs();
+		io.closeFile(file);
+		if (failed || bytesRead != fileSize)
+			cout << "ERROR::IO::BENCHMARK_READ_FAILED\n" << bytesRead << " of " << fileSize << " bytes read" << endl;
+		report(kind == IoBackendKind::ThreadPool ? "THREAD_POOL" : "IO_URING", ms, kind == IoBackendKind::ThreadPool ? poolThreads : 0, bytesRead);
+	}
+	remove(path);
+}
+
+#pragma endregion
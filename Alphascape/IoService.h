@@ -0,0 +1,88 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <cstdint> // Import the fixed width integers.
+#include <deque> // Import the double ended queue.
+#include <functional> // Import function.
+#include <memory> // Import the smart pointers.
+#include <vector> // Import the vector container.
+
+#include "Jobs.h" // Import the job counters.
+
+#pragma endregion
+
+// A file opened for IoService reads: a file descriptor, or a HANDLE on Windows.
+typedef intptr_t IoFileHandle;
+static const IoFileHandle InvalidIoFile = -1;
+
+// Called with the number of bytes read, or a negative value if the read failed.
+typedef std::function<void(int64_t bytesRead)> IoCallback;
+
+enum class IoBackendKind
+{
+	Native, // io_uring when built with ALPHASCAPE_IO_URING and the kernel has IORING_OP_READ, else the thread pool.
+	ThreadPool // Blocking positional reads on a few worker threads.
+};
+
+class IoBackend;
+struct IoRequest;
+
+// Asynchronous file reads, batched. Reads are queued with read(), started together by submit(), and completed by
+// poll(), which runs their callbacks on the calling thread. Each read goes straight into the caller's memory, so
+// asset data can be read directly into a mapped pixel buffer or a staging buffer with no copy in between.
+//
+// With io_uring a whole batch is one system call and no threads wait on the disk at all. The fallback keeps a few
+// threads doing blocking positional reads, which still overlaps requests but holds a thread per read in flight.
+//
+// Not thread safe: use an IoService from one thread, usually the main or streaming thread.
+class IoService
+{
+public:
+	// queueDepth caps the reads in flight; more are kept queued and started as others complete.
+	explicit IoService(IoBackendKind kind = IoBackendKind::Native, unsigned int threadCount = 2, unsigned int queueDepth = 128);
+	~IoService();
+
+	// "io_uring" or "thread pool".
+	const char* getBackendName() const;
+
+	// Open a file for reading, writing its size to size if given. Prints an error and returns InvalidIoFile on failure.
+	IoFileHandle openFile(const char* path, uint64_t* size = nullptr);
+	// Close a file. It must have no reads in flight.
+	void closeFile(IoFileHandle file);
+
+	// Queue a read of size bytes at offset into destination, which must stay valid until the callback has run.
+	void read(IoFileHandle file, uint64_t offset, uint32_t size, void* destination, IoCallback onComplete);
+
+	// Queue a read and return a counter a job can wait on; it is signalled by the poll() that completes the read.
+	// Writes the result to bytesRead if given.
+	std::shared_ptr<JobCounter> read(IoFileHandle file, uint64_t offset, uint32_t size, void* destination, int64_t* bytesRead = nullptr);
+
+	// Start every queued read that fits in the queue depth.
+	void submit();
+
+	// Run the callbacks of finished reads and start queued ones in their place. Never blocks. Returns the callbacks run.
+	size_t poll();
+
+	// Submit, then block until every read has completed and its callback has run.
+	void waitAll();
+
+	// Reads queued or in flight.
+	size_t getPendingCount() const { return queued.size() + inFlight; }
+
+private:
+	// Collect finished reads (blocking for one if wait), start queued ones and run the callbacks. Returns the count.
+	size_t complete(bool wait);
+
+	std::unique_ptr<IoBackend> backend;
+	std::deque<IoRequest*> queued; // Not yet submitted.
+	std::vector<IoRequest*> finished; // Scratch for poll().
+	std::vector<std::unique_ptr<IoRequest>> requests; // Every request ever allocated; reused through freeRequests.
+	std::vector<IoRequest*> freeRequests;
+	size_t inFlight = 0;
+	unsigned int queueDepth;
+};
+
+// Read a fileSizeMb file in chunkKb chunks with blocking reads on one thread, through the thread pool backend and
+// through io_uring if available, and print the throughput and threads each used.
+void runIoBenchmark(int fileSizeMb, int chunkKb);
@@ -0,0 +1,381 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import max.
+#include <atomic> // Import the atomics.
+#include <cstdio> // Import remove.
+#include <fstream> // Import the file streams.
+#include <future> // Import promise, for the blocking pool.
+#include <iomanip> // Import stream formatting.
+#include <iostream> // Import the IO stream libraries.
+#include <queue> // Import the priority queue.
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "Jobs.h" // Import the job system.
+#include "Pool.h" // Import the pool allocators.
+#include "Threading.h" // Import the thread placement.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Counters
+
+void JobCounter::signal()
+{
+	vector<pair<JobSystem*, shared_ptr<Job>>> resumed;
+	{
+		lock_guard<mutex> lock(counterMutex);
+		if (count == 0)
+			return;
+		if (--count > 0)
+			return;
+		resumed.swap(waiters);
+		doneCondition.notify_all();
+	}
+	for (pair<JobSystem*, shared_ptr<Job>>& waiter : resumed)
+		waiter.first->enqueue(waiter.second);
+}
+
+bool JobCounter::isDone() const
+{
+	lock_guard<mutex> lock(counterMutex);
+	return count == 0;
+}
+
+void JobCounter::wait()
+{
+	unique_lock<mutex> lock(counterMutex);
+	doneCondition.wait(lock, [this] { return count == 0; });
+}
+
+bool JobCounter::park(JobSystem* system, const shared_ptr<Job>& job)
+{
+	lock_guard<mutex> lock(counterMutex);
+	if (count == 0)
+		return false;
+	waiters.emplace_back(system, job);
+	return true;
+}
+
+#pragma endregion
+
+#pragma region Job System
+
+JobSystem::JobSystem(unsigned int threadCount)
+{
+	if (threadCount == 0)
+		threadCount = getDefaultWorkerCount();
+	for (unsigned int i = 0; i < threadCount; i++) {
+		workers.emplace_back([this, i] {
+			placeCurrentThread(ThreadRole::Worker, i);
+			workerLoop();
+		});
+	}
+	ioThread = std::thread([this] {
+		placeCurrentThread(ThreadRole::Io);
+		ioLoop();
+	});
+}
+
+JobSystem::~JobSystem()
+{
+	waitIdle();
+	{
+		lock_guard<mutex> lock(queueMutex);
+		shuttingDown = true;
+	}
+	queueCondition.notify_all();
+	ioCondition.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+	ioThread.join();
+}
+
+shared_ptr<JobCounter> JobSystem::run(JobFunction function)
+{
+	shared_ptr<Job> job = allocate_shared<Job>(PoolAllocator<Job>());
+	job->function = function;
+	job->finished = allocate_shared<JobCounter>(PoolAllocator<JobCounter>(), 1);
+	{
+		lock_guard<mutex> lock(queueMutex);
+		unfinishedJobs++;
+		queue.push_back(job);
+	}
+	queueCondition.notify_one();
+	return job->finished;
+}
+
+void JobSystem::enqueue(const shared_ptr<Job>& job)
+{
+	{
+		lock_guard<mutex> lock(queueMutex);
+		queue.push_back(job);
+	}
+	queueCondition.notify_one();
+}
+
+shared_ptr<JobCounter> JobSystem::readFile(const string& path, shared_ptr<vector<char>> data)
+{
+	FileRead read;
+	read.path = path;
+	read.data = data;
+	read.finished = allocate_shared<JobCounter>(PoolAllocator<JobCounter>(), 1);
+	{
+		lock_guard<mutex> lock(queueMutex);
+		reads.push_back(read);
+	}
+	ioCondition.notify_one();
+	return read.finished;
+}
+
+void JobSystem::waitIdle()
+{
+	unique_lock<mutex> lock(queueMutex);
+	idleCondition.wait(lock, [this] { return unfinishedJobs == 0; });
+}
+
+void JobSystem::workerLoop()
+{
+	for (;;) {
+		shared_ptr<Job> job;
+		{
+			unique_lock<mutex> lock(queueMutex);
+			queueCondition.wait(lock, [this] { return shuttingDown || !queue.empty(); });
+			if (queue.empty())
+				return;
+			job = queue.front();
+			queue.pop_front();
+		}
+
+		// Run the job until it finishes or parks on a counter that has not completed yet.
+		JobStep step = job->function();
+		while (step.waitFor && !step.waitFor->park(this, job))
+			step = job->function();
+		if (step.waitFor)
+			continue; // Parked: the counter queues it again.
+
+		job->finished->signal(); // Queues any waiters before the job stops counting as unfinished.
+		bool idle;
+		{
+			lock_guard<mutex> lock(queueMutex);
+			idle = --unfinishedJobs == 0;
+		}
+		if (idle)
+			idleCondition.notify_all();
+	}
+}
+
+void JobSystem::ioLoop()
+{
+	for (;;) {
+		FileRead read;
+		{
+			unique_lock<mutex> lock(queueMutex);
+			ioCondition.wait(lock, [this] { return shuttingDown || !reads.empty(); });
+			if (reads.empty())
+				return;
+			read = reads.front();
+			reads.pop_front();
+		}
+
+		read.data->clear();
+		ifstream file(read.path, ios::binary | ios::ate);
+		if (file) {
+			read.data->resize((size_t)file.tellg());
+			file.seekg(0);
+			if (!file.read(read.data->data(), read.data->size()))
+				read.data->clear();
+		}
+		read.finished->signal();
+	}
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+// Stands in for the GPU: calls each submitted callback a fixed latency after submission, as a fence would signal.
+class SimulatedGpu
+{
+public:
+	explicit SimulatedGpu(double latencyMs)
+		: latency(chrono::duration_cast<Clock::duration>(chrono::duration<double, milli>(latencyMs))), gpuThread(&SimulatedGpu::loop, this) {}
+
+	~SimulatedGpu()
+	{
+		{
+			lock_guard<mutex> lock(gpuMutex);
+			shuttingDown = true;
+		}
+		condition.notify_all();
+		gpuThread.join();
+	}
+
+	void submit(function<void()> onFence)
+	{
+		{
+			lock_guard<mutex> lock(gpuMutex);
+			pending.push({ Clock::now() + latency, onFence });
+		}
+		condition.notify_all();
+	}
+
+private:
+	typedef chrono::high_resolution_clock Clock;
+	struct Fence
+	{
+		Clock::time_point when;
+		function<void()> onFence;
+		bool operator<(const Fence& other) const { return when > other.when; } // Earliest on top.
+	};
+
+	void loop()
+	{
+		unique_lock<mutex> lock(gpuMutex);
+		while (!shuttingDown) {
+			if (pending.empty()) {
+				condition.wait(lock);
+				continue;
+			}
+			if (Clock::now() < pending.top().when) {
+				condition.wait_until(lock, pending.top().when);
+				continue;
+			}
+			Fence fence = pending.top();
+			pending.pop();
+			lock.unlock();
+			fence.onFence();
+			lock.lock();
+		}
+	}
+
+	Clock::duration latency;
+	std::mutex gpuMutex;
+	condition_variable condition;
+	priority_queue<Fence> pending;
+	bool shuttingDown = false;
+	std::thread gpuThread; // Last, so it starts once everything else is constructed.
+};
+
+// The CPU side of decoding a quarter of an asset: a few passes of FNV-1a over it.
+static uint32_t decodeQuarter(const vector<char>& data, int quarter)
+{
+	size_t begin = data.size() * quarter / 4, end = data.size() * (quarter + 1) / 4;
+	uint32_t hash = 2166136261u;
+	for (int pass = 0; pass < 4; pass++) {
+		for (size_t i = begin; i < end; i++)
+			hash = (hash ^ (uint8_t)data[i]) * 16777619u;
+	}
+	return hash;
+}
+
+void runJobSystemBenchmark(int assetCount, unsigned int threadCount)
+{
+	const char* path = "jobs_benchmark.tmp";
+	const size_t fileSize = 64 * 1024;
+	const double fenceLatencyMs = 2.0;
+	{
+		ofstream file(path, ios::binary);
+		for (size_t i = 0; i < fileSize; i++)
+			file.put((char)(i * 31));
+		if (!file) {
+			cout << "ERROR::JOBS::BENCHMARK_FILE_NOT_WRITTEN\n" << path << endl;
+			return;
+		}
+	}
+	cout << "BENCH::JOBS " << assetCount << " assets of " << fileSize / 1024 << " KB, " << threadCount
+		<< " worker threads, " << fenceLatencyMs << " ms upload fences" << endl;
+
+	vector<uint32_t> blockingChecksums(assetCount), jobChecksums(assetCount);
+
+	// A blocking pool: each thread loads one asset at a time, holding the thread through the read and the fence.
+	// Waiting on child jobs from inside a pool like this can deadlock it, so the decode runs inline.
+	double blockingMs;
+	{
+		SimulatedGpu gpu(fenceLatencyMs);
+		atomic<int> nextAsset{ 0 };
+		BenchmarkTimer timer;
+		vector<std::thread> threads;
+		for (unsigned int t = 0; t < threadCount; t++) {
+			threads.emplace_back([&] {
+				for (int asset = nextAsset.fetch_add(1); asset < assetCount; asset = nextAsset.fetch_add(1)) {
+					vector<char> data;
+					ifstream file(path, ios::binary | ios::ate);
+					data.resize((size_t)file.tellg());
+					file.seekg(0);
+					file.read(data.data(), data.size());
+
+					shared_ptr<promise<void>> fence = make_shared<promise<void>>();
+					future<void> fenceDone = fence->get_future();
+					gpu.submit([fence] { fence->set_value(); });
+					fenceDone.wait();
+
+					uint32_t checksum = 0;
+					for (int quarter = 0; quarter < 4; quarter++)
+						checksum ^= decodeQuarter(data, quarter);
+					blockingChecksums[asset] = checksum;
+				}
+			});
+		}
+		for (std::thread& thread : threads)
+			thread.join();
+		blockingMs = timer.elapsedMs();
+	}
+
+	// The job system: the same steps as one resumable job per asset, which parks instead of waiting.
+	double jobsMs;
+	{
+		SimulatedGpu gpu(fenceLatencyMs);
+		JobSystem jobs(threadCount);
+		BenchmarkTimer timer;
+		for (int asset = 0; asset < assetCount; asset++) {
+			struct AssetLoad
+			{
+				int stage = 0;
+				shared_ptr<vector<char>> data = make_shared<vector<char>>();
+				uint32_t quarters[4] = {};
+			};
+			shared_ptr<AssetLoad> load = make_shared<AssetLoad>();
+			jobs.run([&jobs, &gpu, &jobChecksums, path, asset, load]() -> JobStep {
+				switch (load->stage++) {
+				case 0:
+					return JobStep::wait(jobs.readFile(path, load->data));
+				case 1: {
+					shared_ptr<JobCounter> fence = allocate_shared<JobCounter>(PoolAllocator<JobCounter>(), 1);
+					gpu.submit([fence] { fence->signal(); });
+					return JobStep::wait(fence);
+				}
+				case 2: { // Decode the quarters as child jobs.
+					shared_ptr<JobCounter> children = allocate_shared<JobCounter>(PoolAllocator<JobCounter>(), 4);
+					for (int quarter = 0; quarter < 4; quarter++) {
+						jobs.run([load, quarter, children] {
+							load->quarters[quarter] = decodeQuarter(*load->data, quarter);
+							children->signal();
+							return JobStep::done();
+						});
+					}
+					return JobStep::wait(children);
+				}
+				default:
+					jobChecksums[asset] = load->quarters[0] ^ load->quarters[1] ^ load->quarters[2] ^ load->quarters[3];
+					return JobStep::done();
+				}
+			});
+		}
+		jobs.waitIdle();
+		jobsMs = timer.elapsedMs();
+	}
+	remove(path);
+
+	bool match = blockingChecksums == jobChecksums;
+	ios::fmtflags flags = cout.flags();
+	streamsize precision = cout.precision();
+	cout << fixed << setprecision(3)
+		<< "BENCH::JOBS::BLOCKING_POOL " << blockingMs << " ms, " << assetCount / blockingMs * 1000.0 << " assets per second\n"
+		<< "BENCH::JOBS::JOB_SYSTEM " << jobsMs << " ms, " << assetCount / jobsMs * 1000.0 << " assets per second\n"
+		<< "  results " << (match ? "match" : "DIFFER") << endl;
+	cout.flags(flags);
+	cout.precision(precision);
+}
+
+#pragma endregion
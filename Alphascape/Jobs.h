@@ -0,0 +1,123 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <condition_variable> // Import the condition variable.
+#include <cstdint> // Import the fixed width integers.
+#include <deque> // Import the double ended queue.
+#include <functional> // Import function.
+#include <memory> // Import the smart pointers.
+#include <mutex> // Import the mutex.
+#include <string> // Import the string class.
+#include <thread> // Import the threads.
+#include <vector> // Import the vector container.
+
+#pragma endregion
+
+class JobSystem;
+struct Job;
+
+// Something jobs can wait for: other jobs, a file read, a GPU fence. It completes when it has been signalled as many
+// times as its count; jobs waiting on it are then queued to run again. To wait on a GPU fence, make a counter of one
+// and signal it from the thread that owns the context once a zero-timeout glClientWaitSync reports the fence done.
+class JobCounter
+{
+public:
+	explicit JobCounter(uint32_t count) : count(count) {}
+
+	// Count one completion. Any thread may call it; jobs waiting on the counter resume when it reaches zero.
+	void signal();
+
+	bool isDone() const;
+
+	// Block the calling thread until the counter completes. Not from a job, which returns JobStep::wait instead.
+	void wait();
+
+private:
+	friend class JobSystem;
+
+	// Park a job until the counter completes. Returns false, parking nothing, if it already has.
+	bool park(JobSystem* system, const std::shared_ptr<Job>& job);
+
+	mutable std::mutex counterMutex;
+	std::condition_variable doneCondition; // For wait().
+	uint32_t count;
+	std::vector<std::pair<JobSystem*, std::shared_ptr<Job>>> waiters;
+};
+
+// What a job wants next: to finish, or to wait for a counter and then be called again.
+struct JobStep
+{
+	std::shared_ptr<JobCounter> waitFor; // Null when the job is done.
+
+	static JobStep done() { return JobStep(); }
+	static JobStep wait(std::shared_ptr<JobCounter> counter) { JobStep step; step.waitFor = counter; return step; }
+};
+
+// A resumable job: called once to start, then again every time a counter it waited on completes, until it returns
+// JobStep::done(). It keeps its own progress (captured state and a stage number) between calls.
+typedef std::function<JobStep()> JobFunction;
+
+struct Job
+{
+	JobFunction function;
+	std::shared_ptr<JobCounter> finished;
+};
+
+// Runs jobs on a small worker pool without ever blocking a worker on a wait. A job that needs to wait returns the
+// counter it is waiting for and the worker moves on; the job is queued again when the counter completes. Long chains
+// of loads, uploads and child jobs therefore keep a fixed number of threads busy instead of each wait holding one.
+//
+// This does with explicit resumable functions what C++20 coroutines would do with co_await: the engine builds with
+// the Visual Studio 2015 toolset, which has no standard coroutines.
+class JobSystem
+{
+public:
+	// threadCount 0 uses getDefaultWorkerCount(). File reads run on one extra I/O thread.
+	explicit JobSystem(unsigned int threadCount = 0);
+
+	// Waits for every job to finish, so nothing may still be waiting on a counter that will never complete.
+	~JobSystem();
+
+	unsigned int getThreadCount() const { return (unsigned int)workers.size(); }
+
+	// Queue a job. Returns a counter that completes when the job is done.
+	std::shared_ptr<JobCounter> run(JobFunction function);
+
+	// Read a whole file into data on the I/O thread. Returns a counter that completes when the read has finished;
+	// data is left empty if the file could not be read.
+	std::shared_ptr<JobCounter> readFile(const std::string& path, std::shared_ptr<std::vector<char>> data);
+
+	// Block the calling thread, which must not be a worker, until every job (including waiting ones) is done.
+	void waitIdle();
+
+private:
+	friend class JobCounter;
+
+	struct FileRead
+	{
+		std::string path;
+		std::shared_ptr<std::vector<char>> data;
+		std::shared_ptr<JobCounter> finished;
+	};
+
+	void enqueue(const std::shared_ptr<Job>& job);
+	void workerLoop();
+	void ioLoop();
+
+	std::vector<std::thread> workers;
+	std::thread ioThread;
+
+	std::mutex queueMutex; // Guards everything below.
+	std::condition_variable queueCondition; // Wakes workers.
+	std::condition_variable ioCondition; // Wakes the I/O thread.
+	std::deque<std::shared_ptr<Job>> queue;
+	std::deque<FileRead> reads;
+	uint64_t unfinishedJobs = 0; // Queued, running or waiting.
+	std::condition_variable idleCondition;
+	bool shuttingDown = false;
+};
+
+// Load assetCount simulated assets (read a file, wait on a GPU upload fence, decode with child jobs) on a blocking
+// thread pool, where every wait holds a thread, and on a JobSystem of the same size, and print the throughput.
+void runJobSystemBenchmark(int assetCount, unsigned int threadCount);
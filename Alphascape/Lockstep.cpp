@@ -0,0 +1,244 @@
+#pragma region Library Imports
+
+#include <cmath> // Import sqrt, for the float world.
+#include <iomanip> // Import stream formatting.
+#include <iostream> // Import the IO stream libraries.
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "Lockstep.h" // Import the lockstep declarations.
+#include "StringId.h" // Import the FNV-1a hash.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Fixed Point
+
+// The shifts below rely on >> of a negative number being arithmetic, which every compiler the engine builds with does.
+
+Fixed Fixed::fromRatio(int64_t numerator, int64_t denominator)
+{
+	return fromRaw((int32_t)(uint32_t)(numerator * One / denominator));
+}
+
+Fixed Fixed::operator/(Fixed other) const
+{
+	if (other.raw == 0)
+		return fromRaw(raw >= 0 ? INT32_MAX : INT32_MIN);
+	return fromRaw((int32_t)(uint32_t)((int64_t)raw * One / other.raw));
+}
+
+Fixed fixedSqrt(Fixed value)
+{
+	if (value.getRaw() <= 0)
+		return Fixed();
+	// sqrt(raw / One) * One = sqrt(raw * One), by the bit-by-bit integer square root.
+	uint64_t remainder = (uint64_t)value.getRaw() << Fixed::FractionBits;
+	uint64_t root = 0;
+	uint64_t bit = 1ull << 62;
+	while (bit > remainder)
+		bit >>= 2;
+	while (bit) { // Masks rather than branches: which way each bit goes is unpredictable.
+		uint64_t trial = root + bit;
+		uint64_t taken = 0 - (uint64_t)(remainder >= trial);
+		remainder -= trial & taken;
+		root = (root >> 1) + (bit & taken);
+		bit >>= 2;
+	}
+	return Fixed::fromRaw((int32_t)root);
+}
+
+#pragma endregion
+
+#pragma region Simulation
+
+// The few operations the simulation needs beyond arithmetic, for each scalar type.
+template <typename Scalar>
+struct LockstepMath;
+
+template <>
+struct LockstepMath<float>
+{
+	static float ratio(int64_t numerator, int64_t denominator) { return (float)numerator / (float)denominator; }
+	static float squareRoot(float value) { return sqrt(value); }
+	static float toFloat(float value) { return value; }
+};
+
+template <>
+struct LockstepMath<Fixed>
+{
+	static Fixed ratio(int64_t numerator, int64_t denominator) { return Fixed::fromRatio(numerator, denominator); }
+	static Fixed squareRoot(Fixed value) { return fixedSqrt(value); }
+	static float toFloat(Fixed value) { return value.toFloat(); }
+};
+
+template <typename Scalar>
+LockstepWorld<Scalar>::LockstepWorld(int bodyCount, uint32_t seed, int tickRate)
+	: bodies(bodyCount), tickRate(tickRate)
+{
+	typedef LockstepMath<Scalar> Math;
+	uint32_t state = seed ? seed : 1;
+	auto next = [&state](int range) { // xorshift32, so placement is the same everywhere too.
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return (int)(state % (uint32_t)range) - range / 2;
+	};
+	for (Body& body : bodies) {
+		for (int axis = 0; axis < 2; axis++) {
+			body.position[axis] = Math::ratio(next(12000), 100); // Within 60 units of the centre.
+			body.velocity[axis] = Math::ratio(next(2000), 100);
+		}
+	}
+}
+
+template <typename Scalar>
+void LockstepWorld<Scalar>::step(const vector<LockstepInput>& inputs)
+{
+	typedef LockstepMath<Scalar> Math;
+	const Scalar deltaTime = Math::ratio(1, tickRate);
+	const Scalar wall = Math::ratio(64, 1);
+	const Scalar gravity = Math::ratio(8, 1);
+	const Scalar damping = Math::ratio(999, 1000);
+	const Scalar nearCentre = Math::ratio(1, 16);
+
+	for (const LockstepInput& input : inputs) {
+		if (bodies.empty())
+			break;
+		Body& body = bodies[input.body % bodies.size()];
+		body.velocity[0] += Math::ratio(input.impulse[0], 256);
+		body.velocity[1] += Math::ratio(input.impulse[1], 256);
+	}
+
+	for (Body& body : bodies) {
+		Scalar toCentre[2] = { -body.position[0], -body.position[1] };
+		Scalar distance = Math::squareRoot(toCentre[0] * toCentre[0] + toCentre[1] * toCentre[1]);
+		Scalar pull = distance > nearCentre ? gravity * deltaTime / distance : Scalar(); // One division, not two.
+		for (int axis = 0; axis < 2; axis++) {
+			body.velocity[axis] += toCentre[axis] * pull;
+			body.velocity[axis] *= damping;
+			body.position[axis] += body.velocity[axis] * deltaTime;
+			if (body.position[axis] > wall || body.position[axis] < -wall) { // Bounce off the arena walls.
+				body.position[axis] = body.position[axis] > wall ? wall : -wall;
+				body.velocity[axis] = -body.velocity[axis];
+			}
+		}
+	}
+	tick++;
+}
+
+template <typename Scalar>
+uint64_t LockstepWorld<Scalar>::computeChecksum() const
+{
+	// The raw bits: Fixed is a plain int32_t and Body has no padding, so equal states hash equal.
+	return hashNameAtRuntime((const char*)bodies.data(), bodies.size() * sizeof(Body)) ^ tick;
+}
+
+template class LockstepWorld<float>;
+template class LockstepWorld<Fixed>;
+
+void LockstepDesyncDetector::record(uint32_t tick, uint64_t checksum, bool remote)
+{
+	Entry& entry = entries[tick % Capacity];
+	if (entry.tick != tick) { // Reuse the slot of a tick too old to compare any more.
+		entry = Entry();
+		entry.tick = tick;
+	}
+	entry.checksums[remote] = checksum;
+	entry.recorded[remote] = true;
+	if (entry.recorded[0] && entry.recorded[1] && entry.checksums[0] != entry.checksums[1] && !desynced) {
+		desynced = true;
+		desyncTick = tick;
+		cout << "ERROR::LOCKSTEP::DESYNC\nTick " << tick << ": local " << hex << entry.checksums[0] << ", remote "
+			<< entry.checksums[1] << dec << endl;
+	}
+}
+
+int LockstepClock::advance(double seconds)
+{
+	double tickSeconds = 1.0 / tickRate;
+	accumulated += seconds;
+	int ticks = (int)(accumulated / tickSeconds);
+	accumulated -= ticks * tickSeconds;
+	if (ticks > MaxCatchUpTicks)
+		ticks = MaxCatchUpTicks;
+	return ticks;
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+// The inputs of a tick: a few pushes, made up from the tick number the same way on every peer.
+static void makeBenchmarkInputs(uint32_t tick, vector<LockstepInput>& inputs)
+{
+	inputs.clear();
+	for (uint32_t player = 0; player < 4; player++) {
+		LockstepInput input;
+		input.body = tick * 7919u + player * 104729u;
+		input.impulse[0] = (int16_t)((int)(tick * 31 + player * 17) % 512 - 256);
+		input.impulse[1] = (int16_t)((int)(tick * 13 + player * 29) % 512 - 256);
+		inputs.push_back(input);
+	}
+}
+
+template <typename Scalar>
+static vector<double> timeLockstepWorld(LockstepWorld<Scalar>& world, int ticks)
+{
+	vector<LockstepInput> inputs;
+	vector<double> samples;
+	for (int tick = 0; tick < ticks; tick++) {
+		makeBenchmarkInputs(world.getTick(), inputs);
+		BenchmarkTimer timer;
+		world.step(inputs);
+		world.computeChecksum();
+		samples.push_back(timer.elapsedMs());
+	}
+	return samples;
+}
+
+void runLockstepBenchmark(int bodyCount, int ticks, int tickRate)
+{
+	cout << "BENCH::LOCKSTEP " << bodyCount << " bodies, " << ticks << " ticks at " << tickRate << " Hz" << endl;
+
+	LockstepWorld<float> floatWorld(bodyCount, 1, tickRate);
+	LockstepWorld<Fixed> fixedWorld(bodyCount, 1, tickRate);
+	BenchmarkStats floatStats = computeBenchmarkStats(timeLockstepWorld(floatWorld, ticks));
+	BenchmarkStats fixedStats = computeBenchmarkStats(timeLockstepWorld(fixedWorld, ticks));
+	printBenchmarkStats("LOCKSTEP::FLOAT_TICK", floatStats);
+	printBenchmarkStats("LOCKSTEP::FIXED_TICK", fixedStats);
+	double drift = 0.0;
+	for (int i = 0; i < bodyCount; i++)
+		for (int axis = 0; axis < 2; axis++)
+			drift += fabs(floatWorld.getBodies()[i].position[axis] - fixedWorld.getBodies()[i].position[axis].toFloat());
+	ios::fmtflags flags = cout.flags();
+	streamsize precision = cout.precision();
+	cout << "  fixed point costs " << fixed << setprecision(2) << fixedStats.meanMs / floatStats.meanMs << "x float per tick; "
+		<< "mean position difference after " << ticks << " ticks " << drift / (2.0 * bodyCount) << " units" << endl;
+	cout.flags(flags);
+	cout.precision(precision);
+
+	// Two peers on the same inputs, then a third whose input differs once, as a packet corrupted in flight would.
+	const uint32_t corruptTick = (uint32_t)ticks / 2;
+	LockstepWorld<Fixed> peerA(bodyCount, 1, tickRate), peerB(bodyCount, 1, tickRate), peerC(bodyCount, 1, tickRate);
+	LockstepDesyncDetector agreeing, disagreeing;
+	vector<LockstepInput> inputs;
+	cout << "  expect one desync error, from the changed input:" << endl;
+	for (int tick = 0; tick < ticks; tick++) {
+		makeBenchmarkInputs(peerA.getTick(), inputs);
+		peerA.step(inputs);
+		peerB.step(inputs);
+		if (peerC.getTick() == corruptTick)
+			inputs[0].impulse[0]++;
+		peerC.step(inputs);
+		agreeing.recordLocal(peerA.getTick(), peerA.computeChecksum());
+		agreeing.recordRemote(peerB.getTick(), peerB.computeChecksum());
+		disagreeing.recordLocal(peerA.getTick(), peerA.computeChecksum());
+		disagreeing.recordRemote(peerC.getTick(), peerC.computeChecksum());
+	}
+	cout << "  identical peers " << (agreeing.hasDesynced() ? "desynced" : "agreed") << " on all " << ticks << " ticks; "
+		<< "input changed on tick " << corruptTick + 1 << ", desync caught "
+		<< (disagreeing.hasDesynced() ? "on tick " + to_string(disagreeing.getDesyncTick()) : string("never")) << endl;
+}
+
+#pragma endregion
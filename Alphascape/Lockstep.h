@@ -0,0 +1,166 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <cstdint> // Import the fixed width integers.
+#include <vector> // Import the vector container.
+
+#pragma endregion
+
+// Lockstep simulation: every peer runs the same ticks on the same inputs, so only inputs cross the network. That only
+// works if every peer computes bitwise identical results, which floating point does not promise across compilers,
+// instruction sets and optimisation levels. The deterministic mode therefore simulates in Fixed, whose arithmetic is
+// all integer and defined to wrap, and each tick's state is reduced to a checksum that peers compare to catch a
+// desync the tick it happens.
+
+#pragma region Fixed Point
+
+// A signed 16.16 fixed-point number: about -32768 to 32768 in steps of 1/65536. Results are identical everywhere;
+// overflow wraps like two's complement, and division by zero gives the largest value of the dividend's sign.
+class Fixed
+{
+public:
+	static const int FractionBits = 16;
+	static const int32_t One = 1 << FractionBits;
+
+	constexpr Fixed() : raw(0) {}
+
+	static constexpr Fixed fromRaw(int32_t raw) { return Fixed(raw, 0); }
+	static constexpr Fixed fromInt(int value) { return Fixed((int32_t)((uint32_t)value << FractionBits), 0); }
+
+	// numerator / denominator, rounded toward zero. The way to write constants and convert integer inputs.
+	static Fixed fromRatio(int64_t numerator, int64_t denominator);
+
+	// Only for data authored in floating point and converted identically on every peer (e.g. at load time).
+	static Fixed fromFloat(float value) { return fromRaw((int32_t)(value * One)); }
+
+	// For rendering and logs only: never feed the result back into the simulation.
+	float toFloat() const { return raw / (float)One; }
+
+	int32_t getRaw() const { return raw; }
+
+	Fixed operator+(Fixed other) const { return fromRaw((int32_t)((uint32_t)raw + (uint32_t)other.raw)); }
+	Fixed operator-(Fixed other) const { return fromRaw((int32_t)((uint32_t)raw - (uint32_t)other.raw)); }
+	Fixed operator-() const { return fromRaw((int32_t)(0u - (uint32_t)raw)); }
+	Fixed operator*(Fixed other) const { return fromRaw((int32_t)(uint32_t)(((int64_t)raw * other.raw) >> FractionBits)); }
+	Fixed operator/(Fixed other) const;
+
+	Fixed& operator+=(Fixed other) { return *this = *this + other; }
+	Fixed& operator-=(Fixed other) { return *this = *this - other; }
+	Fixed& operator*=(Fixed other) { return *this = *this * other; }
+	Fixed& operator/=(Fixed other) { return *this = *this / other; }
+
+	bool operator==(Fixed other) const { return raw == other.raw; }
+	bool operator!=(Fixed other) const { return raw != other.raw; }
+	bool operator<(Fixed other) const { return raw < other.raw; }
+	bool operator>(Fixed other) const { return raw > other.raw; }
+	bool operator<=(Fixed other) const { return raw <= other.raw; }
+	bool operator>=(Fixed other) const { return raw >= other.raw; }
+
+private:
+	constexpr Fixed(int32_t raw, int) : raw(raw) {}
+
+	int32_t raw;
+};
+
+// The square root, exact to the last bit (rounded down), computed with integers only. Negative values give 0.
+Fixed fixedSqrt(Fixed value);
+
+#pragma endregion
+
+#pragma region Simulation
+
+// One player's command for a tick: push a body. Integers only, so every peer applies exactly the same input.
+struct LockstepInput
+{
+	uint32_t body;
+	int16_t impulse[2]; // In 1/256ths of a unit per second.
+};
+
+// Bodies falling toward the centre of a walled arena, pushed around by inputs. Scalar is Fixed for the deterministic
+// mode, or float to measure what determinism costs; the code is the same either way.
+template <typename Scalar>
+class LockstepWorld
+{
+public:
+	struct Body
+	{
+		Scalar position[2];
+		Scalar velocity[2];
+	};
+
+	// bodyCount bodies placed from seed, ticking tickRate times a second.
+	LockstepWorld(int bodyCount, uint32_t seed, int tickRate);
+
+	// Apply this tick's inputs, in order, then advance one tick.
+	void step(const std::vector<LockstepInput>& inputs);
+
+	// FNV-1a of the whole state, to compare with other peers.
+	uint64_t computeChecksum() const;
+
+	uint32_t getTick() const { return tick; }
+	int getTickRate() const { return tickRate; }
+	const std::vector<Body>& getBodies() const { return bodies; }
+
+private:
+	std::vector<Body> bodies;
+	uint32_t tick = 0;
+	int tickRate;
+};
+
+// Keeps this peer's checksums and other peers' for the last Capacity ticks, and reports the first tick that differs.
+class LockstepDesyncDetector
+{
+public:
+	static const uint32_t Capacity = 256;
+
+	void recordLocal(uint32_t tick, uint64_t checksum) { record(tick, checksum, false); }
+	void recordRemote(uint32_t tick, uint64_t checksum) { record(tick, checksum, true); }
+
+	bool hasDesynced() const { return desynced; }
+	uint32_t getDesyncTick() const { return desyncTick; }
+
+private:
+	struct Entry
+	{
+		uint32_t tick = UINT32_MAX;
+		uint64_t checksums[2] = { 0, 0 }; // Local, remote.
+		bool recorded[2] = { false, false };
+	};
+
+	// Store a checksum; once both sides of a tick are in, compare them and print an ERROR::LOCKSTEP::DESYNC if they differ.
+	void record(uint32_t tick, uint64_t checksum, bool remote);
+
+	Entry entries[Capacity];
+	bool desynced = false;
+	uint32_t desyncTick = 0;
+};
+
+// Turns real time into whole simulation ticks at a fixed rate, carrying the remainder over to the next frame.
+class LockstepClock
+{
+public:
+	// The most ticks advance() returns at once, so a long stall is dropped rather than simulated in one frame.
+	static const int MaxCatchUpTicks = 8;
+
+	explicit LockstepClock(int tickRate) : tickRate(tickRate) {}
+
+	void setTickRate(int rate) { tickRate = rate > 0 ? rate : 1; }
+	int getTickRate() const { return tickRate; }
+
+	// Add seconds of real time, and return how many ticks to simulate now.
+	int advance(double seconds);
+
+	// How far real time is into the next tick, 0 to 1, for interpolating what is drawn.
+	double getAlpha() const { return accumulated * tickRate; }
+
+private:
+	int tickRate;
+	double accumulated = 0.0;
+};
+
+#pragma endregion
+
+// Simulate bodyCount bodies for ticks ticks in float and in Fixed, print the time per tick of each, and check that two
+// Fixed peers given the same inputs agree every tick and that a changed input is caught as a desync.
+void runLockstepBenchmark(int bodyCount, int ticks, int tickRate);
@@ -0,0 +1,277 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import min and max.
+#include <iostream> // Import the IO stream libraries.
+#include <random> // Import the random number generators.
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "GLRenderDevice.h" // Import the GL render device.
+#include "Material.h" // Import the material library.
+#include "Shader.h" // Import the shader compiler.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Material Library
+
+MaterialLibrary::MaterialLibrary(RenderDevice& renderDevice) : device(renderDevice)
+{
+	BufferDesc desc;
+	desc.usage = BufferUsage::Uniform;
+	desc.size = MaxMaterials * sizeof(MaterialParams);
+	desc.dynamic = true;
+	buffer = device.createBuffer(desc);
+}
+
+MaterialLibrary::~MaterialLibrary()
+{
+	device.destroyBuffer(buffer);
+}
+
+uint32_t MaterialLibrary::add(const MaterialParams& materialParams, TextureHandle texture, const SamplerDesc& sampler)
+{
+	if (params.size() >= MaxMaterials) {
+		cout << "ERROR::MATERIAL::LIBRARY_FULL\n" << MaxMaterials << endl;
+		return MaxMaterials;
+	}
+	params.push_back(materialParams);
+	textures.push_back(texture);
+	samplers.push_back(device.getSampler(sampler)); // Shared with every other material sampled the same way.
+
+	uint32_t material = (uint32_t)params.size() - 1;
+	setParams(material, materialParams);
+	return material;
+}
+
+void MaterialLibrary::setParams(uint32_t material, const MaterialParams& materialParams)
+{
+	params[material] = materialParams;
+	if (dirtyFirst == dirtyEnd) {
+		dirtyFirst = material;
+		dirtyEnd = material + 1;
+	} else {
+		dirtyFirst = min(dirtyFirst, material);
+		dirtyEnd = max(dirtyEnd, material + 1);
+	}
+}
+
+void MaterialLibrary::upload()
+{
+	if (dirtyFirst == dirtyEnd)
+		return;
+	device.updateBuffer(buffer, dirtyFirst * sizeof(MaterialParams), &params[dirtyFirst], (dirtyEnd - dirtyFirst) * sizeof(MaterialParams));
+	dirtyFirst = dirtyEnd = 0;
+}
+
+#pragma endregion
+
+#pragma region Shaders
+
+// Materials by index: the draw's constants carry its quad and material.
+static const GLchar* materialVertexShaderSource =
+"#version 330 core\n"
+"layout(std140) uniform Constants { vec4 rect; ivec4 material; };\n"
+"layout(location = 0) in vec2 corner;\n"
+"out vec2 uv;\n"
+"flat out int materialIndex;\n"
+"void main()\n"
+"{\n"
+"uv = corner;\n"
+"materialIndex = material.x;\n"
+"gl_Position = vec4(rect.xy + corner * rect.zw, 0.0, 1.0);\n"
+"}\n\0";
+static const GLchar* materialFragmentShaderSource =
+"#version 330 core\n"
+MATERIAL_BLOCK_GLSL
+"uniform sampler2DArray images;\n"
+"in vec2 uv;\n"
+"flat in int materialIndex;\n"
+"out vec4 color;\n"
+"void main()\n"
+"{\n"
+"Material material = materials[materialIndex];\n"
+"color = texture(images, vec3(uv, material.params.z)) * material.baseColor + material.emissive;\n"
+"}\n\0";
+
+// The same material as loose uniforms, set before every draw.
+static const GLchar* uniformVertexShaderSource =
+"#version 330 core\n"
+"uniform vec4 rect;\n"
+"layout(location = 0) in vec2 corner;\n"
+"out vec2 uv;\n"
+"void main()\n"
+"{\n"
+"uv = corner;\n"
+"gl_Position = vec4(rect.xy + corner * rect.zw, 0.0, 1.0);\n"
+"}\n\0";
+static const GLchar* uniformFragmentShaderSource =
+"#version 330 core\n"
+"uniform vec4 baseColor;\n"
+"uniform vec4 emissive;\n"
+"uniform vec4 params;\n"
+"uniform sampler2DArray images;\n"
+"in vec2 uv;\n"
+"out vec4 color;\n"
+"void main()\n"
+"{\n"
+"color = texture(images, vec3(uv, params.z)) * baseColor + emissive;\n"
+"}\n\0";
+
+#pragma endregion
+
+#pragma region Benchmark
+
+void runMaterialBenchmark(GLFWwindow* window, int materialCount, int drawCount, int frames)
+{
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+	glfwSwapInterval(0); // Never wait for vertical sync while measuring.
+
+	GLRenderDevice device;
+	const float clearColor[4] = { 0.529f, 0.808f, 0.980f, 1.0f };
+	mt19937 random(1234); // Fixed seed, so runs are comparable.
+
+	// Eight checkerboard layers in one array texture.
+	const int layers = 8, size = 32;
+	vector<uint8_t> pixels((size_t)size * size * 4 * layers);
+	for (size_t i = 0; i < pixels.size(); i += 4) {
+		size_t layer = i / (size * size * 4), x = (i / 4) % size, y = (i / 4 / size) % size;
+		uint8_t value = ((x / 4 + y / 4 + layer) % 2) ? 255 : 64;
+		pixels[i] = pixels[i + 1] = pixels[i + 2] = value;
+		pixels[i + 3] = 255;
+	}
+	TextureDesc textureDesc;
+	textureDesc.width = textureDesc.height = size;
+	textureDesc.layers = layers;
+	textureDesc.initialData = pixels.data();
+	TextureHandle texture = device.createTexture(textureDesc);
+
+	// Materials with random colours, layers and one of four sampling states.
+	uniform_real_distribution<float> unit(0.0f, 1.0f);
+	MaterialLibrary library(device);
+	for (int i = 0; i < materialCount; i++) {
+		MaterialParams params;
+		for (int channel = 0; channel < 3; channel++)
+			params.baseColor[channel] = unit(random);
+		params.emissive[0] = 0.1f * unit(random);
+		params.textureLayer = (float)(i % layers);
+		SamplerDesc sampler;
+		sampler.magFilter = sampler.minFilter = i % 2 == 0 ? SamplerFilter::Linear : SamplerFilter::Nearest;
+		sampler.wrapU = sampler.wrapV = (i / 2) % 2 == 0 ? SamplerWrap::Repeat : SamplerWrap::ClampToEdge;
+		library.add(params, texture, sampler);
+	}
+	library.upload();
+
+	// Random quads with random materials.
+	struct Draw { float rect[4]; int32_t material[4]; }; // std140 Constants: vec4 rect; ivec4 material.
+	uniform_real_distribution<float> position(-1.0f, 0.9f), extent(0.02f, 0.1f);
+	uniform_int_distribution<int> material(0, materialCount - 1);
+	vector<Draw> draws(drawCount);
+	for (Draw& draw : draws)
+		draw = { { position(random), position(random), extent(random), extent(random) }, { material(random), 0, 0, 0 } };
+
+	const float corners[] = { 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f };
+	BufferDesc cornerDesc;
+	cornerDesc.size = sizeof(corners);
+	cornerDesc.initialData = corners;
+	BufferHandle cornerBuffer = device.createBuffer(cornerDesc);
+
+	PipelineDesc pipelineDesc;
+	pipelineDesc.vertexSource = materialVertexShaderSource;
+	pipelineDesc.fragmentSource = materialFragmentShaderSource;
+	pipelineDesc.uniformBlocks[0] = "Materials";
+	pipelineDesc.layout.add(0, 2, 0, 0);
+	pipelineDesc.layout.strides[0] = 2 * sizeof(float);
+	PipelineHandle pipeline = device.createPipeline(pipelineDesc);
+
+	// The uniform path is raw GL, as materials were set before the library.
+	GLuint uniformProgram = compileShaderProgram(uniformVertexShaderSource, uniformFragmentShaderSource);
+	UniformLocations uniforms(uniformProgram);
+	GLint rectLocation = uniforms.get(UniformId("rect"));
+	GLint baseColorLocation = uniforms.get(UniformId("baseColor"));
+	GLint emissiveLocation = uniforms.get(UniformId("emissive"));
+	GLint paramsLocation = uniforms.get(UniformId("params"));
+	GLuint uniformVertexArray;
+	glGenVertexArrays(1, &uniformVertexArray);
+	glBindVertexArray(uniformVertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, device.getGLBuffer(cornerBuffer));
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid*)0);
+	glEnableVertexAttribArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	if (!pipeline.valid() || !uniformProgram) {
+		glDeleteVertexArrays(1, &uniformVertexArray);
+		glDeleteProgram(uniformProgram); // Ignored for 0.
+		return;
+	}
+
+	cout << "BENCH::MATERIALS " << drawCount << " draws, " << materialCount << " materials sharing " << device.getSamplerCount() << " sampler objects" << endl;
+
+	// Uniforms: every draw sets the texture's sampling state and the material's uniforms.
+	GLuint textureName = device.getGLTexture(texture);
+	vector<double> samples;
+	for (int frame = 0; frame < frames; frame++) {
+		BenchmarkTimer timer;
+		device.beginFrame(width, height, clearColor);
+		glUseProgram(uniformProgram);
+		glBindVertexArray(uniformVertexArray);
+		for (const Draw& draw : draws) {
+			const MaterialParams& params = library.getParams(draw.material[0]);
+			bool linear = draw.material[0] % 2 == 0, repeat = (draw.material[0] / 2) % 2 == 0;
+			glBindTexture(GL_TEXTURE_2D_ARRAY, textureName);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, linear ? GL_LINEAR : GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, linear ? GL_LINEAR : GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE);
+			glUniform4fv(baseColorLocation, 1, params.baseColor);
+			glUniform4fv(emissiveLocation, 1, params.emissive);
+			glUniform4f(paramsLocation, params.roughness, params.metallic, params.textureLayer, params.alphaCutoff);
+			glUniform4fv(rectLocation, 1, draw.rect);
+			glDrawArrays(GL_TRIANGLES, 0, 6);
+		}
+		glBindVertexArray(0);
+		glUseProgram(0);
+		glFinish(); // Include the GPU work.
+		samples.push_back(timer.elapsedMs());
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+	printBenchmarkStats("MATERIALS::UNIFORMS", computeBenchmarkStats(samples));
+	cout << "  per frame: " << drawCount * 10 << " GL calls (bind, 4 texture parameters, 4 uniforms, draw per draw)" << endl;
+
+	// Library: every draw binds the shared texture with its material's cached sampler and passes an index.
+	CommandList* list = device.createCommandList();
+	samples.clear();
+	device.resetStats();
+	for (int frame = 0; frame < frames; frame++) {
+		BenchmarkTimer timer;
+		list->begin();
+		list->bindPipeline(pipeline);
+		list->bindVertexBuffer(0, cornerBuffer);
+		list->bindUniformBuffer(0, library.getBuffer());
+		for (const Draw& draw : draws) {
+			list->bindTexture(0, library.getTexture(draw.material[0]), library.getSampler(draw.material[0]));
+			list->setConstants(&draw, sizeof(draw));
+			list->draw(6);
+		}
+		list->end();
+		library.upload();
+		device.beginFrame(width, height, clearColor);
+		device.submit(&list, 1);
+		device.endFrame();
+		glFinish();
+		samples.push_back(timer.elapsedMs());
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+	const RenderStats& stats = device.getStats();
+	printBenchmarkStats("MATERIALS::LIBRARY", computeBenchmarkStats(samples));
+	cout << "  per frame: " << stats.textureBinds / frames << " texture binds, " << stats.samplerBinds / frames << " sampler binds, "
+		<< stats.drawCalls / frames << " draws" << endl;
+
+	glDeleteVertexArrays(1, &uniformVertexArray);
+	glDeleteProgram(uniformProgram);
+}
+
+#pragma endregion
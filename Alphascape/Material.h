@@ -0,0 +1,74 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <cstdint> // Import the fixed width integers.
+#include <vector> // Import the vector container.
+
+#include "Graphics.h" // Import GLEW and GLFW.
+#include "Reflection.h" // Import the std140 layout checks.
+#include "RenderDevice.h" // Import the render device interface.
+
+#pragma endregion
+
+// One material's parameters, laid out as the std140 "Material" struct of MATERIAL_BLOCK_GLSL.
+struct MaterialParams
+{
+	float baseColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	float emissive[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float roughness = 0.5f;
+	float metallic = 0.0f;
+	float textureLayer = 0.0f; // Layer of the material's array texture.
+	float alphaCutoff = 0.0f;
+};
+#define MATERIAL_PARAMS_FIELDS(FIELD) FIELD(baseColor) FIELD(emissive) FIELD(roughness) FIELD(metallic) FIELD(textureLayer) FIELD(alphaCutoff)
+REFLECT(MaterialParams, MATERIAL_PARAMS_FIELDS)
+static_assert(isStd140Layout<MaterialParams>(), "MaterialParams must match the std140 Material struct");
+
+// The GLSL side of MaterialLibrary, for shaders that index materials (params is roughness, metallic, layer, cutoff).
+// Bind the library's buffer to the pipeline's "Materials" uniform block.
+#define MATERIAL_BLOCK_GLSL \
+	"struct Material { vec4 baseColor; vec4 emissive; vec4 params; };\n" \
+	"layout(std140) uniform Materials { Material materials[256]; };\n"
+
+// Every material's parameters in one uniform buffer, so a draw selects its material by index (in its constants)
+// instead of setting uniforms, and switching material is an index change. Each material's sampling state goes
+// through the device's sampler cache, so materials that sample alike share one sampler object.
+class MaterialLibrary
+{
+public:
+	static const uint32_t MaxMaterials = 256; // The size of MATERIAL_BLOCK_GLSL's array (12 KB of the 16 KB minimum).
+
+	// Creates the buffer; the device must outlive the library.
+	explicit MaterialLibrary(RenderDevice& device);
+	~MaterialLibrary();
+
+	// Add a material. Returns its index, or MaxMaterials (with an ERROR) when the library is full.
+	uint32_t add(const MaterialParams& params, TextureHandle texture = TextureHandle(), const SamplerDesc& sampler = SamplerDesc());
+
+	// Change a material's parameters; the change reaches the GPU on the next upload().
+	void setParams(uint32_t material, const MaterialParams& params);
+
+	const MaterialParams& getParams(uint32_t material) const { return params[material]; }
+	TextureHandle getTexture(uint32_t material) const { return textures[material]; }
+	SamplerHandle getSampler(uint32_t material) const { return samplers[material]; }
+	size_t size() const { return params.size(); }
+
+	// Copy the changed range of parameter blocks into the buffer. Call before submitting the frame's lists.
+	void upload();
+
+	BufferHandle getBuffer() const { return buffer; }
+
+private:
+	RenderDevice& device;
+	BufferHandle buffer;
+	std::vector<MaterialParams> params;
+	std::vector<TextureHandle> textures;
+	std::vector<SamplerHandle> samplers;
+	uint32_t dirtyFirst = 0, dirtyEnd = 0; // The materials changed since the last upload.
+};
+
+// Draw drawCount quads with materialCount materials in random order, first by setting the material with uniform
+// calls and per-texture sampling state per draw, then by material index into the library's buffer with cached
+// samplers. Prints timings, GL calls and binds per frame.
+void runMaterialBenchmark(GLFWwindow* window, int materialCount, int drawCount, int frames);
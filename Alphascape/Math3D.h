@@ -0,0 +1,134 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <cmath> // Import the C maths libraries.
+
+#pragma endregion
+
+// The little vector and matrix maths the engine needs on the CPU. Matrices are column-major float[16], as GL and
+// std140 uniform blocks expect, and use GL's clip space (z in [-1, 1]).
+
+struct Vec3
+{
+	float x = 0.0f, y = 0.0f, z = 0.0f;
+
+	Vec3() {}
+	Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+	explicit Vec3(const float* v) : x(v[0]), y(v[1]), z(v[2]) {}
+
+	Vec3 operator+(const Vec3& other) const { return Vec3(x + other.x, y + other.y, z + other.z); }
+	Vec3 operator-(const Vec3& other) const { return Vec3(x - other.x, y - other.y, z - other.z); }
+	Vec3 operator*(float scale) const { return Vec3(x * scale, y * scale, z * scale); }
+};
+
+inline float dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Vec3 cross(const Vec3& a, const Vec3& b) { return Vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x); }
+inline float length(const Vec3& v) { return std::sqrt(dot(v, v)); }
+inline Vec3 normalize(const Vec3& v) { float l = length(v); return l > 0.0f ? v * (1.0f / l) : v; }
+
+// out = a * b. out may not alias a or b.
+inline void multiplyMatrix(const float a[16], const float b[16], float out[16])
+{
+	for (int column = 0; column < 4; column++)
+		for (int row = 0; row < 4; row++) {
+			float sum = 0.0f;
+			for (int k = 0; k < 4; k++)
+				sum += a[k * 4 + row] * b[column * 4 + k];
+			out[column * 4 + row] = sum;
+		}
+}
+
+// A right-handed perspective projection; fovY in radians.
+inline void perspectiveMatrix(float fovY, float aspect, float nearZ, float farZ, float out[16])
+{
+	float f = 1.0f / std::tan(fovY * 0.5f);
+	for (int i = 0; i < 16; i++)
+		out[i] = 0.0f;
+	out[0] = f / aspect;
+	out[5] = f;
+	out[10] = (farZ + nearZ) / (nearZ - farZ);
+	out[11] = -1.0f;
+	out[14] = 2.0f * farZ * nearZ / (nearZ - farZ);
+}
+
+// A view matrix looking from eye at target, with up roughly up.
+inline void lookAtMatrix(const Vec3& eye, const Vec3& target, const Vec3& up, float out[16])
+{
+	Vec3 forward = normalize(target - eye);
+	Vec3 right = normalize(cross(forward, up));
+	Vec3 trueUp = cross(right, forward);
+	const float matrix[16] = {
+		right.x, trueUp.x, -forward.x, 0.0f,
+		right.y, trueUp.y, -forward.y, 0.0f,
+		right.z, trueUp.z, -forward.z, 0.0f,
+		-dot(right, eye), -dot(trueUp, eye), dot(forward, eye), 1.0f };
+	for (int i = 0; i < 16; i++)
+		out[i] = matrix[i];
+}
+
+// out = the inverse of m, by cofactors. Returns false (leaving out untouched) if m is singular. out may alias m.
+inline bool invertMatrix(const float m[16], float out[16])
+{
+	float inverse[16];
+	inverse[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+	inverse[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+	inverse[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+	inverse[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+	inverse[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+	inverse[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+	inverse[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+	inverse[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+	inverse[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+	inverse[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+	inverse[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+	inverse[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+	inverse[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+	inverse[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+	inverse[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+	inverse[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+	float determinant = m[0] * inverse[0] + m[1] * inverse[4] + m[2] * inverse[8] + m[3] * inverse[12];
+	if (determinant == 0.0f)
+		return false;
+	for (int i = 0; i < 16; i++)
+		out[i] = inverse[i] / determinant;
+	return true;
+}
+
+// The point m * (x, y, z, 1) after the perspective divide.
+inline Vec3 transformPoint(const float m[16], const Vec3& p)
+{
+	float w = m[3] * p.x + m[7] * p.y + m[11] * p.z + m[15];
+	return Vec3(m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12], m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13], m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14]) * (1.0f / w);
+}
+
+// The six planes of a view frustum, each (a, b, c, d) with a * x + b * y + c * z + d >= 0 inside.
+struct Frustum
+{
+	float planes[6][4];
+};
+
+// Extract the frustum of a column-major view-projection matrix (Gribb and Hartmann): each plane is the last row
+// of the matrix plus or minus one of the others.
+inline void extractFrustum(const float viewProjection[16], Frustum& out)
+{
+	for (int plane = 0; plane < 6; plane++) {
+		int row = plane / 2;
+		float sign = plane % 2 == 0 ? 1.0f : -1.0f;
+		for (int column = 0; column < 4; column++)
+			out.planes[plane][column] = viewProjection[column * 4 + 3] + sign * viewProjection[column * 4 + row];
+	}
+}
+
+// False only if the box is certainly outside: entirely behind one of the planes.
+inline bool frustumIntersectsBox(const Frustum& frustum, const Vec3& low, const Vec3& high)
+{
+	for (const float* plane : frustum.planes) {
+		// The corner furthest along the plane's normal.
+		Vec3 corner(plane[0] >= 0.0f ? high.x : low.x, plane[1] >= 0.0f ? high.y : low.y, plane[2] >= 0.0f ? high.z : low.z);
+		if (plane[0] * corner.x + plane[1] * corner.y + plane[2] * corner.z + plane[3] < 0.0f)
+			return false;
+	}
+	return true;
+}
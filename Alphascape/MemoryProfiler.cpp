@@ -0,0 +1,300 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import sort and find.
+#include <cstdlib> // Import malloc and free.
+#include <fstream> // Import the file streams.
+#include <iomanip> // Import stream formatting.
+#include <iostream> // Import the IO stream libraries.
+#include <thread> // Import the threads.
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <malloc.h> // Import _aligned_malloc.
+#include <windows.h> // Import CaptureStackBackTrace.
+#elif defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h> // Import backtrace.
+#define MEMORY_PROFILER_BACKTRACE
+#endif
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "MemoryProfiler.h" // Import the memory profiler declarations.
+#include "StringId.h" // Import the FNV-1a hash.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region MemoryHeap
+
+MemoryHeap::MemoryHeap(const char* heapName, size_t budget)
+	: name(heapName), budgetBytes(budget)
+{
+	MemoryProfiler::instance().add(this);
+}
+
+MemoryHeap::~MemoryHeap()
+{
+	MemoryProfiler::instance().remove(this);
+}
+
+void* MemoryHeap::allocate(size_t size, size_t alignment)
+{
+	void* pointer;
+	if (alignment <= alignof(max_align_t))
+		pointer = malloc(size ? size : 1);
+	else {
+#ifdef _WIN32
+		pointer = _aligned_malloc(size ? size : 1, alignment);
+#else
+		if (posix_memalign(&pointer, alignment, size ? size : 1) != 0)
+			pointer = nullptr;
+#endif
+	}
+	if (!pointer)
+		return nullptr;
+
+	allocationCount.fetch_add(1, memory_order_relaxed);
+	allocatedBytes.fetch_add(size, memory_order_relaxed);
+	size_t live = liveBytes.fetch_add(size, memory_order_relaxed) + size;
+	size_t peak = peakBytes.load(memory_order_relaxed);
+	while (live > peak && !peakBytes.compare_exchange_weak(peak, live, memory_order_relaxed)) {}
+
+	size_t budget = budgetBytes.load(memory_order_relaxed);
+	if (budget && live > budget && !overBudget.exchange(true, memory_order_relaxed))
+		cout << "ERROR::MEMORY::BUDGET_EXCEEDED\n" << name << ": " << live << " bytes live, budget " << budget << endl;
+
+	uint32_t interval = stackSampleInterval.load(memory_order_relaxed);
+	if (interval && stackSampleCounter.fetch_add(1, memory_order_relaxed) % interval == 0)
+		recordStack(size);
+	return pointer;
+}
+
+void MemoryHeap::deallocate(void* pointer, size_t size, size_t alignment)
+{
+	if (!pointer)
+		return;
+	if (alignment <= alignof(max_align_t))
+		free(pointer);
+	else {
+#ifdef _WIN32
+		_aligned_free(pointer);
+#else
+		free(pointer);
+#endif
+	}
+	freeCount.fetch_add(1, memory_order_relaxed);
+	size_t live = liveBytes.fetch_sub(size, memory_order_relaxed) - size;
+	size_t budget = budgetBytes.load(memory_order_relaxed);
+	if (!budget || live <= budget)
+		overBudget.store(false, memory_order_relaxed); // Warn again the next time it goes over.
+}
+
+void MemoryHeap::recordStack(size_t size)
+{
+	MemoryStackSample sample;
+#ifdef _WIN32
+	sample.frameCount = CaptureStackBackTrace(2, MemoryStackSample::MaxFrames, sample.frames, nullptr); // Skip this and allocate().
+#elif defined(MEMORY_PROFILER_BACKTRACE)
+	void* frames[MemoryStackSample::MaxFrames + 2];
+	int captured = backtrace(frames, MemoryStackSample::MaxFrames + 2);
+	sample.frameCount = (uint32_t)max(0, captured - 2);
+	copy(frames + min(captured, 2), frames + captured, sample.frames);
+#endif
+	uint64_t hash = hashNameAtRuntime((const char*)sample.frames, sample.frameCount * sizeof(void*));
+
+	lock_guard<std::mutex> lock(stackMutex);
+	MemoryStackSample& stack = stacks.emplace(hash, sample).first->second;
+	stack.count++;
+	stack.bytes += size;
+}
+
+vector<MemoryStackSample> MemoryHeap::getStackSamples() const
+{
+	vector<MemoryStackSample> samples;
+	{
+		lock_guard<std::mutex> lock(stackMutex);
+		for (const auto& stack : stacks)
+			samples.push_back(stack.second);
+	}
+	sort(samples.begin(), samples.end(), [](const MemoryStackSample& a, const MemoryStackSample& b) { return a.bytes > b.bytes; });
+	return samples;
+}
+
+#pragma endregion
+
+#pragma region MemoryProfiler
+
+MemoryProfiler& MemoryProfiler::instance()
+{
+	static MemoryProfiler profiler;
+	return profiler;
+}
+
+void MemoryProfiler::add(MemoryHeap* heap)
+{
+	lock_guard<std::mutex> lock(heapsMutex);
+	heaps.push_back(heap);
+	previous[heap] = Previous{ heap->getAllocationCount(), heap->getAllocatedBytes() };
+	heap->setStackSampleInterval(stackSampleInterval);
+}
+
+void MemoryProfiler::remove(MemoryHeap* heap)
+{
+	lock_guard<std::mutex> lock(heapsMutex);
+	heaps.erase(std::remove(heaps.begin(), heaps.end(), heap), heaps.end());
+	previous.erase(heap);
+}
+
+vector<MemoryHeapStats> MemoryProfiler::sample()
+{
+	lock_guard<std::mutex> lock(heapsMutex);
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	double seconds = chrono::duration<double>(now - previousTime).count();
+	previousTime = now;
+
+	vector<MemoryHeapStats> stats;
+	for (MemoryHeap* heap : heaps) {
+		MemoryHeapStats heapStats;
+		heapStats.name = heap->getName();
+		heapStats.liveBytes = heap->getLiveBytes();
+		heapStats.peakBytes = heap->getPeakBytes();
+		heapStats.budgetBytes = heap->getBudget();
+		heapStats.allocations = heap->getAllocationCount();
+		heapStats.frees = heap->getFreeCount();
+		heapStats.allocatedBytes = heap->getAllocatedBytes();
+		Previous& last = previous[heap];
+		if (seconds > 0.0) {
+			heapStats.allocationsPerSecond = (heapStats.allocations - last.allocations) / seconds;
+			heapStats.bytesPerSecond = (heapStats.allocatedBytes - last.allocatedBytes) / seconds;
+		}
+		last = Previous{ heapStats.allocations, heapStats.allocatedBytes };
+		stats.push_back(heapStats);
+	}
+	sort(stats.begin(), stats.end(), [](const MemoryHeapStats& a, const MemoryHeapStats& b) { return a.liveBytes > b.liveBytes; });
+	latest = stats;
+	return stats;
+}
+
+void MemoryProfiler::setStackSampleInterval(uint32_t interval)
+{
+	lock_guard<std::mutex> lock(heapsMutex);
+	stackSampleInterval = interval;
+	for (MemoryHeap* heap : heaps)
+		heap->setStackSampleInterval(interval);
+}
+
+void MemoryProfiler::printReport(ostream& out)
+{
+	writeTable(out, sample());
+}
+
+void MemoryProfiler::writeTable(ostream& out, const vector<MemoryHeapStats>& stats)
+{
+	size_t total = 0;
+	ios::fmtflags flags = out.flags();
+	streamsize precision = out.precision();
+	out << left << setw(24) << "Heap" << right << setw(12) << "Live KB" << setw(12) << "Peak KB" << setw(12) << "Budget KB"
+		<< setw(14) << "Allocs" << setw(12) << "Allocs/s" << setw(12) << "KB/s" << "\n";
+	out << fixed << setprecision(1);
+	for (const MemoryHeapStats& heap : stats) {
+		out << left << setw(24) << heap.name << right << setw(12) << heap.liveBytes / 1024.0 << setw(12) << heap.peakBytes / 1024.0
+			<< setw(12);
+		if (heap.budgetBytes)
+			out << heap.budgetBytes / 1024.0;
+		else
+			out << "-";
+		out << setw(14) << heap.allocations << setw(12) << heap.allocationsPerSecond << setw(12) << heap.bytesPerSecond / 1024.0
+			<< (heap.budgetBytes && heap.liveBytes > heap.budgetBytes ? "  OVER BUDGET" : "") << "\n";
+		total += heap.liveBytes;
+	}
+	out << left << setw(24) << "Total" << right << setw(12) << total / 1024.0 << endl;
+	out.flags(flags);
+	out.precision(precision);
+}
+
+bool MemoryProfiler::exportReport(const string& path)
+{
+	ofstream file(path);
+	if (!file) {
+		cout << "ERROR::MEMORY::REPORT_NOT_WRITTEN\n" << path << endl;
+		return false;
+	}
+	vector<MemoryHeapStats> stats;
+	vector<MemoryHeap*> heapsNow;
+	{
+		lock_guard<std::mutex> lock(heapsMutex);
+		stats = latest;
+		heapsNow = heaps;
+	}
+	writeTable(file, stats.empty() ? sample() : stats);
+
+	for (MemoryHeap* heap : heapsNow) {
+		vector<MemoryStackSample> samples = heap->getStackSamples();
+		if (samples.empty())
+			continue;
+		file << "\nSampled call stacks of " << heap->getName() << ", most bytes first:\n";
+		for (const MemoryStackSample& sample : samples) {
+			file << sample.count << " samples, " << sample.bytes << " bytes\n";
+#ifdef MEMORY_PROFILER_BACKTRACE
+			char** symbols = backtrace_symbols(sample.frames, (int)sample.frameCount);
+			for (uint32_t frame = 0; frame < sample.frameCount; frame++)
+				file << "    " << (symbols ? symbols[frame] : "?") << "\n";
+			free(symbols);
+#else
+			for (uint32_t frame = 0; frame < sample.frameCount; frame++) // Addresses, for symbolising against the PDB.
+				file << "    " << sample.frames[frame] << "\n";
+#endif
+		}
+	}
+	return true;
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+void runMemoryProfilerBenchmark(int blockCount, int threadCount)
+{
+	const int rounds = 5;
+	MemoryHeap heap("Benchmark", 0);
+	cout << "BENCH::MEMORY " << blockCount << " blocks of 16 to 256 bytes, allocated and freed on " << threadCount << " threads" << endl;
+
+	const char* labels[] = { "MEMORY::MALLOC", "MEMORY::HEAP", "MEMORY::HEAP_STACKS_1_IN_64" };
+	for (int mode = 0; mode < 3; mode++) {
+		heap.setStackSampleInterval(mode == 2 ? 64 : 0);
+		vector<double> samples;
+		for (int round = 0; round < rounds; round++) {
+			BenchmarkTimer timer;
+			vector<thread> threads;
+			for (int t = 0; t < threadCount; t++) {
+				threads.emplace_back([&heap, mode, blockCount, threadCount] {
+					int count = blockCount / threadCount;
+					vector<void*> blocks(count);
+					for (int i = 0; i < count; i++) {
+						size_t size = 16 + (i * 37) % 241;
+						blocks[i] = mode == 0 ? malloc(size) : heap.allocate(size);
+					}
+					for (int i = 0; i < count; i++) {
+						size_t size = 16 + (i * 37) % 241;
+						if (mode == 0)
+							free(blocks[i]);
+						else
+							heap.deallocate(blocks[i], size);
+					}
+				});
+			}
+			for (thread& worker : threads)
+				worker.join();
+			samples.push_back(timer.elapsedMs());
+		}
+		printBenchmarkStats(labels[mode], computeBenchmarkStats(samples));
+	}
+
+	MemoryProfiler::instance().printReport(cout);
+	if (MemoryProfiler::instance().exportReport("memory_report.txt"))
+		cout << "Memory report written to memory_report.txt" << endl;
+}
+
+#pragma endregion
@@ -0,0 +1,176 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <atomic> // Import the atomics.
+#include <chrono> // Import the steady clock.
+#include <cstddef> // Import size_t.
+#include <cstdint> // Import the fixed width integers.
+#include <mutex> // Import the mutex.
+#include <new> // Import bad_alloc.
+#include <ostream> // Import the output streams.
+#include <string> // Import the string class.
+#include <unordered_map> // Import the hash map.
+#include <vector> // Import the vector container.
+
+#pragma endregion
+
+// Where heap memory goes, by subsystem. Each subsystem allocates through its own named MemoryHeap, which counts live
+// bytes, the peak, and how much is allocated, and warns when it goes over its budget. The MemoryProfiler collects every
+// heap's numbers for reports at runtime or in a file, along with sampled call stacks showing which code allocates.
+//
+// A subsystem declares its heap once, in its header:
+//     DECLARE_MEMORY_HEAP(VegetationMemory, "Vegetation", 64 << 20)
+// and allocates through it directly, or in containers through HeapAllocator:
+//     HeapVector<Instance, VegetationMemory> instances;
+
+// The call stack of a sampled allocation, with how many sampled allocations came from it and their bytes.
+struct MemoryStackSample
+{
+	static const int MaxFrames = 16;
+
+	void* frames[MaxFrames];
+	uint32_t frameCount = 0;
+	uint64_t count = 0, bytes = 0;
+};
+
+// A named heap. Allocations are forwarded to the system allocator; what the heap adds is accounting. Thread safe.
+class MemoryHeap
+{
+public:
+	// budgetBytes 0 means no budget.
+	MemoryHeap(const char* name, size_t budgetBytes);
+	~MemoryHeap();
+	MemoryHeap(const MemoryHeap&) = delete;
+	MemoryHeap& operator=(const MemoryHeap&) = delete;
+
+	// Returns nullptr if the system is out of memory. Free with the same size and alignment.
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+	void deallocate(void* pointer, size_t size, size_t alignment = alignof(std::max_align_t));
+
+	const char* getName() const { return name; }
+	size_t getLiveBytes() const { return liveBytes.load(std::memory_order_relaxed); }
+	size_t getPeakBytes() const { return peakBytes.load(std::memory_order_relaxed); }
+	uint64_t getAllocationCount() const { return allocationCount.load(std::memory_order_relaxed); }
+	uint64_t getFreeCount() const { return freeCount.load(std::memory_order_relaxed); }
+	uint64_t getAllocatedBytes() const { return allocatedBytes.load(std::memory_order_relaxed); }
+
+	// Print an ERROR::MEMORY::BUDGET_EXCEEDED once each time live bytes rise above the budget.
+	size_t getBudget() const { return budgetBytes.load(std::memory_order_relaxed); }
+	void setBudget(size_t bytes) { budgetBytes.store(bytes, std::memory_order_relaxed); }
+
+	// Capture the call stack of every intervalth allocation (0: none).
+	void setStackSampleInterval(uint32_t interval) { stackSampleInterval.store(interval, std::memory_order_relaxed); }
+
+	// The call stacks sampled so far, most bytes first.
+	std::vector<MemoryStackSample> getStackSamples() const;
+
+private:
+	void recordStack(size_t size);
+
+	const char* name;
+	std::atomic<size_t> liveBytes{ 0 }, peakBytes{ 0 }, budgetBytes;
+	std::atomic<uint64_t> allocationCount{ 0 }, freeCount{ 0 }, allocatedBytes{ 0 };
+	std::atomic<bool> overBudget{ false };
+	std::atomic<uint32_t> stackSampleInterval{ 0 }, stackSampleCounter{ 0 };
+
+	mutable std::mutex stackMutex;
+	std::unordered_map<uint64_t, MemoryStackSample> stacks; // By a hash of the frames.
+};
+
+// One heap's numbers at one moment, with rates over the time since the previous sample.
+struct MemoryHeapStats
+{
+	std::string name;
+	size_t liveBytes = 0, peakBytes = 0, budgetBytes = 0;
+	uint64_t allocations = 0, frees = 0, allocatedBytes = 0;
+	double allocationsPerSecond = 0.0, bytesPerSecond = 0.0;
+};
+
+// Every heap in the program.
+class MemoryProfiler
+{
+public:
+	// The profiler. Constructed on first use, so heaps can register during static initialisation.
+	static MemoryProfiler& instance();
+
+	void add(MemoryHeap* heap);
+	void remove(MemoryHeap* heap);
+
+	// Every heap's numbers, with rates since the last call.
+	std::vector<MemoryHeapStats> sample();
+
+	// Sample stacks from every heap, including heaps created later (0: none).
+	void setStackSampleInterval(uint32_t interval);
+
+	// Print a table of sample().
+	void printReport(std::ostream& out);
+
+	// Write the table of the last sample (a new one if there has been none) and every heap's sampled call stacks
+	// (symbolised where the platform can) to a file. Call after printReport() to save what was just printed.
+	bool exportReport(const std::string& path);
+
+private:
+	struct Previous
+	{
+		uint64_t allocations, allocatedBytes;
+	};
+
+	static void writeTable(std::ostream& out, const std::vector<MemoryHeapStats>& stats);
+
+	std::mutex heapsMutex;
+	std::vector<MemoryHeap*> heaps;
+	std::unordered_map<MemoryHeap*, Previous> previous;
+	std::chrono::steady_clock::time_point previousTime = std::chrono::steady_clock::now();
+	std::vector<MemoryHeapStats> latest; // The last sample().
+	uint32_t stackSampleInterval = 0;
+};
+
+// Declares a heap type for HeapAllocator: Name::get() is the heap called displayName, made on first use. It is never
+// destroyed, so containers in globals can still free into it during shutdown.
+#define DECLARE_MEMORY_HEAP(Name, displayName, budgetBytes) \
+	struct Name \
+	{ \
+		static MemoryHeap& get() \
+		{ \
+			static MemoryHeap* heap = new MemoryHeap(displayName, budgetBytes); \
+			return *heap; \
+		} \
+	};
+
+// A standard allocator drawing from Heap::get(), for containers.
+template <typename T, typename Heap>
+class HeapAllocator
+{
+public:
+	typedef T value_type;
+
+	template <typename U>
+	struct rebind { typedef HeapAllocator<U, Heap> other; };
+
+	HeapAllocator() {}
+	template <typename U>
+	HeapAllocator(const HeapAllocator<U, Heap>&) {}
+
+	T* allocate(size_t count)
+	{
+		T* pointer = (T*)Heap::get().allocate(count * sizeof(T), alignof(T));
+		if (!pointer)
+			throw std::bad_alloc(); // The standard containers require it.
+		return pointer;
+	}
+
+	void deallocate(T* pointer, size_t count) { Heap::get().deallocate(pointer, count * sizeof(T), alignof(T)); }
+
+	template <typename U>
+	bool operator==(const HeapAllocator<U, Heap>&) const { return true; }
+	template <typename U>
+	bool operator!=(const HeapAllocator<U, Heap>&) const { return false; }
+};
+
+template <typename T, typename Heap>
+using HeapVector = std::vector<T, HeapAllocator<T, Heap>>;
+
+// Allocate and free blockCount blocks on threadCount threads through malloc, a heap, and a heap sampling call stacks,
+// print the times, then print the memory report and export it.
+void runMemoryProfilerBenchmark(int blockCount, int threadCount);
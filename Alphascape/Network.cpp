@@ -0,0 +1,657 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import min, max, find_if and remove_if.
+#include <cmath> // Import the maths functions.
+#include <cstdlib> // Import abs.
+#include <cstring> // Import memcpy.
+#include <iostream> // Import the IO stream libraries.
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h> // Import the sockets.
+#include <ws2tcpip.h> // Import the socket address helpers.
+#else
+#include <arpa/inet.h> // Import htonl and htons.
+#include <fcntl.h> // Import fcntl.
+#include <netinet/in.h> // Import sockaddr_in.
+#include <sys/socket.h> // Import the sockets.
+#include <unistd.h> // Import close.
+#endif
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "Network.h" // Import the networking declarations.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+const uint32_t NetAddress::LoopbackIp;
+const size_t SnapshotServer::MaxFragmentPayload;
+const size_t SnapshotServer::MaxClients;
+constexpr double SnapshotServer::ClientTimeout;
+
+#pragma region Sockets
+
+#ifdef _WIN32
+static SOCKET toSocket(intptr_t handle) { return (SOCKET)handle; }
+
+// Winsock must be started once before any socket is made.
+static bool startSockets()
+{
+	static bool started = [] {
+		WSADATA data;
+		return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	}();
+	return started;
+}
+#else
+static int toSocket(intptr_t handle) { return (int)handle; }
+#endif
+
+bool UdpSocket::open(uint16_t port, uint32_t ip)
+{
+	close();
+#ifdef _WIN32
+	if (!startSockets()) {
+		cout << "ERROR::NETWORK::WINSOCK_NOT_STARTED" << endl;
+		return false;
+	}
+	SOCKET created = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (created == INVALID_SOCKET) {
+		cout << "ERROR::NETWORK::SOCKET_NOT_CREATED" << endl;
+		return false;
+	}
+	u_long nonBlocking = 1;
+	ioctlsocket(created, FIONBIO, &nonBlocking);
+#else
+	int created = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (created < 0) {
+		cout << "ERROR::NETWORK::SOCKET_NOT_CREATED" << endl;
+		return false;
+	}
+	fcntl(created, F_SETFL, fcntl(created, F_GETFL, 0) | O_NONBLOCK);
+#endif
+	handle = (intptr_t)created;
+
+	int bufferSize = 1 << 20; // Room for a few large snapshots arriving between receives.
+	setsockopt(created, SOL_SOCKET, SO_RCVBUF, (const char*)&bufferSize, sizeof(bufferSize));
+	setsockopt(created, SOL_SOCKET, SO_SNDBUF, (const char*)&bufferSize, sizeof(bufferSize));
+
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(ip ? ip : INADDR_ANY);
+	address.sin_port = htons(port);
+	if (::bind(created, (const sockaddr*)&address, sizeof(address)) != 0) {
+		cout << "ERROR::NETWORK::SOCKET_NOT_BOUND\n" << port << endl;
+		close();
+		return false;
+	}
+	socklen_t addressSize = sizeof(address);
+	getsockname(created, (sockaddr*)&address, &addressSize);
+	localPort = ntohs(address.sin_port);
+	return true;
+}
+
+void UdpSocket::close()
+{
+	if (handle == -1)
+		return;
+#ifdef _WIN32
+	closesocket((SOCKET)handle);
+#else
+	::close((int)handle);
+#endif
+	handle = -1;
+	localPort = 0;
+}
+
+bool UdpSocket::send(const NetAddress& to, const void* data, size_t size)
+{
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(to.ip);
+	address.sin_port = htons(to.port);
+	return sendto(toSocket(handle), (const char*)data, (int)size, 0, (const sockaddr*)&address, sizeof(address)) == (int)size;
+}
+
+size_t UdpSocket::receive(void* buffer, size_t capacity, NetAddress& from)
+{
+	sockaddr_in address = {};
+	socklen_t addressSize = sizeof(address);
+	int received = (int)recvfrom(toSocket(handle), (char*)buffer, (int)capacity, 0, (sockaddr*)&address, &addressSize);
+	if (received <= 0)
+		return 0; // Nothing waiting (or an error, which for UDP only ever concerns an earlier datagram).
+	from.ip = ntohl(address.sin_addr.s_addr);
+	from.port = ntohs(address.sin_port);
+	return (size_t)received;
+}
+
+#pragma endregion
+
+#pragma region Bit Packing
+
+void BitWriter::writeBits(uint32_t value, int bits)
+{
+	uint64_t mask = (1ull << bits) - 1;
+	scratch |= ((uint64_t)value & mask) << scratchBits;
+	scratchBits += bits;
+	while (scratchBits >= 8) {
+		out.push_back((uint8_t)scratch);
+		scratch >>= 8;
+		scratchBits -= 8;
+	}
+}
+
+void BitWriter::flush()
+{
+	if (scratchBits > 0)
+		out.push_back((uint8_t)scratch);
+	scratch = 0;
+	scratchBits = 0;
+}
+
+uint32_t BitReader::readBits(int bits)
+{
+	uint32_t value = 0;
+	int collected = 0;
+	while (collected < bits) {
+		size_t byte = bitPosition >> 3;
+		if (byte >= size) {
+			overflowed = true;
+			return 0;
+		}
+		int shift = (int)(bitPosition & 7);
+		int take = min(8 - shift, bits - collected);
+		value |= (uint32_t)((data[byte] >> shift) & ((1u << take) - 1)) << collected;
+		collected += take;
+		bitPosition += take;
+	}
+	return value;
+}
+
+#pragma endregion
+
+#pragma region Snapshots
+
+static const float TwoPi = 6.28318530718f;
+
+bool NetQuantizedEntity::operator==(const NetQuantizedEntity& other) const
+{
+	return memcmp(fields, other.fields, sizeof(fields)) == 0;
+}
+
+static uint32_t quantize(float value, float minimum, float maximum, int bits)
+{
+	uint32_t steps = (1u << bits) - 1;
+	float normalized = (min(max(value, minimum), maximum) - minimum) / (maximum - minimum);
+	return (uint32_t)(normalized * steps + 0.5f);
+}
+
+static float dequantize(uint32_t value, float minimum, float maximum, int bits)
+{
+	return minimum + (maximum - minimum) * value / (float)((1u << bits) - 1);
+}
+
+NetQuantizedEntity quantizeEntity(const NetEntityState& state)
+{
+	NetQuantizedEntity entity = {};
+	if (!state.active)
+		return entity; // Inactive entities are all zero, so once gone they cost one bit a snapshot.
+	entity.fields[NetFieldActive] = 1;
+	for (int axis = 0; axis < 3; axis++)
+		entity.fields[NetFieldPositionX + axis] = quantize(state.position[axis], -NetWorldExtent, NetWorldExtent, NetFieldBits[NetFieldPositionX + axis]);
+	float turns = state.yaw / TwoPi;
+	turns -= floor(turns);
+	uint32_t yawSteps = 1u << NetFieldBits[NetFieldYaw];
+	entity.fields[NetFieldYaw] = (uint32_t)(turns * yawSteps + 0.5f) % yawSteps;
+	entity.fields[NetFieldHealth] = (uint32_t)(min(max(state.health, 0.0f), 100.0f) + 0.5f);
+	return entity;
+}
+
+NetEntityState dequantizeEntity(const NetQuantizedEntity& entity)
+{
+	NetEntityState state;
+	state.active = entity.fields[NetFieldActive] != 0;
+	for (int axis = 0; axis < 3; axis++)
+		state.position[axis] = dequantize(entity.fields[NetFieldPositionX + axis], -NetWorldExtent, NetWorldExtent, NetFieldBits[NetFieldPositionX + axis]);
+	state.yaw = entity.fields[NetFieldYaw] * TwoPi / (1u << NetFieldBits[NetFieldYaw]);
+	state.health = (float)entity.fields[NetFieldHealth];
+	return state;
+}
+
+static const NetQuantizedEntity ZeroEntity = {};
+
+void encodeSnapshot(const NetSnapshot& snapshot, const NetSnapshot* baseline, vector<uint8_t>& out)
+{
+	BitWriter writer(out);
+	for (size_t i = 0; i < snapshot.entities.size(); i++) {
+		const NetQuantizedEntity& entity = snapshot.entities[i];
+		const NetQuantizedEntity& base = baseline && i < baseline->entities.size() ? baseline->entities[i] : ZeroEntity;
+		if (entity == base) {
+			writer.writeBits(0, 1);
+			continue;
+		}
+		writer.writeBits(1, 1);
+		for (int field = 0; field < NetFieldCount; field++) {
+			bool changed = entity.fields[field] != base.fields[field];
+			writer.writeBits(changed, 1);
+			if (!changed || NetFieldBits[field] == 1) // A changed one-bit field can only have flipped.
+				continue;
+			if (NetFieldDeltaBits[field]) {
+				int32_t delta = (int32_t)(entity.fields[field] - base.fields[field]);
+				bool small = abs(delta) < (1 << (NetFieldDeltaBits[field] - 1));
+				writer.writeBits(small, 1);
+				if (small) {
+					writer.writeBits(((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31), NetFieldDeltaBits[field]); // Zigzag, so the sign is the low bit.
+					continue;
+				}
+			}
+			writer.writeBits(entity.fields[field], NetFieldBits[field]);
+		}
+	}
+	writer.flush();
+}
+
+bool decodeSnapshot(const uint8_t* data, size_t size, uint32_t entityCount, const NetSnapshot* baseline, NetSnapshot& snapshot)
+{
+	BitReader reader(data, size);
+	snapshot.entities.resize(entityCount);
+	for (uint32_t i = 0; i < entityCount; i++) {
+		const NetQuantizedEntity& base = baseline && i < baseline->entities.size() ? baseline->entities[i] : ZeroEntity;
+		NetQuantizedEntity& entity = snapshot.entities[i];
+		entity = base;
+		if (!reader.readBits(1))
+			continue;
+		for (int field = 0; field < NetFieldCount; field++) {
+			if (!reader.readBits(1))
+				continue;
+			if (NetFieldBits[field] == 1)
+				entity.fields[field] = base.fields[field] ^ 1;
+			else if (NetFieldDeltaBits[field] && reader.readBits(1)) {
+				uint32_t zigzag = reader.readBits(NetFieldDeltaBits[field]);
+				entity.fields[field] = base.fields[field] + (uint32_t)((int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1));
+			}
+			else
+				entity.fields[field] = reader.readBits(NetFieldBits[field]);
+		}
+	}
+	return !reader.hasOverflowed();
+}
+
+NetSnapshot& NetSnapshotHistory::add(uint32_t sequence)
+{
+	NetSnapshot& snapshot = snapshots[sequence % Capacity];
+	snapshot.sequence = sequence;
+	latest = max(latest, sequence);
+	return snapshot;
+}
+
+const NetSnapshot* NetSnapshotHistory::find(uint32_t sequence) const
+{
+	const NetSnapshot& snapshot = snapshots[sequence % Capacity];
+	return sequence != 0 && snapshot.sequence == sequence ? &snapshot : nullptr;
+}
+
+#pragma endregion
+
+#pragma region Server And Client
+
+// Packet types, the first byte of every packet.
+enum NetPacketType : uint8_t
+{
+	NetPacketHello = 1, // Client to server: send me snapshots.
+	NetPacketSnapshot = 2, // Server to client: one fragment of a snapshot.
+	NetPacketAck = 3 // Client to server: this snapshot arrived, use it as my baseline.
+};
+
+// What precedes each snapshot fragment. Written field by field, little endian whatever the host's byte order.
+struct NetFragmentHeader
+{
+	uint32_t sequence, baseline; // Baseline is 0 if encoded against nothing.
+	double time;
+	uint32_t entityCount;
+	uint16_t fragment, fragmentCount;
+};
+
+static const size_t FragmentHeaderSize = 1 + 4 + 4 + 8 + 4 + 2 + 2;
+static const size_t MaxPacketSize = FragmentHeaderSize + SnapshotServer::MaxFragmentPayload;
+
+// Write the low byteCount bytes of value, least significant first.
+static void writeLittleEndian(uint8_t* out, uint64_t value, int byteCount)
+{
+	for (int i = 0; i < byteCount; i++)
+		out[i] = (uint8_t)(value >> (8 * i));
+}
+
+static uint64_t readLittleEndian(const uint8_t* in, int byteCount)
+{
+	uint64_t value = 0;
+	for (int i = 0; i < byteCount; i++)
+		value |= (uint64_t)in[i] << (8 * i);
+	return value;
+}
+
+static void writeFragmentHeader(uint8_t* out, const NetFragmentHeader& header)
+{
+	uint64_t timeBits;
+	memcpy(&timeBits, &header.time, 8); // IEEE 754 everywhere the engine runs.
+	out[0] = NetPacketSnapshot;
+	writeLittleEndian(out + 1, header.sequence, 4);
+	writeLittleEndian(out + 5, header.baseline, 4);
+	writeLittleEndian(out + 9, timeBits, 8);
+	writeLittleEndian(out + 17, header.entityCount, 4);
+	writeLittleEndian(out + 21, header.fragment, 2);
+	writeLittleEndian(out + 23, header.fragmentCount, 2);
+}
+
+static void readFragmentHeader(const uint8_t* in, NetFragmentHeader& header)
+{
+	header.sequence = (uint32_t)readLittleEndian(in + 1, 4);
+	header.baseline = (uint32_t)readLittleEndian(in + 5, 4);
+	uint64_t timeBits = readLittleEndian(in + 9, 8);
+	memcpy(&header.time, &timeBits, 8);
+	header.entityCount = (uint32_t)readLittleEndian(in + 17, 4);
+	header.fragment = (uint16_t)readLittleEndian(in + 21, 2);
+	header.fragmentCount = (uint16_t)readLittleEndian(in + 23, 2);
+}
+
+void SnapshotServer::receive()
+{
+	uint8_t buffer[64];
+	NetAddress from;
+	size_t size;
+	while ((size = socket.receive(buffer, sizeof(buffer), from)) > 0) {
+		stats.packetsReceived++;
+		stats.bytesReceived += size;
+		auto client = find_if(clients.begin(), clients.end(), [&from](const Client& c) { return c.address == from; });
+		if (buffer[0] == NetPacketHello && client == clients.end() && clients.size() < MaxClients) {
+			Client added;
+			added.address = from;
+			added.lastHeard = now;
+			clients.push_back(added);
+		}
+		else if (buffer[0] == NetPacketAck && size >= 5 && client != clients.end()) {
+			uint32_t acknowledged = (uint32_t)readLittleEndian(buffer + 1, 4);
+			if (acknowledged <= sequence && acknowledged > client->acknowledged) {
+				client->acknowledged = acknowledged;
+				client->lastHeard = now;
+			}
+		}
+	}
+}
+
+void SnapshotServer::sendSnapshot(const vector<NetEntityState>& world, double time)
+{
+	now = time;
+	clients.erase(remove_if(clients.begin(), clients.end(), [time](const Client& client) {
+		return time - client.lastHeard > ClientTimeout; // Gone, or never there: a forged hello never acknowledges.
+	}), clients.end());
+
+	sequence++;
+	NetSnapshot& snapshot = history.add(sequence);
+	snapshot.time = time;
+	snapshot.entities.resize(world.size());
+	for (size_t i = 0; i < world.size(); i++)
+		snapshot.entities[i] = quantizeEntity(world[i]);
+
+	for (Client& client : clients) {
+		// Older than the history means the client has been missing snapshots for a long time: start it from nothing.
+		const NetSnapshot* baseline = history.find(client.acknowledged);
+		encoded.clear();
+		encodeSnapshot(snapshot, baseline, encoded);
+
+		if (simulatedLoss > 0.0f) {
+			lossState = lossState * 1664525u + 1013904223u;
+			if ((lossState >> 8) / 16777216.0f < simulatedLoss)
+				continue;
+		}
+
+		NetFragmentHeader header;
+		header.sequence = sequence;
+		header.baseline = baseline ? baseline->sequence : 0;
+		header.time = time;
+		header.entityCount = (uint32_t)snapshot.entities.size();
+		header.fragmentCount = (uint16_t)max<size_t>(1, (encoded.size() + MaxFragmentPayload - 1) / MaxFragmentPayload);
+		packet.resize(MaxPacketSize);
+		for (header.fragment = 0; header.fragment < header.fragmentCount; header.fragment++) {
+			size_t offset = header.fragment * MaxFragmentPayload;
+			size_t payload = min(MaxFragmentPayload, encoded.size() - offset);
+			writeFragmentHeader(packet.data(), header);
+			if (payload)
+				memcpy(packet.data() + FragmentHeaderSize, encoded.data() + offset, payload);
+			if (socket.send(client.address, packet.data(), FragmentHeaderSize + payload)) {
+				stats.packetsSent++;
+				stats.bytesSent += FragmentHeaderSize + payload;
+			}
+		}
+	}
+}
+
+bool SnapshotClient::connect(const NetAddress& serverAddress)
+{
+	server = serverAddress;
+	if (!socket.open(0))
+		return false;
+	uint8_t hello = NetPacketHello;
+	return socket.send(server, &hello, 1);
+}
+
+int SnapshotClient::receive()
+{
+	int completed = 0;
+	uint8_t buffer[MaxPacketSize];
+	NetAddress from;
+	size_t size;
+	while ((size = socket.receive(buffer, sizeof(buffer), from)) > 0) {
+		stats.packetsReceived++;
+		stats.bytesReceived += size;
+		if (!(from == server) || buffer[0] != NetPacketSnapshot || size < FragmentHeaderSize)
+			continue;
+		NetFragmentHeader header;
+		readFragmentHeader(buffer, header);
+		if (header.sequence <= history.getLatestSequence() || header.sequence < assembly.sequence
+			|| header.fragment >= header.fragmentCount)
+			continue; // Stale, or from a snapshot already superseded.
+
+		if (header.sequence != assembly.sequence) { // A newer snapshot: drop any older one still incomplete.
+			assembly.sequence = header.sequence;
+			assembly.baseline = header.baseline;
+			assembly.time = header.time;
+			assembly.entityCount = header.entityCount;
+			assembly.data.assign(header.fragmentCount * SnapshotServer::MaxFragmentPayload, 0);
+			assembly.received.assign(header.fragmentCount, false);
+			assembly.receivedCount = 0;
+		}
+		if (header.fragmentCount != assembly.received.size() || assembly.received[header.fragment])
+			continue;
+		size_t payload = size - FragmentHeaderSize;
+		memcpy(assembly.data.data() + header.fragment * SnapshotServer::MaxFragmentPayload, buffer + FragmentHeaderSize,
+			min(payload, SnapshotServer::MaxFragmentPayload));
+		assembly.received[header.fragment] = true;
+		if (++assembly.receivedCount == assembly.received.size()) {
+			completeSnapshot();
+			completed++;
+		}
+	}
+	return completed;
+}
+
+void SnapshotClient::completeSnapshot()
+{
+	const NetSnapshot* baseline = history.find(assembly.baseline);
+	if (assembly.baseline && !baseline) {
+		cout << "ERROR::NETWORK::BASELINE_MISSING\n" << assembly.baseline << endl;
+		return;
+	}
+	// Decode aside first: the new snapshot's slot in the history may hold its baseline.
+	decoded.sequence = assembly.sequence;
+	decoded.time = assembly.time;
+	if (!decodeSnapshot(assembly.data.data(), assembly.data.size(), assembly.entityCount, baseline, decoded)) {
+		cout << "ERROR::NETWORK::SNAPSHOT_TRUNCATED\n" << assembly.sequence << endl;
+		return;
+	}
+	swap(history.add(assembly.sequence), decoded);
+
+	uint8_t ack[5] = { NetPacketAck };
+	writeLittleEndian(ack + 1, assembly.sequence, 4);
+	if (socket.send(server, ack, sizeof(ack))) {
+		stats.packetsSent++;
+		stats.bytesSent += sizeof(ack);
+	}
+}
+
+bool SnapshotClient::interpolate(double renderTime, vector<NetEntityState>& world) const
+{
+	// The newest snapshot at or before renderTime, and the one after it.
+	const NetSnapshot* before = nullptr;
+	const NetSnapshot* after = nullptr;
+	uint32_t latest = history.getLatestSequence();
+	for (uint32_t sequence = latest; sequence > 0 && sequence + NetSnapshotHistory::Capacity > latest; sequence--) {
+		const NetSnapshot* snapshot = history.find(sequence);
+		if (!snapshot)
+			continue;
+		if (snapshot->time <= renderTime) {
+			before = snapshot;
+			break;
+		}
+		after = snapshot;
+	}
+	if (!before && !after)
+		return false;
+	if (!before || !after) { // Before the oldest or after the newest snapshot: hold the nearest.
+		const NetSnapshot* nearest = before ? before : after;
+		world.resize(nearest->entities.size());
+		for (size_t i = 0; i < world.size(); i++)
+			world[i] = dequantizeEntity(nearest->entities[i]);
+		return true;
+	}
+
+	float t = (float)((renderTime - before->time) / (after->time - before->time));
+	world.resize(after->entities.size());
+	for (size_t i = 0; i < world.size(); i++) {
+		NetEntityState to = dequantizeEntity(after->entities[i]);
+		if (i >= before->entities.size() || !before->entities[i].fields[NetFieldActive] || !to.active) {
+			world[i] = to; // Spawned or despawned in between: nothing to interpolate from.
+			continue;
+		}
+		NetEntityState from = dequantizeEntity(before->entities[i]);
+		NetEntityState& state = world[i];
+		state.active = true;
+		for (int axis = 0; axis < 3; axis++)
+			state.position[axis] = from.position[axis] + (to.position[axis] - from.position[axis]) * t;
+		float turn = to.yaw - from.yaw; // The short way round.
+		turn -= TwoPi * floor(turn / TwoPi + 0.5f);
+		state.yaw = from.yaw + turn * t;
+		state.health = t < 0.5f ? from.health : to.health;
+	}
+	return true;
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+// The benchmark world: a quarter of the entities stand still, the rest walk in circles, and every entity is gone for
+// a while each ten seconds, so snapshots carry spawns and despawns too.
+static NetEntityState benchmarkEntity(int index, double time)
+{
+	NetEntityState state;
+	state.active = fmod(time + index * 0.01, 10.0) < 9.0;
+	float centre[2] = { (float)(index % 40) * 40.0f - 800.0f, (float)(index / 40) * 40.0f - 500.0f };
+	state.health = (float)(100 - (int)(time * 2.0 + index) % 100);
+	if (index % 4 == 0) {
+		state.position[0] = centre[0];
+		state.position[2] = centre[1];
+		state.yaw = index * 0.1f;
+		return state;
+	}
+	float radius = 5.0f + index % 15;
+	float angle = (float)(time * (1.5 + (index % 7) * 0.25) / radius * 4.0) + index;
+	state.position[0] = centre[0] + radius * cos(angle);
+	state.position[1] = 0.5f * sin(angle * 3.0f);
+	state.position[2] = centre[1] + radius * sin(angle);
+	state.yaw = angle + TwoPi / 4.0f;
+	return state;
+}
+
+void runNetworkBenchmark(int entityCount, int ticks, int tickRate)
+{
+	const double tickSeconds = 1.0 / tickRate;
+	const double interpolationDelay = 3.0 * tickSeconds;
+	for (int lossy = 0; lossy < 2; lossy++) {
+		SnapshotServer server;
+		SnapshotClient client;
+		if (!server.open(0, NetAddress::LoopbackIp) || !client.connect(NetAddress::loopback(server.getPort())))
+			return;
+		server.setSimulatedLoss(lossy ? 0.1f : 0.0f);
+		for (int wait = 0; wait < 100 && server.getClientCount() == 0; wait++) // Let the hello arrive.
+			server.receive();
+
+		vector<NetEntityState> world(entityCount), rendered;
+		vector<double> sendSamples, receiveSamples;
+		vector<uint8_t> full;
+		uint64_t fullBytes = 0;
+		int delivered = 0, mismatches = 0, errorSamples = 0;
+		double errorSum = 0.0, errorMax = 0.0;
+		for (int tick = 0; tick < ticks; tick++) {
+			double time = tick * tickSeconds;
+			for (int i = 0; i < entityCount; i++)
+				world[i] = benchmarkEntity(i, time);
+
+			BenchmarkTimer timer;
+			server.receive();
+			uint64_t packetsBefore = server.getStats().packetsSent;
+			server.sendSnapshot(world, time);
+			sendSamples.push_back(timer.elapsedMs());
+			bool sent = server.getStats().packetsSent != packetsBefore;
+
+			// Loopback delivers at once, but allow a moment for the last fragment.
+			timer.reset();
+			int completed = client.receive();
+			for (BenchmarkTimer wait; sent && !completed && wait.elapsedMs() < 5.0;)
+				completed = client.receive();
+			receiveSamples.push_back(timer.elapsedMs());
+			delivered += completed;
+
+			const NetSnapshot* serverSnapshot = server.getLatest();
+			full.clear();
+			encodeSnapshot(*serverSnapshot, nullptr, full);
+			fullBytes += full.size();
+			const NetSnapshot* clientSnapshot = client.getLatest();
+			if (completed && (!clientSnapshot || clientSnapshot->sequence != serverSnapshot->sequence
+				|| clientSnapshot->entities != serverSnapshot->entities))
+				mismatches++;
+
+			double renderTime = time - interpolationDelay;
+			if (renderTime > 0.0 && client.interpolate(renderTime, rendered)) {
+				for (int i = 0; i < entityCount; i++) {
+					NetEntityState truth = benchmarkEntity(i, renderTime);
+					if (!truth.active || !rendered[i].active)
+						continue;
+					double error = sqrt(pow(truth.position[0] - rendered[i].position[0], 2.0) + pow(truth.position[1] - rendered[i].position[1], 2.0)
+						+ pow(truth.position[2] - rendered[i].position[2], 2.0));
+					errorSum += error;
+					errorMax = max(errorMax, error);
+					errorSamples++;
+				}
+			}
+		}
+
+		const NetStats& stats = server.getStats();
+		double seconds = ticks * tickSeconds;
+		cout << "BENCH::NETWORK " << entityCount << " entities, " << ticks << " ticks at " << tickRate << " Hz, "
+			<< (lossy ? 10 : 0) << "% loss: " << delivered << " snapshots delivered, " << stats.packetsSent << " packets\n"
+			<< "  delta " << stats.bytesSent / ticks << " bytes/tick (" << stats.bytesSent * 8.0 / seconds / 1000.0 << " kbit/s), "
+			<< "full " << fullBytes / ticks << " bytes/tick, unquantized " << entityCount * sizeof(NetEntityState) << " bytes/tick\n"
+			<< "  client upload " << client.getStats().bytesSent * 8.0 / seconds / 1000.0 << " kbit/s, "
+			<< "interpolation error mean " << (errorSamples ? errorSum / errorSamples : 0.0) << " max " << errorMax << endl;
+		printBenchmarkStats(lossy ? "NETWORK::LOSSY_SERVER_SEND" : "NETWORK::SERVER_SEND", computeBenchmarkStats(sendSamples));
+		printBenchmarkStats(lossy ? "NETWORK::LOSSY_CLIENT_RECEIVE" : "NETWORK::CLIENT_RECEIVE", computeBenchmarkStats(receiveSamples));
+		if (mismatches)
+			cout << "ERROR::NETWORK::SNAPSHOT_MISMATCH\n" << mismatches << " snapshots" << endl;
+	}
+}
+
+#pragma endregion
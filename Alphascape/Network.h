@@ -0,0 +1,281 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <cstddef> // Import size_t.
+#include <cstdint> // Import the fixed width integers.
+#include <vector> // Import the vector container.
+
+#include "MemoryProfiler.h" // Import the memory heaps.
+
+#pragma endregion
+
+DECLARE_MEMORY_HEAP(NetworkMemory, "Network", 32 << 20)
+
+// Snapshot replication: the server sends the whole replicated world every tick as a snapshot, delta-compressed against
+// the last snapshot each client acknowledged, and the client renders slightly in the past, interpolating between the
+// two snapshots around its render time. Lost packets need no resending: the next snapshot is simply encoded against
+// an older baseline, the last one known to have arrived.
+
+#pragma region Sockets
+
+// An IPv4 address and port, both in host byte order.
+struct NetAddress
+{
+	static const uint32_t LoopbackIp = 0x7F000001; // 127.0.0.1.
+
+	uint32_t ip = 0;
+	uint16_t port = 0;
+
+	static NetAddress loopback(uint16_t port) { NetAddress address; address.ip = LoopbackIp; address.port = port; return address; }
+	bool operator==(const NetAddress& other) const { return ip == other.ip && port == other.port; }
+};
+
+// A non-blocking UDP socket.
+class UdpSocket
+{
+public:
+	UdpSocket() {}
+	~UdpSocket() { close(); }
+	UdpSocket(const UdpSocket&) = delete;
+	UdpSocket& operator=(const UdpSocket&) = delete;
+
+	// Bind to port, or to any free port if port is 0, on the interface with address ip (host byte order), or on every
+	// interface if ip is 0. Prints an error and returns false on failure.
+	bool open(uint16_t port, uint32_t ip = 0);
+	void close();
+
+	bool isOpen() const { return handle != -1; }
+	uint16_t getLocalPort() const { return localPort; }
+
+	bool send(const NetAddress& to, const void* data, size_t size);
+
+	// Receive one datagram, if any is waiting. Returns its size, or 0 if there is none.
+	size_t receive(void* buffer, size_t capacity, NetAddress& from);
+
+private:
+	intptr_t handle = -1;
+	uint16_t localPort = 0;
+};
+
+#pragma endregion
+
+#pragma region Bit Packing
+
+// Writes values of any width from 1 to 32 bits back to back.
+class BitWriter
+{
+public:
+	explicit BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+	void writeBits(uint32_t value, int bits);
+
+	// Write out the last partial byte. Call once at the end.
+	void flush();
+
+private:
+	std::vector<uint8_t>& out;
+	uint64_t scratch = 0;
+	int scratchBits = 0;
+};
+
+// Reads what a BitWriter wrote. Reading past the end returns zeros and sets the overflow flag.
+class BitReader
+{
+public:
+	BitReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+	uint32_t readBits(int bits);
+
+	bool hasOverflowed() const { return overflowed; }
+
+private:
+	const uint8_t* data;
+	size_t size;
+	size_t bitPosition = 0;
+	bool overflowed = false;
+};
+
+#pragma endregion
+
+#pragma region Snapshots
+
+// A replicated entity as the game sees it.
+struct NetEntityState
+{
+	bool active = false;
+	float position[3] = { 0.0f, 0.0f, 0.0f }; // World units, within NetWorldExtent of the origin.
+	float yaw = 0.0f; // Radians.
+	float health = 0.0f; // 0 to 100.
+};
+
+// Every field quantized to a fixed number of bits, which is what is compared, sent and stored.
+enum NetField
+{
+	NetFieldActive,
+	NetFieldPositionX,
+	NetFieldPositionY,
+	NetFieldPositionZ,
+	NetFieldYaw,
+	NetFieldHealth,
+	NetFieldCount
+};
+
+const float NetWorldExtent = 1024.0f;
+const int NetFieldBits[NetFieldCount] = { 1, 20, 20, 20, 10, 7 }; // Positions to 2 mm, yaw to 0.35 degrees.
+// Fields that usually change a little at a time: a change this small (in bits, signed) is sent as the difference.
+const int NetFieldDeltaBits[NetFieldCount] = { 0, 9, 9, 9, 0, 0 }; // Half a metre, over 15 m/s at 60 Hz.
+
+struct NetQuantizedEntity
+{
+	uint32_t fields[NetFieldCount];
+
+	bool operator==(const NetQuantizedEntity& other) const;
+	bool operator!=(const NetQuantizedEntity& other) const { return !(*this == other); }
+};
+
+NetQuantizedEntity quantizeEntity(const NetEntityState& state);
+NetEntityState dequantizeEntity(const NetQuantizedEntity& entity);
+
+// The replicated world at one server tick. Entities are identified by their index.
+struct NetSnapshot
+{
+	uint32_t sequence = 0; // Starts at 1; 0 means no snapshot.
+	double time = 0.0; // Server time, in seconds.
+	HeapVector<NetQuantizedEntity, NetworkMemory> entities;
+};
+
+// Encode snapshot's entities against baseline, or against all-zero entities if there is none: one bit for each
+// unchanged entity, and for a changed one a bit per field plus the new values of the fields that changed (or their
+// differences, if small enough).
+void encodeSnapshot(const NetSnapshot& snapshot, const NetSnapshot* baseline, std::vector<uint8_t>& out);
+
+// Decode what encodeSnapshot() wrote, against the same baseline, into snapshot's entities (its sequence and time are
+// left alone). Returns false if the data is truncated.
+bool decodeSnapshot(const uint8_t* data, size_t size, uint32_t entityCount, const NetSnapshot* baseline, NetSnapshot& snapshot);
+
+// The last snapshots sent or received, by sequence.
+class NetSnapshotHistory
+{
+public:
+	static const uint32_t Capacity = 64; // Over a second at 60 Hz, far longer than an acknowledgement takes.
+
+	NetSnapshot& add(uint32_t sequence);
+	const NetSnapshot* find(uint32_t sequence) const;
+
+	// The newest snapshot, or nullptr if there is none.
+	const NetSnapshot* getLatest() const { return latest ? find(latest) : nullptr; }
+	uint32_t getLatestSequence() const { return latest; }
+
+private:
+	NetSnapshot snapshots[Capacity];
+	uint32_t latest = 0;
+};
+
+#pragma endregion
+
+#pragma region Server And Client
+
+// Traffic counters, for the benchmark and debug overlays.
+struct NetStats
+{
+	uint64_t packetsSent = 0, bytesSent = 0;
+	uint64_t packetsReceived = 0, bytesReceived = 0;
+};
+
+// Sends snapshots to every client that has said hello, each delta-compressed against what that client last acknowledged.
+// A hello is one byte and a snapshot may be many packets, so a hello with a forged source address would have the server
+// flood that address: clients are capped, and a client is dropped once it has acknowledged nothing for ClientTimeout.
+class SnapshotServer
+{
+public:
+	// Payload bytes per packet, so a datagram never needs IP fragmentation. Bigger snapshots are split over packets.
+	static const size_t MaxFragmentPayload = 1200;
+	static const size_t MaxClients = 32; // Hellos past this are ignored.
+	static constexpr double ClientTimeout = 2.0; // Seconds of server time without an acknowledgement.
+
+	// Listen on port on the interface with address ip, or on every interface if ip is 0. See UdpSocket::open().
+	bool open(uint16_t port, uint32_t ip = 0) { return socket.open(port, ip); }
+	uint16_t getPort() const { return socket.getLocalPort(); }
+
+	// Handle hellos and acknowledgements from clients. Call before sendSnapshot() each tick.
+	void receive();
+
+	// Snapshot the world at server time and send it to every client, first dropping clients that have timed out.
+	void sendSnapshot(const std::vector<NetEntityState>& world, double time);
+
+	// Drop this fraction of outgoing snapshots, to exercise older baselines in testing.
+	void setSimulatedLoss(float fraction) { simulatedLoss = fraction; }
+
+	size_t getClientCount() const { return clients.size(); }
+	const NetStats& getStats() const { return stats; }
+
+	// The newest snapshot sent, or nullptr before the first.
+	const NetSnapshot* getLatest() const { return history.getLatest(); }
+
+private:
+	struct Client
+	{
+		NetAddress address;
+		uint32_t acknowledged = 0; // The newest snapshot the client has confirmed, the baseline for the next one.
+		double lastHeard = 0.0; // Server time of its hello or newest acknowledgement.
+	};
+
+	UdpSocket socket;
+	std::vector<Client> clients;
+	double now = 0.0; // Server time of the last snapshot.
+	NetSnapshotHistory history;
+	uint32_t sequence = 0;
+	float simulatedLoss = 0.0f;
+	uint32_t lossState = 1;
+	NetStats stats;
+	std::vector<uint8_t> encoded, packet;
+};
+
+// Receives snapshots from a server, acknowledges them, and interpolates between them for rendering.
+class SnapshotClient
+{
+public:
+	// Open a socket on any free port and say hello to the server.
+	bool connect(const NetAddress& server);
+
+	// Handle waiting packets: reassemble snapshots, decode them against their baselines and acknowledge them.
+	// Returns the number of snapshots completed.
+	int receive();
+
+	// The newest complete snapshot, or nullptr if none has arrived.
+	const NetSnapshot* getLatest() const { return history.getLatest(); }
+
+	// The world at server time renderTime, interpolated between the snapshots either side of it. Render a little
+	// behind the newest snapshot (two or three ticks) so there is usually a snapshot either side, even with loss.
+	// Returns false if no snapshot has arrived.
+	bool interpolate(double renderTime, std::vector<NetEntityState>& world) const;
+
+	const NetStats& getStats() const { return stats; }
+
+private:
+	// The snapshot being reassembled from its packets.
+	struct Assembly
+	{
+		uint32_t sequence = 0, baseline = 0, entityCount = 0;
+		double time = 0.0;
+		std::vector<uint8_t> data;
+		std::vector<bool> received;
+		uint32_t receivedCount = 0;
+	};
+
+	void completeSnapshot();
+
+	UdpSocket socket;
+	NetAddress server;
+	NetSnapshotHistory history;
+	Assembly assembly;
+	NetSnapshot decoded;
+	NetStats stats;
+};
+
+#pragma endregion
+
+// Replicate entityCount entities from a server to a client over loopback UDP for ticks ticks at tickRate, with and
+// without simulated loss, and print the bandwidth, encode and decode times and interpolation error.
+void runNetworkBenchmark(int entityCount, int ticks, int tickRate);
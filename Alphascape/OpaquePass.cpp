@@ -0,0 +1,280 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import stable_sort.
+#include <cstdint> // Import UINT32_MAX.
+#include <cstring> // Import memcpy.
+#include <iostream> // Import the IO stream libraries.
+#include <random> // Import the random number generators.
+#include <string> // Import to_string.
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "GLRenderDevice.h" // Import the GL render device.
+#include "OpaquePass.h" // Import the opaque pass.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Shaders
+
+// Every write adds OverdrawStep / 255 to the pixel, exactly representable in an 8-bit target.
+static const string overdrawFragmentShaderSource =
+"#version 330 core\n"
+"out vec4 color;\n"
+"void main()\n"
+"{\n"
+"color = vec4(vec3(" + to_string(OpaquePass::OverdrawStep) + ".0 / 255.0), 1.0);\n"
+"}\n";
+
+// The pre-pass writes depth only, so it needs no shading at all.
+static const GLchar* depthOnlyFragmentShaderSource =
+"#version 330 core\n"
+"void main()\n"
+"{\n"
+"}\n\0";
+
+#pragma endregion
+
+#pragma region Opaque Pass
+
+OpaquePass::OpaquePass(RenderDevice& renderDevice) : device(renderDevice)
+{
+}
+
+OpaquePass::~OpaquePass()
+{
+	for (Material& material : materials) {
+		for (PipelineHandle variant : material.variants)
+			device.destroyPipeline(variant);
+	}
+}
+
+uint32_t OpaquePass::addMaterial(const PipelineDesc& desc, bool alphaTested)
+{
+	PipelineDesc variants[VariantCount];
+	for (PipelineDesc& variant : variants) {
+		variant = desc;
+		variant.blend = BlendMode::Opaque;
+		variant.depthTest = true;
+	}
+
+	// Depth-only: no colour and an empty fragment shader, so the pre-pass costs rasterisation and depth writes only.
+	// An alpha-tested material keeps its own shader, whose discard decides which fragments write depth.
+	variants[DepthOnly].depthWrite = true;
+	variants[DepthOnly].colorWrite = false;
+	if (!alphaTested) {
+		variants[DepthOnly].fragmentSource = depthOnlyFragmentShaderSource;
+		if (!desc.fragmentSpirv.empty()) {
+			vector<uint32_t> depthOnlySpirv = loadSpirv("shaders/depth_only.frag.spv");
+			if (!depthOnlySpirv.empty()) // Else the material's shader: slower, but the same depth.
+				variants[DepthOnly].fragmentSpirv = depthOnlySpirv;
+		}
+	}
+
+	// Shading on its own, or over the pre-pass's depth. LessEqual rather than Equal, which would depend on both
+	// pipelines producing bit-identical depth.
+	variants[Shade].depthWrite = true;
+	variants[ShadeAfterPrePass].depthWrite = false;
+	variants[ShadeAfterPrePass].depthCompare = DepthCompare::LessEqual;
+
+	// Overdraw: the same depth behaviour, but every write adds one step of brightness.
+	variants[Overdraw] = variants[Shade];
+	variants[OverdrawAfterPrePass] = variants[ShadeAfterPrePass];
+	for (int variant = Overdraw; variant <= OverdrawAfterPrePass; variant++) {
+		variants[variant].fragmentSource = overdrawFragmentShaderSource.c_str();
+		variants[variant].fragmentSpirv.clear(); // GL only, like the benchmark that reads it back.
+		variants[variant].blend = BlendMode::Additive;
+	}
+
+	Material material;
+	for (int variant = 0; variant < VariantCount; variant++) {
+		material.variants[variant] = device.createPipeline(variants[variant]);
+		if (!material.variants[variant].valid() && variant < Overdraw) {
+			for (PipelineHandle created : material.variants)
+				device.destroyPipeline(created);
+			return UINT32_MAX;
+		}
+	}
+	materials.push_back(material);
+	return (uint32_t)materials.size() - 1;
+}
+
+void OpaquePass::record(CommandList& list, const vector<OpaqueDraw>& draws, const OpaquePassSettings& settings)
+{
+	// Sort indices, not draws: nearest first, keeping submission order between equal depths.
+	order.resize(draws.size());
+	for (uint32_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	if (settings.sort == OpaqueSortMode::FrontToBack)
+		stable_sort(order.begin(), order.end(), [&draws](uint32_t a, uint32_t b) { return draws[a].viewDepth < draws[b].viewDepth; });
+
+	if (settings.depthPrePass)
+		recordDraws(list, draws, DepthOnly);
+	if (settings.visualizeOverdraw)
+		recordDraws(list, draws, settings.depthPrePass ? OverdrawAfterPrePass : Overdraw);
+	else
+		recordDraws(list, draws, settings.depthPrePass ? ShadeAfterPrePass : Shade);
+}
+
+void OpaquePass::recordDraws(CommandList& list, const vector<OpaqueDraw>& draws, Variant variant)
+{
+	for (uint32_t index : order) {
+		const OpaqueDraw& draw = draws[index];
+		if (draw.material >= materials.size() || !materials[draw.material].variants[variant].valid())
+			continue;
+		list.bindPipeline(materials[draw.material].variants[variant]); // Repeats cost nothing on either backend.
+		list.bindVertexBuffer(0, draw.vertexBuffer);
+		list.bindIndexBuffer(draw.indexBuffer);
+		if (draw.constantsSize > 0)
+			list.setConstants(draw.constants, draw.constantsSize);
+		list.drawIndexed(draw.indexCount, 1, draw.firstIndex);
+	}
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+// A deliberately expensive fragment shader, so shading each pixel more than once shows in the GPU time.
+static const GLchar* expensiveVertexShaderSource =
+"#version 330 core\n"
+"layout(std140) uniform Constants { vec4 rect; vec4 color; };\n"
+"layout(location = 0) in vec3 corner;\n"
+"out vec2 uv;\n"
+"void main()\n"
+"{\n"
+"uv = corner.xy;\n"
+"gl_Position = vec4(rect.xy + corner.xy * rect.zw, corner.z, 1.0);\n"
+"}\n\0";
+static const GLchar* expensiveFragmentShaderSource =
+"#version 330 core\n"
+"layout(std140) uniform Constants { vec4 rect; vec4 color; };\n"
+"in vec2 uv;\n"
+"out vec4 fragmentColor;\n"
+"void main()\n"
+"{\n"
+"float value = 0.0;\n"
+"for (int i = 0; i < 64; i++)\n"
+"value += sin(uv.x * float(i) + value) * cos(uv.y * float(i));\n"
+"fragmentColor = vec4(color.rgb * (0.75 + 0.25 * fract(value)), 1.0);\n"
+"}\n\0";
+
+void runOverdrawBenchmark(GLFWwindow* window, int drawCount, int frames)
+{
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+	glfwSwapInterval(0); // Never wait for vertical sync while measuring.
+
+	GLRenderDevice device;
+	OpaquePass pass(device);
+	const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f }; // Black, so the overdraw readback counts from zero.
+
+	// A quad with its depth in the vertices' z; each draw gets its own depth through its own vertex buffer region.
+	// The constants position it, so one index buffer serves every draw.
+	mt19937 random(1234); // Fixed seed, so runs are comparable.
+	uniform_real_distribution<float> position(-1.0f, 0.4f), size(0.3f, 0.6f), depth(-0.95f, 0.95f), unit(0.0f, 1.0f);
+	vector<float> vertices;
+	vector<uint32_t> indices;
+	vector<OpaqueDraw> draws(drawCount);
+	for (int i = 0; i < drawCount; i++) {
+		float z = depth(random);
+		const float corners[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+		uint32_t base = (uint32_t)vertices.size() / 3;
+		for (const float* corner : corners) {
+			vertices.push_back(corner[0]);
+			vertices.push_back(corner[1]);
+			vertices.push_back(z);
+		}
+		const uint32_t quad[] = { 0, 1, 2, 0, 2, 3 };
+		for (uint32_t index : quad)
+			indices.push_back(base + index);
+
+		OpaqueDraw& draw = draws[i];
+		draw.indexCount = 6;
+		draw.firstIndex = (uint32_t)i * 6;
+		draw.viewDepth = z;
+		float constants[8] = { position(random), position(random), size(random), size(random), unit(random), unit(random), unit(random), 1.0f };
+		memcpy(draw.constants, constants, sizeof(constants));
+		draw.constantsSize = sizeof(constants);
+	}
+	BufferDesc vertexDesc;
+	vertexDesc.size = vertices.size() * sizeof(float);
+	vertexDesc.initialData = vertices.data();
+	BufferDesc indexDesc;
+	indexDesc.usage = BufferUsage::Index;
+	indexDesc.size = indices.size() * sizeof(uint32_t);
+	indexDesc.initialData = indices.data();
+	BufferHandle vertexBuffer = device.createBuffer(vertexDesc), indexBuffer = device.createBuffer(indexDesc);
+
+	PipelineDesc desc;
+	desc.vertexSource = expensiveVertexShaderSource;
+	desc.fragmentSource = expensiveFragmentShaderSource;
+	desc.layout.add(0, 3, 0, 0);
+	desc.layout.strides[0] = 3 * sizeof(float);
+	uint32_t material = pass.addMaterial(desc);
+	if (material == UINT32_MAX)
+		return;
+	for (OpaqueDraw& draw : draws) {
+		draw.material = material;
+		draw.vertexBuffer = vertexBuffer;
+		draw.indexBuffer = indexBuffer;
+	}
+
+	GLuint query;
+	glGenQueries(1, &query);
+	CommandList* list = device.createCommandList();
+	vector<uint8_t> pixels((size_t)width * height * 4);
+
+	struct Mode { const char* name; OpaquePassSettings settings; };
+	Mode modes[3];
+	modes[0].name = "OVERDRAW::SUBMISSION_ORDER";
+	modes[0].settings.sort = OpaqueSortMode::Submission;
+	modes[1].name = "OVERDRAW::FRONT_TO_BACK";
+	modes[2].name = "OVERDRAW::DEPTH_PRE_PASS";
+	modes[2].settings.depthPrePass = true;
+	modes[2].settings.sort = OpaqueSortMode::Submission; // The pre-pass makes order irrelevant to shading.
+
+	cout << "BENCH::OVERDRAW " << drawCount << " quads, " << width << "x" << height << endl;
+	for (Mode& mode : modes) {
+		vector<double> gpuSamples;
+		for (int frame = 0; frame < frames; frame++) {
+			list->begin();
+			pass.record(*list, draws, mode.settings);
+			list->end();
+			device.beginFrame(width, height, clearColor);
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			device.submit(&list, 1);
+			glEndQuery(GL_TIME_ELAPSED);
+			device.endFrame();
+			GLuint64 gpuNanoseconds = 0; // Waits for the frame; fine while benchmarking.
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpuNanoseconds);
+			gpuSamples.push_back(gpuNanoseconds / 1.0e6);
+			glfwSwapBuffers(window);
+			glfwPollEvents();
+		}
+
+		// Count the shaded fragment writes with the overdraw variant of the same mode.
+		mode.settings.visualizeOverdraw = true;
+		list->begin();
+		pass.record(*list, draws, mode.settings);
+		list->end();
+		device.beginFrame(width, height, clearColor);
+		device.submit(&list, 1);
+		device.readPixels(0, 0, width, height, pixels.data());
+		uint64_t writes = 0, coveredPixels = 0;
+		for (size_t i = 0; i < pixels.size(); i += 4) {
+			int count = (pixels[i] + OpaquePass::OverdrawStep / 2) / OpaquePass::OverdrawStep;
+			writes += count;
+			coveredPixels += count > 0 ? 1 : 0;
+		}
+		printBenchmarkStats(mode.name, computeBenchmarkStats(gpuSamples));
+		cout << "  shaded writes per covered pixel: " << (coveredPixels ? (double)writes / coveredPixels : 0.0)
+			<< " (saturates at " << 255 / OpaquePass::OverdrawStep << ")" << endl;
+	}
+
+	glDeleteQueries(1, &query);
+	device.destroyBuffer(vertexBuffer);
+	device.destroyBuffer(indexBuffer);
+}
+
+#pragma endregion
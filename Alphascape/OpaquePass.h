@@ -0,0 +1,70 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <cstdint> // Import the fixed width integers.
+#include <vector> // Import the vector container.
+
+#include "Graphics.h" // Import GLEW and GLFW.
+#include "RenderDevice.h" // Import the render device interface.
+
+#pragma endregion
+
+enum class OpaqueSortMode { Submission, FrontToBack };
+
+// How a scene draws its opaque geometry (per scene, from the r_* settings for the main scene).
+struct OpaquePassSettings
+{
+	bool depthPrePass = false; // Lay down depth first, so each pixel is shaded once.
+	OpaqueSortMode sort = OpaqueSortMode::FrontToBack; // Nearest first, so early depth testing rejects what is hidden.
+	bool visualizeOverdraw = false; // Shade every fragment write as one step of brightness instead.
+};
+
+// One opaque draw: indexed geometry, its material and where it is along the view direction.
+struct OpaqueDraw
+{
+	uint32_t material = 0; // From OpaquePass::addMaterial.
+	BufferHandle vertexBuffer, indexBuffer;
+	uint32_t indexCount = 0, firstIndex = 0;
+	float viewDepth = 0.0f; // Smaller is nearer (NDC z of the draw's centre, until there is a camera).
+	uint8_t constants[32] = {}; // The draw's constants (see CommandList::setConstants).
+	uint32_t constantsSize = 0;
+};
+
+// Records a scene's opaque draws with depth testing: optionally sorted front to back, optionally after a depth-only
+// pre-pass (then each pixel's shading runs once, for the nearest surface only), or as an overdraw visualisation.
+//
+// Every material gets its depth-only, shading and overdraw variants baked as immutable pipelines up front, so
+// switching mode never creates state at draw time.
+class OpaquePass
+{
+public:
+	// Each overdraw variant adds OverdrawStep to red, green and blue, so a pixel's writes are its value / OverdrawStep.
+	static const int OverdrawStep = 16; // Of 255: 15 writes saturate to white.
+
+	explicit OpaquePass(RenderDevice& device);
+	~OpaquePass();
+
+	// Bake the variants of a material. desc supplies the shaders, vertex layout and rasterisation; depth, colour
+	// writes and blending are set per variant. The depth-only variant runs an empty fragment shader unless alphaTested
+	// (the material discards fragments, as with MaterialParams::alphaCutoff > 0). Returns the material index, or
+	// UINT32_MAX if a variant failed.
+	uint32_t addMaterial(const PipelineDesc& desc, bool alphaTested = false);
+
+	// Record the draws into list (which must be recording).
+	void record(CommandList& list, const std::vector<OpaqueDraw>& draws, const OpaquePassSettings& settings);
+
+private:
+	enum Variant { DepthOnly, Shade, ShadeAfterPrePass, Overdraw, OverdrawAfterPrePass, VariantCount };
+	struct Material { PipelineHandle variants[VariantCount]; };
+
+	void recordDraws(CommandList& list, const std::vector<OpaqueDraw>& draws, Variant variant);
+
+	RenderDevice& device;
+	std::vector<Material> materials;
+	std::vector<uint32_t> order; // Draw order, reused every frame.
+};
+
+// Draw drawCount overlapping quads at random depths with an expensive fragment shader, unsorted, front to back and
+// with a depth pre-pass, and print GPU time and the measured overdraw (fragment writes per covered pixel) for each.
+void runOverdrawBenchmark(GLFWwindow* window, int drawCount, int frames);
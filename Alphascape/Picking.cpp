@@ -0,0 +1,407 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import min and max.
+#include <cmath> // Import the C maths libraries.
+#include <cstdint> // Import UINT32_MAX.
+#include <iostream> // Import the IO stream libraries.
+#include <random> // Import the random number generators.
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "Picking.h" // Import the pickers.
+#include "Shader.h" // Import the shader compiler.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Shaders
+
+static const GLchar* idVertexShaderSource =
+"#version 330 core\n"
+"uniform mat4 viewProjection;\n"
+"layout(location = 0) in vec3 position;\n"
+"void main()\n"
+"{\n"
+"gl_Position = viewProjection * vec4(position, 1.0);\n"
+"}\n\0";
+static const GLchar* idFragmentShaderSource =
+"#version 330 core\n"
+"uniform uint objectId;\n"
+"layout(location = 0) out uint id;\n"
+"void main()\n"
+"{\n"
+"id = objectId;\n"
+"}\n\0";
+
+#pragma endregion
+
+#pragma region GPU Picker
+
+bool GpuPicker::init(GLsizei newWidth, GLsizei newHeight)
+{
+	program = compileShaderProgram(idVertexShaderSource, idFragmentShaderSource);
+	GLint linked = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (!linked)
+		return false;
+	viewProjectionLocation = glGetUniformLocation(program, "viewProjection");
+	objectIdLocation = glGetUniformLocation(program, "objectId");
+
+	glGenVertexArrays(1, &vertexArray); // Buffers are attached per object at request time.
+
+	// Pixel buffers big enough for the largest region; reads into them return immediately.
+	GLsizeiptr regionBytes = (2 * PickRadius + 1) * (2 * PickRadius + 1) * sizeof(GLuint);
+	for (Readback& readback : readbacks) {
+		glGenBuffers(1, &readback.pixelBuffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixelBuffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, regionBytes, NULL, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	width = newWidth;
+	height = newHeight;
+	createTargets();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		cout << "ERROR::PICKING::FRAMEBUFFER_INCOMPLETE\n" << status << endl;
+		return false;
+	}
+	return true;
+}
+
+void GpuPicker::createTargets()
+{
+	// One unsigned integer per pixel: the ID of the nearest object, 0 for none.
+	glGenTextures(1, &idTexture);
+	glBindTexture(GL_TEXTURE_2D, idTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenRenderbuffers(1, &depthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, idTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRenderbuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void GpuPicker::destroyTargets()
+{
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteTextures(1, &idTexture);
+	glDeleteRenderbuffers(1, &depthRenderbuffer);
+	framebuffer = idTexture = depthRenderbuffer = 0;
+}
+
+void GpuPicker::resize(GLsizei newWidth, GLsizei newHeight)
+{
+	if (newWidth == width && newHeight == height)
+		return;
+	width = newWidth;
+	height = newHeight;
+	destroyTargets(); // Reads in flight copied their pixels out already; only their fences remain.
+	createTargets();
+}
+
+uint32_t GpuPicker::request(int x, int y, const float viewProjection[16], const vector<PickObject>& objects)
+{
+	Readback* slot = nullptr;
+	for (Readback& readback : readbacks) {
+		if (!readback.fence) {
+			slot = &readback;
+			break;
+		}
+	}
+	if (!slot || x < 0 || y < 0 || x >= width || y >= height)
+		return 0;
+
+	GLint targetFramebuffer, viewport[4]; // Put back afterwards.
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &targetFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	// Draw every object's ID with depth testing, so the nearest wins.
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, width, height);
+	const GLuint noObject[4] = { 0, 0, 0, 0 };
+	glClearBufferuiv(GL_COLOR, 0, noObject);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	glEnable(GL_DEPTH_TEST);
+	glUseProgram(program);
+	glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, viewProjection);
+	glBindVertexArray(vertexArray);
+	glEnableVertexAttribArray(0);
+	for (const PickObject& object : objects) {
+		glBindBuffer(GL_ARRAY_BUFFER, object.vertexBuffer);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object.indexBuffer);
+		glUniform1ui(objectIdLocation, object.id);
+		glDrawElements(GL_TRIANGLES, object.indexCount, GL_UNSIGNED_INT, (GLvoid*)(object.firstIndex * sizeof(GLuint)));
+	}
+
+	// Read the region around the pixel into the slot's pixel buffer: this queues the copy and returns at once.
+	slot->regionX = max(x - PickRadius, 0);
+	slot->regionY = max(y - PickRadius, 0);
+	slot->regionWidth = min(x + PickRadius + 1, (int)width) - slot->regionX;
+	slot->regionHeight = min(y + PickRadius + 1, (int)height) - slot->regionY;
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pixelBuffer);
+	glReadPixels(slot->regionX, slot->regionY, slot->regionWidth, slot->regionHeight, GL_RED_INTEGER, GL_UNSIGNED_INT, (GLvoid*)0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot->result = PickResult();
+	slot->result.request = nextRequest++;
+	slot->result.x = x;
+	slot->result.y = y;
+
+	// Leave the defaults the rest of the frame expects.
+	glBindVertexArray(0);
+	glUseProgram(0);
+	glDisable(GL_DEPTH_TEST);
+	glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	return slot->result.request;
+}
+
+bool GpuPicker::poll(PickResult& result)
+{
+	// Age every request in flight, then hand back the oldest finished one.
+	Readback* finished = nullptr;
+	for (Readback& readback : readbacks) {
+		if (!readback.fence)
+			continue;
+		readback.result.framesWaited++;
+		GLenum status = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0); // A timeout of 0 only checks.
+		bool signalled = status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+		if (signalled && (!finished || readback.result.request < finished->result.request))
+			finished = &readback;
+	}
+	if (!finished)
+		return false;
+
+	// Prefer the pixel itself, else the nearest hit in the region.
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, finished->pixelBuffer);
+	GLsizeiptr bytes = finished->regionWidth * finished->regionHeight * sizeof(GLuint);
+	const GLuint* ids = (const GLuint*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+	if (ids) {
+		int bestDistance = INT32_MAX;
+		for (int row = 0; row < finished->regionHeight; row++) {
+			for (int column = 0; column < finished->regionWidth; column++) {
+				GLuint id = ids[row * finished->regionWidth + column];
+				int dx = finished->regionX + column - finished->result.x, dy = finished->regionY + row - finished->result.y;
+				if (id != 0 && dx * dx + dy * dy < bestDistance) {
+					bestDistance = dx * dx + dy * dy;
+					finished->result.objectId = id;
+				}
+			}
+		}
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	glDeleteSync(finished->fence);
+	finished->fence = 0;
+	result = finished->result;
+	return true;
+}
+
+void GpuPicker::destroy()
+{
+	for (Readback& readback : readbacks) {
+		if (readback.fence)
+			glDeleteSync(readback.fence);
+		glDeleteBuffers(1, &readback.pixelBuffer);
+		readback = Readback();
+	}
+	destroyTargets();
+	glDeleteVertexArrays(1, &vertexArray);
+	glDeleteProgram(program);
+	vertexArray = program = 0;
+}
+
+#pragma endregion
+
+#pragma region CPU Ray Cast
+
+void pickRay(float ndcX, float ndcY, const float viewProjection[16], Vec3& origin, Vec3& direction)
+{
+	float inverse[16];
+	if (!invertMatrix(viewProjection, inverse)) {
+		origin = direction = Vec3();
+		return;
+	}
+	origin = transformPoint(inverse, Vec3(ndcX, ndcY, -1.0f));
+	direction = normalize(transformPoint(inverse, Vec3(ndcX, ndcY, 1.0f)) - origin);
+}
+
+uint32_t rayCastPick(const Vec3& origin, const Vec3& direction, const vector<PickObject>& objects, float* distance)
+{
+	uint32_t nearestId = 0;
+	float nearest = INFINITY;
+	for (const PickObject& object : objects) {
+		for (uint32_t i = object.firstIndex; i + 3 <= object.firstIndex + object.indexCount; i += 3) {
+			Vec3 a(&object.positions[object.indices[i] * 3]);
+			Vec3 b(&object.positions[object.indices[i + 1] * 3]);
+			Vec3 c(&object.positions[object.indices[i + 2] * 3]);
+			// Moller-Trumbore: solve origin + t * direction = a + u * (b - a) + v * (c - a).
+			Vec3 edge1 = b - a, edge2 = c - a;
+			Vec3 p = cross(direction, edge2);
+			float determinant = dot(edge1, p);
+			if (fabs(determinant) < 1e-12f)
+				continue; // Parallel to the triangle.
+			float inverseDeterminant = 1.0f / determinant;
+			Vec3 s = origin - a;
+			float u = dot(s, p) * inverseDeterminant;
+			if (u < 0.0f || u > 1.0f)
+				continue;
+			Vec3 q = cross(s, edge1);
+			float v = dot(direction, q) * inverseDeterminant;
+			if (v < 0.0f || u + v > 1.0f)
+				continue;
+			float t = dot(edge2, q) * inverseDeterminant;
+			if (t >= 0.0f && t < nearest) {
+				nearest = t;
+				nearestId = object.id;
+			}
+		}
+	}
+	if (distance)
+		*distance = nearest;
+	return nearestId;
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+void runPickingBenchmark(GLFWwindow* window, int objectCount, int picks)
+{
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+	glfwSwapInterval(0); // Never wait for vertical sync while measuring.
+
+	// Random boxes (12 triangles each) in front of a perspective camera, all in one pair of buffers.
+	mt19937 random(1234); // Fixed seed, so runs are comparable.
+	uniform_real_distribution<float> spread(-8.0f, 8.0f), depth(-30.0f, -5.0f), size(0.2f, 1.0f);
+	vector<float> positions;
+	vector<uint32_t> indices;
+	vector<PickObject> objects(objectCount);
+	for (int i = 0; i < objectCount; i++) {
+		Vec3 center(spread(random), spread(random), depth(random));
+		float half = size(random);
+		uint32_t base = (uint32_t)positions.size() / 3;
+		for (int corner = 0; corner < 8; corner++) {
+			positions.push_back(center.x + (corner & 1 ? half : -half));
+			positions.push_back(center.y + (corner & 2 ? half : -half));
+			positions.push_back(center.z + (corner & 4 ? half : -half));
+		}
+		const uint32_t box[] = { 0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1, 2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3 };
+		objects[i].firstIndex = (uint32_t)indices.size();
+		objects[i].indexCount = sizeof(box) / sizeof(box[0]);
+		objects[i].id = (uint32_t)i + 1;
+		for (uint32_t index : box)
+			indices.push_back(base + index);
+	}
+	GLuint buffers[2];
+	glGenBuffers(2, buffers);
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+	glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float), positions.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	for (PickObject& object : objects) {
+		object.vertexBuffer = buffers[0];
+		object.indexBuffer = buffers[1];
+		object.positions = positions.data();
+		object.indices = indices.data();
+	}
+
+	float viewProjection[16];
+	perspectiveMatrix(1.047f, (float)width / height, 0.1f, 100.0f, viewProjection); // The camera sits at the origin.
+	GpuPicker picker;
+	if (!picker.init(width, height)) {
+		picker.destroy();
+		glDeleteBuffers(2, buffers);
+		return;
+	}
+
+	vector<int> pixelX(picks), pixelY(picks);
+	uniform_int_distribution<int> columns(0, width - 1), rows(0, height - 1);
+	for (int i = 0; i < picks; i++) {
+		pixelX[i] = columns(random);
+		pixelY[i] = rows(random);
+	}
+	cout << "BENCH::PICKING " << objectCount << " boxes, " << picks << " picks at " << width << "x" << height << endl;
+
+	// Asynchronous: one request per frame, results collected whenever they arrive.
+	vector<double> asyncSamples, latencies;
+	vector<uint32_t> gpuIds(picks, UINT32_MAX);
+	vector<int> requestedPicks; // By request number - 1; rejected requests take no number.
+	PickResult result;
+	for (int i = 0; i < picks || latencies.size() < asyncSamples.size(); i++) {
+		BenchmarkTimer timer;
+		uint32_t request = i < picks ? picker.request(pixelX[i], pixelY[i], viewProjection, objects) : 0;
+		if (request != 0)
+			requestedPicks.push_back(i);
+		if (picker.poll(result)) { // Once per frame, so framesWaited counts frames.
+			gpuIds[requestedPicks[result.request - 1]] = result.objectId;
+			latencies.push_back(result.framesWaited);
+		}
+		if (request != 0)
+			asyncSamples.push_back(timer.elapsedMs());
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+	printBenchmarkStats("PICKING::GPU_ASYNC", computeBenchmarkStats(asyncSamples));
+	double meanLatency = 0.0;
+	for (double latency : latencies)
+		meanLatency += latency / latencies.size();
+	cout << "  " << asyncSamples.size() << " of " << picks << " requests accepted, results after " << meanLatency << " frames on average" << endl;
+
+	// Synchronous: the same pass, but waiting for the result before carrying on.
+	vector<double> syncSamples;
+	for (int i = 0; i < picks; i++) {
+		BenchmarkTimer timer;
+		if (picker.request(pixelX[i], pixelY[i], viewProjection, objects) == 0)
+			continue;
+		while (!picker.poll(result)) {}
+		syncSamples.push_back(timer.elapsedMs());
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+	printBenchmarkStats("PICKING::GPU_SYNC", computeBenchmarkStats(syncSamples));
+
+	// The CPU fallback: a ray through the centre of the pixel against every triangle.
+	vector<double> cpuSamples;
+	int agreements = 0, compared = 0;
+	for (int i = 0; i < picks; i++) {
+		BenchmarkTimer timer;
+		Vec3 origin, direction;
+		pickRay((pixelX[i] + 0.5f) / width * 2.0f - 1.0f, (pixelY[i] + 0.5f) / height * 2.0f - 1.0f, viewProjection, origin, direction);
+		uint32_t id = rayCastPick(origin, direction, objects);
+		cpuSamples.push_back(timer.elapsedMs());
+		if (gpuIds[i] != UINT32_MAX) {
+			compared++;
+			agreements += gpuIds[i] == id ? 1 : 0;
+		}
+	}
+	printBenchmarkStats("PICKING::CPU_RAY_CAST", computeBenchmarkStats(cpuSamples));
+	cout << "  agrees with the GPU on " << agreements << " of " << compared << " picks (the GPU also accepts hits within "
+		<< GpuPicker::PickRadius << " pixels)" << endl;
+
+	picker.destroy();
+	glDeleteBuffers(2, buffers);
+}
+
+#pragma endregion
@@ -0,0 +1,86 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <cstdint> // Import the fixed width integers.
+#include <vector> // Import the vector container.
+
+#include "Graphics.h" // Import GLEW and GLFW.
+#include "Math3D.h" // Import the vectors.
+
+#pragma endregion
+
+// Indexed geometry to pick from: 32-bit indices into tightly packed x, y, z positions. id 0 means nothing.
+struct PickObject
+{
+	GLuint vertexBuffer = 0, indexBuffer = 0; // GL buffers, for GpuPicker.
+	const float* positions = nullptr; // The same data on the CPU, for rayCastPick.
+	const uint32_t* indices = nullptr;
+	uint32_t indexCount = 0, firstIndex = 0;
+	uint32_t id = 0;
+};
+
+struct PickResult
+{
+	uint32_t request = 0; // As returned by GpuPicker::request.
+	int x = 0, y = 0; // The requested pixel.
+	uint32_t objectId = 0; // 0 if nothing was under the cursor.
+	int framesWaited = 0; // Calls to poll() before the result was available.
+};
+
+// Picks by rendering object IDs into an integer target and reading back a few pixels around the cursor without
+// stalling: the read goes into a pixel buffer object with a fence behind it, and poll() only maps the buffer once the
+// fence has signalled, normally a frame or two later.
+//
+// Raw GL, like the transparency pass, because the render device has no integer render targets. request() leaves the
+// GL state at its defaults (depth testing off, no program or vertex array bound) and the draw framebuffer as it was.
+class GpuPicker
+{
+public:
+	static const int PickRadius = 2; // Read (2 * PickRadius + 1)^2 pixels, so thin objects can be hit too.
+	static const int ReadbackSlots = 3; // Requests in flight at once.
+
+	// Create the ID target, shaders and pixel buffers. Returns false if any of them failed.
+	bool init(GLsizei width, GLsizei height);
+	void resize(GLsizei width, GLsizei height);
+
+	// Draw objects' IDs and start reading back around pixel (x, y), counted from the bottom left. Returns the request
+	// number, or 0 if every readback slot is still in flight.
+	uint32_t request(int x, int y, const float viewProjection[16], const std::vector<PickObject>& objects);
+
+	// Collect one finished request, if any. Never blocks; call once per frame.
+	bool poll(PickResult& result);
+
+	// Properly de-allocate all resources.
+	void destroy();
+
+private:
+	struct Readback
+	{
+		GLuint pixelBuffer = 0;
+		GLsync fence = 0; // Non-zero while in flight.
+		PickResult result;
+		int regionX = 0, regionY = 0, regionWidth = 0, regionHeight = 0;
+	};
+
+	void createTargets();
+	void destroyTargets();
+
+	GLsizei width = 0, height = 0;
+	GLuint framebuffer = 0, idTexture = 0, depthRenderbuffer = 0;
+	GLuint program = 0, vertexArray = 0;
+	GLint viewProjectionLocation = -1, objectIdLocation = -1;
+	Readback readbacks[ReadbackSlots];
+	uint32_t nextRequest = 1;
+};
+
+// The world space ray through a point in normalized device coordinates, from the near plane towards the far plane.
+void pickRay(float ndcX, float ndcY, const float viewProjection[16], Vec3& origin, Vec3& direction);
+
+// The CPU fallback: the ID of the object with the nearest triangle the ray hits (Moller-Trumbore), or 0. Writes the
+// distance along the ray to distance if given.
+uint32_t rayCastPick(const Vec3& origin, const Vec3& direction, const std::vector<PickObject>& objects, float* distance = nullptr);
+
+// Pick repeatedly in a scene of objectCount objects with the asynchronous GPU picker, with a synchronous glReadPixels
+// and with the CPU ray cast, and print the time each costs the calling thread and the GPU picker's latency in frames.
+void runPickingBenchmark(GLFWwindow* window, int objectCount, int picks);
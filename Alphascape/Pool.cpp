@@ -0,0 +1,256 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import min.
+#include <iostream> // Import the IO stream libraries.
+#include <thread> // Import the threads.
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "Pool.h" // Import the pool declarations.
+#include "Threading.h" // Import the thread barrier.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Pool Registry
+
+thread_local PoolThreadCaches poolThreadCaches;
+
+// The live pools by ID, so exiting threads can hand their blocks back to pools that still exist.
+static mutex& registryMutex()
+{
+	static mutex registry;
+	return registry;
+}
+
+static FixedPool* livePools[PoolThreadCaches::MaxPools];
+static uint64_t nextSerial = 1;
+
+PoolThreadCaches::~PoolThreadCaches()
+{
+	lock_guard<std::mutex> lock(registryMutex());
+	for (uint32_t id = 0; id < MaxPools; id++) {
+		PoolThreadCache& cache = caches[id];
+		if (cache.count && livePools[id] && livePools[id]->serial == cache.serial)
+			livePools[id]->flush(cache, 0);
+	}
+}
+
+#pragma endregion
+
+#pragma region FixedPool
+
+const uint32_t FixedPool::BatchSize;
+
+FixedPool::FixedPool(size_t size, size_t blockAlignment, uint32_t slabBlocks, MemoryHeap& slabHeap)
+	: blockSize((size + blockAlignment - 1) / blockAlignment * blockAlignment), alignment(blockAlignment),
+	blocksPerSlab(max(slabBlocks, BatchSize)), heap(slabHeap)
+{
+	lock_guard<std::mutex> lock(registryMutex());
+	serial = nextSerial++;
+	id = PoolThreadCaches::MaxPools;
+	for (uint32_t i = 0; i < PoolThreadCaches::MaxPools; i++) {
+		if (!livePools[i]) {
+			id = i;
+			livePools[i] = this;
+			break;
+		}
+	}
+	if (id == PoolThreadCaches::MaxPools)
+		cout << "ERROR::POOL::TOO_MANY_POOLS\nPools past " << PoolThreadCaches::MaxPools << " share one lock" << endl;
+}
+
+FixedPool::~FixedPool()
+{
+	{
+		lock_guard<std::mutex> lock(registryMutex());
+		if (id < PoolThreadCaches::MaxPools)
+			livePools[id] = nullptr;
+	}
+	for (void* slab : slabs)
+		heap.deallocate(slab, blockSize * blocksPerSlab, alignment);
+}
+
+void FixedPool::growSlab()
+{
+	char* slab = (char*)heap.allocate(blockSize * blocksPerSlab, alignment);
+	if (!slab)
+		return;
+	slabs.push_back(slab);
+	for (uint32_t i = blocksPerSlab; i-- > 0;) { // Back to front, so blocks are handed out in address order.
+		PoolFreeBlock* block = (PoolFreeBlock*)(slab + i * blockSize);
+		block->next = freeList;
+		freeList = block;
+	}
+	freeCount += blocksPerSlab;
+}
+
+void* FixedPool::refill(PoolThreadCache& cache)
+{
+	lock_guard<std::mutex> lock(poolMutex);
+	if (freeCount < BatchSize)
+		growSlab();
+	if (!freeList)
+		return nullptr;
+
+	PoolFreeBlock* block = freeList;
+	freeList = block->next;
+	freeCount--;
+	if (id == PoolThreadCaches::MaxPools)
+		return block; // Uncached: every allocation takes the lock.
+
+	// A slot of another serial holds blocks of a pool since destroyed, whose slabs went with it.
+	cache.serial = serial;
+	cache.head = nullptr;
+	cache.count = 0;
+	for (uint32_t i = 0; i < BatchSize && freeList; i++) {
+		PoolFreeBlock* cached = freeList;
+		freeList = cached->next;
+		freeCount--;
+		cached->next = cache.head;
+		cache.head = cached;
+		cache.count++;
+	}
+	return block;
+}
+
+void FixedPool::returnBlock(PoolThreadCache& cache, void* pointer)
+{
+	PoolFreeBlock* block = (PoolFreeBlock*)pointer;
+	if (id == PoolThreadCaches::MaxPools) {
+		lock_guard<std::mutex> lock(poolMutex);
+		block->next = freeList;
+		freeList = block;
+		freeCount++;
+		return;
+	}
+	cache.serial = serial; // This thread's first use of the slot for this pool.
+	cache.head = block;
+	block->next = nullptr;
+	cache.count = 1;
+}
+
+void FixedPool::flush(PoolThreadCache& cache, uint32_t keep)
+{
+	lock_guard<std::mutex> lock(poolMutex);
+	while (cache.count > keep) {
+		PoolFreeBlock* block = cache.head;
+		cache.head = block->next;
+		cache.count--;
+		block->next = freeList;
+		freeList = block;
+		freeCount++;
+	}
+}
+
+size_t FixedPool::getSlabCount() const
+{
+	lock_guard<std::mutex> lock(poolMutex);
+	return slabs.size();
+}
+
+size_t FixedPool::getCapacity() const
+{
+	return getSlabCount() * blocksPerSlab;
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+// A particle and a network message, the kinds of object made and destroyed by the thousand every frame.
+struct PoolParticle
+{
+	float position[3], velocity[3], color[4];
+	float life;
+};
+
+struct PoolMessage
+{
+	uint32_t type, sequence;
+	uint8_t payload[48];
+};
+
+DECLARE_MEMORY_HEAP(PoolBenchmarkMemory, "PoolBenchmark", 0)
+
+template <typename T>
+static T* createBenchmarkObject(bool pooled)
+{
+	return pooled ? createPooled<T>() : new (PoolBenchmarkMemory::get().allocate(sizeof(T))) T();
+}
+
+template <typename T>
+static void destroyBenchmarkObject(T* object, bool pooled)
+{
+	if (pooled)
+		destroyPooled(object);
+	else {
+		object->~T();
+		PoolBenchmarkMemory::get().deallocate(object, sizeof(T));
+	}
+}
+
+void runPoolBenchmark(int objectsPerFrame, int frames, int threadCount)
+{
+	// Counted through tagged heaps rather than by hooking malloc: the general-heap mode allocates every object from
+	// PoolBenchmarkMemory, and the pools take their slabs from PoolMemory, so each heap's allocation count is the
+	// number of malloc calls made on its behalf.
+	cout << "BENCH::POOL " << objectsPerFrame << " particles and messages per thread per frame, " << frames << " frames, "
+		<< threadCount << " threads; a third of each frame's objects are freed by another thread" << endl;
+
+	for (int pooled = 0; pooled < 2; pooled++) {
+		MemoryHeap& countedHeap = pooled ? PoolMemory::get() : PoolBenchmarkMemory::get();
+		uint64_t warmAllocations = 0;
+		vector<double> samples;
+		// Each thread frees the previous frame's objects, a third of them its neighbour's, then makes this frame's.
+		vector<vector<PoolParticle*>> particles(threadCount), nextParticles(threadCount);
+		vector<vector<PoolMessage*>> messages(threadCount), nextMessages(threadCount);
+		ThreadBarrier barrier(threadCount);
+		vector<thread> threads;
+		for (int t = 0; t < threadCount; t++) {
+			threads.emplace_back([&, t] {
+				int neighbour = (t + 1) % threadCount;
+				BenchmarkTimer timer;
+				for (int frame = 0; frame <= frames; frame++) {
+					if (t == 0 && frame == 1)
+						warmAllocations = countedHeap.getAllocationCount(); // Leave out the first frame's slab growth.
+					barrier.wait();
+					timer.reset();
+					for (size_t i = 0; i < particles[t].size(); i++) {
+						destroyBenchmarkObject(i % 3 == 0 ? particles[neighbour][i] : particles[t][i], pooled != 0);
+						destroyBenchmarkObject(i % 3 == 0 ? messages[neighbour][i] : messages[t][i], pooled != 0);
+					}
+					nextParticles[t].resize(objectsPerFrame);
+					nextMessages[t].resize(objectsPerFrame);
+					for (int i = 0; i < objectsPerFrame; i++) {
+						nextParticles[t][i] = createBenchmarkObject<PoolParticle>(pooled != 0);
+						nextMessages[t][i] = createBenchmarkObject<PoolMessage>(pooled != 0);
+						nextParticles[t][i]->life = (float)i;
+						nextMessages[t][i]->sequence = (uint32_t)frame;
+					}
+					barrier.wait();
+					if (t == 0 && frame > 0)
+						samples.push_back(timer.elapsedMs());
+					particles[t].swap(nextParticles[t]);
+					messages[t].swap(nextMessages[t]);
+				}
+				barrier.wait();
+				for (int i = 0; i < objectsPerFrame; i++) {
+					destroyBenchmarkObject(particles[t][i], pooled != 0);
+					destroyBenchmarkObject(messages[t][i], pooled != 0);
+				}
+			});
+		}
+		for (thread& worker : threads)
+			worker.join();
+
+		printBenchmarkStats(pooled ? "POOL::POOLED_FRAME" : "POOL::HEAP_FRAME", computeBenchmarkStats(samples));
+		uint64_t allocations = countedHeap.getAllocationCount() - warmAllocations;
+		cout << "  " << (double)allocations / frames << " heap allocations per frame after the first";
+		if (pooled)
+			cout << ", " << getTypePool<PoolParticle>().getSlabCount() + getTypePool<PoolMessage>().getSlabCount() << " slabs in all";
+		cout << endl;
+	}
+}
+
+#pragma endregion
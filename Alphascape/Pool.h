@@ -0,0 +1,180 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <cstddef> // Import size_t.
+#include <cstdint> // Import the fixed width integers.
+#include <mutex> // Import the mutex.
+#include <new> // Import placement new and bad_alloc.
+#include <utility> // Import forward.
+#include <vector> // Import the vector container.
+
+#include "MemoryProfiler.h" // Import the memory heaps.
+
+#pragma endregion
+
+// Pools for small objects made and destroyed all the time (jobs, particles, messages), so they stay off the general
+// heap. A pool hands out fixed-size blocks from slabs it grows as needed, and every thread keeps its own short free list
+// per pool: allocating or freeing is a few instructions on that list, with no lock and no atomic. Only when a
+// thread's list runs dry, or grows too long, does it move a batch of blocks to or from the pool's shared list, under
+// the pool's lock. A block freed on another thread than the one that allocated it simply joins that thread's list.
+
+DECLARE_MEMORY_HEAP(PoolMemory, "Pools", 0)
+
+struct PoolFreeBlock
+{
+	PoolFreeBlock* next;
+};
+
+// One thread's free list for one pool.
+struct PoolThreadCache
+{
+	uint64_t serial = 0; // The pool's serial number; a mismatch means the slot belongs to another (or no) pool yet.
+	PoolFreeBlock* head = nullptr;
+	uint32_t count = 0;
+};
+
+// Every pool's free list for the calling thread, indexed by pool ID. Returned to the pools when the thread exits.
+struct PoolThreadCaches
+{
+	static const uint32_t MaxPools = 128;
+
+	~PoolThreadCaches();
+
+	PoolThreadCache caches[MaxPools + 1]; // The extra slot is for pools past MaxPools, which go uncached.
+};
+
+extern thread_local PoolThreadCaches poolThreadCaches;
+
+// A pool of fixed-size blocks. Destroy it only once no thread will allocate from it again; the slabs are freed with it.
+class FixedPool
+{
+public:
+	// Blocks move between a thread's list and the shared list this many at a time.
+	static const uint32_t BatchSize = 32;
+
+	// Slabs come from heap, blocksPerSlab blocks at a time.
+	FixedPool(size_t blockSize, size_t alignment, uint32_t blocksPerSlab = 256, MemoryHeap& heap = PoolMemory::get());
+	~FixedPool();
+	FixedPool(const FixedPool&) = delete;
+	FixedPool& operator=(const FixedPool&) = delete;
+
+	// A block, or nullptr if the system is out of memory.
+	void* allocate()
+	{
+		PoolThreadCache& cache = poolThreadCaches.caches[id];
+		PoolFreeBlock* block = cache.head;
+		if (block && cache.serial == serial) {
+			cache.head = block->next;
+			cache.count--;
+			return block;
+		}
+		return refill(cache);
+	}
+
+	void deallocate(void* pointer)
+	{
+		PoolThreadCache& cache = poolThreadCaches.caches[id];
+		if (cache.serial != serial) {
+			returnBlock(cache, pointer);
+			return;
+		}
+		PoolFreeBlock* block = (PoolFreeBlock*)pointer;
+		block->next = cache.head;
+		cache.head = block;
+		if (++cache.count > 2 * BatchSize)
+			flush(cache, BatchSize);
+	}
+
+	size_t getBlockSize() const { return blockSize; }
+	size_t getSlabCount() const;
+	size_t getCapacity() const; // Blocks in all slabs, free or not.
+
+private:
+	friend struct PoolThreadCaches;
+
+	// The slow paths: take a batch from the shared list (growing a slab if it is short), or give one back.
+	void* refill(PoolThreadCache& cache);
+	void returnBlock(PoolThreadCache& cache, void* pointer);
+	void flush(PoolThreadCache& cache, uint32_t keep);
+	void growSlab();
+
+	size_t blockSize, alignment;
+	uint32_t blocksPerSlab;
+	MemoryHeap& heap;
+	uint32_t id;
+	uint64_t serial;
+
+	mutable std::mutex poolMutex;
+	PoolFreeBlock* freeList = nullptr;
+	size_t freeCount = 0;
+	std::vector<void*> slabs;
+};
+
+// The pool for objects of type T, shared by the whole program and made on first use. Never destroyed, so objects can
+// still be freed into it during shutdown.
+template <typename T>
+FixedPool& getTypePool()
+{
+	static FixedPool* pool = new FixedPool(sizeof(T) < sizeof(PoolFreeBlock) ? sizeof(PoolFreeBlock) : sizeof(T),
+		alignof(T) < alignof(PoolFreeBlock) ? alignof(PoolFreeBlock) : alignof(T));
+	return *pool;
+}
+
+// Make and destroy T in its type's pool.
+template <typename T, typename... Args>
+T* createPooled(Args&&... args)
+{
+	void* block = getTypePool<T>().allocate();
+	return block ? new (block) T(std::forward<Args>(args)...) : nullptr;
+}
+
+template <typename T>
+void destroyPooled(T* object)
+{
+	if (!object)
+		return;
+	object->~T();
+	getTypePool<T>().deallocate(object);
+}
+
+// A standard allocator that takes single objects from their type's pool and anything bigger from PoolMemory. For
+// allocate_shared, which allocates the object and its reference counts together as one pooled block.
+template <typename T>
+class PoolAllocator
+{
+public:
+	typedef T value_type;
+
+	template <typename U>
+	struct rebind { typedef PoolAllocator<U> other; };
+
+	PoolAllocator() {}
+	template <typename U>
+	PoolAllocator(const PoolAllocator<U>&) {}
+
+	T* allocate(size_t count)
+	{
+		void* pointer = count == 1 ? getTypePool<T>().allocate() : PoolMemory::get().allocate(count * sizeof(T), alignof(T));
+		if (!pointer)
+			throw std::bad_alloc(); // The standard containers require it.
+		return (T*)pointer;
+	}
+
+	void deallocate(T* pointer, size_t count)
+	{
+		if (count == 1)
+			getTypePool<T>().deallocate(pointer);
+		else
+			PoolMemory::get().deallocate(pointer, count * sizeof(T), alignof(T));
+	}
+
+	template <typename U>
+	bool operator==(const PoolAllocator<U>&) const { return true; }
+	template <typename U>
+	bool operator!=(const PoolAllocator<U>&) const { return false; }
+};
+
+// Simulate frames that make and destroy particles and messages on threadCount threads, through the heap and through
+// pools, and print the time per frame and the heap allocations per frame of each.
+void runPoolBenchmark(int objectsPerFrame, int frames, int threadCount);
@@ -0,0 +1,93 @@
+#pragma region Library Imports
+
+#include <iomanip> // Import stream formatting.
+#include <iostream> // Import the IO stream libraries.
+#include <vector> // Import the vector container.
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "Reflection.h" // Import the reflection templates.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Benchmark
+
+// An entity with padding after flags, which the packed format leaves out.
+struct ReflectedEntity
+{
+	uint32_t id;
+	float position[3];
+	float rotation[4];
+	uint16_t flags;
+	float health;
+};
+#define REFLECTED_ENTITY_FIELDS(FIELD) FIELD(id) FIELD(position) FIELD(rotation) FIELD(flags) FIELD(health)
+REFLECT(ReflectedEntity, REFLECTED_ENTITY_FIELDS)
+
+// What writePacked() would be written as by hand.
+static char* writeEntityByHand(const ReflectedEntity& entity, char* out)
+{
+	memcpy(out, &entity.id, 4);
+	memcpy(out + 4, entity.position, 12);
+	memcpy(out + 16, entity.rotation, 16);
+	memcpy(out + 32, &entity.flags, 2);
+	memcpy(out + 34, &entity.health, 4);
+	return out + 38;
+}
+
+static const char* readEntityByHand(ReflectedEntity& entity, const char* in)
+{
+	memcpy(&entity.id, in, 4);
+	memcpy(entity.position, in + 4, 12);
+	memcpy(entity.rotation, in + 16, 16);
+	memcpy(&entity.flags, in + 32, 2);
+	memcpy(&entity.health, in + 34, 4);
+	return in + 38;
+}
+
+void runReflectionBenchmark(int entityCount)
+{
+	const int rounds = 20;
+	vector<ReflectedEntity> entities(entityCount), loaded(entityCount);
+	for (int i = 0; i < entityCount; i++) {
+		ReflectedEntity& entity = entities[i];
+		entity.id = (uint32_t)i;
+		for (int c = 0; c < 3; c++)
+			entity.position[c] = (float)(i % 1000) * (c + 1);
+		entity.rotation[0] = entity.rotation[1] = entity.rotation[2] = 0.0f;
+		entity.rotation[3] = 1.0f;
+		entity.flags = (uint16_t)(i & 0xFFFF);
+		entity.health = (float)(i % 100);
+	}
+	size_t packed = packedSize<ReflectedEntity>();
+	vector<char> buffer(packed * entityCount);
+	cout << "BENCH::REFLECTION " << entityCount << " entities, " << Reflection<ReflectedEntity>::FieldCount << " fields, "
+		<< sizeof(ReflectedEntity) << " bytes in memory, " << packed << " packed" << endl;
+	printFields(cout, entities[1]);
+
+	for (int generated = 0; generated < 2; generated++) {
+		vector<double> writeSamples, readSamples;
+		bool matches = true;
+		for (int round = 0; round < rounds; round++) {
+			BenchmarkTimer timer;
+			char* out = buffer.data();
+			for (const ReflectedEntity& entity : entities)
+				out = generated ? writePacked(entity, out) : writeEntityByHand(entity, out);
+			writeSamples.push_back(timer.elapsedMs());
+
+			timer.reset();
+			const char* in = buffer.data();
+			for (ReflectedEntity& entity : loaded)
+				in = generated ? readPacked(entity, in) : readEntityByHand(entity, in);
+			readSamples.push_back(timer.elapsedMs());
+			matches = matches && out == buffer.data() + buffer.size() && loaded.back().health == entities.back().health;
+		}
+		printBenchmarkStats(generated ? "REFLECTION::GENERATED_WRITE" : "REFLECTION::HAND_WRITTEN_WRITE", computeBenchmarkStats(writeSamples));
+		printBenchmarkStats(generated ? "REFLECTION::GENERATED_READ" : "REFLECTION::HAND_WRITTEN_READ", computeBenchmarkStats(readSamples));
+		if (!matches)
+			cout << "ERROR::REFLECTION::ROUND_TRIP_MISMATCH" << endl;
+	}
+}
+
+#pragma endregion
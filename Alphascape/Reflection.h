@@ -0,0 +1,168 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <cstddef> // Import offsetof and size_t.
+#include <cstdint> // Import the fixed width integers.
+#include <cstring> // Import memcpy.
+#include <ostream> // Import the output streams.
+
+#pragma endregion
+
+// Compile-time reflection: a struct's fields are listed once, and serializers, std140 layout checks and inspectors are
+// generated from the list by templates. Everything resolves at compile time, through member pointers and offsetof,
+// so there is no runtime type lookup and the generated code inlines to the same as hand-written code.
+//
+// List the fields with an X-macro after the struct, at global scope:
+//
+//   struct Light { float position[4]; float color[4]; float radius; };
+//   #define LIGHT_FIELDS(FIELD) FIELD(position) FIELD(color) FIELD(radius)
+//   REFLECT(Light, LIGHT_FIELDS)
+//
+// Then Reflection<Light>::forEachField(visitor) calls visitor(name, memberPointer, offset) for each field in order,
+// and the helpers below build on that.
+template <typename T>
+struct Reflection; // Only the REFLECT specialisations are defined.
+
+#pragma region std140
+
+// A field's std140 base alignment and size. Scalars are 4 bytes; float[2], [3] and [4] are vec2, vec3 and vec4, and
+// float[16] is a column-major mat4. Other arrays have no specialisation, so reflecting them for std140 fails to compile
+// (std140 pads every array element to 16 bytes, which a plain C array does not).
+template <typename T>
+struct Std140Traits;
+
+template <> struct Std140Traits<float> { static const size_t Alignment = 4, Size = 4; };
+template <> struct Std140Traits<int32_t> { static const size_t Alignment = 4, Size = 4; };
+template <> struct Std140Traits<uint32_t> { static const size_t Alignment = 4, Size = 4; };
+
+template <size_t N>
+struct Std140VectorTraits;
+
+template <> struct Std140VectorTraits<2> { static const size_t Alignment = 8, Size = 8; };
+template <> struct Std140VectorTraits<3> { static const size_t Alignment = 16, Size = 12; };
+template <> struct Std140VectorTraits<4> { static const size_t Alignment = 16, Size = 16; };
+template <> struct Std140VectorTraits<16> { static const size_t Alignment = 16, Size = 64; }; // mat4.
+
+template <typename T, size_t N>
+struct Std140Traits<T[N]> : Std140VectorTraits<N>
+{
+	static_assert(Std140Traits<T>::Size == 4, "std140 vectors and matrices are made of 4-byte scalars");
+};
+
+// T, but dependent on Unused, so a member template naming it is only checked when instantiated.
+template <typename Unused, typename T>
+struct ReflectDelay { typedef T Type; };
+
+// Where the std140 layout has got to while walking the fields: the next free offset, and whether every field so far
+// sits exactly where std140 would put it.
+struct Std140State
+{
+	size_t offset;
+	bool matches;
+};
+
+constexpr size_t std140AlignUp(size_t offset, size_t alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+constexpr Std140State std140Next(Std140State state, size_t actualOffset, size_t alignment, size_t size)
+{
+	return Std140State{ std140AlignUp(state.offset, alignment) + size, state.matches && actualOffset == std140AlignUp(state.offset, alignment) };
+}
+
+// True if every field of T is at its std140 offset and sizeof(T) is its std140 size as a struct (a multiple of 16),
+// so T can be copied as-is into a uniform block, including arrays of it. Use in a static_assert.
+template <typename T>
+constexpr bool isStd140Layout()
+{
+	return Reflection<T>::template std140Layout<>().matches && sizeof(T) == std140AlignUp(Reflection<T>::template std140Layout<>().offset, 16);
+}
+
+#pragma endregion
+
+// Defines Reflection<Type> from an X-macro listing its fields. See the top of this file.
+#define REFLECT(Type, FIELDS) \
+	template <> \
+	struct Reflection<Type> \
+	{ \
+		typedef Type Reflected; \
+		static const char* getName() { return #Type; } \
+		static const size_t FieldCount = 0 FIELDS(REFLECT_COUNT_FIELD); \
+		template <typename Visitor> \
+		static void forEachField(Visitor&& visitor) { FIELDS(REFLECT_VISIT_FIELD) } \
+		template <typename Unused = void> /* A template, so only types used with std140 need std140 traits. */ \
+		static constexpr Std140State std140Layout() { return FIELDS(REFLECT_STD140_OPEN) Std140State{ 0, true } FIELDS(REFLECT_STD140_CLOSE); } \
+	};
+
+#define REFLECT_COUNT_FIELD(member) + 1
+#define REFLECT_VISIT_FIELD(member) visitor(#member, &Reflected::member, offsetof(Reflected, member));
+// Opens one std140Next( per field, then closes them in field order, folding the fields left to right.
+#define REFLECT_STD140_OPEN(member) std140Next(
+#define REFLECT_STD140_CLOSE(member) , offsetof(Reflected, member), Std140Traits<typename ReflectDelay<Unused, decltype(Reflected::member)>::Type>::Alignment, Std140Traits<typename ReflectDelay<Unused, decltype(Reflected::member)>::Type>::Size)
+
+#pragma region Packed Serialization
+
+// The bytes writePacked() produces: the fields back to back, without the struct's padding.
+template <typename T>
+size_t packedSize()
+{
+	size_t size = 0;
+	Reflection<T>::forEachField([&size](const char*, auto member, size_t) { size += sizeof(((T*)nullptr)->*member); });
+	return size;
+}
+
+// Write the fields of object to out, back to back, and return the end of what was written.
+template <typename T>
+char* writePacked(const T& object, char* out)
+{
+	Reflection<T>::forEachField([&object, &out](const char*, auto member, size_t) {
+		memcpy(out, &(object.*member), sizeof(object.*member));
+		out += sizeof(object.*member);
+	});
+	return out;
+}
+
+// Read the fields of object back from what writePacked() wrote, and return the end of what was read.
+template <typename T>
+const char* readPacked(T& object, const char* in)
+{
+	Reflection<T>::forEachField([&object, &in](const char*, auto member, size_t) {
+		memcpy(&(object.*member), in, sizeof(object.*member));
+		in += sizeof(object.*member);
+	});
+	return in;
+}
+
+#pragma endregion
+
+#pragma region Inspector
+
+template <typename V>
+void printReflectedValue(std::ostream& out, const V& value) { out << value; }
+
+template <typename V, size_t N>
+void printReflectedValue(std::ostream& out, const V (&values)[N])
+{
+	for (size_t i = 0; i < N; i++)
+		out << (i ? " " : "") << values[i];
+}
+
+// Print one "name = value" line per field, for debug views and logs.
+template <typename T>
+void printFields(std::ostream& out, const T& object)
+{
+	out << Reflection<T>::getName() << "\n";
+	Reflection<T>::forEachField([&out, &object](const char* name, auto member, size_t) {
+		out << "  " << name << " = ";
+		printReflectedValue(out, object.*member);
+		out << "\n";
+	});
+}
+
+#pragma endregion
+
+// Write and read entityCount reflected entities with the generated packed serializer and with a hand-written one, and
+// print the time per entity of each.
+void runReflectionBenchmark(int entityCount);
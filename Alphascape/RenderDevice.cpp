@@ -0,0 +1,182 @@
+#pragma region Library Imports
+
+#include <cmath> // Import the C maths libraries.
+#include <cstdlib> // Import abs.
+#include <fstream> // Import the file streams.
+#include <iostream> // Import the IO stream libraries.
+#include <thread> // Import the threads.
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "RenderDevice.h" // Import the render device interface.
+#include "SceneGeometry.h" // Import the scene geometry.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Shaders
+
+// The scene shaders with their colour in the Constants block, as every RenderDevice pipeline expects.
+static const char* sceneVertexShaderSource =
+"#version 330 core\n"
+"layout(location = 0) in vec3 position;\n"
+"void main()\n"
+"{\n"
+"gl_Position = vec4(position, 1.0);\n"
+"}\n\0";
+static const char* sceneFragmentShaderSource =
+"#version 330 core\n"
+"layout(std140) uniform Constants { vec4 ourColor; };\n"
+"out vec4 color;\n"
+"void main()\n"
+"{\n"
+"color = ourColor;\n"
+"}\n\0";
+
+#pragma endregion
+
+SamplerHandle RenderDevice::getSampler(const SamplerDesc& desc)
+{
+	vector<pair<SamplerDesc, SamplerHandle>>& bucket = samplerCache[hashSamplerDesc(desc)];
+	for (const pair<SamplerDesc, SamplerHandle>& entry : bucket) { // Almost always one entry; equal hashes are checked.
+		if (entry.first == desc)
+			return entry.second;
+	}
+	SamplerHandle sampler = createSamplerObject(desc);
+	if (sampler.valid()) {
+		bucket.push_back(make_pair(desc, sampler));
+		samplerCount++;
+	}
+	return sampler;
+}
+
+vector<uint32_t> loadSpirv(const string& path)
+{
+	ifstream file(path, ios::binary | ios::ate);
+	if (!file) {
+		cout << "ERROR::RENDER_DEVICE::SPIRV_NOT_FOUND\n" << path << " (compile the shaders/ sources with glslangValidator -V)" << endl;
+		return vector<uint32_t>();
+	}
+	size_t size = (size_t)file.tellg();
+	if (size == 0 || size % 4 != 0) {
+		cout << "ERROR::RENDER_DEVICE::SPIRV_INVALID\n" << path << endl;
+		return vector<uint32_t>();
+	}
+	vector<uint32_t> words(size / 4);
+	file.seekg(0);
+	file.read((char*)words.data(), size);
+	return words;
+}
+
+bool runRenderDeviceTest(RenderDevice& device, int width, int height, int recordingThreads, int drawsPerThread, int frames)
+{
+	cout << "Render device: " << device.getBackendName() << endl;
+
+	// Scene resources.
+	BufferDesc vertexDesc;
+	vertexDesc.usage = BufferUsage::Vertex;
+	vertexDesc.size = sizeof(sceneVertices);
+	vertexDesc.initialData = sceneVertices;
+	BufferHandle vertexBuffer = device.createBuffer(vertexDesc);
+
+	BufferDesc indexDesc;
+	indexDesc.usage = BufferUsage::Index;
+	indexDesc.size = sizeof(sceneIndices);
+	indexDesc.initialData = sceneIndices;
+	BufferHandle indexBuffer = device.createBuffer(indexDesc);
+
+	PipelineDesc pipelineDesc;
+	pipelineDesc.vertexSource = sceneVertexShaderSource;
+	pipelineDesc.fragmentSource = sceneFragmentShaderSource;
+	if (string(device.getBackendName()).find("Vulkan") != string::npos) {
+		pipelineDesc.vertexSpirv = loadSpirv("shaders/scene.vert.spv");
+		pipelineDesc.fragmentSpirv = loadSpirv("shaders/scene.frag.spv");
+	}
+	pipelineDesc.layout.add(0, 3, 0, 0);
+	pipelineDesc.layout.strides[0] = 3 * sizeof(float);
+	PipelineHandle pipeline = device.createPipeline(pipelineDesc);
+	pipelineDesc.blend = BlendMode::Alpha; // Same output for opaque colours; only the blend state differs.
+	PipelineHandle blendedPipeline = device.createPipeline(pipelineDesc);
+	if (!pipeline.valid() || !blendedPipeline.valid())
+		return false;
+
+	vector<CommandList*> lists;
+	for (int i = 0; i < recordingThreads; i++)
+		lists.push_back(device.createCommandList());
+
+	// Every draw covers the same quads, so the last draw of the last list decides the final colour.
+	const float clearColor[4] = { 0.529f, 0.808f, 0.980f, 1.0f };
+	auto drawColor = [&](int list, int draw, float color[4]) {
+		color[0] = (list + 1) / (float)recordingThreads;
+		color[1] = (draw + 1) / (float)drawsPerThread;
+		color[2] = 0.25f;
+		color[3] = 1.0f;
+	};
+
+	// Record each list on its own thread. Draws alternate between two pipelines in runs of eight, so the backend has
+	// to switch state without it being every draw.
+	auto record = [&](int index) {
+		CommandList* list = lists[index];
+		list->begin();
+		for (int draw = 0; draw < drawsPerThread; draw++) {
+			float color[4];
+			drawColor(index, draw, color);
+			list->bindPipeline((draw / 8) % 2 == 0 ? pipeline : blendedPipeline);
+			list->bindVertexBuffer(0, vertexBuffer);
+			list->bindIndexBuffer(indexBuffer);
+			list->setConstants(color, sizeof(color));
+			list->drawIndexed(sceneIndexCount);
+		}
+		list->end();
+	};
+
+	vector<double> recordSamples, submitSamples;
+	device.resetStats();
+	for (int frame = 0; frame < frames; frame++) {
+		BenchmarkTimer timer;
+		vector<thread> threads;
+		for (int i = 1; i < recordingThreads; i++)
+			threads.emplace_back(record, i);
+		record(0); // The submitting thread records the first list itself.
+		for (thread& worker : threads)
+			worker.join();
+		recordSamples.push_back(timer.elapsedMs());
+
+		timer.reset();
+		device.beginFrame(width, height, clearColor);
+		device.submit(lists.data(), lists.size());
+		device.endFrame();
+		submitSamples.push_back(timer.elapsedMs());
+	}
+
+	// Check the frame: inside the first quad and in the background.
+	unsigned char quadPixel[4] = {}, backgroundPixel[4] = {};
+	bool readBack = device.readPixels(width / 4, height / 4, 1, 1, quadPixel) && device.readPixels(width - 2, 1, 1, 1, backgroundPixel);
+	float expected[4];
+	drawColor(recordingThreads - 1, drawsPerThread - 1, expected);
+	bool success = readBack;
+	for (int channel = 0; channel < 4; channel++) {
+		success = success && abs(quadPixel[channel] - (int)lround(expected[channel] * 255.0f)) <= 2;
+		success = success && abs(backgroundPixel[channel] - (int)lround(clearColor[channel] * 255.0f)) <= 2;
+	}
+
+	cout << "BENCH::RENDER_DEVICE " << device.getBackendName() << ", " << recordingThreads << " recording threads x " << drawsPerThread << " draws" << endl;
+	printBenchmarkStats("RENDER_DEVICE::RECORD", computeBenchmarkStats(recordSamples));
+	printBenchmarkStats("RENDER_DEVICE::SUBMIT", computeBenchmarkStats(submitSamples));
+	const RenderStats& stats = device.getStats();
+	cout << "Per frame: " << stats.drawCalls / frames << " draws, " << stats.pipelineBinds / frames << " pipeline binds, "
+		<< stats.stateChanges / frames << " state changes emitted, " << stats.stateChangesSkipped / frames << " skipped, "
+		<< stats.bufferBinds / frames << " buffer binds" << endl;
+	cout << "Render device test " << (success ? "PASSED" : "FAILED");
+	if (readBack)
+		cout << " (quad pixel " << (int)quadPixel[0] << " " << (int)quadPixel[1] << " " << (int)quadPixel[2] << " " << (int)quadPixel[3] << ")";
+	else
+		cout << " (pixels not read back)";
+	cout << endl;
+
+	device.destroyPipeline(pipeline);
+	device.destroyPipeline(blendedPipeline);
+	device.destroyBuffer(vertexBuffer);
+	device.destroyBuffer(indexBuffer);
+	return success;
+}
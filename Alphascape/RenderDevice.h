@@ -0,0 +1,265 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <cstddef> // Import size_t.
+#include <cstdint> // Import the fixed width integers.
+#include <string> // Import the string class.
+#include <unordered_map> // Import the hash map.
+#include <utility> // Import pair.
+#include <vector> // Import the vector container.
+
+#pragma endregion
+
+// A thin, backend-neutral rendering interface: buffers, textures, pipelines and command lists.
+//
+// Resources are created up front and referred to by small handles. Drawing is recorded into CommandLists, which
+// may be recorded on any number of threads at once (one list per thread), and then submitted in order on the
+// thread that owns the device. Resources must not be created or destroyed while lists are being recorded.
+//
+// Backends: GLRenderDevice (the existing GL 3.3 path, GLRenderDevice.h) and VulkanRenderDevice
+// (VulkanRenderDevice.h, compiled in with ALPHASCAPE_VULKAN).
+
+#pragma region Handles
+
+struct BufferHandle { uint32_t id = 0; bool valid() const { return id != 0; } };
+struct TextureHandle { uint32_t id = 0; bool valid() const { return id != 0; } };
+struct PipelineHandle { uint32_t id = 0; bool valid() const { return id != 0; } };
+struct SamplerHandle { uint32_t id = 0; bool valid() const { return id != 0; } };
+
+#pragma endregion
+
+#pragma region Descriptions
+
+enum class BufferUsage { Vertex, Index, Uniform };
+
+struct BufferDesc
+{
+	BufferUsage usage = BufferUsage::Vertex;
+	size_t size = 0;
+	const void* initialData = nullptr; // May be null.
+	bool dynamic = false; // Updated every frame with updateBuffer().
+};
+
+enum class TextureFormat { RGBA8, RGBA16F, R16F };
+
+struct TextureDesc
+{
+	int width = 0, height = 0;
+	int layers = 1; // More than one creates a 2D array texture.
+	bool array = false; // Create a 2D array texture even with a single layer (sampler2DArray).
+	TextureFormat format = TextureFormat::RGBA8;
+	const void* initialData = nullptr; // Tightly packed, all layers; may be null.
+	bool linearFilter = true;
+	bool generateMipmaps = false;
+};
+
+enum class SamplerFilter { Nearest, Linear };
+enum class SamplerWrap { Repeat, ClampToEdge, MirroredRepeat };
+
+// Sampling state, kept apart from textures so one sampler object serves every texture sampled the same way.
+struct SamplerDesc
+{
+	SamplerFilter minFilter = SamplerFilter::Linear;
+	SamplerFilter magFilter = SamplerFilter::Linear;
+	bool mipmaps = false; // Filter between mip levels with minFilter.
+	SamplerWrap wrapU = SamplerWrap::Repeat;
+	SamplerWrap wrapV = SamplerWrap::Repeat;
+	float maxAnisotropy = 1.0f; // Clamped to what the device supports.
+
+	bool operator==(const SamplerDesc& other) const
+	{
+		return minFilter == other.minFilter && magFilter == other.magFilter && mipmaps == other.mipmaps &&
+			wrapU == other.wrapU && wrapV == other.wrapV && maxAnisotropy == other.maxAnisotropy;
+	}
+};
+
+// FNV-1a over the fields (not the bytes, so padding never matters).
+inline uint64_t hashSamplerDesc(const SamplerDesc& desc)
+{
+	uint32_t anisotropyBits = (uint32_t)(desc.maxAnisotropy * 16.0f);
+	uint32_t fields[] = { (uint32_t)desc.minFilter, (uint32_t)desc.magFilter, desc.mipmaps ? 1u : 0u, (uint32_t)desc.wrapU, (uint32_t)desc.wrapV, anisotropyBits };
+	uint64_t hash = 14695981039346656037ull;
+	for (uint32_t field : fields) {
+		hash ^= field;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+// One float vertex attribute. Binding 0 advances per vertex, binding 1 per instance.
+struct VertexAttribute
+{
+	uint32_t location = 0;
+	uint32_t components = 3; // 1 to 4 floats.
+	uint32_t binding = 0;
+	uint32_t offset = 0; // In bytes from the start of the element.
+};
+
+struct VertexLayout
+{
+	static const int MaxAttributes = 8;
+	VertexAttribute attributes[MaxAttributes];
+	uint32_t attributeCount = 0;
+	uint32_t strides[2] = { 0, 0 }; // Bytes per element of binding 0 and binding 1.
+
+	// Append an attribute; returns *this so layouts can be built in one expression.
+	VertexLayout& add(uint32_t location, uint32_t components, uint32_t binding, uint32_t offset)
+	{
+		VertexAttribute& attribute = attributes[attributeCount++];
+		attribute.location = location;
+		attribute.components = components;
+		attribute.binding = binding;
+		attribute.offset = offset;
+		return *this;
+	}
+};
+
+enum class PrimitiveTopology { Triangles, TriangleStrip };
+
+enum class BlendMode { Opaque, Alpha, Additive };
+
+enum class DepthCompare { Less, LessEqual, Equal, Always };
+
+// Everything a draw needs besides its buffers, textures and constants. Pipelines are immutable once created, so
+// backends resolve the state up front and binding one costs only the changes from the previous pipeline.
+struct PipelineDesc
+{
+	// GLSL 330 sources for the GL backend. Per-draw constants live in "layout(std140) uniform Constants { ... };".
+	const char* vertexSource = nullptr;
+	const char* fragmentSource = nullptr;
+	// SPIR-V for the Vulkan backend. Per-draw constants live in a push constant block.
+	std::vector<uint32_t> vertexSpirv;
+	std::vector<uint32_t> fragmentSpirv;
+
+	// Uniform blocks fed by CommandList::bindUniformBuffer(slot): GL binds blocks by these names; Vulkan shaders
+	// declare slot 0 as "layout(set = 1, binding = 0) uniform". Slot 0 only on Vulkan.
+	static const int MaxUniformBlocks = 2;
+	const char* uniformBlocks[MaxUniformBlocks] = {};
+
+	VertexLayout layout;
+	PrimitiveTopology topology = PrimitiveTopology::Triangles;
+	BlendMode blend = BlendMode::Opaque;
+	bool depthTest = false;
+	bool depthWrite = false;
+	DepthCompare depthCompare = DepthCompare::Less;
+	bool colorWrite = true; // False for depth-only passes.
+	bool wireframe = false;
+};
+
+#pragma endregion
+
+#pragma region Statistics
+
+// What the backend actually did, to check that batching and state sorting pay off. Reset with resetStats().
+struct RenderStats
+{
+	uint64_t drawCalls = 0;
+	uint64_t pipelineBinds = 0; // bindPipeline commands executed.
+	uint64_t stateChanges = 0; // Driver state calls actually emitted (GL) or pipeline switches (Vulkan).
+	uint64_t stateChangesSkipped = 0; // State calls avoided because the state was already current.
+	uint64_t bufferBinds = 0;
+	uint64_t textureBinds = 0;
+	uint64_t samplerBinds = 0;
+
+	RenderStats& operator+=(const RenderStats& other)
+	{
+		drawCalls += other.drawCalls;
+		pipelineBinds += other.pipelineBinds;
+		stateChanges += other.stateChanges;
+		stateChangesSkipped += other.stateChangesSkipped;
+		bufferBinds += other.bufferBinds;
+		textureBinds += other.textureBinds;
+		samplerBinds += other.samplerBinds;
+		return *this;
+	}
+};
+
+#pragma endregion
+
+#pragma region Interfaces
+
+// Recorded drawing commands. Record between begin() and end() on any single thread.
+// Vertex and index buffers are bound after the pipeline that reads them.
+class CommandList
+{
+public:
+	static const size_t MaxConstantsSize = 128; // The smallest push constant size Vulkan guarantees.
+
+	virtual ~CommandList() {}
+
+	virtual void begin() = 0; // Reset and start recording.
+	virtual void end() = 0;
+
+	virtual void bindPipeline(PipelineHandle pipeline) = 0;
+	virtual void bindVertexBuffer(uint32_t binding, BufferHandle buffer, size_t offset = 0) = 0;
+	virtual void bindIndexBuffer(BufferHandle buffer) = 0; // 32-bit indices.
+	// Bind a texture, sampled with sampler if given, else with the texture's own filtering.
+	virtual void bindTexture(uint32_t unit, TextureHandle texture, SamplerHandle sampler = SamplerHandle()) = 0;
+	virtual void bindUniformBuffer(uint32_t slot, BufferHandle buffer) = 0; // See PipelineDesc::uniformBlocks.
+	virtual void setConstants(const void* data, size_t size) = 0; // Per-draw constants, at most MaxConstantsSize bytes.
+	virtual void draw(uint32_t vertexCount, uint32_t instanceCount = 1, uint32_t firstVertex = 0) = 0;
+	virtual void drawIndexed(uint32_t indexCount, uint32_t instanceCount = 1, uint32_t firstIndex = 0) = 0;
+};
+
+class RenderDevice
+{
+public:
+	virtual ~RenderDevice() {}
+
+	virtual const char* getBackendName() const = 0;
+
+	virtual BufferHandle createBuffer(const BufferDesc& desc) = 0;
+	virtual void updateBuffer(BufferHandle buffer, size_t offset, const void* data, size_t size) = 0;
+	virtual void destroyBuffer(BufferHandle buffer) = 0;
+
+	virtual TextureHandle createTexture(const TextureDesc& desc) = 0;
+	virtual void destroyTexture(TextureHandle texture) = 0;
+
+	// Samplers are deduplicated by state: equal descriptions share one sampler object, which lives as long as the
+	// device. Cheap enough to call per material.
+	SamplerHandle getSampler(const SamplerDesc& desc);
+	size_t getSamplerCount() const { return samplerCount; }
+
+	// Returns an invalid handle (and prints an ERROR) if the shaders do not compile for this backend.
+	virtual PipelineHandle createPipeline(const PipelineDesc& desc) = 0;
+	virtual void destroyPipeline(PipelineHandle pipeline) = 0;
+
+	// Command lists are owned by the device; create one per recording thread and reuse it every frame.
+	virtual CommandList* createCommandList() = 0;
+
+	// Start a frame: set the viewport and clear colour and depth.
+	virtual void beginFrame(int width, int height, const float clearColor[4]) = 0;
+
+	// Execute recorded lists, in order. Lists must have been ended.
+	virtual void submit(CommandList* const* lists, size_t count) = 0;
+
+	// Finish the frame. The GL backend leaves presenting to the caller (glfwSwapBuffers).
+	virtual void endFrame() = 0;
+
+	// Read back RGBA8 pixels of the last frame, row 0 at the bottom (GL convention). Waits for the GPU.
+	virtual bool readPixels(int x, int y, int width, int height, void* rgba) = 0;
+
+	// Counters accumulated by submit() since the last resetStats().
+	const RenderStats& getStats() const { return stats; }
+	void resetStats() { stats = RenderStats(); }
+
+protected:
+	virtual SamplerHandle createSamplerObject(const SamplerDesc& desc) = 0; // Called once per distinct description.
+
+	RenderStats stats;
+
+private:
+	std::unordered_map<uint64_t, std::vector<std::pair<SamplerDesc, SamplerHandle>>> samplerCache; // By hashSamplerDesc.
+	size_t samplerCount = 0;
+};
+
+#pragma endregion
+
+// Load a SPIR-V binary (as produced by glslangValidator -V). Returns an empty vector and prints an ERROR on failure.
+std::vector<uint32_t> loadSpirv(const std::string& path);
+
+// Draw the scene geometry through the device with recordingThreads command lists recorded in parallel,
+// each issuing drawsPerThread draws, then read the frame back and check the quads have the expected colour.
+// Prints the timings and returns true on success.
+bool runRenderDeviceTest(RenderDevice& device, int width, int height, int recordingThreads, int drawsPerThread, int frames);
@@ -0,0 +1,89 @@
+#pragma region Library Imports
+
+#include <iostream> // Import the IO stream libraries.
+
+#include "RenderThread.h" // Import the render thread.
+#include "Threading.h" // Import the thread placement.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+bool RenderThread::start(GLFWwindow* renderWindow, int framebufferWidth, int framebufferHeight)
+{
+	window = renderWindow;
+	glfwMakeContextCurrent(nullptr); // A context can only be current on one thread at a time.
+	thread = std::thread(&RenderThread::run, this, framebufferWidth, framebufferHeight);
+
+	// Wait for the renderer to finish creating its resources.
+	unique_lock<mutex> lock(sleepMutex);
+	sleepCondition.wait(lock, [this] { return initialised.load() != 0; });
+	lock.unlock();
+	if (initialised.load() < 0) {
+		thread.join();
+		return false;
+	}
+	return true;
+}
+
+void RenderThread::wake()
+{
+	// Take the mutex so a side that has just checked the queue cannot miss this notification.
+	lock_guard<mutex> lock(sleepMutex);
+	sleepCondition.notify_all();
+}
+
+void RenderThread::submit(const FrameData& frame)
+{
+	while (!queue.tryPush(frame)) { // The render thread is FramesInFlight frames behind: wait for a slot.
+		unique_lock<mutex> lock(sleepMutex);
+		sleepCondition.wait(lock, [this] { return !queue.full(); });
+	}
+	wake();
+}
+
+void RenderThread::stop()
+{
+	if (!thread.joinable())
+		return;
+	stopping.store(true);
+	wake();
+	thread.join();
+	glfwMakeContextCurrent(window); // Hand the context back to the main thread.
+}
+
+void RenderThread::run(int framebufferWidth, int framebufferHeight)
+{
+	placeCurrentThread(ThreadRole::Render);
+	glfwMakeContextCurrent(window); // Make this window the current context on the render thread.
+
+	bool success = renderer.init(framebufferWidth, framebufferHeight);
+	if (!success)
+		cout << "ERROR::RENDER_THREAD::RENDERER_INIT_FAILED" << endl;
+	initialised.store(success ? 1 : -1);
+	wake();
+	if (!success) {
+		renderer.shutdown();
+		glfwMakeContextCurrent(nullptr);
+		return;
+	}
+
+	FrameData frame;
+	for (;;) {
+		if (!queue.tryPop(frame)) {
+			if (stopping.load())
+				break; // Queue drained and asked to stop.
+			unique_lock<mutex> lock(sleepMutex); // Nothing to draw: sleep until a frame or stop arrives.
+			sleepCondition.wait(lock, [this] { return !queue.empty() || stopping.load(); });
+			continue;
+		}
+		wake(); // A slot was freed for the main thread.
+
+		renderer.render(frame);
+		glfwSwapBuffers(window); // Swap the buffers.
+		presented.fetch_add(1, memory_order_relaxed);
+	}
+
+	renderer.shutdown();
+	glfwMakeContextCurrent(nullptr); // Release the context so the main thread can take it back.
+}
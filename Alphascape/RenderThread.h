@@ -0,0 +1,54 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <atomic> // Import the atomics.
+#include <condition_variable> // Import the condition variable.
+#include <mutex> // Import the mutex.
+#include <thread> // Import the threads.
+
+#include "FrameData.h" // Import the frame data.
+#include "Graphics.h" // Import GLEW and GLFW.
+#include "Renderer.h" // Import the renderer.
+#include "SpscQueue.h" // Import the lock-free queue.
+
+#pragma endregion
+
+// Runs the Renderer on a dedicated thread that owns the window's GL context.
+//
+// GLFW must process events on the main thread, so the main thread keeps polling and simulating and hands each
+// finished frame to the render thread through a lock-free SPSC queue. The queue holds FramesInFlight frames,
+// so frame N+1 is simulated while frame N renders, and the main thread only blocks if it gets further ahead.
+// The queue itself never locks; the mutex and condition variable are only used to put an idle side to sleep.
+class RenderThread
+{
+public:
+	static const size_t FramesInFlight = 2;
+
+	// Release the context from the calling thread and start rendering on a new one.
+	// Blocks until the renderer is initialised; returns false (with the thread stopped) if that failed.
+	bool start(GLFWwindow* window, int framebufferWidth, int framebufferHeight);
+
+	// Queue a frame for rendering. Blocks only while FramesInFlight frames are already queued.
+	void submit(const FrameData& frame);
+
+	// Render everything still queued, shut the renderer down and join the thread.
+	void stop();
+
+	// Number of frames the render thread has presented.
+	unsigned long long presentedFrames() const { return presented.load(std::memory_order_relaxed); }
+
+private:
+	void run(int framebufferWidth, int framebufferHeight);
+	void wake();
+
+	GLFWwindow* window = nullptr;
+	Renderer renderer;
+	SpscQueue<FrameData, FramesInFlight> queue;
+	std::thread thread;
+	std::atomic<bool> stopping{ false };
+	std::atomic<int> initialised{ 0 }; // 0 while starting, 1 on success, -1 on failure.
+	std::atomic<unsigned long long> presented{ 0 };
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+};
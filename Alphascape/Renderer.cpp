@@ -0,0 +1,186 @@
+#pragma region Library Imports
+
+#include <cmath> // Import the C maths libraries.
+#include <cstring> // Import memcpy.
+#include <iostream> // Import the IO stream libraries.
+#include <vector> // Import the vector container.
+
+#include "Renderer.h" // Import the renderer.
+#include "SceneGeometry.h" // Import the scene geometry.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Shaders
+
+static const GLchar* vertexShaderSource =
+"#version 330 core\n"
+"layout(location = 0) in vec3 position;\n"
+"void main()\n"
+"{\n"
+"gl_Position = vec4(position, 1.0);\n"
+"}\n\0";
+static const GLchar* fragmentShaderSource =
+"#version 330 core\n"
+"layout(std140) uniform Constants { vec4 ourColor; };\n" // Per-draw constants of the render device.
+"out vec4 color;\n"
+"void main()\n"
+"{\n"
+"color = ourColor;\n"
+"}\n\0";
+
+#pragma endregion
+
+bool Renderer::init(int framebufferWidth, int framebufferHeight)
+{
+	device.reset(new GLRenderDevice()); // Needs the context, so it is created here rather than with the Renderer.
+
+	#pragma region Pipelines
+
+	// Build and compile the scene materials: one filled, one for wireframe mode. The opaque pass bakes their
+	// depth-only, shading and overdraw pipelines.
+	opaquePass.reset(new OpaquePass(*device));
+	PipelineDesc pipelineDesc;
+	pipelineDesc.vertexSource = vertexShaderSource;
+	pipelineDesc.fragmentSource = fragmentShaderSource;
+	pipelineDesc.layout.add(0, 3, 0, 0); // Tell the device how to interpret the vertices.
+	pipelineDesc.layout.strides[0] = 3 * sizeof(GLfloat);
+	fillMaterial = opaquePass->addMaterial(pipelineDesc);
+	pipelineDesc.wireframe = true;
+	wireframeMaterial = opaquePass->addMaterial(pipelineDesc);
+	if (fillMaterial == UINT32_MAX || wireframeMaterial == UINT32_MAX)
+		return false;
+
+	#pragma endregion
+
+	#pragma region Buffers
+
+	// Load the scene geometry as static vertices and indices.
+	BufferDesc vertexDesc;
+	vertexDesc.usage = BufferUsage::Vertex;
+	vertexDesc.size = sizeof(sceneVertices);
+	vertexDesc.initialData = sceneVertices;
+	vertexBuffer = device->createBuffer(vertexDesc);
+
+	BufferDesc indexDesc;
+	indexDesc.usage = BufferUsage::Index;
+	indexDesc.size = sizeof(sceneIndices);
+	indexDesc.initialData = sceneIndices;
+	indexBuffer = device->createBuffer(indexDesc);
+
+	// One draw per quad (six indices each), at the depth of its centre.
+	for (unsigned int first = 0; first < sceneIndexCount; first += 6) {
+		OpaqueDraw draw;
+		draw.vertexBuffer = vertexBuffer;
+		draw.indexBuffer = indexBuffer;
+		draw.indexCount = 6;
+		draw.firstIndex = first;
+		for (unsigned int i = first; i < first + 6; i++)
+			draw.viewDepth += sceneVertices[sceneIndices[i] * 3 + 2] / 6.0f;
+		sceneDraws.push_back(draw);
+	}
+
+	sceneCommands = device->createCommandList();
+
+	#pragma endregion
+
+	#pragma region Picking
+
+	// The same quads as pickable objects, read straight from the device's buffers.
+	for (unsigned int first = 0; first < sceneIndexCount; first += 6) {
+		PickObject object;
+		object.vertexBuffer = device->getGLBuffer(vertexBuffer);
+		object.indexBuffer = device->getGLBuffer(indexBuffer);
+		object.positions = sceneVertices;
+		object.indices = sceneIndices;
+		object.indexCount = 6;
+		object.firstIndex = first;
+		object.id = first / 6 + 1;
+		pickObjects.push_back(object);
+	}
+	if (!picker.init(framebufferWidth, framebufferHeight))
+		return false;
+
+	#pragma endregion
+
+	#pragma region Transparent Layer
+
+	// A small ring of overlapping transparent quads drawn over the scene.
+	vector<TransparentQuad> transparentQuads;
+	for (int i = 0; i < 12; i++) {
+		GLfloat angle = i * 6.2831853f / 12.0f;
+		TransparentQuad quad = {
+			{ 0.35f * cos(angle), 0.35f * sin(angle), -0.5f + i / 12.0f },
+			{ 0.4f, 0.4f },
+			{ 0.5f + 0.5f * cos(angle), 0.5f + 0.5f * sin(angle), 0.5f, 0.35f }
+		};
+		transparentQuads.push_back(quad);
+	}
+	if (!transparencyRenderer.init(framebufferWidth, framebufferHeight))
+		return false;
+	transparencyRenderer.setQuads(transparentQuads);
+
+	#pragma endregion
+
+	// Define the viewport dimensions
+	viewportWidth = framebufferWidth;
+	viewportHeight = framebufferHeight;
+	glViewport(0, 0, viewportWidth, viewportHeight);
+	return true;
+}
+
+void Renderer::render(const FrameData& frame)
+{
+	// Follow the window size; the viewport can only be changed on the render thread.
+	if (frame.framebufferWidth != viewportWidth || frame.framebufferHeight != viewportHeight) {
+		viewportWidth = frame.framebufferWidth;
+		viewportHeight = frame.framebufferHeight;
+		glViewport(0, 0, viewportWidth, viewportHeight);
+		transparencyRenderer.resize(viewportWidth, viewportHeight);
+		picker.resize(viewportWidth, viewportHeight);
+	}
+
+	// Vertical sync has to be set by the thread that owns the context.
+	if (frame.swapInterval != swapInterval) {
+		swapInterval = frame.swapInterval;
+		glfwSwapInterval(swapInterval);
+	}
+
+	// Clear, then draw the quads (as lines in wireframe mode) through the render device.
+	for (OpaqueDraw& draw : sceneDraws) {
+		draw.material = frame.wireframe ? wireframeMaterial : fillMaterial;
+		memcpy(draw.constants, frame.objectColor, sizeof(frame.objectColor)); // Upload the simulated colour.
+		draw.constantsSize = sizeof(frame.objectColor);
+	}
+	sceneCommands->begin();
+	opaquePass->record(*sceneCommands, sceneDraws, frame.opaque);
+	sceneCommands->end();
+
+	device->beginFrame(viewportWidth, viewportHeight, frame.clearColor);
+	device->submit(&sceneCommands, 1); // Leaves filled polygons, no blending and no depth testing for the transparency pass.
+	device->endFrame();
+
+	// Draw the transparent layer over the opaque scene (not while showing overdraw, which it would hide).
+	if (!frame.opaque.visualizeOverdraw)
+		transparencyRenderer.render(frame.transparencyMode);
+
+	// Start a pick if one was clicked and report any that has been read back, never waiting for the GPU.
+	if (frame.pick) {
+		const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 }; // The scene is in clip space.
+		if (picker.request(frame.pickX, frame.pickY, identity, pickObjects) == 0)
+			cout << "ERROR::PICKING::TOO_MANY_REQUESTS" << endl;
+	}
+	PickResult pick;
+	if (picker.poll(pick))
+		cout << "Picked object " << pick.objectId << " (GPU, " << pick.framesWaited << " frames later)" << endl;
+}
+
+void Renderer::shutdown()
+{
+	// Properly de-allocate all resources.
+	transparencyRenderer.shutdown(); // Delete the transparency targets and buffers.
+	picker.destroy(); // Delete the ID target and pixel buffers.
+	opaquePass.reset(); // Delete the scene pipelines.
+	device.reset(); // Delete the scene buffers.
+}
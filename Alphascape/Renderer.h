@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory> // Import unique_ptr.
+
+#include "FrameData.h" // Import the frame data.
+#include "GLRenderDevice.h" // Import the GL render device.
+#include "OpaquePass.h" // Import the opaque pass.
+#include "Picking.h" // Import the GPU picker.
+#include "Transparency.h" // Import the transparency renderer.
+
+// Owns every GL object of the scene and draws one FrameData at a time.
+// All methods must be called on the thread that has the GL context current.
+class Renderer
+{
+public:
+	// Compile the shaders and create the buffers. Returns false if a required resource could not be created.
+	bool init(int framebufferWidth, int framebufferHeight);
+
+	// Draw a frame into the default framebuffer. Does not swap.
+	void render(const FrameData& frame);
+
+	// Properly de-allocate all resources.
+	void shutdown();
+
+private:
+	std::unique_ptr<GLRenderDevice> device; // Draws the scene; created once the context is current.
+	std::unique_ptr<OpaquePass> opaquePass;
+	BufferHandle vertexBuffer, indexBuffer;
+	uint32_t fillMaterial = 0, wireframeMaterial = 0;
+	std::vector<OpaqueDraw> sceneDraws; // One per quad, so they can be sorted.
+	CommandList* sceneCommands = nullptr;
+	int viewportWidth = 0, viewportHeight = 0;
+	int swapInterval = -1; // The swap interval last applied, so glfwSwapInterval is only called on change.
+	TransparencyRenderer transparencyRenderer;
+	GpuPicker picker;
+	std::vector<PickObject> pickObjects; // The scene's quads, IDs 1 and 2.
+};
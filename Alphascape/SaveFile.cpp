@@ -0,0 +1,608 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import min.
+#include <cstdio> // Import remove.
+#include <cstring> // Import memcpy and strncmp.
+#include <fstream> // Import the file streams.
+#include <iomanip> // Import stream formatting.
+#include <iostream> // Import the IO stream libraries.
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "SaveFile.h" // Import the save files.
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h> // Import the file mapping functions.
+#else
+#include <fcntl.h> // Import open.
+#include <sys/mman.h> // Import mmap.
+#include <sys/stat.h> // Import fstat.
+#include <unistd.h> // Import close.
+#endif
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Binary Layout
+
+static const char SaveMagic[4] = { 'A', 'S', 'A', 'V' };
+static const char* SaveTextMagic = "ALPHASCAPE_SAVE_TEXT";
+static const size_t SaveAlignment = 16;
+
+struct SaveHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t sectionCount;
+	uint32_t reserved;
+	uint64_t fileSize;
+	uint64_t sectionTableOffset;
+};
+
+struct SaveSectionEntry
+{
+	char name[32];
+	uint32_t recordSize, recordCount, fieldCount, reserved;
+	uint64_t fieldsOffset, dataOffset;
+};
+
+struct SaveFieldEntry
+{
+	char name[32];
+	uint32_t type, count, offset, reserved;
+};
+
+static_assert(sizeof(SaveHeader) == 32 && sizeof(SaveSectionEntry) == 64 && sizeof(SaveFieldEntry) == 48, "The save layout must not depend on the compiler.");
+
+static size_t alignSave(size_t offset)
+{
+	return (offset + SaveAlignment - 1) & ~(SaveAlignment - 1);
+}
+
+static const char* saveTypeName(SaveFieldType type)
+{
+	switch (type) {
+	case SaveFieldType::U32: return "u32";
+	case SaveFieldType::I32: return "i32";
+	default: return "f32";
+	}
+}
+
+// Read one value of a field as a double, which holds every u32, i32 and f32 exactly.
+static double readSaveValue(const char* at, SaveFieldType type)
+{
+	switch (type) {
+	case SaveFieldType::U32: { uint32_t value; memcpy(&value, at, 4); return value; }
+	case SaveFieldType::I32: { int32_t value; memcpy(&value, at, 4); return value; }
+	default: { float value; memcpy(&value, at, 4); return value; }
+	}
+}
+
+static void writeSaveValue(char* at, SaveFieldType type, double value)
+{
+	switch (type) {
+	case SaveFieldType::U32: { uint32_t converted = (uint32_t)value; memcpy(at, &converted, 4); break; }
+	case SaveFieldType::I32: { int32_t converted = (int32_t)value; memcpy(at, &converted, 4); break; }
+	default: { float converted = (float)value; memcpy(at, &converted, 4); break; }
+	}
+}
+
+#pragma endregion
+
+#pragma region Writer
+
+void SaveWriter::addSection(const SaveSchema& schema, const void* records, uint32_t recordCount)
+{
+	sections.push_back({ schema, records, recordCount });
+}
+
+void SaveWriter::buildBinary(vector<char>& image) const
+{
+	// Header, section table, then each section's field table and records.
+	size_t offset = alignSave(sizeof(SaveHeader) + sections.size() * sizeof(SaveSectionEntry));
+	vector<SaveSectionEntry> entries(sections.size());
+	for (size_t i = 0; i < sections.size(); i++) {
+		const Section& section = sections[i];
+		SaveSectionEntry& entry = entries[i];
+		memset(&entry, 0, sizeof(entry));
+		strncpy(entry.name, section.schema.name.c_str(), SaveFile::MaxNameLength);
+		entry.recordSize = section.schema.recordSize;
+		entry.recordCount = section.recordCount;
+		entry.fieldCount = (uint32_t)section.schema.fields.size();
+		entry.fieldsOffset = offset;
+		offset = alignSave(offset + section.schema.fields.size() * sizeof(SaveFieldEntry));
+		entry.dataOffset = offset;
+		offset = alignSave(offset + (size_t)section.schema.recordSize * section.recordCount);
+	}
+
+	image.assign(offset, 0);
+	SaveHeader header;
+	memcpy(header.magic, SaveMagic, 4);
+	header.version = SaveFile::FormatVersion;
+	header.sectionCount = (uint32_t)sections.size();
+	header.reserved = 0;
+	header.fileSize = offset;
+	header.sectionTableOffset = sizeof(SaveHeader);
+	memcpy(image.data(), &header, sizeof(header));
+	if (!entries.empty())
+		memcpy(image.data() + sizeof(header), entries.data(), entries.size() * sizeof(SaveSectionEntry));
+
+	for (size_t i = 0; i < sections.size(); i++) {
+		const Section& section = sections[i];
+		for (size_t f = 0; f < section.schema.fields.size(); f++) {
+			const SaveField& field = section.schema.fields[f];
+			SaveFieldEntry fieldEntry;
+			memset(&fieldEntry, 0, sizeof(fieldEntry));
+			strncpy(fieldEntry.name, field.name.c_str(), SaveFile::MaxNameLength);
+			fieldEntry.type = (uint32_t)field.type;
+			fieldEntry.count = field.count;
+			fieldEntry.offset = field.offset;
+			memcpy(image.data() + entries[i].fieldsOffset + f * sizeof(SaveFieldEntry), &fieldEntry, sizeof(fieldEntry));
+		}
+		if (section.recordCount > 0)
+			memcpy(image.data() + entries[i].dataOffset, section.records, (size_t)section.schema.recordSize * section.recordCount);
+	}
+}
+
+bool SaveWriter::writeBinary(const char* path) const
+{
+	vector<char> image;
+	buildBinary(image);
+	ofstream file(path, ios::binary);
+	file.write(image.data(), image.size());
+	if (!file) {
+		cout << "ERROR::SAVE::FILE_NOT_WRITTEN\n" << path << endl;
+		return false;
+	}
+	return true;
+}
+
+bool SaveWriter::writeText(const char* path) const
+{
+	ofstream file(path);
+	file << SaveTextMagic << " " << SaveFile::FormatVersion << "\n" << setprecision(9); // Enough digits for floats to round trip.
+	for (const Section& section : sections) {
+		file << "section " << section.schema.name << " " << section.recordCount << " " << section.schema.recordSize
+			<< " " << section.schema.fields.size() << "\n";
+		for (const SaveField& field : section.schema.fields)
+			file << "field " << field.name << " " << saveTypeName(field.type) << " " << field.count << " " << field.offset << "\n";
+		const char* record = (const char*)section.records;
+		for (uint32_t r = 0; r < section.recordCount; r++, record += section.schema.recordSize) {
+			file << "r";
+			for (const SaveField& field : section.schema.fields) {
+				for (uint32_t v = 0; v < field.count; v++)
+					file << " " << readSaveValue(record + field.offset + v * 4, field.type);
+			}
+			file << "\n";
+		}
+	}
+	if (!file) {
+		cout << "ERROR::SAVE::FILE_NOT_WRITTEN\n" << path << endl;
+		return false;
+	}
+	return true;
+}
+
+#pragma endregion
+
+#pragma region Reader
+
+SaveFile::~SaveFile()
+{
+	close();
+}
+
+bool SaveFile::open(const char* path)
+{
+	close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		cout << "ERROR::SAVE::FILE_NOT_OPENED\n" << path << endl;
+		return false;
+	}
+	fileHandle = (intptr_t)file;
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+		HANDLE fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (fileMapping) {
+			mappingHandle = (intptr_t)fileMapping;
+			mapping = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+			size = (size_t)fileSize.QuadPart;
+		}
+	}
+#else
+	int file = ::open(path, O_RDONLY);
+	if (file < 0) {
+		cout << "ERROR::SAVE::FILE_NOT_OPENED\n" << path << endl;
+		return false;
+	}
+	fileHandle = file;
+	struct stat status;
+	if (fstat(file, &status) == 0 && status.st_size > 0) {
+		void* view = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (view != MAP_FAILED) {
+			mapping = view;
+			size = (size_t)status.st_size;
+		}
+	}
+#endif
+	if (!mapping) {
+		cout << "ERROR::SAVE::FILE_NOT_MAPPED\n" << path << endl;
+		close();
+		return false;
+	}
+	data = (const char*)mapping;
+
+	if (size >= 4 && memcmp(data, SaveMagic, 4) == 0)
+		return validate(path);
+
+	// Not binary: parse it as text into an image of the binary layout.
+	bool text = size >= strlen(SaveTextMagic) && strncmp(data, SaveTextMagic, strlen(SaveTextMagic)) == 0;
+	close();
+	if (!text) {
+		cout << "ERROR::SAVE::NOT_A_SAVE\n" << path << endl;
+		return false;
+	}
+	return parseText(path);
+}
+
+void SaveFile::close()
+{
+#ifdef _WIN32
+	if (mapping)
+		UnmapViewOfFile(mapping);
+	if (mappingHandle != -1)
+		CloseHandle((HANDLE)mappingHandle);
+	if (fileHandle != -1)
+		CloseHandle((HANDLE)fileHandle);
+#else
+	if (mapping)
+		munmap(mapping, size);
+	if (fileHandle != -1)
+		::close((int)fileHandle);
+#endif
+	mapping = nullptr;
+	fileHandle = mappingHandle = -1;
+	ownedData.clear();
+	data = nullptr;
+	size = 0;
+}
+
+// Whether count elements of elementSize bytes at offset lie within size bytes. Divides rather than adding and
+// multiplying, so offsets and counts near 2^64 cannot wrap around into range.
+static bool fitsWithin(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t size)
+{
+	return offset <= size && (elementSize == 0 || count <= (size - offset) / elementSize);
+}
+
+// Check every offset and size, so a truncated or corrupt save is rejected instead of read out of bounds.
+bool SaveFile::validate(const char* path)
+{
+	const char* problem = nullptr;
+	SaveHeader header;
+	if (size < sizeof(header)) {
+		problem = "truncated header";
+	}
+	else {
+		memcpy(&header, data, sizeof(header));
+		if (header.version > FormatVersion)
+			problem = "written by a newer version";
+		else if (header.fileSize != size)
+			problem = "truncated";
+		else if (header.sectionTableOffset % SaveAlignment != 0 || !fitsWithin(header.sectionTableOffset, header.sectionCount, sizeof(SaveSectionEntry), size))
+			problem = "section table out of bounds";
+	}
+	for (uint32_t s = 0; !problem && s < header.sectionCount; s++) {
+		const SaveSectionEntry& entry = ((const SaveSectionEntry*)(data + header.sectionTableOffset))[s];
+		if (memchr(entry.name, 0, sizeof(entry.name)) == nullptr)
+			problem = "section name not terminated";
+		else if (entry.fieldsOffset % SaveAlignment != 0 || !fitsWithin(entry.fieldsOffset, entry.fieldCount, sizeof(SaveFieldEntry), size))
+			problem = "field table out of bounds";
+		else if (entry.dataOffset % SaveAlignment != 0 || !fitsWithin(entry.dataOffset, entry.recordCount, entry.recordSize, size))
+			problem = "records out of bounds";
+		for (uint32_t f = 0; !problem && f < entry.fieldCount; f++) {
+			const SaveFieldEntry& field = ((const SaveFieldEntry*)(data + entry.fieldsOffset))[f];
+			if (memchr(field.name, 0, sizeof(field.name)) == nullptr)
+				problem = "field name not terminated";
+			else if (field.type > (uint32_t)SaveFieldType::F32)
+				problem = "unknown field type";
+			else if ((uint64_t)field.offset + (uint64_t)field.count * 4 > entry.recordSize)
+				problem = "field outside its record";
+		}
+	}
+	if (problem) {
+		cout << "ERROR::SAVE::MALFORMED\n" << path << ": " << problem << endl;
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool SaveFile::parseText(const char* path)
+{
+	ifstream file(path);
+	string word;
+	uint32_t version = 0;
+	file >> word >> version;
+	if (word != SaveTextMagic || version > FormatVersion) {
+		cout << "ERROR::SAVE::MALFORMED\n" << path << ": bad text header" << endl;
+		return false;
+	}
+
+	// Parse each section's schema and records, then lay them out exactly as a binary save.
+	SaveWriter writer;
+	vector<vector<char>> records;
+	while (file >> word) {
+		SaveSchema schema;
+		uint32_t recordCount = 0, fieldCount = 0;
+		if (word != "section" || !(file >> schema.name >> recordCount >> schema.recordSize >> fieldCount))
+			break;
+		for (uint32_t f = 0; f < fieldCount; f++) {
+			SaveField field;
+			string type;
+			file >> word >> field.name >> type >> field.count >> field.offset;
+			field.type = type == "u32" ? SaveFieldType::U32 : type == "i32" ? SaveFieldType::I32 : SaveFieldType::F32;
+			if (word != "field" || (uint64_t)field.offset + (uint64_t)field.count * 4 > schema.recordSize)
+				file.setstate(ios::failbit);
+			schema.fields.push_back(field);
+		}
+		records.emplace_back((size_t)schema.recordSize * recordCount, 0);
+		char* record = records.back().data();
+		for (uint32_t r = 0; r < recordCount && file; r++, record += schema.recordSize) {
+			file >> word;
+			for (const SaveField& field : schema.fields) {
+				for (uint32_t v = 0; v < field.count; v++) {
+					double value = 0.0;
+					file >> value;
+					writeSaveValue(record + field.offset + v * 4, field.type, value);
+				}
+			}
+		}
+		if (!file)
+			break;
+		writer.addSection(schema, records.back().data(), recordCount);
+	}
+	if (!file.eof()) {
+		cout << "ERROR::SAVE::MALFORMED\n" << path << ": text does not parse" << endl;
+		return false;
+	}
+	writer.buildBinary(ownedData);
+	data = ownedData.data();
+	size = ownedData.size();
+	return true;
+}
+
+uint32_t SaveFile::findSection(const char* name) const
+{
+	if (!data)
+		return UINT32_MAX;
+	const SaveHeader* header = (const SaveHeader*)data;
+	const SaveSectionEntry* entries = (const SaveSectionEntry*)(data + header->sectionTableOffset);
+	for (uint32_t s = 0; s < header->sectionCount; s++) {
+		if (strcmp(entries[s].name, name) == 0)
+			return s;
+	}
+	return UINT32_MAX;
+}
+
+uint32_t SaveFile::getRecordCount(uint32_t section) const
+{
+	const SaveHeader* header = (const SaveHeader*)data;
+	return ((const SaveSectionEntry*)(data + header->sectionTableOffset))[section].recordCount;
+}
+
+// True if the section was stored with exactly this layout, so its records can be used in place.
+static bool layoutMatches(const char* data, const SaveSectionEntry& entry, const SaveSchema& schema)
+{
+	if (entry.recordSize != schema.recordSize || entry.fieldCount != schema.fields.size())
+		return false;
+	const SaveFieldEntry* stored = (const SaveFieldEntry*)(data + entry.fieldsOffset);
+	for (uint32_t f = 0; f < entry.fieldCount; f++) {
+		const SaveField& field = schema.fields[f];
+		if (strcmp(stored[f].name, field.name.c_str()) != 0 || stored[f].type != (uint32_t)field.type || stored[f].count != field.count || stored[f].offset != field.offset)
+			return false;
+	}
+	return true;
+}
+
+const void* SaveFile::getRecords(uint32_t section, const SaveSchema& schema) const
+{
+	const SaveHeader* header = (const SaveHeader*)data;
+	const SaveSectionEntry& entry = ((const SaveSectionEntry*)(data + header->sectionTableOffset))[section];
+	return layoutMatches(data, entry, schema) ? data + entry.dataOffset : nullptr;
+}
+
+uint32_t SaveFile::readRecords(uint32_t section, const SaveSchema& schema, void* records, uint32_t capacity) const
+{
+	const SaveHeader* header = (const SaveHeader*)data;
+	const SaveSectionEntry& entry = ((const SaveSectionEntry*)(data + header->sectionTableOffset))[section];
+	uint32_t count = min(capacity, entry.recordCount);
+	const char* source = data + entry.dataOffset;
+	char* destination = (char*)records;
+	if (layoutMatches(data, entry, schema)) {
+		memcpy(destination, source, (size_t)count * schema.recordSize);
+		return count;
+	}
+
+	// Match the fields by name once, then convert every record.
+	const SaveFieldEntry* stored = (const SaveFieldEntry*)(data + entry.fieldsOffset);
+	vector<const SaveFieldEntry*> matches(schema.fields.size(), nullptr);
+	for (size_t f = 0; f < schema.fields.size(); f++) {
+		for (uint32_t s = 0; s < entry.fieldCount; s++) {
+			if (strcmp(stored[s].name, schema.fields[f].name.c_str()) == 0)
+				matches[f] = &stored[s];
+		}
+	}
+	for (uint32_t r = 0; r < count; r++, source += entry.recordSize, destination += schema.recordSize) {
+		for (size_t f = 0; f < schema.fields.size(); f++) {
+			const SaveField& field = schema.fields[f];
+			const SaveFieldEntry* match = matches[f];
+			if (!match)
+				continue; // Not in this save: keep the caller's default.
+			uint32_t values = min(field.count, match->count);
+			if (match->type == (uint32_t)field.type) {
+				memcpy(destination + field.offset, source + match->offset, values * 4);
+				continue;
+			}
+			for (uint32_t v = 0; v < values; v++)
+				writeSaveValue(destination + field.offset + v * 4, field.type, readSaveValue(source + match->offset + v * 4, (SaveFieldType)match->type));
+		}
+	}
+	return count;
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+// A scene entity as the current version saves it.
+struct SaveEntity
+{
+	uint32_t id, parent;
+	float position[3], rotation[4], scale[3];
+	uint32_t mesh, material;
+	float health;
+	int32_t team;
+};
+#define SAVE_ENTITY_FIELDS(FIELD) FIELD(id) FIELD(parent) FIELD(position) FIELD(rotation) FIELD(scale) FIELD(mesh) FIELD(material) FIELD(health) FIELD(team)
+REFLECT(SaveEntity, SAVE_ENTITY_FIELDS)
+
+// The same entity as an older version saved it, before materials, health and teams. Described by hand, as any
+// struct can be.
+struct SaveEntityV1
+{
+	uint32_t id, parent;
+	float position[3], rotation[4], scale[3];
+	uint32_t mesh;
+};
+
+static SaveSchema entitySchemaV1()
+{
+	SaveSchema schema;
+	schema.name = "entities";
+	schema.recordSize = sizeof(SaveEntityV1);
+	schema.fields = {
+		SAVE_FIELD(SaveEntityV1, id, SaveFieldType::U32, 1),
+		SAVE_FIELD(SaveEntityV1, parent, SaveFieldType::U32, 1),
+		SAVE_FIELD(SaveEntityV1, position, SaveFieldType::F32, 3),
+		SAVE_FIELD(SaveEntityV1, rotation, SaveFieldType::F32, 4),
+		SAVE_FIELD(SaveEntityV1, scale, SaveFieldType::F32, 3),
+		SAVE_FIELD(SaveEntityV1, mesh, SaveFieldType::U32, 1),
+	};
+	return schema;
+}
+
+// Sum a few fields of every entity, so loads are checked and cannot be optimised away.
+static double entityChecksum(const SaveEntity* entities, uint32_t count)
+{
+	double sum = 0.0;
+	for (uint32_t i = 0; i < count; i++)
+		sum += entities[i].id + entities[i].position[0] + entities[i].scale[2] + entities[i].mesh + entities[i].health + entities[i].team;
+	return sum;
+}
+
+void runSaveBenchmark(int entityCount)
+{
+	const char* binaryPath = "save_benchmark.asav";
+	const char* textPath = "save_benchmark.txt";
+	const char* oldPath = "save_benchmark_v1.asav";
+
+	vector<SaveEntity> entities(entityCount);
+	vector<SaveEntityV1> oldEntities(entityCount);
+	for (int i = 0; i < entityCount; i++) {
+		SaveEntity& entity = entities[i];
+		entity.id = (uint32_t)i + 1;
+		entity.parent = (uint32_t)i / 2; // A binary tree of parents; 0 is none.
+		for (int c = 0; c < 3; c++) {
+			entity.position[c] = (float)((i * (c + 3)) % 1000) * 0.37f;
+			entity.scale[c] = 1.0f + (float)(i % 5) * 0.25f;
+		}
+		entity.rotation[0] = entity.rotation[1] = entity.rotation[2] = 0.0f;
+		entity.rotation[3] = 1.0f;
+		entity.mesh = (uint32_t)(i % 64);
+		entity.material = (uint32_t)(i % 16);
+		entity.health = 100.0f - (float)(i % 100);
+		entity.team = i % 3 - 1;
+		memcpy(&oldEntities[i], &entity, offsetof(SaveEntity, mesh)); // The shared prefix.
+		oldEntities[i].mesh = entity.mesh;
+	}
+	double expected = entityChecksum(entities.data(), (uint32_t)entityCount);
+	cout << "BENCH::SAVE " << entityCount << " entities of " << sizeof(SaveEntity) << " bytes" << endl;
+
+	auto fileSize = [](const char* path) { ifstream file(path, ios::binary | ios::ate); return (long long)file.tellg(); };
+	auto report = [](const char* name, double ms, const char* detail) {
+		ios::fmtflags flags = cout.flags();
+		streamsize precision = cout.precision();
+		cout << "BENCH::SAVE::" << name << fixed << setprecision(3) << " " << ms << " ms" << detail << endl;
+		cout.flags(flags);
+		cout.precision(precision);
+	};
+	SaveSchema schema = makeSaveSchema<SaveEntity>("entities");
+
+	// Binary save, then load in place.
+	{
+		BenchmarkTimer timer;
+		SaveWriter writer;
+		writer.addSection(schema, entities.data(), (uint32_t)entityCount);
+		if (!writer.writeBinary(binaryPath))
+			return;
+		report("BINARY_SAVE", timer.elapsedMs(), (", " + to_string(fileSize(binaryPath) / 1024) + " KB").c_str());
+	}
+	{
+		BenchmarkTimer timer;
+		SaveFile save;
+		uint32_t section = save.open(binaryPath) ? save.findSection("entities") : UINT32_MAX;
+		const SaveEntity* loaded = section != UINT32_MAX ? save.getRecords<SaveEntity>(section, schema) : nullptr;
+		bool correct = loaded && entityChecksum(loaded, save.getRecordCount(section)) == expected;
+		report("BINARY_LOAD_IN_PLACE", timer.elapsedMs(), correct ? ", mapped, checksum matches" : ", FAILED");
+	}
+
+	// A save from the older version, converted on load.
+	{
+		SaveWriter writer;
+		writer.addSection(entitySchemaV1(), oldEntities.data(), (uint32_t)entityCount);
+		if (!writer.writeBinary(oldPath))
+			return;
+		BenchmarkTimer timer;
+		SaveFile save;
+		uint32_t section = save.open(oldPath) ? save.findSection("entities") : UINT32_MAX;
+		vector<SaveEntity> converted(entityCount);
+		for (SaveEntity& entity : converted) { // Defaults for the fields the old version lacks.
+			entity.material = 0;
+			entity.health = 100.0f;
+			entity.team = 0;
+		}
+		bool correct = section != UINT32_MAX && save.getRecords(section, schema) == nullptr
+			&& save.readRecords(section, schema, converted.data(), (uint32_t)entityCount) == (uint32_t)entityCount
+			&& converted.back().mesh == entities.back().mesh && converted.back().position[1] == entities.back().position[1];
+		report("BINARY_LOAD_OLD_VERSION", timer.elapsedMs(), correct ? ", converted by field name" : ", FAILED");
+	}
+
+	// Text, for debugging.
+	{
+		BenchmarkTimer timer;
+		SaveWriter writer;
+		writer.addSection(schema, entities.data(), (uint32_t)entityCount);
+		if (!writer.writeText(textPath))
+			return;
+		report("TEXT_SAVE", timer.elapsedMs(), (", " + to_string(fileSize(textPath) / 1024) + " KB").c_str());
+	}
+	{
+		BenchmarkTimer timer;
+		SaveFile save;
+		uint32_t section = save.open(textPath) ? save.findSection("entities") : UINT32_MAX;
+		const SaveEntity* loaded = section != UINT32_MAX ? save.getRecords<SaveEntity>(section, schema) : nullptr;
+		bool correct = loaded && !save.isMapped() && entityChecksum(loaded, save.getRecordCount(section)) == expected;
+		report("TEXT_LOAD", timer.elapsedMs(), correct ? ", parsed, checksum matches" : ", FAILED");
+	}
+
+	remove(binaryPath);
+	remove(oldPath);
+	remove(textPath);
+}
+
+#pragma endregion
@@ -0,0 +1,152 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <cstddef> // Import offsetof.
+#include <cstdint> // Import the fixed width integers.
+#include <string> // Import the string class.
+#include <type_traits> // Import remove_reference.
+#include <vector> // Import the vector container.
+
+#include "Reflection.h" // Import the reflected field lists.
+
+#pragma endregion
+
+enum class SaveFieldType : uint32_t
+{
+	U32,
+	I32,
+	F32
+};
+
+// One field of a record: count values of a type at a byte offset into the record.
+struct SaveField
+{
+	std::string name; // At most SaveFile::MaxNameLength characters.
+	SaveFieldType type;
+	uint32_t count;
+	uint32_t offset;
+};
+
+// Describes the records of a section: a plain struct of fixed-size numeric fields.
+struct SaveSchema
+{
+	std::string name; // The section's name, at most SaveFile::MaxNameLength characters.
+	uint32_t recordSize = 0;
+	std::vector<SaveField> fields;
+};
+
+// Describe a struct member for a SaveSchema: SAVE_FIELD(Entity, position, SaveFieldType::F32, 3).
+#define SAVE_FIELD(Struct, member, type, count) SaveField{ #member, type, count, (uint32_t)offsetof(Struct, member) }
+
+// The SaveFieldType and value count of a field's C++ type, for reflected schemas.
+template <typename V>
+struct SaveFieldTraits;
+
+template <> struct SaveFieldTraits<uint32_t> { static const SaveFieldType Type = SaveFieldType::U32; static const uint32_t Count = 1; };
+template <> struct SaveFieldTraits<int32_t> { static const SaveFieldType Type = SaveFieldType::I32; static const uint32_t Count = 1; };
+template <> struct SaveFieldTraits<float> { static const SaveFieldType Type = SaveFieldType::F32; static const uint32_t Count = 1; };
+
+template <typename V, size_t N>
+struct SaveFieldTraits<V[N]>
+{
+	static const SaveFieldType Type = SaveFieldTraits<V>::Type;
+	static const uint32_t Count = (uint32_t)N * SaveFieldTraits<V>::Count;
+};
+
+// The schema of a reflected struct (see Reflection.h), for a section called name.
+template <typename T>
+SaveSchema makeSaveSchema(const char* name)
+{
+	SaveSchema schema;
+	schema.name = name;
+	schema.recordSize = sizeof(T);
+	Reflection<T>::forEachField([&schema](const char* fieldName, auto member, size_t offset) {
+		typedef typename std::remove_reference<decltype(((T*)nullptr)->*member)>::type Field;
+		schema.fields.push_back(SaveField{ fieldName, SaveFieldTraits<Field>::Type, SaveFieldTraits<Field>::Count, (uint32_t)offset });
+	});
+	return schema;
+}
+
+// Collects sections of records and writes them as a save, binary or text.
+class SaveWriter
+{
+public:
+	// Add a section. records must stay valid until the last write.
+	void addSection(const SaveSchema& schema, const void* records, uint32_t recordCount);
+
+	// Write the binary format. Prints an error and returns false on failure.
+	bool writeBinary(const char* path) const;
+
+	// Write the text format: the same schema and records, one record per line, for reading and diffing.
+	bool writeText(const char* path) const;
+
+private:
+	friend class SaveFile;
+
+	// Lay the sections out in the binary format.
+	void buildBinary(std::vector<char>& image) const;
+
+	struct Section
+	{
+		SaveSchema schema;
+		const void* records;
+		uint32_t recordCount;
+	};
+
+	std::vector<Section> sections;
+};
+
+// A save opened for reading. Binary saves are memory-mapped and read in place: a section whose stored layout matches
+// the caller's schema exactly is returned as a pointer into the mapping, with no parsing or copying at all.
+//
+// The binary layout is a header, a section table and each section's field table and records, all at fixed offsets
+// and 16-byte aligned. Every section stores its own schema, so saves written by older versions still load: when the
+// layouts differ, readRecords() converts field by field, matched by name, leaving fields the save lacks untouched.
+// Text saves are parsed into the same layout on open, so both formats share one read path. Numbers are little endian.
+class SaveFile
+{
+public:
+	static const uint32_t FormatVersion = 1;
+	static const size_t MaxNameLength = 31;
+
+	SaveFile() {}
+	~SaveFile();
+	SaveFile(const SaveFile&) = delete;
+	SaveFile& operator=(const SaveFile&) = delete;
+
+	// Open a binary or text save. Prints an error and returns false if it cannot be read or is malformed.
+	bool open(const char* path);
+	void close();
+
+	// True if the save was mapped in place rather than parsed from text.
+	bool isMapped() const { return mapping != nullptr; }
+
+	// The section's index, or UINT32_MAX if there is none by that name.
+	uint32_t findSection(const char* name) const;
+	uint32_t getRecordCount(uint32_t section) const;
+
+	// The section's records in place, or nullptr if their stored layout differs from schema (use readRecords()).
+	const void* getRecords(uint32_t section, const SaveSchema& schema) const;
+
+	template <typename T>
+	const T* getRecords(uint32_t section, const SaveSchema& schema) const { return (const T*)getRecords(section, schema); }
+
+	// Copy up to capacity records into records, converting from the stored layout field by field. Returns the number
+	// copied.
+	uint32_t readRecords(uint32_t section, const SaveSchema& schema, void* records, uint32_t capacity) const;
+
+private:
+	bool validate(const char* path);
+	bool parseText(const char* path);
+
+	const char* data = nullptr;
+	size_t size = 0;
+	void* mapping = nullptr; // The mapped view, if mapped.
+	intptr_t fileHandle = -1, mappingHandle = -1; // Platform handles behind the mapping.
+	std::vector<char> ownedData; // The binary image built from a text save.
+};
+
+// Save and load a world of entityCount entities in binary (mapped in place, and converted from an older version) and
+// text, and print the times and file sizes.
+void runSaveBenchmark(int entityCount);
@@ -0,0 +1,25 @@
+#pragma once
+
+// The scene's static geometry, shared by the GL renderer and the software rasterizer.
+// Plain C types, so GL-less builds can include it.
+
+// Two overlapping quads: 3 floats (x, y, z) per vertex.
+static const float sceneVertices[] = {
+	0.2f,  0.2f, 0.0f,  // Top Right
+	0.2f, -0.8f, 0.0f,  // Bottom Right
+	-0.8f, -0.8f, 0.0f,  // Bottom Left
+	-0.8f,  0.2f, 0.0f,   // Top Left
+
+	0.8f,  0.8f, 0.0f,  // Top Right
+	0.8f, -0.2f, 0.0f,  // Bottom Right
+	-0.2f, -0.2f, 0.0f,  // Bottom Left
+	-0.2f,  0.8f, 0.0f   // Top Left
+};
+static const unsigned int sceneIndices[] = {  // Set up indice data.
+	0, 1, 3,   // First triangle
+	1, 2, 3,   // Second triangle
+	4, 5, 7,
+	5, 6, 7
+};
+static const unsigned int sceneVertexCount = sizeof(sceneVertices) / (3 * sizeof(float));
+static const unsigned int sceneIndexCount = sizeof(sceneIndices) / sizeof(unsigned int);
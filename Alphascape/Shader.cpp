@@ -0,0 +1,96 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import max.
+#include <iostream> // Import the IO stream libraries.
+#include <string> // Import the string class.
+#include <vector> // Import the vector container.
+
+#include "Shader.h" // Import the shader declarations.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+// Return the name used in error messages for a shader stage.
+static const char* shaderStageName(GLenum type)
+{
+	switch (type)
+	{
+	case GL_VERTEX_SHADER: return "VERTEX";
+	case GL_FRAGMENT_SHADER: return "FRAGMENT";
+	case GL_GEOMETRY_SHADER: return "GEOMETRY";
+	default: return "UNKNOWN";
+	}
+}
+
+GLuint compileShader(GLenum type, const GLchar* source)
+{
+	GLuint shader = glCreateShader(type); // Create the shader.
+	glShaderSource(shader, 1, &source, NULL); // Pass the shader source.
+	glCompileShader(shader); // Compile the shader.
+	// Check for errors at compile time from OpenGL:
+	GLint success; // Declare the success variable.
+	GLchar infoLog[512]; // Declare the information log.
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success); // Get the success of the shader compilation.
+	if (!success) // If the shader compilation was not a success:
+	{
+		glGetShaderInfoLog(shader, 512, NULL, infoLog); // Get the information log.
+		cout << "ERROR::SHADER::" << shaderStageName(type) << "::COMPILATION_FAILED\n" << infoLog << endl; // Print the information log.
+	}
+	return shader;
+}
+
+GLuint compileShaderProgram(const GLchar* vertexSource, const GLchar* fragmentSource)
+{
+	GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource); // The vertex shader.
+	GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource); // The fragment shader.
+
+	// Link the shaders.
+	GLuint program = glCreateProgram(); // Create the shader program.
+	glAttachShader(program, vertexShader); // Attach the vertex shader.
+	glAttachShader(program, fragmentShader); // Attach the fragment shader.
+	glLinkProgram(program); // Link the shader program to the OpenGL context.
+
+	// Check for errors at link time from OpenGL:
+	GLint success; // Declare the success variable.
+	GLchar infoLog[512]; // Declare the information log.
+	glGetProgramiv(program, GL_LINK_STATUS, &success); // Get the success of the shader linking.
+	if (!success) { // If the shader linking was not a success:
+		glGetProgramInfoLog(program, 512, NULL, infoLog); // Get the information log.
+		cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << endl; // Print the information log.
+	}
+
+	// Delete the shaders to avoid a memory leak.
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+	return program;
+}
+
+UniformLocations::UniformLocations(GLuint program)
+{
+	if (!program)
+		return;
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	vector<GLchar> name(max(maxLength, 1));
+	for (GLint i = 0; i < count; i++) {
+		GLsizei length = 0;
+		GLint size;
+		GLenum type;
+		glGetActiveUniform(program, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, name.data());
+		GLint location = glGetUniformLocation(program, name.data());
+		if (location < 0)
+			continue; // In a uniform block.
+		string uniformName(name.data(), length);
+		if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+			uniformName.resize(uniformName.size() - 3); // Arrays are named by their first element.
+		locations[UniformId::fromString(uniformName)] = location;
+	}
+}
+
+GLint UniformLocations::get(UniformId id) const
+{
+	auto found = locations.find(id);
+	return found == locations.end() ? -1 : found->second;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <unordered_map> // Import the hash map.
+
+#include "Graphics.h" // Import GLEW and GLFW.
+#include "StringId.h" // Import the hashed names.
+
+// Compile a vertex and fragment shader pair and link them into a program.
+// Errors are printed in the same ERROR::SHADER::* format as the rest of the engine; the program is returned regardless,
+// so callers behave exactly as they did when this code lived inline in main().
+GLuint compileShaderProgram(const GLchar* vertexSource, const GLchar* fragmentSource);
+
+// Compile a single shader stage. Returns the shader object, printing the information log on failure.
+GLuint compileShader(GLenum type, const GLchar* source);
+
+// A linked program's uniform locations by hashed name, read once from its active uniforms, so callers look them up
+// with a UniformId hashed at compile time instead of passing strings to glGetUniformLocation.
+class UniformLocations
+{
+public:
+	UniformLocations() {}
+	explicit UniformLocations(GLuint program);
+
+	// The uniform's location, or -1 if the program has no such active uniform, as glGetUniformLocation.
+	GLint get(UniformId id) const;
+
+private:
+	std::unordered_map<UniformId, GLint> locations;
+};
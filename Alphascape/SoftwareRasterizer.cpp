@@ -0,0 +1,489 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import min/max.
+#include <cmath> // Import the C maths libraries.
+#include <cstdio> // Import the C file functions.
+#include <iostream> // Import the IO stream libraries.
+#include <random> // Import the random number generators.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTWARE_RASTERIZER_SSE2
+#include <emmintrin.h> // Import the SSE2 intrinsics.
+#endif
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "SceneGeometry.h" // Import the scene geometry.
+#include "SoftwareRasterizer.h" // Import the software rasterizer.
+#include "Threading.h" // Import the thread placement.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Helpers
+
+// Pack a [0, 1] colour into RGBA8 (R in the lowest byte).
+static inline uint32_t packColor(const float color[4])
+{
+	uint32_t packed = 0;
+	for (int channel = 0; channel < 4; channel++) {
+		float clamped = min(max(color[channel], 0.0f), 1.0f);
+		packed |= (uint32_t)(clamped * 255.0f + 0.5f) << (channel * 8);
+	}
+	return packed;
+}
+
+// Evaluate the plane a * x + b * y + c.
+static inline float evaluatePlane(const float plane[3], float x, float y)
+{
+	return plane[0] * x + plane[1] * y + plane[2];
+}
+
+#pragma endregion
+
+#pragma region Set Up
+
+SoftwareRasterizer::SoftwareRasterizer(int newWidth, int newHeight, unsigned int threadCount)
+	: width(newWidth), height(newHeight)
+{
+	tilesX = (width + TileSize - 1) / TileSize;
+	tilesY = (height + TileSize - 1) / TileSize;
+	pitch = tilesX * TileSize;
+	paddedHeight = tilesY * TileSize;
+	colorBuffer.assign((size_t)pitch * paddedHeight, 0);
+	depthBuffer.assign((size_t)pitch * paddedHeight, 1.0f);
+	bins.resize((size_t)tilesX * tilesY);
+
+	if (threadCount == 0)
+		threadCount = getDefaultWorkerCount();
+	for (unsigned int i = 1; i < threadCount; i++) { // The flushing thread is worker 0.
+		workers.emplace_back([this, i] {
+			placeCurrentThread(ThreadRole::Worker, i);
+			workerLoop();
+		});
+	}
+}
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+	{
+		lock_guard<mutex> lock(poolMutex);
+		shuttingDown = true;
+	}
+	poolCondition.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void SoftwareRasterizer::clear(const float color[4], float depth)
+{
+	// Anything binned before a clear would be overwritten, so drop it.
+	triangles.clear();
+	for (vector<uint32_t>& bin : bins)
+		bin.clear();
+	clearPending = true;
+	clearColor = packColor(color);
+	clearDepth = depth;
+}
+
+#pragma endregion
+
+#pragma region Vertex Stage and Binning
+
+void SoftwareRasterizer::drawIndexed(const SoftwareDrawCall& draw)
+{
+	// Run the vertex stage once per vertex, as a post-transform cache would.
+	transformed.resize(draw.vertexCount);
+	for (unsigned int i = 0; i < draw.vertexCount; i++)
+		draw.vertexStage(draw.vertices + (size_t)i * draw.vertexStride, draw.uniforms, transformed[i]);
+
+	for (unsigned int i = 0; i + 2 < draw.indexCount; i += 3) {
+		unsigned int i0 = draw.indices[i], i1 = draw.indices[i + 1], i2 = draw.indices[i + 2];
+		if (i0 >= draw.vertexCount || i1 >= draw.vertexCount || i2 >= draw.vertexCount)
+			continue; // Out of range indices are skipped rather than read past the buffer.
+		setupTriangle(transformed[i0], transformed[i1], transformed[i2], draw);
+	}
+}
+
+void SoftwareRasterizer::setupTriangle(const SoftwareVertex& v0, const SoftwareVertex& v1, const SoftwareVertex& v2, const SoftwareDrawCall& draw)
+{
+	const SoftwareVertex* vertices[3] = { &v0, &v1, &v2 };
+	float x[3], y[3], z[3], inverseW[3];
+	for (int i = 0; i < 3; i++) {
+		const float* position = vertices[i]->position;
+		if (position[3] <= 0.0f)
+			return; // Behind the eye: no clipping, so reject.
+		inverseW[i] = 1.0f / position[3];
+		// Perspective divide and viewport transform; y points down in the colour buffer.
+		x[i] = (position[0] * inverseW[i] * 0.5f + 0.5f) * width;
+		y[i] = (0.5f - position[1] * inverseW[i] * 0.5f) * height;
+		z[i] = position[2] * inverseW[i] * 0.5f + 0.5f;
+	}
+
+	Triangle triangle;
+	// Edge i is opposite vertex i: E_i(p) = A_i * p.x + B_i * p.y + C_i.
+	for (int i = 0; i < 3; i++) {
+		int a = (i + 1) % 3, b = (i + 2) % 3;
+		triangle.edgeA[i] = y[a] - y[b];
+		triangle.edgeB[i] = x[b] - x[a];
+		triangle.edgeC[i] = x[a] * y[b] - y[a] * x[b];
+	}
+	float area = triangle.edgeA[0] * x[0] + triangle.edgeB[0] * y[0] + triangle.edgeC[0];
+	if (fabs(area) < 1e-8f)
+		return; // Degenerate.
+	if (area < 0.0f) { // No culling: flip clockwise triangles so inside is always positive.
+		for (int i = 0; i < 3; i++) {
+			triangle.edgeA[i] = -triangle.edgeA[i];
+			triangle.edgeB[i] = -triangle.edgeB[i];
+			triangle.edgeC[i] = -triangle.edgeC[i];
+		}
+		area = -area;
+	}
+
+	// Interpolation planes: value(p) = sum_i E_i(p) / area * value_i.
+	float inverseArea = 1.0f / area;
+	auto makePlane = [&](const float values[3], float plane[3]) {
+		for (int k = 0; k < 3; k++)
+			plane[k] = 0.0f;
+		for (int i = 0; i < 3; i++) {
+			plane[0] += triangle.edgeA[i] * values[i] * inverseArea;
+			plane[1] += triangle.edgeB[i] * values[i] * inverseArea;
+			plane[2] += triangle.edgeC[i] * values[i] * inverseArea;
+		}
+	};
+	makePlane(z, triangle.depthPlane);
+	makePlane(inverseW, triangle.inverseWPlane);
+	triangle.varyingCount = min(draw.varyingCount, (unsigned int)SoftwareMaxVaryings);
+	for (unsigned int v = 0; v < triangle.varyingCount; v++) {
+		float values[3];
+		for (int i = 0; i < 3; i++)
+			values[i] = vertices[i]->varyings[v] * inverseW[i];
+		makePlane(values, triangle.varyingPlanes[v]);
+	}
+
+	// Pixel bounding box, clamped to the framebuffer.
+	triangle.minX = max(0, (int)floor(min(x[0], min(x[1], x[2]))));
+	triangle.minY = max(0, (int)floor(min(y[0], min(y[1], y[2]))));
+	triangle.maxX = min(width - 1, (int)ceil(max(x[0], max(x[1], x[2]))));
+	triangle.maxY = min(height - 1, (int)ceil(max(y[0], max(y[1], y[2]))));
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+		return; // Off screen.
+
+	triangle.fragmentStage = draw.fragmentStage;
+	triangle.uniforms = draw.uniforms;
+	triangle.depthTest = draw.depthTest;
+	triangle.depthWrite = draw.depthWrite;
+
+	// Bin into every tile the bounding box touches.
+	uint32_t index = (uint32_t)triangles.size();
+	triangles.push_back(triangle);
+	for (int tileY = triangle.minY / TileSize; tileY <= triangle.maxY / TileSize; tileY++)
+		for (int tileX = triangle.minX / TileSize; tileX <= triangle.maxX / TileSize; tileX++)
+			bins[(size_t)tileY * tilesX + tileX].push_back(index);
+}
+
+#pragma endregion
+
+#pragma region Tile Rasterization
+
+void SoftwareRasterizer::rasterizeTile(int tile)
+{
+	int tileMinX = (tile % tilesX) * TileSize;
+	int tileMinY = (tile / tilesX) * TileSize;
+
+	if (clearPending) { // Clear in the tile pass, so the clear is parallel and cache warm.
+		for (int y = tileMinY; y < tileMinY + TileSize; y++) {
+			fill_n(colorBuffer.begin() + (size_t)y * pitch + tileMinX, TileSize, clearColor);
+			fill_n(depthBuffer.begin() + (size_t)y * pitch + tileMinX, TileSize, clearDepth);
+		}
+	}
+
+	for (uint32_t index : bins[tile])
+		rasterizeTriangle(triangles[index], tileMinX, tileMinY, tileMinX + TileSize - 1, tileMinY + TileSize - 1);
+}
+
+void SoftwareRasterizer::rasterizeTriangle(const Triangle& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY)
+{
+	// The part of the bounding box inside this tile, with x aligned down to a group of four pixels.
+	int minX = max(triangle.minX, tileMinX) & ~3;
+	int minY = max(triangle.minY, tileMinY);
+	int maxX = min(triangle.maxX, tileMaxX);
+	int maxY = min(triangle.maxY, tileMaxY);
+
+	float varyings[SoftwareMaxVaryings];
+	float color[4];
+
+	// Shade one covered pixel that passed the depth test.
+	auto shade = [&](int x, int y, float depth) {
+		float px = x + 0.5f, py = y + 0.5f;
+		float w = 1.0f / evaluatePlane(triangle.inverseWPlane, px, py);
+		for (unsigned int v = 0; v < triangle.varyingCount; v++)
+			varyings[v] = evaluatePlane(triangle.varyingPlanes[v], px, py) * w;
+		triangle.fragmentStage(varyings, triangle.uniforms, color);
+		size_t offset = (size_t)y * pitch + x;
+		colorBuffer[offset] = packColor(color);
+		if (triangle.depthWrite)
+			depthBuffer[offset] = depth;
+	};
+
+#ifdef SOFTWARE_RASTERIZER_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f); // Pixel centres of the four lanes.
+	const __m128 four = _mm_set1_ps(4.0f);
+	__m128 edgeA[3], edgeStep[3];
+	for (int i = 0; i < 3; i++) {
+		edgeA[i] = _mm_set1_ps(triangle.edgeA[i]);
+		edgeStep[i] = _mm_mul_ps(edgeA[i], four);
+	}
+	const __m128 depthA = _mm_set1_ps(triangle.depthPlane[0]);
+	const __m128 depthStep = _mm_mul_ps(depthA, four);
+
+	for (int y = minY; y <= maxY; y++) {
+		float py = y + 0.5f;
+		__m128 px = _mm_add_ps(_mm_set1_ps((float)minX), laneOffsets);
+		__m128 edge[3];
+		for (int i = 0; i < 3; i++)
+			edge[i] = _mm_add_ps(_mm_mul_ps(edgeA[i], px), _mm_set1_ps(triangle.edgeB[i] * py + triangle.edgeC[i]));
+		__m128 depth = _mm_add_ps(_mm_mul_ps(depthA, px), _mm_set1_ps(triangle.depthPlane[1] * py + triangle.depthPlane[2]));
+		float* depthRow = depthBuffer.data() + (size_t)y * pitch;
+
+		for (int x = minX; x <= maxX; x += 4) {
+			__m128 inside = _mm_and_ps(_mm_cmpge_ps(edge[0], zero), _mm_and_ps(_mm_cmpge_ps(edge[1], zero), _mm_cmpge_ps(edge[2], zero)));
+			if (triangle.depthTest)
+				inside = _mm_and_ps(inside, _mm_cmplt_ps(depth, _mm_loadu_ps(depthRow + x)));
+			int mask = _mm_movemask_ps(inside);
+			if (mask) {
+				float depths[4];
+				_mm_storeu_ps(depths, depth);
+				for (int lane = 0; lane < 4; lane++) {
+					if ((mask & (1 << lane)) && x + lane <= maxX)
+						shade(x + lane, y, depths[lane]);
+				}
+			}
+			for (int i = 0; i < 3; i++)
+				edge[i] = _mm_add_ps(edge[i], edgeStep[i]);
+			depth = _mm_add_ps(depth, depthStep);
+		}
+	}
+#else
+	for (int y = minY; y <= maxY; y++) {
+		float py = y + 0.5f;
+		for (int x = minX; x <= maxX; x++) {
+			float px = x + 0.5f;
+			if (triangle.edgeA[0] * px + triangle.edgeB[0] * py + triangle.edgeC[0] < 0.0f ||
+				triangle.edgeA[1] * px + triangle.edgeB[1] * py + triangle.edgeC[1] < 0.0f ||
+				triangle.edgeA[2] * px + triangle.edgeB[2] * py + triangle.edgeC[2] < 0.0f)
+				continue;
+			float depth = evaluatePlane(triangle.depthPlane, px, py);
+			if (triangle.depthTest && !(depth < depthBuffer[(size_t)y * pitch + x]))
+				continue;
+			shade(x, y, depth);
+		}
+	}
+#endif
+}
+
+#pragma endregion
+
+#pragma region Worker Pool
+
+void SoftwareRasterizer::runTiles()
+{
+	int tileCount = tilesX * tilesY;
+	for (int tile = nextTile.fetch_add(1); tile < tileCount; tile = nextTile.fetch_add(1))
+		rasterizeTile(tile);
+}
+
+void SoftwareRasterizer::workerLoop()
+{
+	unsigned long long seenGeneration = 0;
+	for (;;) {
+		{
+			unique_lock<mutex> lock(poolMutex);
+			poolCondition.wait(lock, [&] { return shuttingDown || generation != seenGeneration; });
+			if (shuttingDown)
+				return;
+			seenGeneration = generation;
+		}
+		runTiles();
+		{
+			lock_guard<mutex> lock(poolMutex);
+			busyWorkers--;
+		}
+		poolCondition.notify_all();
+	}
+}
+
+void SoftwareRasterizer::flush()
+{
+	nextTile.store(0);
+	{
+		lock_guard<mutex> lock(poolMutex);
+		busyWorkers = (unsigned int)workers.size();
+		generation++;
+	}
+	poolCondition.notify_all();
+	runTiles(); // The calling thread works too.
+	{
+		unique_lock<mutex> lock(poolMutex);
+		poolCondition.wait(lock, [this] { return busyWorkers == 0; });
+	}
+
+	clearPending = false;
+	triangles.clear();
+	for (vector<uint32_t>& bin : bins)
+		bin.clear();
+}
+
+#pragma endregion
+
+#pragma region Output
+
+bool SoftwareRasterizer::writePPM(const string& path) const
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file) {
+		cout << "ERROR::SOFTWARE_RASTERIZER::CANNOT_WRITE\n" << path << endl;
+		return false;
+	}
+	fprintf(file, "P6\n%d %d\n255\n", width, height);
+	vector<unsigned char> row((size_t)width * 3);
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			uint32_t pixel = colorBuffer[(size_t)y * pitch + x];
+			row[x * 3 + 0] = pixel & 0xFF;
+			row[x * 3 + 1] = (pixel >> 8) & 0xFF;
+			row[x * 3 + 2] = (pixel >> 16) & 0xFF;
+		}
+		fwrite(row.data(), 1, row.size(), file);
+	}
+	fclose(file);
+	return true;
+}
+
+#pragma endregion
+
+#pragma region Scenes and Benchmarks
+
+// The software equivalents of the scene shaders in Renderer.cpp.
+struct SceneUniforms
+{
+	float ourColor[4];
+};
+
+static void sceneVertexStage(const float* attributes, const void*, SoftwareVertex& out)
+{
+	out.position[0] = attributes[0]; // gl_Position = vec4(position, 1.0);
+	out.position[1] = attributes[1];
+	out.position[2] = attributes[2];
+	out.position[3] = 1.0f;
+}
+
+static void sceneFragmentStage(const float*, const void* uniforms, float outColor[4])
+{
+	const SceneUniforms* scene = (const SceneUniforms*)uniforms; // color = ourColor;
+	for (int channel = 0; channel < 4; channel++)
+		outColor[channel] = scene->ourColor[channel];
+}
+
+// A vertex colour shader for the benchmark: x, y, z, r, g, b per vertex.
+static void colorVertexStage(const float* attributes, const void*, SoftwareVertex& out)
+{
+	out.position[0] = attributes[0];
+	out.position[1] = attributes[1];
+	out.position[2] = attributes[2];
+	out.position[3] = 1.0f;
+	out.varyings[0] = attributes[3];
+	out.varyings[1] = attributes[4];
+	out.varyings[2] = attributes[5];
+}
+
+static void colorFragmentStage(const float* varyings, const void*, float outColor[4])
+{
+	outColor[0] = varyings[0];
+	outColor[1] = varyings[1];
+	outColor[2] = varyings[2];
+	outColor[3] = 1.0f;
+}
+
+void runSoftwareScene(int width, int height, int frames, const char* outputPath)
+{
+	SoftwareRasterizer rasterizer(width, height);
+	const float clearColor[4] = { 0.529f, 0.808f, 0.980f, 1.0f };
+	SceneUniforms uniforms;
+
+	vector<double> samples;
+	for (int frame = 0; frame < frames; frame++) {
+		BenchmarkTimer timer;
+		float greenValue = (float)(sin(frame / 60.0) / 2.0f) + 0.5f; // The same animation as the GL path at 60 fps.
+		for (int channel = 0; channel < 3; channel++)
+			uniforms.ourColor[channel] = greenValue;
+		uniforms.ourColor[3] = 1.0f;
+
+		SoftwareDrawCall draw;
+		draw.vertices = sceneVertices;
+		draw.vertexCount = sceneVertexCount;
+		draw.indices = sceneIndices;
+		draw.indexCount = sceneIndexCount;
+		draw.vertexStage = sceneVertexStage;
+		draw.fragmentStage = sceneFragmentStage;
+		draw.uniforms = &uniforms;
+
+		rasterizer.clear(clearColor);
+		rasterizer.drawIndexed(draw);
+		rasterizer.flush();
+		samples.push_back(timer.elapsedMs());
+	}
+	cout << "BENCH::SOFTWARE_SCENE " << width << "x" << height << ", " << rasterizer.getThreadCount() << " threads" << endl;
+	printBenchmarkStats("SOFTWARE_SCENE::FRAME", computeBenchmarkStats(samples));
+	if (outputPath)
+		rasterizer.writePPM(outputPath);
+}
+
+void runSoftwareRasterizerBenchmark(int width, int height, int triangleCount, int frames)
+{
+	// Random overlapping triangles at random depths, coloured per vertex.
+	mt19937 random(1234); // Fixed seed, so runs are comparable.
+	uniform_real_distribution<float> position(-1.0f, 1.0f), offset(-0.2f, 0.2f), unit(0.0f, 1.0f);
+	vector<float> vertices;
+	vector<unsigned int> indices;
+	for (int i = 0; i < triangleCount; i++) {
+		float centreX = position(random), centreY = position(random), depth = position(random);
+		for (int corner = 0; corner < 3; corner++) {
+			float attributes[] = { centreX + offset(random), centreY + offset(random), depth, unit(random), unit(random), unit(random) };
+			vertices.insert(vertices.end(), attributes, attributes + 6);
+			indices.push_back((unsigned int)indices.size());
+		}
+	}
+
+	SoftwareDrawCall draw;
+	draw.vertices = vertices.data();
+	draw.vertexStride = 6;
+	draw.vertexCount = (unsigned int)(vertices.size() / 6);
+	draw.indices = indices.data();
+	draw.indexCount = (unsigned int)indices.size();
+	draw.vertexStage = colorVertexStage;
+	draw.fragmentStage = colorFragmentStage;
+	draw.varyingCount = 3;
+
+	const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	unsigned int threadCounts[] = { 1, max(1u, std::thread::hardware_concurrency()) };
+	for (unsigned int threads : threadCounts) {
+		SoftwareRasterizer rasterizer(width, height, threads);
+		vector<double> binSamples, rasterSamples;
+		for (int frame = 0; frame < frames; frame++) {
+			BenchmarkTimer timer;
+			rasterizer.clear(clearColor);
+			rasterizer.drawIndexed(draw);
+			binSamples.push_back(timer.elapsedMs());
+			timer.reset();
+			rasterizer.flush();
+			rasterSamples.push_back(timer.elapsedMs());
+		}
+		cout << "BENCH::SOFTWARE_RASTERIZER " << triangleCount << " triangles, " << width << "x" << height << ", " << threads << " threads" << endl;
+		printBenchmarkStats("SOFTWARE_RASTERIZER::VERTEX_AND_BIN", computeBenchmarkStats(binSamples));
+		printBenchmarkStats("SOFTWARE_RASTERIZER::RASTERIZE", computeBenchmarkStats(rasterSamples));
+	}
+}
+
+#pragma endregion
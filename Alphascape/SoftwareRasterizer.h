@@ -0,0 +1,143 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <atomic> // Import the atomics.
+#include <condition_variable> // Import the condition variable.
+#include <cstdint> // Import the fixed width integers.
+#include <mutex> // Import the mutex.
+#include <string> // Import the string class.
+#include <thread> // Import the threads.
+#include <vector> // Import the vector container.
+
+#include "MemoryProfiler.h" // Import the memory heaps.
+
+#pragma endregion
+
+DECLARE_MEMORY_HEAP(SoftwareRasterizerMemory, "SoftwareRasterizer", 128 << 20)
+
+// A CPU rasterizer for machines without any GL implementation. It mirrors the engine's GL draw path:
+// indexed triangle lists, a vertex stage producing clip space positions plus varyings, a fragment stage
+// producing a colour, and a less-than depth test. It deliberately includes no GL headers.
+//
+// drawIndexed() runs the vertex stage immediately and bins each triangle into the 64x64 tiles its bounding box
+// touches. flush() then rasterizes every tile on a worker pool: each tile is owned by one thread, so tiles need
+// no locking, and triangles within a tile keep their submission order. Inside a tile the edge functions, depth
+// and coverage are evaluated four pixels at a time with SSE2 (scalar fallback elsewhere).
+//
+// Limitations: triangles with any vertex behind the eye (w <= 0) are rejected rather than clipped, and no
+// top-left fill rule is applied, so pixels exactly on a shared edge are shaded twice.
+
+static const int SoftwareMaxVaryings = 4;
+
+// Output of the vertex stage.
+struct SoftwareVertex
+{
+	float position[4]; // Clip space x, y, z, w.
+	float varyings[SoftwareMaxVaryings]; // Interpolated with perspective correction.
+};
+
+// Vertex stage: read one vertex's attributes and write its clip space position and varyings.
+typedef void (*SoftwareVertexStage)(const float* attributes, const void* uniforms, SoftwareVertex& out);
+
+// Fragment stage: turn interpolated varyings into an RGBA colour in [0, 1].
+typedef void (*SoftwareFragmentStage)(const float* varyings, const void* uniforms, float outColor[4]);
+
+// One indexed draw, the software equivalent of glDrawElements(GL_TRIANGLES, ...).
+struct SoftwareDrawCall
+{
+	const float* vertices = nullptr; // Attribute data.
+	unsigned int vertexStride = 3; // Floats per vertex.
+	unsigned int vertexCount = 0;
+	const unsigned int* indices = nullptr;
+	unsigned int indexCount = 0;
+	SoftwareVertexStage vertexStage = nullptr;
+	SoftwareFragmentStage fragmentStage = nullptr;
+	const void* uniforms = nullptr; // Must stay valid until flush() returns.
+	unsigned int varyingCount = 0;
+	bool depthTest = true;
+	bool depthWrite = true;
+};
+
+class SoftwareRasterizer
+{
+public:
+	static const int TileSize = 64;
+
+	// threadCount 0 uses getDefaultWorkerCount().
+	SoftwareRasterizer(int width, int height, unsigned int threadCount = 0);
+	~SoftwareRasterizer();
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	unsigned int getThreadCount() const { return (unsigned int)workers.size() + 1; }
+
+	// Clear colour and depth (depth in [0, 1]). The clear is performed per tile at the next flush.
+	void clear(const float color[4], float depth = 1.0f);
+
+	// Transform and bin the triangles of a draw call.
+	void drawIndexed(const SoftwareDrawCall& draw);
+
+	// Rasterize everything binned since the last flush. Blocks until all tiles are done.
+	void flush();
+
+	// Triangles binned since the last flush, after rejection.
+	size_t binnedTriangles() const { return triangles.size(); }
+
+	// The colour buffer as RGBA8, row 0 at the top. Rows are getPitch() pixels apart.
+	const uint32_t* getColorBuffer() const { return colorBuffer.data(); }
+	int getPitch() const { return pitch; }
+
+	// Write the colour buffer as a binary PPM. Returns false if the file could not be written.
+	bool writePPM(const std::string& path) const;
+
+private:
+	// A binned triangle: edge functions and interpolation planes in screen space.
+	struct Triangle
+	{
+		float edgeA[3], edgeB[3], edgeC[3]; // Edge i is opposite vertex i; inside when all are >= 0.
+		float depthPlane[3]; // Depth in [0, 1] as a * x + b * y + c.
+		float inverseWPlane[3]; // 1 / w as a plane, for perspective correction.
+		float varyingPlanes[SoftwareMaxVaryings][3]; // Varying / w as planes.
+		int minX, minY, maxX, maxY; // Pixel bounding box, clamped to the framebuffer.
+		unsigned int varyingCount;
+		SoftwareFragmentStage fragmentStage;
+		const void* uniforms;
+		bool depthTest, depthWrite;
+	};
+
+	void setupTriangle(const SoftwareVertex& v0, const SoftwareVertex& v1, const SoftwareVertex& v2, const SoftwareDrawCall& draw);
+	void rasterizeTile(int tile);
+	void rasterizeTriangle(const Triangle& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY);
+	void runTiles();
+	void workerLoop();
+
+	int width, height;
+	int pitch, paddedHeight; // Buffers are padded to whole tiles so SIMD loops never need a remainder.
+	int tilesX, tilesY;
+	HeapVector<uint32_t, SoftwareRasterizerMemory> colorBuffer;
+	HeapVector<float, SoftwareRasterizerMemory> depthBuffer;
+	HeapVector<SoftwareVertex, SoftwareRasterizerMemory> transformed; // Scratch for the vertex stage.
+	HeapVector<Triangle, SoftwareRasterizerMemory> triangles;
+	std::vector<std::vector<uint32_t>> bins; // Triangle indices per tile, in submission order.
+
+	bool clearPending = false;
+	uint32_t clearColor = 0;
+	float clearDepth = 1.0f;
+
+	// Worker pool.
+	std::vector<std::thread> workers;
+	std::mutex poolMutex;
+	std::condition_variable poolCondition;
+	unsigned long long generation = 0; // Bumped for every flush.
+	unsigned int busyWorkers = 0;
+	bool shuttingDown = false;
+	std::atomic<int> nextTile{ 0 };
+};
+
+// Render the engine's scene on the CPU for the given number of frames, print the timings and write
+// the last frame to outputPath. Uses no GL or GLFW calls at all.
+void runSoftwareScene(int width, int height, int frames, const char* outputPath);
+
+// Render triangleCount random overlapping triangles with one thread and with all threads, and print the timings.
+void runSoftwareRasterizerBenchmark(int width, int height, int triangleCount, int frames);
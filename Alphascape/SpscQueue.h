@@ -0,0 +1,51 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <atomic> // Import the atomics.
+#include <cstddef> // Import size_t.
+
+#pragma endregion
+
+// A bounded, lock-free, single-producer single-consumer ring buffer.
+// Exactly one thread may call tryPush and exactly one (other) thread may call tryPop.
+// The producer owns tail and the consumer owns head; each only reads the other's index,
+// and the two indices live on separate cache lines so the threads never share a written line.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two.");
+
+public:
+	// Copy item into the queue. Returns false if the queue is full. Producer thread only.
+	bool tryPush(const T& item)
+	{
+		size_t currentTail = tail.load(std::memory_order_relaxed);
+		if (currentTail - head.load(std::memory_order_acquire) == Capacity)
+			return false; // Full.
+		slots[currentTail & (Capacity - 1)] = item;
+		tail.store(currentTail + 1, std::memory_order_release); // Publish the slot.
+		return true;
+	}
+
+	// Move the oldest item into item. Returns false if the queue is empty. Consumer thread only.
+	bool tryPop(T& item)
+	{
+		size_t currentHead = head.load(std::memory_order_relaxed);
+		if (currentHead == tail.load(std::memory_order_acquire))
+			return false; // Empty.
+		item = slots[currentHead & (Capacity - 1)];
+		head.store(currentHead + 1, std::memory_order_release); // Hand the slot back.
+		return true;
+	}
+
+	// Approximate number of queued items; exact only when called from one side with the other idle.
+	size_t size() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); }
+	bool empty() const { return size() == 0; }
+	bool full() const { return size() == Capacity; }
+
+private:
+	alignas(64) std::atomic<size_t> head{ 0 }; // Next slot to read, written by the consumer.
+	alignas(64) std::atomic<size_t> tail{ 0 }; // Next slot to write, written by the producer.
+	alignas(64) T slots[Capacity];
+};
@@ -0,0 +1,119 @@
+#pragma region Library Imports
+
+#include <iostream> // Import the IO stream libraries.
+#include <map> // Import the ordered map.
+#include <vector> // Import the vector container.
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "StringId.h" // Import the string IDs.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Hashing
+
+uint64_t hashNameAtRuntime(const char* text, size_t length)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < length; i++)
+		hash = (hash ^ (uint8_t)text[i]) * 1099511628211ull;
+	return hash;
+}
+
+// The compile-time and runtime hashes must agree, or literal IDs would never match interned ones.
+static_assert(hashName("", 0) == 14695981039346656037ull, "FNV-1a offset basis");
+static_assert(StringId("a").getValue() == 0xaf63dc4c8601ec8cull, "FNV-1a of \"a\"");
+
+#pragma endregion
+
+#pragma region StringTable
+
+StringTable& StringTable::instance()
+{
+	static StringTable table;
+	return table;
+}
+
+uint64_t StringTable::intern(const char* text, size_t length)
+{
+	uint64_t hash = hashNameAtRuntime(text, length);
+	lock_guard<std::mutex> lock(namesMutex);
+	auto found = strings.find(hash);
+	if (found == strings.end())
+		strings.emplace(hash, string(text, length));
+	else if (found->second.compare(0, string::npos, text, length) != 0)
+		cout << "ERROR::STRING_TABLE::HASH_COLLISION\n" << found->second << " and " << string(text, length) << endl;
+	return hash;
+}
+
+const char* StringTable::lookup(uint64_t hash) const
+{
+	lock_guard<std::mutex> lock(namesMutex);
+	auto found = strings.find(hash);
+	return found == strings.end() ? nullptr : found->second.c_str(); // Stable: entries are never removed.
+}
+
+size_t StringTable::getCount() const
+{
+	lock_guard<std::mutex> lock(namesMutex);
+	return strings.size();
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+void runStringIdBenchmark(int nameCount, int lookups)
+{
+	const int rounds = 10;
+	vector<string> names;
+	map<string, int> byName;
+	unordered_map<string, int> byHashedName;
+	unordered_map<AssetId, int> byId;
+	for (int i = 0; i < nameCount; i++) {
+		names.push_back("textures/environment/terrain_" + to_string(i) + ".png");
+		byName[names.back()] = i;
+		byHashedName[names.back()] = i;
+		byId[AssetId::fromString(names.back())] = i;
+	}
+
+	// The requests a frame makes: strings for the string maps, and the same names as IDs, hashed once up front the
+	// way a literal or a loaded asset reference would be.
+	vector<const string*> requestNames(lookups);
+	vector<AssetId> requestIds(lookups);
+	long long expected = 0;
+	for (int i = 0; i < lookups; i++) {
+		int name = (int)(((uint64_t)i * 2654435761u) % nameCount);
+		requestNames[i] = &names[name];
+		requestIds[i] = AssetId(hashNameAtRuntime(names[name].data(), names[name].size()));
+		expected += name;
+	}
+
+	constexpr AssetId literalId("textures/environment/terrain_7.png");
+	cout << "BENCH::STRING_ID " << nameCount << " asset names, " << lookups << " lookups, " << StringTable::instance().getCount()
+		<< " interned; " << literalId.getDebugName() << " found by a compile-time ID: " << (byId.count(literalId) ? "yes" : "no") << endl;
+
+	for (int mode = 0; mode < 3; mode++) {
+		vector<double> samples;
+		long long checksum = 0;
+		for (int round = 0; round < rounds; round++) {
+			BenchmarkTimer timer;
+			for (int i = 0; i < lookups; i++) {
+				if (mode == 0)
+					checksum += byName.find(*requestNames[i])->second;
+				else if (mode == 1)
+					checksum += byHashedName.find(*requestNames[i])->second;
+				else
+					checksum += byId.find(requestIds[i])->second;
+			}
+			samples.push_back(timer.elapsedMs());
+		}
+		const char* label = mode == 0 ? "STRING_ID::STRING_MAP" : mode == 1 ? "STRING_ID::STRING_HASH_MAP" : "STRING_ID::ID_HASH_MAP";
+		printBenchmarkStats(label, computeBenchmarkStats(samples));
+		if (checksum != expected * rounds)
+			cout << "ERROR::STRING_ID::LOOKUP_MISMATCH" << endl;
+	}
+}
+
+#pragma endregion
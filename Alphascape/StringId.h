@@ -0,0 +1,102 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <cstddef> // Import size_t.
+#include <cstdint> // Import the fixed width integers.
+#include <functional> // Import hash.
+#include <mutex> // Import the mutex.
+#include <string> // Import the string class.
+#include <unordered_map> // Import the hash map.
+
+#pragma endregion
+
+// 64-bit FNV-1a of length characters. Written as a single recursive return (C++11 constexpr), so names hash at
+// compile time on every toolset the engine builds with, including Visual Studio 2015.
+constexpr uint64_t hashName(const char* text, size_t length, uint64_t hash = 14695981039346656037ull)
+{
+	return length == 0 ? hash : hashName(text + 1, length - 1, (hash ^ (uint8_t)text[0]) * 1099511628211ull);
+}
+
+// The same hash as a loop, for long runtime strings.
+uint64_t hashNameAtRuntime(const char* text, size_t length);
+
+// Every runtime string turned into an ID, by hash, so IDs can be turned back into names in logs and debug views.
+// Thread safe. Prints an error if two different strings ever hash the same.
+class StringTable
+{
+public:
+	static StringTable& instance();
+
+	// Add a string if new, and return its hash.
+	uint64_t intern(const char* text, size_t length);
+
+	// The string with this hash, or nullptr if none was interned.
+	const char* lookup(uint64_t hash) const;
+
+	size_t getCount() const;
+
+private:
+	mutable std::mutex namesMutex;
+	std::unordered_map<uint64_t, std::string> strings;
+};
+
+// A name reduced to its 64-bit hash, so comparing or looking up names compares integers. The Tag keeps different
+// kinds of name apart (an asset ID cannot be passed where a uniform ID is expected).
+//
+// From a string literal the hash is computed at compile time: constexpr UniformId color("ourColor"). Literal IDs are
+// not interned (a constant expression cannot touch the table), so debug lookups only know them once the same name
+// has also been interned, e.g. through fromString() when the asset or uniform was registered.
+template <typename Tag>
+class NameId
+{
+public:
+	constexpr NameId() : value(0) {}
+	explicit constexpr NameId(uint64_t hash) : value(hash) {}
+
+	// From a string literal, hashed at compile time. Explicit, so a char buffer, which would hash its full length
+	// rather than up to the terminator, is never converted by accident; name the type to hash a literal.
+	template <size_t N>
+	explicit constexpr NameId(const char (&literal)[N]) : value(hashName(literal, N - 1)) {}
+
+	// From a runtime string, interning it for debug lookups.
+	static NameId fromString(const std::string& text) { return NameId(StringTable::instance().intern(text.data(), text.size())); }
+
+	constexpr uint64_t getValue() const { return value; }
+	constexpr bool isValid() const { return value != 0; }
+
+	// The name, if it was ever interned, else "?".
+	const char* getDebugName() const
+	{
+		const char* name = StringTable::instance().lookup(value);
+		return name ? name : "?";
+	}
+
+	constexpr bool operator==(NameId other) const { return value == other.value; }
+	constexpr bool operator!=(NameId other) const { return value != other.value; }
+	constexpr bool operator<(NameId other) const { return value < other.value; }
+
+private:
+	uint64_t value;
+};
+
+struct StringIdTag {};
+struct AssetIdTag {};
+struct UniformIdTag {};
+
+typedef NameId<StringIdTag> StringId; // Any name, e.g. a cvar.
+typedef NameId<AssetIdTag> AssetId;
+typedef NameId<UniformIdTag> UniformId; // A shader uniform; see UniformLocations.
+
+namespace std
+{
+	template <typename Tag>
+	struct hash<NameId<Tag>>
+	{
+		size_t operator()(NameId<Tag> id) const { return (size_t)(id.getValue() ^ (id.getValue() >> 32)); }
+	};
+}
+
+// Look up nameCount asset names by std::string in an ordered map, by std::string in a hash map, and by AssetId in a
+// hash map, and print the time per lookup of each.
+void runStringIdBenchmark(int nameCount, int lookups);
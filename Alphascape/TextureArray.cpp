@@ -0,0 +1,336 @@
+#pragma region Library Imports
+
+#include <cstring> // Import memcpy.
+#include <functional> // Import function.
+#include <iostream> // Import the IO stream libraries.
+#include <random> // Import the random number generators.
+#include <string> // Import the string class.
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "GLRenderDevice.h" // Import the GL render device.
+#include "TextureArray.h" // Import the texture array packer.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+static size_t bytesPerPixel(TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::RGBA16F: return 8;
+	case TextureFormat::R16F: return 2;
+	default: return 4;
+	}
+}
+
+#pragma region Texture Array Packer
+
+int TextureArrayPacker::add(int width, int height, TextureFormat format, const void* pixels)
+{
+	// Find (or start) the group of textures with this size and format.
+	uint32_t array = 0;
+	while (array < groups.size() && !(groups[array].width == width && groups[array].height == height && groups[array].format == format))
+		array++;
+	if (array == groups.size()) {
+		Group group;
+		group.width = width;
+		group.height = height;
+		group.format = format;
+		group.layers = 0;
+		groups.push_back(group);
+	}
+
+	Group& group = groups[array];
+	size_t layerSize = (size_t)width * height * bytesPerPixel(format);
+	group.pixels.resize(group.pixels.size() + layerSize);
+	memcpy(group.pixels.data() + group.pixels.size() - layerSize, pixels, layerSize);
+
+	TextureArraySlot slot;
+	slot.array = array;
+	slot.layer = group.layers++;
+	slots.push_back(slot);
+	return (int)slots.size() - 1;
+}
+
+bool TextureArrayPacker::build(RenderDevice& device)
+{
+	for (Group& group : groups) {
+		TextureDesc desc;
+		desc.width = group.width;
+		desc.height = group.height;
+		desc.layers = group.layers;
+		desc.array = true; // Even a group of one is sampled through sampler2DArray.
+		desc.format = group.format;
+		desc.initialData = group.pixels.data();
+		group.texture = device.createTexture(desc);
+		if (!group.texture.valid())
+			return false;
+		vector<uint8_t>().swap(group.pixels); // The GPU has its copy.
+	}
+	return true;
+}
+
+void TextureArrayPacker::destroy(RenderDevice& device)
+{
+	for (Group& group : groups)
+		device.destroyTexture(group.texture);
+	groups.clear();
+	slots.clear();
+}
+
+#pragma endregion
+
+#pragma region Shaders
+
+// One texture per draw: the quad comes from the per-draw constants.
+static const GLchar* boundVertexShaderSource =
+"#version 330 core\n"
+"layout(std140) uniform Constants { vec4 rect; };\n" // Position and size in NDC.
+"layout(location = 0) in vec2 corner;\n"
+"out vec2 uv;\n"
+"void main()\n"
+"{\n"
+"uv = corner;\n"
+"gl_Position = vec4(rect.xy + corner * rect.zw, 0.0, 1.0);\n"
+"}\n\0";
+static const GLchar* boundFragmentShaderSource =
+"#version 330 core\n"
+"uniform sampler2D image;\n"
+"in vec2 uv;\n"
+"out vec4 color;\n"
+"void main()\n"
+"{\n"
+"color = texture(image, uv);\n"
+"}\n\0";
+
+// Instanced: every instance carries its quad and the texture it samples (an array layer, or a bindless handle index).
+static const GLchar* instancedVertexShaderSource =
+"#version 330 core\n"
+"layout(location = 0) in vec2 corner;\n"
+"layout(location = 1) in vec4 rect;\n"
+"layout(location = 2) in float textureIndex;\n"
+"out vec2 uv;\n"
+"flat out int layer;\n"
+"void main()\n"
+"{\n"
+"uv = corner;\n"
+"layer = int(textureIndex);\n"
+"gl_Position = vec4(rect.xy + corner * rect.zw, 0.0, 1.0);\n"
+"}\n\0";
+static const GLchar* arrayFragmentShaderSource =
+"#version 330 core\n"
+"uniform sampler2DArray images;\n"
+"in vec2 uv;\n"
+"flat in int layer;\n"
+"out vec4 color;\n"
+"void main()\n"
+"{\n"
+"color = texture(images, vec3(uv, layer));\n"
+"}\n\0";
+// Two 64-bit handles per uvec4, since std140 pads every array element to 16 bytes. ARB_bindless_texture needs GLSL
+// 4.00, and on its own requires a sampler built from a handle to be dynamically uniform; the handle index here varies
+// per instance, which only NV_gpu_shader5 allows. That is vendor-specific, so the benchmark runs this shader only where
+// the driver exposes both extensions, and keeps one texture per draw or texture arrays elsewhere.
+static const GLchar* bindlessFragmentShaderSource =
+"#version 400 core\n"
+"#extension GL_ARB_bindless_texture : require\n"
+"#extension GL_NV_gpu_shader5 : require\n"
+"layout(std140) uniform TextureHandles { uvec4 handles[128]; };\n"
+"in vec2 uv;\n"
+"flat in int layer;\n"
+"out vec4 color;\n"
+"void main()\n"
+"{\n"
+"uvec4 pair = handles[layer / 2];\n"
+"sampler2D image = sampler2D((layer % 2) == 0 ? pair.xy : pair.zw);\n"
+"color = texture(image, uv);\n"
+"}\n\0";
+
+static const int MaxBindlessTextures = 256; // handles[128], two per element.
+
+#pragma endregion
+
+#pragma region Benchmark
+
+void runTextureBindingBenchmark(GLFWwindow* window, int textureCount, int quadCount, int frames)
+{
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+	glfwSwapInterval(0); // Never wait for vertical sync while measuring.
+
+	GLRenderDevice device;
+	const float clearColor[4] = { 0.529f, 0.808f, 0.980f, 1.0f };
+
+	#pragma region Textures
+
+	// Checkerboards in distinct colours, in two sizes so the packer has two arrays to make.
+	vector<TextureHandle> textures(textureCount);
+	TextureArrayPacker packer;
+	vector<int> packedIndices(textureCount);
+	for (int i = 0; i < textureCount; i++) {
+		int size = i % 4 == 0 ? 32 : 64;
+		vector<uint8_t> pixels((size_t)size * size * 4);
+		for (int y = 0; y < size; y++) {
+			for (int x = 0; x < size; x++) {
+				uint8_t* pixel = &pixels[((size_t)y * size + x) * 4];
+				bool light = ((x / 8) + (y / 8)) % 2 == 0;
+				pixel[0] = (uint8_t)(light ? 255 : (i * 37) % 256);
+				pixel[1] = (uint8_t)(light ? 255 : (i * 91) % 256);
+				pixel[2] = (uint8_t)(light ? 255 : (i * 53) % 256);
+				pixel[3] = 255;
+			}
+		}
+		TextureDesc desc;
+		desc.width = desc.height = size;
+		desc.initialData = pixels.data();
+		textures[i] = device.createTexture(desc);
+		packedIndices[i] = packer.add(size, size, TextureFormat::RGBA8, pixels.data());
+	}
+	if (!packer.build(device))
+		return;
+
+	#pragma endregion
+
+	#pragma region Geometry and Pipelines
+
+	// A unit quad as two triangles.
+	const float corners[] = { 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f };
+	BufferDesc cornerDesc;
+	cornerDesc.size = sizeof(corners);
+	cornerDesc.initialData = corners;
+	BufferHandle cornerBuffer = device.createBuffer(cornerDesc);
+
+	// Random quads, each sampling one of the textures.
+	struct Quad { float rect[4]; int texture; };
+	mt19937 random(1234); // Fixed seed, so runs are comparable.
+	uniform_real_distribution<float> position(-1.0f, 0.9f), size(0.02f, 0.1f);
+	vector<Quad> quads(quadCount);
+	for (int i = 0; i < quadCount; i++)
+		quads[i] = { { position(random), position(random), size(random), size(random) }, i % textureCount };
+
+	// Per-instance data: the quad, then an array layer or a bindless handle index.
+	struct Instance { float rect[4]; float textureIndex; };
+	vector<Instance> arrayInstances, bindlessInstances;
+	vector<uint32_t> arrayFirst(packer.getArrayCount() + 1, 0); // Instances sorted by array.
+	for (const Quad& quad : quads)
+		arrayFirst[packer.getSlot(packedIndices[quad.texture]).array + 1]++;
+	for (size_t array = 1; array < arrayFirst.size(); array++)
+		arrayFirst[array] += arrayFirst[array - 1];
+	arrayInstances.resize(quads.size());
+	vector<uint32_t> arrayFill(arrayFirst.begin(), arrayFirst.end() - 1);
+	for (const Quad& quad : quads) {
+		TextureArraySlot slot = packer.getSlot(packedIndices[quad.texture]);
+		Instance instance = { { quad.rect[0], quad.rect[1], quad.rect[2], quad.rect[3] }, (float)slot.layer };
+		arrayInstances[arrayFill[slot.array]++] = instance;
+		instance.textureIndex = (float)quad.texture;
+		bindlessInstances.push_back(instance);
+	}
+	BufferDesc instanceDesc;
+	instanceDesc.size = arrayInstances.size() * sizeof(Instance);
+	instanceDesc.initialData = arrayInstances.data();
+	BufferHandle arrayInstanceBuffer = device.createBuffer(instanceDesc);
+	instanceDesc.initialData = bindlessInstances.data();
+	BufferHandle bindlessInstanceBuffer = device.createBuffer(instanceDesc);
+
+	PipelineDesc boundDesc;
+	boundDesc.vertexSource = boundVertexShaderSource;
+	boundDesc.fragmentSource = boundFragmentShaderSource;
+	boundDesc.layout.add(0, 2, 0, 0);
+	boundDesc.layout.strides[0] = 2 * sizeof(float);
+	PipelineHandle boundPipeline = device.createPipeline(boundDesc);
+
+	PipelineDesc instancedDesc = boundDesc;
+	instancedDesc.vertexSource = instancedVertexShaderSource;
+	instancedDesc.fragmentSource = arrayFragmentShaderSource;
+	instancedDesc.layout.add(1, 4, 1, 0).add(2, 1, 1, 4 * sizeof(float));
+	instancedDesc.layout.strides[1] = sizeof(Instance);
+	PipelineHandle arrayPipeline = device.createPipeline(instancedDesc);
+
+	// Bindless: the handle table is a uniform buffer in slot 0.
+	PipelineHandle bindlessPipeline;
+	BufferHandle handleBuffer;
+	bool bindless = device.supportsBindless() && glewIsSupported("GL_NV_gpu_shader5") && textureCount <= MaxBindlessTextures;
+	if (bindless) {
+		instancedDesc.fragmentSource = bindlessFragmentShaderSource;
+		instancedDesc.uniformBlocks[0] = "TextureHandles";
+		bindlessPipeline = device.createPipeline(instancedDesc);
+		vector<GLuint64> handles(MaxBindlessTextures, 0);
+		for (int i = 0; i < textureCount; i++)
+			handles[i] = device.getBindlessHandle(textures[i]);
+		BufferDesc handleDesc;
+		handleDesc.usage = BufferUsage::Uniform;
+		handleDesc.size = handles.size() * sizeof(GLuint64);
+		handleDesc.initialData = handles.data();
+		handleBuffer = device.createBuffer(handleDesc);
+		bindless = bindlessPipeline.valid();
+	}
+	if (!boundPipeline.valid() || !arrayPipeline.valid())
+		return;
+
+	#pragma endregion
+
+	#pragma region Runs
+
+	CommandList* list = device.createCommandList();
+	auto recordBound = [&]() { // One bind and one draw per quad.
+		list->bindPipeline(boundPipeline);
+		list->bindVertexBuffer(0, cornerBuffer);
+		for (const Quad& quad : quads) {
+			list->bindTexture(0, textures[quad.texture]);
+			list->setConstants(quad.rect, sizeof(quad.rect));
+			list->draw(6);
+		}
+	};
+	auto recordArrays = [&]() { // One bind and one instanced draw per array.
+		list->bindPipeline(arrayPipeline);
+		list->bindVertexBuffer(0, cornerBuffer);
+		for (uint32_t array = 0; array < packer.getArrayCount(); array++) {
+			list->bindTexture(0, packer.getArrayTexture(array));
+			list->bindVertexBuffer(1, arrayInstanceBuffer, arrayFirst[array] * sizeof(Instance));
+			list->draw(6, arrayFirst[array + 1] - arrayFirst[array]);
+		}
+	};
+	auto recordBindless = [&]() { // No binds; one instanced draw.
+		list->bindPipeline(bindlessPipeline);
+		list->bindUniformBuffer(0, handleBuffer);
+		list->bindVertexBuffer(0, cornerBuffer);
+		list->bindVertexBuffer(1, bindlessInstanceBuffer);
+		list->draw(6, (uint32_t)quads.size());
+	};
+
+	struct Run { const char* name; function<void()> record; };
+	vector<Run> runs = { { "TEXTURES::BIND_PER_DRAW", recordBound }, { "TEXTURES::ARRAY", recordArrays } };
+	if (bindless)
+		runs.push_back({ "TEXTURES::BINDLESS", recordBindless });
+	else
+		cout << "ARB_bindless_texture with NV_gpu_shader5 not available; skipping the bindless run." << endl;
+
+	cout << "BENCH::TEXTURES " << quadCount << " quads, " << textureCount << " textures in " << packer.getArrayCount() << " arrays" << endl;
+	for (const Run& run : runs) {
+		vector<double> samples;
+		device.resetStats();
+		for (int frame = 0; frame < frames; frame++) {
+			BenchmarkTimer timer;
+			list->begin();
+			run.record();
+			list->end();
+			device.beginFrame(width, height, clearColor);
+			device.submit(&list, 1);
+			device.endFrame();
+			glFinish(); // Include the GPU work.
+			samples.push_back(timer.elapsedMs());
+			glfwSwapBuffers(window);
+			glfwPollEvents();
+		}
+		const RenderStats& stats = device.getStats();
+		printBenchmarkStats(run.name, computeBenchmarkStats(samples));
+		cout << "  per frame: " << stats.textureBinds / frames << " texture binds, " << stats.drawCalls / frames << " draws" << endl;
+	}
+
+	#pragma endregion
+
+	packer.destroy(device);
+}
+
+#pragma endregion
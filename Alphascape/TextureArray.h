@@ -0,0 +1,56 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <cstdint> // Import the fixed width integers.
+#include <vector> // Import the vector container.
+
+#include "Graphics.h" // Import GLEW and GLFW.
+#include "RenderDevice.h" // Import the render device interface.
+
+#pragma endregion
+
+// Where a packed texture ended up: which array texture, and which layer of it.
+struct TextureArraySlot
+{
+	uint32_t array = 0; // Index for getArrayTexture().
+	uint32_t layer = 0;
+};
+
+// Packs textures that share a size and format into the layers of one 2D array texture, so draws that use different
+// textures can be merged into one instanced draw: each instance passes its layer instead of the draw binding its
+// texture. Shaders sample them through a sampler2DArray.
+class TextureArrayPacker
+{
+public:
+	// Queue a texture (tightly packed pixels, copied). Returns the index to look its slot up with.
+	int add(int width, int height, TextureFormat format, const void* pixels);
+
+	// Create one array texture per distinct size and format. Call once, after every add().
+	bool build(RenderDevice& device);
+
+	TextureArraySlot getSlot(int index) const { return slots[index]; }
+	TextureHandle getArrayTexture(uint32_t array) const { return groups[array].texture; }
+	size_t getArrayCount() const { return groups.size(); }
+
+	// Destroy the array textures.
+	void destroy(RenderDevice& device);
+
+private:
+	struct Group
+	{
+		int width, height;
+		TextureFormat format;
+		uint32_t layers;
+		std::vector<uint8_t> pixels; // Every layer, in order.
+		TextureHandle texture;
+	};
+
+	std::vector<Group> groups;
+	std::vector<TextureArraySlot> slots;
+};
+
+// Draw quadCount quads sampling textureCount distinct textures three ways: a texture bind and draw per quad, one
+// instanced draw per texture array, and (where ARB_bindless_texture and NV_gpu_shader5 are available) a single
+// instanced draw indexing bindless handles. Prints texture binds, draws and timings per frame for each.
+void runTextureBindingBenchmark(GLFWwindow* window, int textureCount, int quadCount, int frames);
@@ -0,0 +1,507 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import sort, min and max.
+#include <atomic> // Import the atomics.
+#include <cerrno> // Import errno.
+#include <cstdio> // Import snprintf.
+#include <cstring> // Import strlen and memcpy.
+#include <fstream> // Import the file streams.
+#include <iostream> // Import the IO stream libraries.
+#include <map> // Import the ordered map.
+#include <mutex> // Import the mutex.
+#include <set> // Import the ordered set.
+#include <string> // Import the string class.
+#include <thread> // Import the threads.
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h> // Import GetLogicalProcessorInformationEx and the thread functions.
+#elif defined(__APPLE__)
+#include <pthread.h> // Import pthread_setname_np.
+#include <pthread/qos.h> // Import the quality of service classes.
+#include <sys/sysctl.h> // Import sysctlbyname.
+#else
+#include <pthread.h> // Import pthread_setaffinity_np and pthread_setname_np.
+#include <sched.h> // Import sched_getaffinity.
+#include <sys/resource.h> // Import setpriority.
+#include <sys/syscall.h> // Import SYS_gettid.
+#include <unistd.h> // Import syscall.
+#endif
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "Threading.h" // Import the threading declarations.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Topology
+
+CpuTopology::CpuTopology()
+{
+	detect();
+	if (processors.empty()) { // Nothing could be read: one core per logical processor.
+		for (uint32_t processor = 0; processor < max(1u, std::thread::hardware_concurrency()); processor++)
+			processors.push_back(processor);
+	}
+	if (cores.empty()) {
+		for (uint32_t processor : processors) {
+			CpuCore core;
+			core.processors.push_back(processor);
+			cores.push_back(core);
+		}
+	}
+	sort(caches.begin(), caches.end(), [](const CpuCache& a, const CpuCache& b) {
+		return a.level != b.level ? a.level < b.level : a.processors < b.processors;
+	});
+}
+
+const CpuTopology& CpuTopology::instance()
+{
+	static CpuTopology topology;
+	return topology;
+}
+
+#ifdef _WIN32
+
+static vector<uint32_t> processorsInMask(KAFFINITY mask, KAFFINITY allowed)
+{
+	vector<uint32_t> found;
+	for (uint32_t processor = 0; processor < sizeof(KAFFINITY) * 8; processor++) {
+		if ((mask & allowed) & ((KAFFINITY)1 << processor))
+			found.push_back(processor);
+	}
+	return found;
+}
+
+void CpuTopology::detect()
+{
+	// Only processor group 0, which is every processor on machines with 64 or fewer.
+	DWORD_PTR processMask, systemMask;
+	if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+		return;
+	processors = processorsInMask(processMask, processMask);
+
+	DWORD length = 0;
+	GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+	vector<char> buffer(length);
+	if (!length || !GetLogicalProcessorInformationEx(RelationAll, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)buffer.data(), &length))
+		return;
+
+	vector<KAFFINITY> packages;
+	for (DWORD offset = 0; offset < length;) {
+		const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& info = *(const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)(buffer.data() + offset);
+		offset += info.Size;
+		if (info.Relationship == RelationProcessorPackage && info.Processor.GroupMask[0].Group == 0)
+			packages.push_back(info.Processor.GroupMask[0].Mask);
+		else if (info.Relationship == RelationProcessorCore && info.Processor.GroupMask[0].Group == 0) {
+			CpuCore core;
+			core.processors = processorsInMask(info.Processor.GroupMask[0].Mask, processMask);
+			if (!core.processors.empty())
+				cores.push_back(core);
+		}
+		else if (info.Relationship == RelationCache && info.Cache.Type != CacheInstruction && info.Cache.GroupMask.Group == 0) {
+			CpuCache cache;
+			cache.level = info.Cache.Level;
+			cache.sizeBytes = info.Cache.CacheSize;
+			cache.processors = processorsInMask(info.Cache.GroupMask.Mask, processMask);
+			if (!cache.processors.empty())
+				caches.push_back(cache);
+		}
+	}
+	for (CpuCore& core : cores) {
+		for (uint32_t package = 0; package < packages.size(); package++) {
+			if (packages[package] & ((KAFFINITY)1 << core.processors[0]))
+				core.package = package;
+		}
+	}
+}
+
+#elif defined(__APPLE__)
+
+static uint64_t readSysctl(const char* name)
+{
+	uint64_t value = 0;
+	size_t size = sizeof(value);
+	if (sysctlbyname(name, &value, &size, nullptr, 0) != 0)
+		return 0;
+	return size == sizeof(uint32_t) ? *(uint32_t*)&value : value;
+}
+
+void CpuTopology::detect()
+{
+	// macOS reports counts and sizes but not which processors share what, so SMT siblings are taken to be numbered
+	// together, L1 to be per core and the rest shared by all.
+	uint32_t logical = (uint32_t)readSysctl("hw.logicalcpu"), physical = (uint32_t)readSysctl("hw.physicalcpu");
+	if (!logical || !physical)
+		return;
+	for (uint32_t processor = 0; processor < logical; processor++)
+		processors.push_back(processor);
+	uint32_t siblings = max(1u, logical / physical);
+	for (uint32_t first = 0; first < logical; first += siblings) {
+		CpuCore core;
+		for (uint32_t processor = first; processor < min(logical, first + siblings); processor++)
+			core.processors.push_back(processor);
+		cores.push_back(core);
+
+		CpuCache cache;
+		cache.level = 1;
+		cache.sizeBytes = (size_t)readSysctl("hw.l1dcachesize");
+		cache.processors = core.processors;
+		if (cache.sizeBytes)
+			caches.push_back(cache);
+	}
+	const char* sharedSizes[] = { "hw.l2cachesize", "hw.l3cachesize" };
+	for (uint32_t level = 2; level <= 3; level++) {
+		CpuCache cache;
+		cache.level = level;
+		cache.sizeBytes = (size_t)readSysctl(sharedSizes[level - 2]);
+		cache.processors = processors;
+		if (cache.sizeBytes)
+			caches.push_back(cache);
+	}
+}
+
+#else
+
+static bool readSysfs(const string& path, string& value)
+{
+	ifstream file(path);
+	return (bool)getline(file, value);
+}
+
+// A processor list such as "0-3,8-11", keeping only allowed processors.
+static vector<uint32_t> parseProcessorList(const string& list, const cpu_set_t& allowed)
+{
+	vector<uint32_t> found;
+	size_t position = 0;
+	while (position < list.size()) {
+		size_t end = list.find(',', position);
+		if (end == string::npos)
+			end = list.size();
+		string range = list.substr(position, end - position);
+		size_t dash = range.find('-');
+		uint32_t first = (uint32_t)stoul(range), last = dash == string::npos ? first : (uint32_t)stoul(range.substr(dash + 1));
+		for (uint32_t processor = first; processor <= last && processor < CPU_SETSIZE; processor++) {
+			if (CPU_ISSET(processor, &allowed))
+				found.push_back(processor);
+		}
+		position = end + 1;
+	}
+	return found;
+}
+
+void CpuTopology::detect()
+{
+	// Only the processors this process may run on, which inside a container or under taskset may be a few of them.
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+		return;
+	for (uint32_t processor = 0; processor < CPU_SETSIZE; processor++) {
+		if (CPU_ISSET(processor, &allowed))
+			processors.push_back(processor);
+	}
+
+	map<pair<uint32_t, uint32_t>, size_t> coreIndices; // By package and core ID.
+	set<pair<uint32_t, vector<uint32_t>>> seenCaches; // By level and sharing processors.
+	for (uint32_t processor : processors) {
+		string directory = "/sys/devices/system/cpu/cpu" + to_string(processor) + "/", package, coreId;
+		pair<uint32_t, uint32_t> key(~0u, processor); // Unreadable: a core of its own.
+		if (readSysfs(directory + "topology/physical_package_id", package) && readSysfs(directory + "topology/core_id", coreId))
+			key = make_pair((uint32_t)stoul(package), (uint32_t)stoul(coreId));
+		auto found = coreIndices.find(key);
+		if (found == coreIndices.end()) {
+			found = coreIndices.emplace(key, cores.size()).first;
+			cores.push_back(CpuCore());
+			cores.back().package = key.first == ~0u ? 0 : key.first;
+		}
+		cores[found->second].processors.push_back(processor);
+
+		for (int index = 0;; index++) {
+			string cacheDirectory = directory + "cache/index" + to_string(index) + "/", level, type, size, shared;
+			if (!readSysfs(cacheDirectory + "level", level) || !readSysfs(cacheDirectory + "type", type)
+				|| !readSysfs(cacheDirectory + "size", size) || !readSysfs(cacheDirectory + "shared_cpu_list", shared))
+				break;
+			if (type == "Instruction")
+				continue;
+			CpuCache cache;
+			cache.level = (uint32_t)stoul(level);
+			cache.sizeBytes = (size_t)stoul(size) * (size.back() == 'M' ? 1024 * 1024 : size.back() == 'K' ? 1024 : 1);
+			cache.processors = parseProcessorList(shared, allowed);
+			if (!seenCaches.emplace(cache.level, cache.processors).second)
+				continue;
+			caches.push_back(cache);
+		}
+	}
+}
+
+#endif
+
+void CpuTopology::print(ostream& out) const
+{
+	auto printList = [&out](const vector<uint32_t>& list) {
+		for (size_t i = 0; i < list.size(); i++)
+			out << (i ? "," : "") << list[i];
+	};
+	out << "CPU topology: " << getPhysicalCount() << " physical cores, " << getLogicalCount() << " logical processors\n";
+	for (size_t core = 0; core < cores.size(); core++) {
+		out << "  core " << core << " (package " << cores[core].package << "): processors ";
+		printList(cores[core].processors);
+		out << "\n";
+	}
+	for (const CpuCache& cache : caches) {
+		out << "  L" << cache.level << " " << cache.sizeBytes / 1024 << " KB: processors ";
+		printList(cache.processors);
+		out << "\n";
+	}
+	out.flush();
+}
+
+#pragma endregion
+
+#pragma region Threads
+
+static atomic<bool> threadPinning{ true };
+
+void setThreadPinning(bool enabled)
+{
+	threadPinning.store(enabled);
+}
+
+bool getThreadPinning()
+{
+	return threadPinning.load();
+}
+
+// Cores workers are pinned to: every core but the last, which is the render thread's, unless there is only one.
+static unsigned int getWorkerCoreCount()
+{
+	unsigned int count = CpuTopology::instance().getPhysicalCount();
+	return count > 1 ? count - 1 : count;
+}
+
+unsigned int getDefaultWorkerCount()
+{
+	return getWorkerCoreCount();
+}
+
+// How many pinned workers each worker core has, across every pool, so each new worker goes to the least busy core
+// rather than every pool starting again from the first.
+static std::mutex coreLoadMutex;
+static vector<unsigned int> coreLoads;
+
+// The core the calling worker holds, given back when the thread exits.
+struct WorkerCoreClaim
+{
+	int core = -1;
+
+	~WorkerCoreClaim() { release(); }
+
+	void release()
+	{
+		if (core < 0)
+			return;
+		lock_guard<std::mutex> lock(coreLoadMutex);
+		coreLoads[core]--;
+		core = -1;
+	}
+};
+
+static thread_local WorkerCoreClaim workerCoreClaim;
+
+// Claim the least busy worker core for the calling thread, lowest first on a tie.
+static int claimWorkerCore()
+{
+	lock_guard<std::mutex> lock(coreLoadMutex);
+	coreLoads.resize(getWorkerCoreCount(), 0);
+	int core = (int)(min_element(coreLoads.begin(), coreLoads.end()) - coreLoads.begin());
+	coreLoads[core]++;
+	workerCoreClaim.core = core;
+	return core;
+}
+
+bool setCurrentThreadAffinity(const vector<uint32_t>& processors)
+{
+	const vector<uint32_t>& chosen = processors.empty() ? CpuTopology::instance().getProcessors() : processors;
+#ifdef _WIN32
+	KAFFINITY mask = 0;
+	for (uint32_t processor : chosen) {
+		if (processor < sizeof(KAFFINITY) * 8)
+			mask |= (KAFFINITY)1 << processor;
+	}
+	return mask && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__APPLE__)
+	(void)chosen;
+	return false; // macOS has no thread affinity, only hints the scheduler may ignore.
+#else
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (uint32_t processor : chosen) {
+		if (processor < CPU_SETSIZE)
+			CPU_SET(processor, &set);
+	}
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+}
+
+bool setCurrentThreadPriority(ThreadPriority priority)
+{
+#ifdef _WIN32
+	const int priorities[] = { THREAD_PRIORITY_BELOW_NORMAL, THREAD_PRIORITY_NORMAL, THREAD_PRIORITY_ABOVE_NORMAL };
+	return SetThreadPriority(GetCurrentThread(), priorities[(int)priority]) != 0;
+#elif defined(__APPLE__)
+	const qos_class_t classes[] = { QOS_CLASS_UTILITY, QOS_CLASS_USER_INITIATED, QOS_CLASS_USER_INTERACTIVE };
+	return pthread_set_qos_class_self_np(classes[(int)priority], 0) == 0;
+#else
+	// Per-thread nice values. Raising one above normal needs CAP_SYS_NICE or an RLIMIT_NICE allowance, which ordinary
+	// users seldom have, so a refused raise is expected: the thread stays at normal priority and it is noted once.
+	const int niceValues[] = { 10, 0, -5 };
+	id_t thread = (id_t)syscall(SYS_gettid);
+	if (setpriority(PRIO_PROCESS, thread, niceValues[(int)priority]) == 0)
+		return true;
+	if (priority == ThreadPriority::High && (errno == EACCES || errno == EPERM)) {
+		static atomic<bool> noted{ false };
+		if (!noted.exchange(true))
+			cout << "Thread priority not raised without CAP_SYS_NICE; running at normal priority" << endl;
+		setpriority(PRIO_PROCESS, thread, niceValues[(int)ThreadPriority::Normal]);
+		return false;
+	}
+	static atomic<bool> reported{ false };
+	if (!reported.exchange(true))
+		cout << "ERROR::THREADING::PRIORITY_NOT_SET\nNice " << niceValues[(int)priority] << " refused; raising thread priority needs CAP_SYS_NICE" << endl;
+	return false;
+#endif
+}
+
+void setCurrentThreadName(const char* name)
+{
+#ifdef _WIN32
+	// SetThreadDescription is Windows 10 1607 and later, and missing from older SDKs, so it is looked up at runtime.
+	typedef HRESULT(WINAPI* SetThreadDescriptionFunction)(HANDLE, PCWSTR);
+	static SetThreadDescriptionFunction setDescription =
+		(SetThreadDescriptionFunction)GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "SetThreadDescription");
+	if (!setDescription)
+		return;
+	wstring wideName(name, name + strlen(name));
+	setDescription(GetCurrentThread(), wideName.c_str());
+#elif defined(__APPLE__)
+	pthread_setname_np(name);
+#else
+	char shortName[16]; // Linux names are at most 15 characters.
+	size_t length = min(strlen(name), sizeof(shortName) - 1);
+	memcpy(shortName, name, length);
+	shortName[length] = '\0';
+	pthread_setname_np(pthread_self(), shortName);
+#endif
+}
+
+bool placeCurrentThread(ThreadRole role, unsigned int index)
+{
+	const vector<CpuCore>& cores = CpuTopology::instance().getCores();
+	bool pin = threadPinning.load();
+	bool placed = true;
+	char name[32];
+	switch (role) {
+	case ThreadRole::Main:
+		setCurrentThreadName("Main");
+		return true;
+	case ThreadRole::Render:
+		setCurrentThreadName("Render");
+		placed = setCurrentThreadAffinity(pin ? cores.back().processors : vector<uint32_t>());
+		return setCurrentThreadPriority(ThreadPriority::High) && placed;
+	case ThreadRole::Worker:
+		snprintf(name, sizeof(name), "Worker %u", index);
+		setCurrentThreadName(name);
+		workerCoreClaim.release();
+		placed = setCurrentThreadAffinity(pin ? cores[claimWorkerCore()].processors : vector<uint32_t>());
+		return setCurrentThreadPriority(ThreadPriority::Normal) && placed;
+	case ThreadRole::Io:
+		setCurrentThreadName("IO");
+		placed = setCurrentThreadAffinity(vector<uint32_t>()); // Undo any pinning inherited from the starting thread.
+		return setCurrentThreadPriority(ThreadPriority::Low) && placed;
+	}
+	return false;
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+void runThreadingBenchmark(int frames)
+{
+	const CpuTopology& topology = CpuTopology::instance();
+	topology.print(cout);
+
+	// Each worker updates its own quarter of an L2 cache of floats several times a frame, so a worker moved to another
+	// core loses its warm cache. One background thread per logical processor keeps the scheduler busy meanwhile.
+	unsigned int workerCount = getDefaultWorkerCount();
+	size_t l2Bytes = 256 * 1024;
+	for (const CpuCache& cache : topology.getCaches()) {
+		if (cache.level == 2) {
+			l2Bytes = cache.sizeBytes;
+			break;
+		}
+	}
+	size_t floatsPerWorker = l2Bytes / 4 / sizeof(float);
+	const int passesPerFrame = 64;
+	cout << "BENCH::THREADS " << workerCount << " workers updating " << floatsPerWorker * sizeof(float) / 1024 << " KB each "
+		<< passesPerFrame << " times a frame, " << frames << " frames, " << topology.getLogicalCount() << " background threads" << endl;
+
+	atomic<bool> backgroundRunning{ true };
+	vector<std::thread> background;
+	for (unsigned int i = 0; i < topology.getLogicalCount(); i++) {
+		background.emplace_back([&backgroundRunning] {
+			placeCurrentThread(ThreadRole::Io);
+			vector<float> scratch(64 * 1024, 1.0f);
+			while (backgroundRunning.load(memory_order_relaxed)) {
+				for (float& value : scratch)
+					value = value * 0.999f + 0.001f;
+				std::this_thread::sleep_for(chrono::microseconds(200)); // Bursts of work, like other processes.
+			}
+		});
+	}
+
+	bool wasPinning = getThreadPinning();
+	for (int pinned = 0; pinned < 2; pinned++) {
+		setThreadPinning(pinned != 0);
+		vector<double> samples;
+		ThreadBarrier barrier((int)workerCount);
+		vector<std::thread> workers;
+		for (unsigned int w = 0; w < workerCount; w++) {
+			workers.emplace_back([&, w] {
+				placeCurrentThread(ThreadRole::Worker, w);
+				vector<float> data(floatsPerWorker, 1.0f);
+				BenchmarkTimer timer;
+				for (int frame = 0; frame <= frames; frame++) { // Frame 0 warms the caches and is not counted.
+					barrier.wait();
+					timer.reset();
+					for (int pass = 0; pass < passesPerFrame; pass++) {
+						for (float& value : data)
+							value = value * 0.999f + 0.001f;
+					}
+					barrier.wait();
+					if (w == 0 && frame > 0)
+						samples.push_back(timer.elapsedMs());
+				}
+				if (data[0] < 0.0f) // Keep the work from being optimised away.
+					cout << data[0];
+			});
+		}
+		for (std::thread& worker : workers)
+			worker.join();
+
+		printBenchmarkStats(pinned ? "THREADS::PINNED" : "THREADS::UNPINNED", computeBenchmarkStats(samples));
+		sort(samples.begin(), samples.end());
+		cout << "  99th percentile " << samples[min(samples.size() - 1, samples.size() * 99 / 100)] << " ms" << endl;
+	}
+	setThreadPinning(wasPinning);
+
+	backgroundRunning.store(false);
+	for (std::thread& thread : background)
+		thread.join();
+}
+
+#pragma endregion
@@ -0,0 +1,120 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <condition_variable> // Import the condition variable.
+#include <cstddef> // Import size_t.
+#include <cstdint> // Import the fixed width integers.
+#include <mutex> // Import the mutex.
+#include <ostream> // Import the output streams.
+#include <vector> // Import the vector container.
+
+#pragma endregion
+
+// Where the engine's threads run. CpuTopology describes the processors this process may use: physical cores, the
+// logical processors (SMT siblings) of each, and which processors share each cache. Each long-lived thread calls
+// placeCurrentThread() with its role as it starts, which pins it to a core and sets its priority, so the OS does not
+// move critical threads between cores (losing their caches) or let background work preempt them.
+
+// One physical core.
+struct CpuCore
+{
+	uint32_t package = 0; // The socket.
+	std::vector<uint32_t> processors; // Its logical processors; more than one with SMT.
+};
+
+// A data or unified cache and the logical processors sharing it.
+struct CpuCache
+{
+	uint32_t level = 0;
+	size_t sizeBytes = 0;
+	std::vector<uint32_t> processors;
+};
+
+class CpuTopology
+{
+public:
+	// The topology, detected on first use. Falls back to one core per logical processor where it cannot be read.
+	static const CpuTopology& instance();
+
+	unsigned int getLogicalCount() const { return (unsigned int)processors.size(); }
+	unsigned int getPhysicalCount() const { return (unsigned int)cores.size(); }
+	const std::vector<uint32_t>& getProcessors() const { return processors; } // Every logical processor, ascending.
+	const std::vector<CpuCore>& getCores() const { return cores; }
+	const std::vector<CpuCache>& getCaches() const { return caches; } // By level, then first processor.
+
+	void print(std::ostream& out) const;
+
+private:
+	CpuTopology();
+	void detect();
+
+	std::vector<uint32_t> processors;
+	std::vector<CpuCore> cores;
+	std::vector<CpuCache> caches;
+};
+
+enum class ThreadPriority
+{
+	Low, // Background work that mostly waits, such as file reads.
+	Normal,
+	High, // Threads a frame waits on.
+};
+
+enum class ThreadRole
+{
+	// Simulation and events. Only named: threads it starts inherit its affinity on some platforms, and its nice value on
+	// Linux, so pinning it or raising its priority would carry over to every thread started after.
+	Main,
+	Render, // Pinned to the last core, which workers are kept off when there is more than one.
+	Worker, // Pinned to the least busy of the other cores, counted across every pool, so pools spread out, not stack.
+	Io, // Not pinned, low priority.
+};
+
+// Pin the calling thread and set its priority and debugger name for its role. index numbers workers within their pool
+// for the name, counting a calling thread that works too as 0; a worker gives its core back when the thread exits.
+// With pinning off (setThreadPinning) threads run on any processor, but priorities still apply. Returns false if the
+// platform refused part of it.
+bool placeCurrentThread(ThreadRole role, unsigned int index = 0);
+
+// Whether placeCurrentThread() pins threads (sys_pinThreads); affects threads placed afterwards.
+void setThreadPinning(bool enabled);
+bool getThreadPinning();
+
+// The lower level calls placeCurrentThread() is made of. An empty processor list means every processor.
+bool setCurrentThreadAffinity(const std::vector<uint32_t>& processors);
+bool setCurrentThreadPriority(ThreadPriority priority);
+void setCurrentThreadName(const char* name);
+
+// Holds threads until all count of them have arrived; reusable, so benchmarks can wait on it once per frame boundary.
+class ThreadBarrier
+{
+public:
+	explicit ThreadBarrier(int count) : count(count) {}
+
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock(barrierMutex);
+		uint64_t arrivedIn = generation;
+		if (++waiting == count) {
+			waiting = 0;
+			generation++;
+			released.notify_all();
+		}
+		else
+			released.wait(lock, [&] { return generation != arrivedIn; });
+	}
+
+private:
+	std::mutex barrierMutex;
+	std::condition_variable released;
+	int count, waiting = 0;
+	uint64_t generation = 0;
+};
+
+// The default size of a worker pool: one thread per physical core but the render thread's.
+unsigned int getDefaultWorkerCount();
+
+// Print the topology, then run frames of fixed work split across a default sized pool of workers, unpinned and pinned,
+// alongside background threads competing for the processors, and print the frame times and their spread.
+void runThreadingBenchmark(int frames);
@@ -0,0 +1,378 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import sort.
+#include <cstddef> // Import offsetof.
+#include <iostream> // Import the IO stream libraries.
+#include <random> // Import the random number generators.
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "Shader.h" // Import the shader compiler.
+#include "Transparency.h" // Import the transparency renderer.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Shaders
+
+// Shared instanced quad vertex shader: a unit quad expanded around each instance position.
+static const GLchar* quadVertexShaderSource =
+"#version 330 core\n"
+"layout(location = 0) in vec2 corner;\n"
+"layout(location = 1) in vec3 instancePosition;\n"
+"layout(location = 2) in vec2 instanceSize;\n"
+"layout(location = 3) in vec4 instanceColor;\n"
+"out vec4 quadColor;\n"
+"void main()\n"
+"{\n"
+"quadColor = instanceColor;\n"
+"gl_Position = vec4(instancePosition.xy + corner * instanceSize, instancePosition.z, 1.0);\n"
+"}\n\0";
+
+// Weighted blended accumulation: writes premultiplied, weighted colour and the weight to two targets.
+static const GLchar* accumulateFragmentShaderSource =
+"#version 330 core\n"
+"in vec4 quadColor;\n"
+"layout(location = 0) out vec4 accumulation;\n"
+"layout(location = 1) out float weightSum;\n"
+"void main()\n"
+"{\n"
+"float alpha = quadColor.a;\n"
+"float weight = alpha * clamp(3e3 * pow(1.0 - gl_FragCoord.z, 3.0), 1e-2, 3e3);\n" // McGuire and Bavoil's bounds.
+"accumulation = vec4(quadColor.rgb * alpha * weight, alpha);\n"
+"weightSum = alpha * weight;\n"
+"}\n\0";
+
+// Full screen triangle generated from gl_VertexID, so the composite needs no vertex buffer.
+static const GLchar* compositeVertexShaderSource =
+"#version 330 core\n"
+"void main()\n"
+"{\n"
+"vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+"gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);\n"
+"}\n\0";
+
+// Composite: average colour over the scene, covering it by 1 - revealage.
+static const GLchar* compositeFragmentShaderSource =
+"#version 330 core\n"
+"uniform sampler2D accumulationTexture;\n"
+"uniform sampler2D weightTexture;\n"
+"out vec4 color;\n"
+"void main()\n"
+"{\n"
+"ivec2 texel = ivec2(gl_FragCoord.xy);\n"
+"vec4 accumulation = texelFetch(accumulationTexture, texel, 0);\n"
+"float revealage = accumulation.a;\n"
+"if (revealage >= 1.0) discard;\n"
+"float weightSum = texelFetch(weightTexture, texel, 0).r;\n"
+"color = vec4(accumulation.rgb / max(weightSum, 1e-5), 1.0 - revealage);\n"
+"}\n\0";
+
+// Sorted fallback: plain straight alpha output.
+static const GLchar* sortedFragmentShaderSource =
+"#version 330 core\n"
+"in vec4 quadColor;\n"
+"out vec4 color;\n"
+"void main()\n"
+"{\n"
+"color = quadColor;\n"
+"}\n\0";
+
+#pragma endregion
+
+// Describe the per-instance layout of a TransparentQuad buffer on the currently bound VAO.
+static void setupQuadVertexArray(GLuint quadVBO, GLuint instanceVBO)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, quadVBO); // The shared unit quad.
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid*)0);
+	glEnableVertexAttribArray(0);
+
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO); // The per-instance data.
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TransparentQuad), (GLvoid*)offsetof(TransparentQuad, position));
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(TransparentQuad), (GLvoid*)offsetof(TransparentQuad, size));
+	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(TransparentQuad), (GLvoid*)offsetof(TransparentQuad, color));
+	for (GLuint attribute = 1; attribute <= 3; attribute++) {
+		glEnableVertexAttribArray(attribute);
+		glVertexAttribDivisor(attribute, 1); // Advance once per instance.
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool TransparencyRenderer::init(GLsizei newWidth, GLsizei newHeight)
+{
+	// Compile the three programs.
+	accumulateProgram = compileShaderProgram(quadVertexShaderSource, accumulateFragmentShaderSource);
+	compositeProgram = compileShaderProgram(compositeVertexShaderSource, compositeFragmentShaderSource);
+	sortedProgram = compileShaderProgram(quadVertexShaderSource, sortedFragmentShaderSource);
+
+	UniformLocations compositeUniforms(compositeProgram);
+	glUseProgram(compositeProgram); // Bind the composite samplers to texture units 0 and 1.
+	glUniform1i(compositeUniforms.get(UniformId("accumulationTexture")), 0);
+	glUniform1i(compositeUniforms.get(UniformId("weightTexture")), 1);
+	glUseProgram(0);
+
+	// A unit quad, drawn as a triangle strip.
+	GLfloat corners[] = {
+		-0.5f, -0.5f,
+		0.5f, -0.5f,
+		-0.5f,  0.5f,
+		0.5f,  0.5f
+	};
+	glGenBuffers(1, &quadVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+
+	// One static instance buffer for the weighted blended path and one streamed buffer for the sorted path.
+	glGenBuffers(1, &instanceVBO);
+	glGenBuffers(1, &sortedInstanceVBO);
+
+	glGenVertexArrays(1, &quadVAO);
+	glBindVertexArray(quadVAO);
+	setupQuadVertexArray(quadVBO, instanceVBO);
+
+	glGenVertexArrays(1, &sortedVAO);
+	glBindVertexArray(sortedVAO);
+	setupQuadVertexArray(quadVBO, sortedInstanceVBO);
+
+	glGenVertexArrays(1, &fullscreenVAO); // Core profile requires a bound VAO even without attributes.
+	glBindVertexArray(0);
+
+	width = newWidth;
+	height = newHeight;
+	createTargets();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		cout << "ERROR::TRANSPARENCY::FRAMEBUFFER_INCOMPLETE\n" << status << endl;
+		return false;
+	}
+	return true;
+}
+
+void TransparencyRenderer::createTargets()
+{
+	// The accumulation target: weighted premultiplied colour in rgb, revealage in a. Both targets are 32-bit float:
+	// even with the weight clamped to 3e3, a few thousand overlapping layers (as in the 100k quad benchmark) sum past
+	// the 65504 a half float holds, and the composite would divide inf by inf.
+	glGenTextures(1, &accumulationTexture);
+	glBindTexture(GL_TEXTURE_2D, accumulationTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	// The weight target: the sum of alpha * weight.
+	glGenTextures(1, &weightTexture);
+	glBindTexture(GL_TEXTURE_2D, weightTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// Depth in the same format as the default framebuffer, so it can be blitted across.
+	glGenRenderbuffers(1, &depthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accumulationTexture, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, weightTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRenderbuffer);
+	GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, drawBuffers);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void TransparencyRenderer::destroyTargets()
+{
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteTextures(1, &accumulationTexture);
+	glDeleteTextures(1, &weightTexture);
+	glDeleteRenderbuffers(1, &depthRenderbuffer);
+	framebuffer = accumulationTexture = weightTexture = depthRenderbuffer = 0;
+}
+
+void TransparencyRenderer::resize(GLsizei newWidth, GLsizei newHeight)
+{
+	if (newWidth == width && newHeight == height)
+		return;
+	width = newWidth;
+	height = newHeight;
+	destroyTargets();
+	createTargets();
+}
+
+void TransparencyRenderer::setQuads(const vector<TransparentQuad>& newQuads)
+{
+	quads = newQuads;
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, quads.size() * sizeof(TransparentQuad), quads.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, sortedInstanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, quads.size() * sizeof(TransparentQuad), NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TransparencyRenderer::render(TransparencyMode mode)
+{
+	if (quads.empty())
+		return;
+	if (mode == TransparencyMode::WeightedBlended)
+		renderWeightedBlended();
+	else
+		renderSorted();
+}
+
+void TransparencyRenderer::renderWeightedBlended()
+{
+	sortMs = 0.0;
+
+	GLint targetFramebuffer; // Remember where the composite goes.
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &targetFramebuffer);
+
+	// Copy the opaque depth so opaque geometry occludes transparent geometry.
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, targetFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+	// Clear accumulation to (0, 0, 0, 1): no colour, fully revealed. Clear the weight to 0.
+	GLfloat clearAccumulation[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	GLfloat clearWeight[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	glClearBufferfv(GL_COLOR, 0, clearAccumulation);
+	glClearBufferfv(GL_COLOR, 1, clearWeight);
+
+	// Accumulate: colour channels add, alpha multiplies by (1 - alpha). Depth is tested but never written.
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	glEnable(GL_BLEND);
+	glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+
+	glUseProgram(accumulateProgram);
+	glBindVertexArray(quadVAO);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)quads.size());
+
+	// Composite over the original target.
+	glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+	glDisable(GL_DEPTH_TEST);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glUseProgram(compositeProgram);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, accumulationTexture);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, weightTexture);
+	glBindVertexArray(fullscreenVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	// Restore the default state.
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(0);
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+}
+
+void TransparencyRenderer::renderSorted()
+{
+	// Sort back to front every frame: larger z is further away.
+	BenchmarkTimer timer;
+	order.resize(quads.size());
+	for (GLuint i = 0; i < order.size(); i++)
+		order[i] = i;
+	sort(order.begin(), order.end(), [this](GLuint a, GLuint b) { return quads[a].position[2] > quads[b].position[2]; });
+	sortedQuads.resize(quads.size());
+	for (size_t i = 0; i < order.size(); i++)
+		sortedQuads[i] = quads[order[i]];
+	sortMs = timer.elapsedMs();
+
+	// Orphan and refill the streamed instance buffer.
+	glBindBuffer(GL_ARRAY_BUFFER, sortedInstanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, sortedQuads.size() * sizeof(TransparentQuad), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, sortedQuads.size() * sizeof(TransparentQuad), sortedQuads.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glUseProgram(sortedProgram);
+	glBindVertexArray(sortedVAO);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)sortedQuads.size());
+	glBindVertexArray(0);
+
+	glDepthMask(GL_TRUE);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+}
+
+void TransparencyRenderer::shutdown()
+{
+	destroyTargets();
+	glDeleteVertexArrays(1, &quadVAO);
+	glDeleteVertexArrays(1, &sortedVAO);
+	glDeleteVertexArrays(1, &fullscreenVAO);
+	glDeleteBuffers(1, &quadVBO);
+	glDeleteBuffers(1, &instanceVBO);
+	glDeleteBuffers(1, &sortedInstanceVBO);
+	glDeleteProgram(accumulateProgram);
+	glDeleteProgram(compositeProgram);
+	glDeleteProgram(sortedProgram);
+}
+
+void runTransparencyBenchmark(GLFWwindow* window, int quadCount, int frames)
+{
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+	glfwSwapInterval(0); // Never wait for vertical sync while measuring.
+
+	// Overlapping quads clustered around the centre, so every pixel there is covered many times.
+	mt19937 random(1234); // Fixed seed, so runs are comparable.
+	uniform_real_distribution<float> centre(-0.5f, 0.5f), depth(-0.99f, 0.99f), size(0.05f, 0.4f), unit(0.0f, 1.0f), alpha(0.05f, 0.4f);
+	vector<TransparentQuad> quads(quadCount);
+	for (TransparentQuad& quad : quads) {
+		quad = { { centre(random), centre(random), depth(random) }, { size(random), size(random) }, { unit(random), unit(random), unit(random), alpha(random) } };
+	}
+
+	TransparencyRenderer renderer;
+	if (!renderer.init(width, height))
+		return;
+	renderer.setQuads(quads);
+
+	GLuint query;
+	glGenQueries(1, &query);
+
+	const TransparencyMode modes[] = { TransparencyMode::WeightedBlended, TransparencyMode::Sorted };
+	const char* names[] = { "OIT::WEIGHTED_BLENDED", "OIT::SORTED" };
+	for (int m = 0; m < 2; m++) {
+		vector<double> cpuSamples, gpuSamples, sortSamples;
+		for (int frame = 0; frame < frames; frame++) {
+			glClearColor(0.529f, 0.808f, 0.980f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+			BenchmarkTimer timer;
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			renderer.render(modes[m]);
+			glEndQuery(GL_TIME_ELAPSED);
+			cpuSamples.push_back(timer.elapsedMs());
+			sortSamples.push_back(renderer.lastSortMs());
+
+			GLuint64 gpuNanoseconds = 0; // Waits for the frame; fine while benchmarking.
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpuNanoseconds);
+			gpuSamples.push_back(gpuNanoseconds / 1.0e6);
+
+			glfwSwapBuffers(window);
+			glfwPollEvents();
+		}
+		cout << "BENCH::OIT " << quadCount << " quads, " << width << "x" << height << endl;
+		printBenchmarkStats((string(names[m]) + "::CPU").c_str(), computeBenchmarkStats(cpuSamples));
+		printBenchmarkStats((string(names[m]) + "::CPU_SORT").c_str(), computeBenchmarkStats(sortSamples));
+		printBenchmarkStats((string(names[m]) + "::GPU").c_str(), computeBenchmarkStats(gpuSamples));
+	}
+
+	glDeleteQueries(1, &query);
+	renderer.shutdown();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <vector> // Import the vector container.
+
+#include "Graphics.h" // Import GLEW and GLFW.
+
+#pragma endregion
+
+// A camera-facing transparent quad, drawn instanced. Position is in normalised device coordinates,
+// with z in [-1, 1] used both for sorting and for the order-independent weight.
+struct TransparentQuad
+{
+	GLfloat position[3];
+	GLfloat size[2];
+	GLfloat color[4]; // Straight (non-premultiplied) colour and alpha.
+};
+
+// How the transparent layer is composited.
+enum class TransparencyMode
+{
+	WeightedBlended, // Weighted blended order-independent transparency (McGuire & Bavoil): no sorting.
+	Sorted // Classic back-to-front sorted alpha blending, kept for comparison.
+};
+
+// Renders a set of transparent quads over whatever is in the target framebuffer.
+//
+// The weighted blended path accumulates into two render targets in a single pass:
+//   accumulation (RGBA32F): rgb += colour * alpha * weight, a *= (1 - alpha) (the revealage)
+//   weight (R32F):          r += alpha * weight
+// and then a full screen composite pass resolves rgb / weight over the scene with alpha = 1 - revealage.
+// Both targets share one glBlendFuncSeparate call, so the path works on plain GL 3.3 without glBlendFunci.
+class TransparencyRenderer
+{
+public:
+	// Create the shaders, quad buffers and accumulation targets. Returns false if the framebuffer is incomplete.
+	bool init(GLsizei width, GLsizei height);
+
+	// Recreate the accumulation targets for a new framebuffer size.
+	void resize(GLsizei width, GLsizei height);
+
+	// Replace the quads to draw. They are uploaded once; the weighted blended path never touches them again.
+	void setQuads(const std::vector<TransparentQuad>& quads);
+
+	// Draw the quads over the framebuffer currently bound to GL_DRAW_FRAMEBUFFER (normally the default framebuffer).
+	// Depth from that framebuffer is copied so opaque geometry still occludes the transparent layer.
+	void render(TransparencyMode mode);
+
+	// Milliseconds the CPU spent sorting in the last Sorted render (always 0 for WeightedBlended).
+	double lastSortMs() const { return sortMs; }
+
+	// Delete all GL objects.
+	void shutdown();
+
+private:
+	void createTargets();
+	void destroyTargets();
+	void renderWeightedBlended();
+	void renderSorted();
+
+	GLsizei width = 0, height = 0;
+
+	GLuint accumulateProgram = 0, compositeProgram = 0, sortedProgram = 0;
+	GLuint quadVBO = 0, instanceVBO = 0, sortedInstanceVBO = 0;
+	GLuint quadVAO = 0, sortedVAO = 0, fullscreenVAO = 0;
+
+	GLuint framebuffer = 0, accumulationTexture = 0, weightTexture = 0, depthRenderbuffer = 0;
+
+	std::vector<TransparentQuad> quads; // CPU copy, only needed by the sorted path.
+	std::vector<TransparentQuad> sortedQuads; // Scratch buffer for the sorted path.
+	std::vector<GLuint> order; // Scratch sort indices for the sorted path.
+	double sortMs = 0.0;
+};
+
+// Render quadCount overlapping transparent quads for the given number of frames in each mode and print the timings.
+void runTransparencyBenchmark(GLFWwindow* window, int quadCount, int frames);
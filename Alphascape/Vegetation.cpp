@@ -0,0 +1,351 @@
+#pragma region Library Imports
+
+#include <algorithm> // Import min, max and shuffle.
+#include <cmath> // Import the C maths libraries.
+#include <cstdint> // Import UINT32_MAX.
+#include <cstring> // Import memcpy.
+#include <iostream> // Import the IO stream libraries.
+#include <random> // Import the random number generators.
+#include <string> // Import the string class.
+
+#include "Benchmark.h" // Import the benchmark helpers.
+#include "GLRenderDevice.h" // Import the GL render device.
+#include "Vegetation.h" // Import the vegetation system.
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#pragma region Shaders
+
+// density.x is the fractional number of the cell's instances to draw and density.y the width, in instances, of the
+// band over which they shrink to nothing. Each instance gets a stable yaw from its position.
+static const GLchar* vegetationVertexShaderSource =
+"#version 330 core\n"
+"layout(std140) uniform Constants { mat4 viewProjection; vec4 color; vec4 density; };\n"
+"layout(location = 0) in vec3 position;\n"
+"layout(location = 1) in vec3 normal;\n"
+"layout(location = 2) in vec4 instance;\n" // Translation and scale.
+"out vec3 worldNormal;\n"
+"void main()\n"
+"{\n"
+"float scale = instance.w * clamp((density.x - float(gl_InstanceID)) / density.y, 0.0, 1.0);\n"
+"float angle = fract(sin(dot(instance.xz, vec2(12.9898, 78.233))) * 43758.5453) * 6.2831853;\n"
+"mat2 yaw = mat2(cos(angle), sin(angle), -sin(angle), cos(angle));\n"
+"vec2 positionXZ = yaw * position.xz, normalXZ = yaw * normal.xz;\n"
+"worldNormal = vec3(normalXZ.x, normal.y, normalXZ.y);\n"
+"gl_Position = viewProjection * vec4(instance.xyz + vec3(positionXZ.x, position.y, positionXZ.y) * scale, 1.0);\n"
+"}\n\0";
+static const GLchar* vegetationFragmentShaderSource =
+"#version 330 core\n"
+"layout(std140) uniform Constants { mat4 viewProjection; vec4 color; vec4 density; };\n"
+"in vec3 worldNormal;\n"
+"out vec4 fragmentColor;\n"
+"void main()\n"
+"{\n"
+"vec3 normal = normalize(worldNormal);\n"
+"float diffuse = abs(dot(normal, vec3(0.424, 0.848, 0.318)));\n" // Two-sided: blades are seen from both sides.
+"fragmentColor = vec4(color.rgb * (0.35 + 0.65 * diffuse), 1.0);\n"
+"}\n\0";
+
+#pragma endregion
+
+#pragma region Vegetation System
+
+// The fraction of a cell's range over which thinned-out instances shrink away.
+static const float fadeBand = 0.25f;
+
+VegetationSystem::VegetationSystem(RenderDevice& renderDevice) : device(renderDevice)
+{
+}
+
+VegetationSystem::~VegetationSystem()
+{
+	for (Layer& layer : layers) {
+		device.destroyBuffer(layer.vertexBuffer);
+		device.destroyBuffer(layer.indexBuffer);
+		device.destroyBuffer(layer.instanceBuffer);
+	}
+	device.destroyPipeline(pipeline);
+}
+
+bool VegetationSystem::init()
+{
+	PipelineDesc desc;
+	desc.vertexSource = vegetationVertexShaderSource;
+	desc.fragmentSource = vegetationFragmentShaderSource;
+	desc.layout.add(0, 3, 0, 0).add(1, 3, 0, 3 * sizeof(float)).add(2, 4, 1, 0);
+	desc.layout.strides[0] = 6 * sizeof(float);
+	desc.layout.strides[1] = sizeof(ImpostorInstance);
+	desc.depthTest = true;
+	desc.depthWrite = true;
+	pipeline = device.createPipeline(desc);
+	return pipeline.valid();
+}
+
+uint32_t VegetationSystem::addLayer(const VegetationLayerDesc& desc, const vector<ImpostorInstance>& instances)
+{
+	Layer layer;
+	BufferDesc vertexDesc;
+	vertexDesc.size = desc.mesh.vertices.size() * sizeof(float);
+	vertexDesc.initialData = desc.mesh.vertices.data();
+	layer.vertexBuffer = device.createBuffer(vertexDesc);
+	BufferDesc indexDesc;
+	indexDesc.usage = BufferUsage::Index;
+	indexDesc.size = desc.mesh.indices.size() * sizeof(uint32_t);
+	indexDesc.initialData = desc.mesh.indices.data();
+	layer.indexBuffer = device.createBuffer(indexDesc);
+	layer.indexCount = (uint32_t)desc.mesh.indices.size();
+	memcpy(layer.color, desc.mesh.color, sizeof(layer.color));
+	layer.fadeStart = desc.fadeStart;
+	layer.fadeEnd = max(desc.fadeEnd, desc.fadeStart + 0.001f);
+
+	// The mesh's vertical extent and its reach around the y axis, whatever yaw the shader gives it.
+	float meshLow = 0.0f, meshHigh = 0.0f, meshReach = 0.0f;
+	for (size_t i = 0; i + 5 < desc.mesh.vertices.size(); i += 6) {
+		const float* vertex = &desc.mesh.vertices[i];
+		meshLow = min(meshLow, vertex[1]);
+		meshHigh = max(meshHigh, vertex[1]);
+		meshReach = max(meshReach, sqrt(vertex[0] * vertex[0] + vertex[2] * vertex[2]));
+	}
+
+	// Bucket by cell with a counting sort over the grid that covers the instances.
+	float minX = INFINITY, minZ = INFINITY, maxX = -INFINITY, maxZ = -INFINITY;
+	for (const ImpostorInstance& instance : instances) {
+		minX = min(minX, instance.position[0]);
+		maxX = max(maxX, instance.position[0]);
+		minZ = min(minZ, instance.position[2]);
+		maxZ = max(maxZ, instance.position[2]);
+	}
+	int cellsX = instances.empty() ? 0 : (int)((maxX - minX) / desc.cellSize) + 1;
+	int cellsZ = instances.empty() ? 0 : (int)((maxZ - minZ) / desc.cellSize) + 1;
+	vector<uint32_t> cellOf(instances.size());
+	vector<Cell> cells((size_t)cellsX * cellsZ);
+	for (size_t i = 0; i < instances.size(); i++) {
+		int x = min((int)((instances[i].position[0] - minX) / desc.cellSize), cellsX - 1);
+		int z = min((int)((instances[i].position[2] - minZ) / desc.cellSize), cellsZ - 1);
+		cellOf[i] = (uint32_t)(z * cellsX + x);
+		cells[cellOf[i]].count++;
+	}
+	uint32_t offset = 0;
+	for (Cell& cell : cells) {
+		cell.first = offset;
+		offset += cell.count;
+		cell.count = 0; // Counted again while filling.
+		cell.low = Vec3(INFINITY, INFINITY, INFINITY);
+		cell.high = Vec3(-INFINITY, -INFINITY, -INFINITY);
+	}
+	vector<ImpostorInstance> sorted(instances.size());
+	for (size_t i = 0; i < instances.size(); i++) {
+		Cell& cell = cells[cellOf[i]];
+		const ImpostorInstance& instance = instances[i];
+		sorted[cell.first + cell.count++] = instance;
+		float reach = meshReach * instance.scale;
+		cell.low = Vec3(min(cell.low.x, instance.position[0] - reach), min(cell.low.y, instance.position[1] + meshLow * instance.scale), min(cell.low.z, instance.position[2] - reach));
+		cell.high = Vec3(max(cell.high.x, instance.position[0] + reach), max(cell.high.y, instance.position[1] + meshHigh * instance.scale), max(cell.high.z, instance.position[2] + reach));
+	}
+
+	// Shuffle each cell, so every prefix of it is an even sample. Fixed seed: the same instances thin the same way.
+	mt19937 random(1234);
+	for (const Cell& cell : cells)
+		shuffle(sorted.begin() + cell.first, sorted.begin() + cell.first + cell.count, random);
+	for (const Cell& cell : cells) {
+		if (cell.count > 0)
+			layer.cells.push_back(cell);
+	}
+
+	BufferDesc instanceDesc;
+	instanceDesc.size = sorted.size() * sizeof(ImpostorInstance);
+	instanceDesc.initialData = sorted.data();
+	layer.instanceBuffer = device.createBuffer(instanceDesc);
+	totalInstances += instances.size();
+	layers.push_back(layer);
+	return (uint32_t)layers.size() - 1;
+}
+
+void VegetationSystem::record(CommandList& list, const ImpostorView& view, const VegetationSettings& settings)
+{
+	Frustum frustum;
+	extractFrustum(view.viewProjection, frustum);
+	Vec3 camera(view.cameraPosition);
+
+	// Decide how much of each cell to draw.
+	visible.clear();
+	double wanted = 0.0;
+	for (uint32_t layerIndex = 0; layerIndex < layers.size(); layerIndex++) {
+		const Layer& layer = layers[layerIndex];
+		for (uint32_t cellIndex = 0; cellIndex < layer.cells.size(); cellIndex++) {
+			const Cell& cell = layer.cells[cellIndex];
+			if (settings.frustumCulling && !frustumIntersectsBox(frustum, cell.low, cell.high))
+				continue;
+			// Past the band's width beyond the cell's end, every drawn instance is at full size.
+			float fraction = 1.0f + fadeBand;
+			if (settings.densityFalloff) {
+				Vec3 nearest(min(max(camera.x, cell.low.x), cell.high.x), min(max(camera.y, cell.low.y), cell.high.y), min(max(camera.z, cell.low.z), cell.high.z));
+				float distance = length(nearest - camera);
+				fraction = min(max((layer.fadeEnd - distance) / (layer.fadeEnd - layer.fadeStart), 0.0f), 1.0f) * (1.0f + fadeBand);
+				if (fraction <= 0.0f)
+					continue;
+			}
+			VisibleCell entry = { layerIndex, cellIndex, cell.count, cell.count * fraction };
+			visible.push_back(entry);
+			wanted += min((float)cell.count, entry.instances);
+		}
+	}
+
+	// Over budget: thin every cell by the same factor, so the budget costs density rather than whole cells. A cell
+	// drawn at full density keeps drawing all of its instances until the scale brings its fade band below its count,
+	// so the total is not proportional to the scale: bisect for the largest scale that fits.
+	float budgetScale = 1.0f;
+	if (wanted > settings.instanceBudget) {
+		float low = 0.0f, high = 1.0f;
+		for (int iteration = 0; iteration < 24; iteration++) {
+			float scale = (low + high) * 0.5f;
+			double drawn = 0.0;
+			for (const VisibleCell& entry : visible)
+				drawn += min((float)entry.count, ceil(entry.instances * scale));
+			(drawn <= settings.instanceBudget ? low : high) = scale;
+		}
+		budgetScale = low;
+	}
+
+	drawnInstances = 0;
+	uint32_t boundLayer = UINT32_MAX;
+	float constants[24];
+	memcpy(constants, view.viewProjection, sizeof(view.viewProjection));
+	for (const VisibleCell& entry : visible) {
+		const Layer& layer = layers[entry.layer];
+		const Cell& cell = layer.cells[entry.cell];
+		float instances = entry.instances * budgetScale;
+		uint32_t count = min(cell.count, (uint32_t)ceil(instances));
+		count = (uint32_t)min<uint64_t>(count, settings.instanceBudget - drawnInstances); // A hard cap, whatever the rounding.
+		if (count == 0)
+			continue;
+		if (entry.layer != boundLayer) {
+			list.bindPipeline(pipeline);
+			list.bindVertexBuffer(0, layer.vertexBuffer);
+			list.bindIndexBuffer(layer.indexBuffer);
+			memcpy(constants + 16, layer.color, sizeof(layer.color));
+			constants[19] = 1.0f;
+			boundLayer = entry.layer;
+		}
+		constants[20] = instances;
+		constants[21] = max(cell.count * fadeBand * budgetScale, 1.0f);
+		constants[22] = constants[23] = 0.0f;
+		list.bindVertexBuffer(1, layer.instanceBuffer, (size_t)cell.first * sizeof(ImpostorInstance));
+		list.setConstants(constants, sizeof(constants));
+		list.drawIndexed(layer.indexCount, count);
+		drawnInstances += count;
+	}
+}
+
+#pragma endregion
+
+#pragma region Benchmark
+
+// A blade of grass: a tapering strip of five triangles, facing +z.
+static ImpostorMesh makeGrassMesh()
+{
+	const float outline[][2] = { { -0.05f, 0.0f }, { 0.05f, 0.0f }, { -0.04f, 0.3f }, { 0.04f, 0.3f }, { -0.025f, 0.6f }, { 0.025f, 0.6f }, { 0.0f, 0.9f } };
+	ImpostorMesh mesh;
+	mesh.color[0] = 0.3f;
+	mesh.color[1] = 0.6f;
+	mesh.color[2] = 0.2f;
+	for (const float* point : outline) {
+		const float vertex[6] = { point[0], point[1], 0.0f, 0.0f, 0.3f, 0.95f };
+		mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + 6);
+	}
+	const uint32_t indices[] = { 0, 1, 3, 0, 3, 2, 2, 3, 5, 2, 5, 4, 4, 5, 6 };
+	mesh.indices.assign(indices, indices + sizeof(indices) / sizeof(indices[0]));
+	return mesh;
+}
+
+void runVegetationBenchmark(GLFWwindow* window, int instanceCount, int frames)
+{
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+	glfwSwapInterval(0); // Never wait for vertical sync while measuring.
+
+	GLRenderDevice device;
+	VegetationSystem vegetation(device);
+	if (!vegetation.init())
+		return;
+	const float clearColor[4] = { 0.529f, 0.808f, 0.980f, 1.0f };
+
+	// About eight blades per square unit over rolling ground.
+	mt19937 random(1234); // Fixed seed, so runs are comparable.
+	float side = sqrt(instanceCount / 8.0f);
+	uniform_real_distribution<float> coordinate(-side * 0.5f, side * 0.5f), scale(0.6f, 1.4f);
+	vector<ImpostorInstance> instances(instanceCount);
+	for (ImpostorInstance& instance : instances) {
+		instance.position[0] = coordinate(random);
+		instance.position[2] = coordinate(random);
+		instance.position[1] = 2.0f * sin(instance.position[0] * 0.05f) * cos(instance.position[2] * 0.05f);
+		instance.scale = scale(random);
+	}
+	VegetationLayerDesc grass;
+	grass.mesh = makeGrassMesh();
+	BenchmarkTimer buildTimer;
+	vegetation.addLayer(grass, instances);
+	cout << "BENCH::VEGETATION " << instanceCount << " blades over " << (int)side << "x" << (int)side << " units, built in "
+		<< buildTimer.elapsedMs() << " ms" << endl;
+
+	float projection[16];
+	perspectiveMatrix(1.047f, (float)width / height, 0.1f, side, projection);
+	GLuint query;
+	glGenQueries(1, &query);
+	CommandList* list = device.createCommandList();
+
+	struct Mode { const char* name; VegetationSettings settings; };
+	Mode modes[3];
+	modes[0].name = "VEGETATION::ALL_INSTANCES";
+	modes[0].settings.frustumCulling = false;
+	modes[0].settings.densityFalloff = false;
+	modes[0].settings.instanceBudget = UINT32_MAX;
+	modes[1].name = "VEGETATION::FRUSTUM_CULLED";
+	modes[1].settings.densityFalloff = false;
+	modes[1].settings.instanceBudget = UINT32_MAX;
+	modes[2].name = "VEGETATION::CULLED_FALLOFF_BUDGET";
+	modes[2].settings.instanceBudget = 400000;
+
+	for (Mode& mode : modes) {
+		vector<double> cpuSamples, gpuSamples;
+		for (int frame = 0; frame < frames; frame++) {
+			// Stand in the middle and turn, at head height.
+			float yaw = frame * 0.03f;
+			Vec3 eye(0.0f, 3.5f, 0.0f), target(sin(yaw), 3.2f, cos(yaw));
+			ImpostorView view;
+			float viewMatrix[16];
+			lookAtMatrix(eye, target, Vec3(0.0f, 1.0f, 0.0f), viewMatrix);
+			multiplyMatrix(projection, viewMatrix, view.viewProjection);
+			view.cameraPosition[0] = eye.x;
+			view.cameraPosition[1] = eye.y;
+			view.cameraPosition[2] = eye.z;
+
+			BenchmarkTimer cpuTimer;
+			list->begin();
+			vegetation.record(*list, view, mode.settings);
+			list->end();
+			device.beginFrame(width, height, clearColor);
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			device.submit(&list, 1);
+			glEndQuery(GL_TIME_ELAPSED);
+			device.endFrame();
+			cpuSamples.push_back(cpuTimer.elapsedMs());
+			GLuint64 gpuNanoseconds = 0; // Waits for the frame; fine while benchmarking.
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpuNanoseconds);
+			gpuSamples.push_back(gpuNanoseconds / 1.0e6);
+			glfwSwapBuffers(window);
+			glfwPollEvents();
+		}
+		string cpuName = string(mode.name) + "::CPU", gpuName = string(mode.name) + "::GPU";
+		printBenchmarkStats(cpuName.c_str(), computeBenchmarkStats(cpuSamples));
+		printBenchmarkStats(gpuName.c_str(), computeBenchmarkStats(gpuSamples));
+		cout << "  last frame: " << vegetation.getVisibleCells() << " cells, " << vegetation.getDrawnInstances() << " of "
+			<< vegetation.getTotalInstances() << " instances" << endl;
+	}
+
+	glDeleteQueries(1, &query);
+}
+
+#pragma endregion
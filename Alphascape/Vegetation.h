@@ -0,0 +1,84 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <cstdint> // Import the fixed width integers.
+#include <vector> // Import the vector container.
+
+#include "Graphics.h" // Import GLEW and GLFW.
+#include "Impostor.h" // Import the mesh and instance formats.
+#include "Math3D.h" // Import the vectors.
+#include "RenderDevice.h" // Import the render device interface.
+
+#pragma endregion
+
+// A kind of vegetation: its mesh (ImpostorMesh format) and how its density thins out with distance.
+struct VegetationLayerDesc
+{
+	ImpostorMesh mesh;
+	float cellSize = 16.0f; // Instances are bucketed into square cells this wide, in x and z.
+	float fadeStart = 30.0f; // Full density up to here...
+	float fadeEnd = 120.0f; // ...thinning to none here, where cells stop being drawn.
+};
+
+struct VegetationSettings
+{
+	bool frustumCulling = true;
+	bool densityFalloff = true;
+	uint32_t instanceBudget = 1000000; // At most this many instances are drawn; all cells thin evenly to fit.
+};
+
+// Draws large numbers of static instances (grass, shrubs, trees) with a draw per visible cell and no per-instance
+// CPU work at all.
+//
+// Each layer's instances are bucketed by cell into one static instance buffer, each cell's range shuffled. A cell is
+// culled against the view frustum by its bounding box, and thinned by drawing only a prefix of its range: because the
+// range is shuffled, any prefix is an even sample of the cell. Instances near the end of the prefix are shrunk in the
+// vertex shader, so density changes never pop. Culling runs on the CPU; cells are coarse enough that it costs
+// microseconds for millions of instances.
+class VegetationSystem
+{
+public:
+	explicit VegetationSystem(RenderDevice& device);
+	~VegetationSystem();
+
+	// Create the pipeline. Returns false if it does not compile.
+	bool init();
+
+	// Bucket, shuffle and upload a layer's instances. Returns the layer index.
+	uint32_t addLayer(const VegetationLayerDesc& desc, const std::vector<ImpostorInstance>& instances);
+
+	// Cull and record every layer. view supplies the camera; its impostor distance is unused.
+	void record(CommandList& list, const ImpostorView& view, const VegetationSettings& settings);
+
+	// Counts of the last record().
+	uint32_t getVisibleCells() const { return (uint32_t)visible.size(); }
+	uint64_t getDrawnInstances() const { return drawnInstances; }
+	uint64_t getTotalInstances() const { return totalInstances; }
+
+private:
+	struct Cell
+	{
+		uint32_t first = 0, count = 0; // Range in the layer's instance buffer.
+		Vec3 low, high; // Bounds of the instances' meshes.
+	};
+	struct Layer
+	{
+		BufferHandle vertexBuffer, indexBuffer, instanceBuffer;
+		uint32_t indexCount = 0;
+		float color[3] = {};
+		float fadeStart = 0.0f, fadeEnd = 0.0f;
+		std::vector<Cell> cells;
+	};
+	struct VisibleCell { uint32_t layer, cell, count; float instances; }; // instances: the fractional prefix to draw.
+
+	RenderDevice& device;
+	PipelineHandle pipeline;
+	std::vector<Layer> layers;
+	std::vector<VisibleCell> visible; // Reused every frame.
+	uint64_t drawnInstances = 0, totalInstances = 0;
+};
+
+// Scatter instanceCount grass blades over rolling ground and draw them from a turning camera with no culling, with
+// frustum culling, and with culling, density falloff and an instance budget. Prints CPU and GPU times and counts.
+void runVegetationBenchmark(GLFWwindow* window, int instanceCount, int frames);
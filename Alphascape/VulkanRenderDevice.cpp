@@ -0,0 +1,1127 @@
+#pragma region Library Imports
+
+#include <cstring> // Import memcpy.
+#include <iostream> // Import the IO stream libraries.
+#include <mutex> // Import the mutex.
+#include <unordered_map> // Import the hash map.
+#include <vector> // Import the vector container.
+
+#include "VulkanRenderDevice.h" // Import the Vulkan render device.
+
+#ifdef ALPHASCAPE_VULKAN
+#include <vulkan/vulkan.h> // Import the Vulkan API.
+#endif
+
+using namespace std; // Use the standard namespace.
+
+#pragma endregion
+
+#ifndef ALPHASCAPE_VULKAN
+
+unique_ptr<RenderDevice> createVulkanRenderDevice(int, int)
+{
+	cout << "ERROR::VULKAN::NOT_COMPILED_IN\nBuild with ALPHASCAPE_VULKAN defined and the Vulkan SDK available (the CMake build does by default)." << endl;
+	return nullptr;
+}
+
+#else
+
+#pragma region Helpers
+
+// Print an ERROR::VULKAN message for a failed call. Returns true if the call succeeded.
+static bool vulkanCheck(VkResult result, const char* what)
+{
+	if (result != VK_SUCCESS)
+		cout << "ERROR::VULKAN::" << what << "\n" << (int)result << endl;
+	return result == VK_SUCCESS;
+}
+
+static VkFormat vulkanFormat(TextureFormat format, size_t& bytesPerPixel)
+{
+	switch (format)
+	{
+	case TextureFormat::RGBA16F: bytesPerPixel = 8; return VK_FORMAT_R16G16B16A16_SFLOAT;
+	case TextureFormat::R16F: bytesPerPixel = 2; return VK_FORMAT_R16_SFLOAT;
+	default: bytesPerPixel = 4; return VK_FORMAT_R8G8B8A8_UNORM;
+	}
+}
+
+static VkSamplerAddressMode vulkanWrap(SamplerWrap wrap)
+{
+	switch (wrap)
+	{
+	case SamplerWrap::ClampToEdge: return VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	case SamplerWrap::MirroredRepeat: return VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
+	default: return VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	}
+}
+
+static VkFormat vulkanAttributeFormat(uint32_t components)
+{
+	switch (components)
+	{
+	case 1: return VK_FORMAT_R32_SFLOAT;
+	case 2: return VK_FORMAT_R32G32_SFLOAT;
+	case 3: return VK_FORMAT_R32G32B32_SFLOAT;
+	default: return VK_FORMAT_R32G32B32A32_SFLOAT;
+	}
+}
+
+#pragma endregion
+
+class VulkanRenderDevice;
+
+#pragma region Command List
+
+// Records one secondary command buffer from its own pool, so each recording thread needs no synchronisation.
+class VulkanCommandList : public CommandList
+{
+public:
+	VulkanCommandList(VulkanRenderDevice& owner);
+	~VulkanCommandList() override;
+
+	void begin() override;
+	void end() override;
+	void bindPipeline(PipelineHandle pipeline) override;
+	void bindVertexBuffer(uint32_t binding, BufferHandle buffer, size_t offset) override;
+	void bindIndexBuffer(BufferHandle buffer) override;
+	void bindTexture(uint32_t unit, TextureHandle texture, SamplerHandle sampler) override;
+	void bindUniformBuffer(uint32_t slot, BufferHandle buffer) override;
+	void setConstants(const void* data, size_t size) override;
+	void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex) override;
+	void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex) override;
+
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	RenderStats stats; // Per list, since lists record concurrently; merged by submit().
+
+private:
+	VulkanRenderDevice& device;
+	VkCommandPool pool = VK_NULL_HANDLE;
+	uint32_t boundPipeline = 0; // Binding the same pipeline again is skipped.
+};
+
+#pragma endregion
+
+#pragma region Device
+
+class VulkanRenderDevice : public RenderDevice
+{
+public:
+	~VulkanRenderDevice() override;
+
+	bool init(int width, int height);
+
+	const char* getBackendName() const override { return backendName.c_str(); }
+
+	BufferHandle createBuffer(const BufferDesc& desc) override;
+	void updateBuffer(BufferHandle buffer, size_t offset, const void* data, size_t size) override;
+	void destroyBuffer(BufferHandle buffer) override;
+
+	TextureHandle createTexture(const TextureDesc& desc) override;
+	void destroyTexture(TextureHandle texture) override;
+
+	PipelineHandle createPipeline(const PipelineDesc& desc) override;
+	void destroyPipeline(PipelineHandle pipeline) override;
+
+	CommandList* createCommandList() override;
+
+	void beginFrame(int width, int height, const float clearColor[4]) override;
+	void submit(CommandList* const* lists, size_t count) override;
+	void endFrame() override;
+	bool readPixels(int x, int y, int width, int height, void* rgba) override;
+
+protected:
+	SamplerHandle createSamplerObject(const SamplerDesc& desc) override;
+
+private:
+	friend class VulkanCommandList;
+
+	struct VulkanBuffer { VkBuffer buffer = VK_NULL_HANDLE; VkDeviceMemory memory = VK_NULL_HANDLE; void* mapped = nullptr; VkDescriptorSet uniformSet = VK_NULL_HANDLE; };
+	struct VulkanTexture { VkImage image = VK_NULL_HANDLE; VkDeviceMemory memory = VK_NULL_HANDLE; VkImageView view = VK_NULL_HANDLE; VkSampler sampler = VK_NULL_HANDLE; VkDescriptorSet descriptorSet = VK_NULL_HANDLE; };
+
+	uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const;
+	bool createBufferObject(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VulkanBuffer& buffer);
+	bool createImage(uint32_t imageWidth, uint32_t imageHeight, uint32_t layers, VkFormat format, VkImageUsageFlags usage, VkImage& image, VkDeviceMemory& memory);
+	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspect, uint32_t layers, bool array = false);
+	VkDescriptorSet getTextureSet(TextureHandle texture, SamplerHandle sampler);
+	VkCommandBuffer beginOneShot();
+	void endOneShot(VkCommandBuffer commandBuffer);
+
+	string backendName = "Vulkan";
+	int width = 0, height = 0;
+
+	VkInstance instance = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	bool fillModeNonSolid = false;
+	float maxAnisotropy = 1.0f; // 1 when samplerAnisotropy is unsupported.
+	VkDevice device = VK_NULL_HANDLE;
+	uint32_t queueFamily = 0;
+	VkQueue queue = VK_NULL_HANDLE;
+
+	// The offscreen target.
+	VkImage colorImage = VK_NULL_HANDLE, depthImage = VK_NULL_HANDLE;
+	VkDeviceMemory colorMemory = VK_NULL_HANDLE, depthMemory = VK_NULL_HANDLE;
+	VkImageView colorView = VK_NULL_HANDLE, depthView = VK_NULL_HANDLE;
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	VkFramebuffer framebuffer = VK_NULL_HANDLE;
+	VulkanBuffer readbackBuffer;
+	bool frameRendered = false;
+
+	// Shared pipeline layout: set 0 is one combined image sampler, set 1 one uniform buffer, plus
+	// CommandList::MaxConstantsSize bytes of push constants.
+	VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+	VkDescriptorSetLayout uniformSetLayout = VK_NULL_HANDLE;
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+
+	// Frame submission.
+	VkCommandPool primaryPool = VK_NULL_HANDLE;
+	VkCommandPool oneShotPool = VK_NULL_HANDLE;
+	VkCommandBuffer primaryBuffer = VK_NULL_HANDLE;
+	VkFence fence = VK_NULL_HANDLE;
+	VkClearValue clearValues[2];
+	vector<VkCommandBuffer> pendingLists;
+
+	vector<VulkanBuffer> buffers;
+	vector<VulkanTexture> textures;
+	vector<VkPipeline> pipelines;
+	vector<VkSampler> samplers;
+	vector<unique_ptr<VulkanCommandList>> commandLists;
+
+	// Descriptor sets for textures bound with a sampler object, made on first use (by any recording thread).
+	mutex samplerSetMutex;
+	unordered_map<uint64_t, VkDescriptorSet> samplerSets; // By texture id << 32 | sampler id.
+};
+
+bool VulkanRenderDevice::init(int targetWidth, int targetHeight)
+{
+	width = targetWidth;
+	height = targetHeight;
+
+	#pragma region Instance and Device
+
+	VkApplicationInfo applicationInfo = {};
+	applicationInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	applicationInfo.pApplicationName = "Alphascape";
+	applicationInfo.pEngineName = "Alphascape";
+	applicationInfo.apiVersion = VK_API_VERSION_1_0;
+
+	VkInstanceCreateInfo instanceInfo = {};
+	instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	instanceInfo.pApplicationInfo = &applicationInfo; // Headless: no surface extensions needed.
+	if (!vulkanCheck(vkCreateInstance(&instanceInfo, nullptr, &instance), "CREATE_INSTANCE"))
+		return false;
+
+	uint32_t deviceCount = 0;
+	vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+	vector<VkPhysicalDevice> physicalDevices(deviceCount);
+	vkEnumeratePhysicalDevices(instance, &deviceCount, physicalDevices.data());
+	for (VkPhysicalDevice candidate : physicalDevices) { // The first device with a graphics queue.
+		uint32_t familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, nullptr);
+		vector<VkQueueFamilyProperties> families(familyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, families.data());
+		for (uint32_t family = 0; family < familyCount; family++) {
+			if (families[family].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+				physicalDevice = candidate;
+				queueFamily = family;
+				break;
+			}
+		}
+		if (physicalDevice != VK_NULL_HANDLE)
+			break;
+	}
+	if (physicalDevice == VK_NULL_HANDLE) {
+		cout << "ERROR::VULKAN::NO_GRAPHICS_DEVICE" << endl;
+		return false;
+	}
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	backendName = string("Vulkan (") + properties.deviceName + ")";
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+	VkPhysicalDeviceFeatures supported;
+	vkGetPhysicalDeviceFeatures(physicalDevice, &supported);
+	VkPhysicalDeviceFeatures enabled = {};
+	enabled.fillModeNonSolid = supported.fillModeNonSolid; // Needed for wireframe pipelines.
+	fillModeNonSolid = supported.fillModeNonSolid == VK_TRUE;
+	enabled.samplerAnisotropy = supported.samplerAnisotropy;
+	maxAnisotropy = supported.samplerAnisotropy ? properties.limits.maxSamplerAnisotropy : 1.0f;
+
+	float priority = 1.0f;
+	VkDeviceQueueCreateInfo queueInfo = {};
+	queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	queueInfo.queueFamilyIndex = queueFamily;
+	queueInfo.queueCount = 1;
+	queueInfo.pQueuePriorities = &priority;
+
+	VkDeviceCreateInfo deviceInfo = {};
+	deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	deviceInfo.queueCreateInfoCount = 1;
+	deviceInfo.pQueueCreateInfos = &queueInfo;
+	deviceInfo.pEnabledFeatures = &enabled;
+	if (!vulkanCheck(vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device), "CREATE_DEVICE"))
+		return false;
+	vkGetDeviceQueue(device, queueFamily, 0, &queue);
+
+	#pragma endregion
+
+	#pragma region Offscreen Target
+
+	if (!createImage(width, height, 1, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, colorImage, colorMemory) ||
+		!createImage(width, height, 1, VK_FORMAT_D32_SFLOAT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, depthImage, depthMemory))
+		return false;
+	colorView = createImageView(colorImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+	depthView = createImageView(depthImage, VK_FORMAT_D32_SFLOAT, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
+
+	VkAttachmentDescription attachments[2] = {};
+	attachments[0].format = VK_FORMAT_R8G8B8A8_UNORM;
+	attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+	attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachments[0].finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL; // Ready for readPixels.
+	attachments[1].format = VK_FORMAT_D32_SFLOAT;
+	attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+	attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+	VkAttachmentReference depthReference = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+	VkSubpassDescription subpass = {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colorReference;
+	subpass.pDepthStencilAttachment = &depthReference;
+
+	VkSubpassDependency dependencies[2] = {};
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL; // Previous frame's readback before this frame's writes.
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[1].srcSubpass = 0; // This frame's writes before the readback copy.
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = 2;
+	renderPassInfo.pAttachments = attachments;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = 2;
+	renderPassInfo.pDependencies = dependencies;
+	if (!vulkanCheck(vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass), "CREATE_RENDER_PASS"))
+		return false;
+
+	VkImageView views[] = { colorView, depthView };
+	VkFramebufferCreateInfo framebufferInfo = {};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = renderPass;
+	framebufferInfo.attachmentCount = 2;
+	framebufferInfo.pAttachments = views;
+	framebufferInfo.width = width;
+	framebufferInfo.height = height;
+	framebufferInfo.layers = 1;
+	if (!vulkanCheck(vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffer), "CREATE_FRAMEBUFFER"))
+		return false;
+
+	if (!createBufferObject((VkDeviceSize)width * height * 4, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readbackBuffer))
+		return false;
+
+	#pragma endregion
+
+	#pragma region Layouts and Pools
+
+	VkDescriptorSetLayoutBinding textureBinding = {};
+	textureBinding.binding = 0;
+	textureBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	textureBinding.descriptorCount = 1;
+	textureBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+	setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	setLayoutInfo.bindingCount = 1;
+	setLayoutInfo.pBindings = &textureBinding;
+	if (!vulkanCheck(vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &descriptorSetLayout), "CREATE_DESCRIPTOR_SET_LAYOUT"))
+		return false;
+
+	VkDescriptorSetLayoutBinding uniformBinding = {};
+	uniformBinding.binding = 0;
+	uniformBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uniformBinding.descriptorCount = 1;
+	uniformBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	setLayoutInfo.pBindings = &uniformBinding;
+	if (!vulkanCheck(vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &uniformSetLayout), "CREATE_DESCRIPTOR_SET_LAYOUT"))
+		return false;
+	VkDescriptorSetLayout setLayouts[] = { descriptorSetLayout, uniformSetLayout };
+
+	VkPushConstantRange constantsRange = {};
+	constantsRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	constantsRange.size = CommandList::MaxConstantsSize;
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = 2;
+	layoutInfo.pSetLayouts = setLayouts;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &constantsRange;
+	if (!vulkanCheck(vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout), "CREATE_PIPELINE_LAYOUT"))
+		return false;
+
+	VkDescriptorPoolSize poolSizes[] = { { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1024 }, { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 256 } };
+	VkDescriptorPoolCreateInfo descriptorPoolInfo = {};
+	descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptorPoolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+	descriptorPoolInfo.maxSets = 1280;
+	descriptorPoolInfo.poolSizeCount = 2;
+	descriptorPoolInfo.pPoolSizes = poolSizes;
+	if (!vulkanCheck(vkCreateDescriptorPool(device, &descriptorPoolInfo, nullptr, &descriptorPool), "CREATE_DESCRIPTOR_POOL"))
+		return false;
+
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = queueFamily;
+	if (!vulkanCheck(vkCreateCommandPool(device, &poolInfo, nullptr, &primaryPool), "CREATE_COMMAND_POOL") ||
+		!vulkanCheck(vkCreateCommandPool(device, &poolInfo, nullptr, &oneShotPool), "CREATE_COMMAND_POOL"))
+		return false;
+
+	VkCommandBufferAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = primaryPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = 1;
+	if (!vulkanCheck(vkAllocateCommandBuffers(device, &allocateInfo, &primaryBuffer), "ALLOCATE_COMMAND_BUFFERS"))
+		return false;
+
+	VkFenceCreateInfo fenceInfo = {};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	if (!vulkanCheck(vkCreateFence(device, &fenceInfo, nullptr, &fence), "CREATE_FENCE"))
+		return false;
+
+	#pragma endregion
+
+	clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+	clearValues[1].depthStencil = { 1.0f, 0 };
+	return true;
+}
+
+VulkanRenderDevice::~VulkanRenderDevice()
+{
+	if (device == VK_NULL_HANDLE) {
+		if (instance != VK_NULL_HANDLE)
+			vkDestroyInstance(instance, nullptr);
+		return;
+	}
+	vkDeviceWaitIdle(device);
+
+	commandLists.clear(); // Destroys their pools.
+	for (size_t i = 0; i < buffers.size(); i++)
+		destroyBuffer(BufferHandle{ (uint32_t)i + 1 });
+	for (size_t i = 0; i < textures.size(); i++)
+		destroyTexture(TextureHandle{ (uint32_t)i + 1 });
+	for (size_t i = 0; i < pipelines.size(); i++)
+		destroyPipeline(PipelineHandle{ (uint32_t)i + 1 });
+	for (VkSampler sampler : samplers)
+		vkDestroySampler(device, sampler, nullptr);
+
+	vkDestroyBuffer(device, readbackBuffer.buffer, nullptr);
+	vkFreeMemory(device, readbackBuffer.memory, nullptr);
+	vkDestroyFence(device, fence, nullptr);
+	vkDestroyCommandPool(device, primaryPool, nullptr);
+	vkDestroyCommandPool(device, oneShotPool, nullptr);
+	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+	vkDestroyDescriptorSetLayout(device, uniformSetLayout, nullptr);
+	vkDestroyFramebuffer(device, framebuffer, nullptr);
+	vkDestroyRenderPass(device, renderPass, nullptr);
+	vkDestroyImageView(device, colorView, nullptr);
+	vkDestroyImageView(device, depthView, nullptr);
+	vkDestroyImage(device, colorImage, nullptr);
+	vkDestroyImage(device, depthImage, nullptr);
+	vkFreeMemory(device, colorMemory, nullptr);
+	vkFreeMemory(device, depthMemory, nullptr);
+	vkDestroyDevice(device, nullptr);
+	vkDestroyInstance(instance, nullptr);
+}
+
+#pragma endregion
+
+#pragma region Memory, Images and One-Shot Commands
+
+uint32_t VulkanRenderDevice::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const
+{
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+		if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			return i;
+	}
+	cout << "ERROR::VULKAN::NO_MEMORY_TYPE\n" << properties << endl;
+	return 0;
+}
+
+bool VulkanRenderDevice::createBufferObject(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VulkanBuffer& buffer)
+{
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = size;
+	bufferInfo.usage = usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (!vulkanCheck(vkCreateBuffer(device, &bufferInfo, nullptr, &buffer.buffer), "CREATE_BUFFER"))
+		return false;
+
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(device, buffer.buffer, &requirements);
+	VkMemoryAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = requirements.size;
+	allocateInfo.memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+	if (!vulkanCheck(vkAllocateMemory(device, &allocateInfo, nullptr, &buffer.memory), "ALLOCATE_MEMORY"))
+		return false;
+	vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0);
+	if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		vkMapMemory(device, buffer.memory, 0, VK_WHOLE_SIZE, 0, &buffer.mapped); // Persistently mapped.
+	return true;
+}
+
+bool VulkanRenderDevice::createImage(uint32_t imageWidth, uint32_t imageHeight, uint32_t layers, VkFormat format, VkImageUsageFlags usage, VkImage& image, VkDeviceMemory& memory)
+{
+	VkImageCreateInfo imageInfo = {};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = format;
+	imageInfo.extent = { imageWidth, imageHeight, 1 };
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = layers;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = usage;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	if (!vulkanCheck(vkCreateImage(device, &imageInfo, nullptr, &image), "CREATE_IMAGE"))
+		return false;
+
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(device, image, &requirements);
+	VkMemoryAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = requirements.size;
+	allocateInfo.memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	if (!vulkanCheck(vkAllocateMemory(device, &allocateInfo, nullptr, &memory), "ALLOCATE_MEMORY"))
+		return false;
+	vkBindImageMemory(device, image, memory, 0);
+	return true;
+}
+
+VkImageView VulkanRenderDevice::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspect, uint32_t layers, bool array)
+{
+	VkImageViewCreateInfo viewInfo = {};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = image;
+	viewInfo.viewType = layers > 1 || array ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = format;
+	viewInfo.subresourceRange = { aspect, 0, 1, 0, layers };
+	VkImageView view = VK_NULL_HANDLE;
+	vulkanCheck(vkCreateImageView(device, &viewInfo, nullptr, &view), "CREATE_IMAGE_VIEW");
+	return view;
+}
+
+VkCommandBuffer VulkanRenderDevice::beginOneShot()
+{
+	VkCommandBufferAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = oneShotPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = 1;
+	VkCommandBuffer commandBuffer;
+	vkAllocateCommandBuffers(device, &allocateInfo, &commandBuffer);
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+	return commandBuffer;
+}
+
+void VulkanRenderDevice::endOneShot(VkCommandBuffer commandBuffer)
+{
+	vkEndCommandBuffer(commandBuffer);
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	vulkanCheck(vkQueueSubmit(queue, 1, &submitInfo, fence), "QUEUE_SUBMIT");
+	vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+	vkResetFences(device, 1, &fence);
+	vkFreeCommandBuffers(device, oneShotPool, 1, &commandBuffer);
+}
+
+#pragma endregion
+
+#pragma region Resources
+
+BufferHandle VulkanRenderDevice::createBuffer(const BufferDesc& desc)
+{
+	VkBufferUsageFlags usage = desc.usage == BufferUsage::Index ? VK_BUFFER_USAGE_INDEX_BUFFER_BIT
+		: desc.usage == BufferUsage::Uniform ? VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT : VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+	VulkanBuffer buffer;
+	if (!createBufferObject(desc.size, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer))
+		return BufferHandle();
+	if (desc.initialData)
+		memcpy(buffer.mapped, desc.initialData, desc.size);
+
+	if (desc.usage == BufferUsage::Uniform) { // Uniform buffers carry their own set 1, like textures carry set 0.
+		VkDescriptorSetAllocateInfo setInfo = {};
+		setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		setInfo.descriptorPool = descriptorPool;
+		setInfo.descriptorSetCount = 1;
+		setInfo.pSetLayouts = &uniformSetLayout;
+		if (vulkanCheck(vkAllocateDescriptorSets(device, &setInfo, &buffer.uniformSet), "ALLOCATE_DESCRIPTOR_SETS")) {
+			VkDescriptorBufferInfo bufferInfo = { buffer.buffer, 0, VK_WHOLE_SIZE };
+			VkWriteDescriptorSet write = {};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = buffer.uniformSet;
+			write.descriptorCount = 1;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			write.pBufferInfo = &bufferInfo;
+			vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+		}
+	}
+	buffers.push_back(buffer);
+	return BufferHandle{ (uint32_t)buffers.size() };
+}
+
+void VulkanRenderDevice::updateBuffer(BufferHandle handle, size_t offset, const void* data, size_t size)
+{
+	// Host coherent: the write is visible to the next submission. The caller must not update a buffer the GPU is
+	// still reading; endFrame() waits for the frame, so updates between frames are safe.
+	memcpy((char*)buffers[handle.id - 1].mapped + offset, data, size);
+}
+
+void VulkanRenderDevice::destroyBuffer(BufferHandle handle)
+{
+	if (!handle.valid())
+		return;
+	VulkanBuffer& buffer = buffers[handle.id - 1];
+	if (buffer.buffer == VK_NULL_HANDLE)
+		return;
+	vkDeviceWaitIdle(device);
+	if (buffer.uniformSet != VK_NULL_HANDLE)
+		vkFreeDescriptorSets(device, descriptorPool, 1, &buffer.uniformSet);
+	vkDestroyBuffer(device, buffer.buffer, nullptr);
+	vkFreeMemory(device, buffer.memory, nullptr);
+	buffer = VulkanBuffer();
+}
+
+TextureHandle VulkanRenderDevice::createTexture(const TextureDesc& desc)
+{
+	size_t bytesPerPixel;
+	VkFormat format = vulkanFormat(desc.format, bytesPerPixel);
+	uint32_t layers = (uint32_t)desc.layers;
+
+	VulkanTexture texture;
+	if (!createImage(desc.width, desc.height, layers, format, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, texture.image, texture.memory))
+		return TextureHandle();
+	texture.view = createImageView(texture.image, format, VK_IMAGE_ASPECT_COLOR_BIT, layers, desc.array);
+
+	// Upload through a staging buffer (or just transition, without data), leaving the image ready for sampling.
+	VkDeviceSize size = (VkDeviceSize)desc.width * desc.height * layers * bytesPerPixel;
+	VulkanBuffer staging;
+	if (desc.initialData) {
+		if (!createBufferObject(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging))
+			return TextureHandle();
+		memcpy(staging.mapped, desc.initialData, (size_t)size);
+	}
+	VkCommandBuffer commandBuffer = beginOneShot();
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = texture.image;
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, layers };
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	if (desc.initialData) {
+		VkBufferImageCopy region = {};
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, layers };
+		region.imageExtent = { (uint32_t)desc.width, (uint32_t)desc.height, 1 };
+		vkCmdCopyBufferToImage(commandBuffer, staging.buffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	}
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	endOneShot(commandBuffer);
+	if (desc.initialData) {
+		vkDestroyBuffer(device, staging.buffer, nullptr);
+		vkFreeMemory(device, staging.memory, nullptr);
+	}
+
+	VkSamplerCreateInfo samplerInfo = {};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = samplerInfo.minFilter = desc.linearFilter ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+	samplerInfo.addressModeU = samplerInfo.addressModeV = samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.maxLod = 0.0f;
+	vulkanCheck(vkCreateSampler(device, &samplerInfo, nullptr, &texture.sampler), "CREATE_SAMPLER");
+
+	// Each texture owns a ready-made descriptor set, so binding it is a single vkCmdBindDescriptorSets.
+	VkDescriptorSetAllocateInfo setInfo = {};
+	setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setInfo.descriptorPool = descriptorPool;
+	setInfo.descriptorSetCount = 1;
+	setInfo.pSetLayouts = &descriptorSetLayout;
+	if (!vulkanCheck(vkAllocateDescriptorSets(device, &setInfo, &texture.descriptorSet), "ALLOCATE_DESCRIPTOR_SETS"))
+		return TextureHandle();
+	VkDescriptorImageInfo imageInfo = { texture.sampler, texture.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = texture.descriptorSet;
+	write.dstBinding = 0;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &imageInfo;
+	vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+	textures.push_back(texture);
+	return TextureHandle{ (uint32_t)textures.size() };
+}
+
+void VulkanRenderDevice::destroyTexture(TextureHandle handle)
+{
+	if (!handle.valid())
+		return;
+	VulkanTexture& texture = textures[handle.id - 1];
+	if (texture.image == VK_NULL_HANDLE)
+		return;
+	vkDeviceWaitIdle(device);
+	vkFreeDescriptorSets(device, descriptorPool, 1, &texture.descriptorSet);
+	for (auto entry = samplerSets.begin(); entry != samplerSets.end();) { // Its sets with sampler objects too.
+		if ((entry->first >> 32) == handle.id) {
+			vkFreeDescriptorSets(device, descriptorPool, 1, &entry->second);
+			entry = samplerSets.erase(entry);
+		} else {
+			++entry;
+		}
+	}
+	vkDestroySampler(device, texture.sampler, nullptr);
+	vkDestroyImageView(device, texture.view, nullptr);
+	vkDestroyImage(device, texture.image, nullptr);
+	vkFreeMemory(device, texture.memory, nullptr);
+	texture = VulkanTexture();
+}
+
+PipelineHandle VulkanRenderDevice::createPipeline(const PipelineDesc& desc)
+{
+	if (desc.vertexSpirv.empty() || desc.fragmentSpirv.empty()) {
+		cout << "ERROR::VULKAN::MISSING_SPIRV" << endl;
+		return PipelineHandle();
+	}
+
+	// Shader stages.
+	VkShaderModule modules[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+	const vector<uint32_t>* code[2] = { &desc.vertexSpirv, &desc.fragmentSpirv };
+	for (int i = 0; i < 2; i++) {
+		VkShaderModuleCreateInfo moduleInfo = {};
+		moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		moduleInfo.codeSize = code[i]->size() * sizeof(uint32_t);
+		moduleInfo.pCode = code[i]->data();
+		if (!vulkanCheck(vkCreateShaderModule(device, &moduleInfo, nullptr, &modules[i]), "CREATE_SHADER_MODULE")) {
+			vkDestroyShaderModule(device, modules[0], nullptr);
+			return PipelineHandle();
+		}
+	}
+	VkPipelineShaderStageCreateInfo stages[2] = {};
+	for (int i = 0; i < 2; i++) {
+		stages[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		stages[i].stage = i == 0 ? VK_SHADER_STAGE_VERTEX_BIT : VK_SHADER_STAGE_FRAGMENT_BIT;
+		stages[i].module = modules[i];
+		stages[i].pName = "main";
+	}
+
+	// Vertex input: binding 0 per vertex, binding 1 per instance.
+	vector<VkVertexInputBindingDescription> bindings;
+	vector<VkVertexInputAttributeDescription> attributes;
+	bool bindingUsed[2] = { false, false };
+	for (uint32_t i = 0; i < desc.layout.attributeCount; i++) {
+		const VertexAttribute& attribute = desc.layout.attributes[i];
+		VkVertexInputAttributeDescription description = { attribute.location, attribute.binding, vulkanAttributeFormat(attribute.components), attribute.offset };
+		attributes.push_back(description);
+		bindingUsed[attribute.binding] = true;
+	}
+	for (uint32_t binding = 0; binding < 2; binding++) {
+		if (bindingUsed[binding]) {
+			VkVertexInputBindingDescription description = { binding, desc.layout.strides[binding], binding == 1 ? VK_VERTEX_INPUT_RATE_INSTANCE : VK_VERTEX_INPUT_RATE_VERTEX };
+			bindings.push_back(description);
+		}
+	}
+	VkPipelineVertexInputStateCreateInfo vertexInput = {};
+	vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInput.vertexBindingDescriptionCount = (uint32_t)bindings.size();
+	vertexInput.pVertexBindingDescriptions = bindings.data();
+	vertexInput.vertexAttributeDescriptionCount = (uint32_t)attributes.size();
+	vertexInput.pVertexAttributeDescriptions = attributes.data();
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = desc.topology == PrimitiveTopology::TriangleStrip ? VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	VkPipelineViewportStateCreateInfo viewport = {};
+	viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewport.viewportCount = 1; // Dynamic.
+	viewport.scissorCount = 1;
+
+	VkPipelineRasterizationStateCreateInfo rasterization = {};
+	rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterization.polygonMode = desc.wireframe && fillModeNonSolid ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL;
+	rasterization.cullMode = VK_CULL_MODE_NONE; // Match the GL default.
+	rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterization.lineWidth = 1.0f;
+
+	VkPipelineMultisampleStateCreateInfo multisample = {};
+	multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.depthTestEnable = desc.depthTest ? VK_TRUE : VK_FALSE;
+	depthStencil.depthWriteEnable = desc.depthWrite ? VK_TRUE : VK_FALSE;
+	const VkCompareOp compareOps[] = { VK_COMPARE_OP_LESS, VK_COMPARE_OP_LESS_OR_EQUAL, VK_COMPARE_OP_EQUAL, VK_COMPARE_OP_ALWAYS };
+	depthStencil.depthCompareOp = compareOps[(int)desc.depthCompare];
+
+	VkPipelineColorBlendAttachmentState blendAttachment = {};
+	blendAttachment.colorWriteMask = desc.colorWrite ? VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT : 0;
+	if (desc.blend != BlendMode::Opaque) {
+		blendAttachment.blendEnable = VK_TRUE;
+		blendAttachment.srcColorBlendFactor = desc.blend == BlendMode::Alpha ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+		blendAttachment.dstColorBlendFactor = desc.blend == BlendMode::Alpha ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+		blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		blendAttachment.srcAlphaBlendFactor = blendAttachment.srcColorBlendFactor;
+		blendAttachment.dstAlphaBlendFactor = blendAttachment.dstColorBlendFactor;
+		blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+	}
+	VkPipelineColorBlendStateCreateInfo colorBlend = {};
+	colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlend.attachmentCount = 1;
+	colorBlend.pAttachments = &blendAttachment;
+
+	VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamic = {};
+	dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamic.dynamicStateCount = 2;
+	dynamic.pDynamicStates = dynamicStates;
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = stages;
+	pipelineInfo.pVertexInputState = &vertexInput;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewport;
+	pipelineInfo.pRasterizationState = &rasterization;
+	pipelineInfo.pMultisampleState = &multisample;
+	pipelineInfo.pDepthStencilState = &depthStencil;
+	pipelineInfo.pColorBlendState = &colorBlend;
+	pipelineInfo.pDynamicState = &dynamic;
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.renderPass = renderPass;
+	pipelineInfo.subpass = 0;
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	bool created = vulkanCheck(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline), "CREATE_GRAPHICS_PIPELINES");
+	vkDestroyShaderModule(device, modules[0], nullptr);
+	vkDestroyShaderModule(device, modules[1], nullptr);
+	if (!created)
+		return PipelineHandle();
+	pipelines.push_back(pipeline);
+	return PipelineHandle{ (uint32_t)pipelines.size() };
+}
+
+void VulkanRenderDevice::destroyPipeline(PipelineHandle handle)
+{
+	if (!handle.valid() || pipelines[handle.id - 1] == VK_NULL_HANDLE)
+		return;
+	vkDeviceWaitIdle(device);
+	vkDestroyPipeline(device, pipelines[handle.id - 1], nullptr);
+	pipelines[handle.id - 1] = VK_NULL_HANDLE;
+}
+
+SamplerHandle VulkanRenderDevice::createSamplerObject(const SamplerDesc& desc)
+{
+	VkSamplerCreateInfo samplerInfo = {};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = desc.magFilter == SamplerFilter::Linear ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+	samplerInfo.minFilter = desc.minFilter == SamplerFilter::Linear ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = desc.minFilter == SamplerFilter::Linear ? VK_SAMPLER_MIPMAP_MODE_LINEAR : VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = vulkanWrap(desc.wrapU);
+	samplerInfo.addressModeV = vulkanWrap(desc.wrapV);
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.anisotropyEnable = desc.maxAnisotropy > 1.0f && maxAnisotropy > 1.0f ? VK_TRUE : VK_FALSE;
+	samplerInfo.maxAnisotropy = desc.maxAnisotropy < maxAnisotropy ? desc.maxAnisotropy : maxAnisotropy;
+	samplerInfo.maxLod = desc.mipmaps ? VK_LOD_CLAMP_NONE : 0.0f;
+	VkSampler sampler;
+	if (!vulkanCheck(vkCreateSampler(device, &samplerInfo, nullptr, &sampler), "CREATE_SAMPLER"))
+		return SamplerHandle();
+	samplers.push_back(sampler);
+	return SamplerHandle{ (uint32_t)samplers.size() };
+}
+
+VkDescriptorSet VulkanRenderDevice::getTextureSet(TextureHandle texture, SamplerHandle sampler)
+{
+	if (!sampler.valid())
+		return textures[texture.id - 1].descriptorSet;
+
+	lock_guard<mutex> lock(samplerSetMutex); // Lists record concurrently, and the pool needs external synchronisation.
+	uint64_t key = (uint64_t)texture.id << 32 | sampler.id;
+	auto found = samplerSets.find(key);
+	if (found != samplerSets.end())
+		return found->second;
+
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	VkDescriptorSetAllocateInfo setInfo = {};
+	setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setInfo.descriptorPool = descriptorPool;
+	setInfo.descriptorSetCount = 1;
+	setInfo.pSetLayouts = &descriptorSetLayout;
+	if (!vulkanCheck(vkAllocateDescriptorSets(device, &setInfo, &set), "ALLOCATE_DESCRIPTOR_SETS"))
+		return textures[texture.id - 1].descriptorSet;
+	VkDescriptorImageInfo imageInfo = { samplers[sampler.id - 1], textures[texture.id - 1].view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = set;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &imageInfo;
+	vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+	samplerSets[key] = set;
+	return set;
+}
+
+CommandList* VulkanRenderDevice::createCommandList()
+{
+	commandLists.emplace_back(new VulkanCommandList(*this));
+	return commandLists.back().get();
+}
+
+#pragma endregion
+
+#pragma region Frames
+
+void VulkanRenderDevice::beginFrame(int frameWidth, int frameHeight, const float clearColor[4])
+{
+	if (frameWidth != width || frameHeight != height)
+		cout << "ERROR::VULKAN::FRAME_SIZE_MISMATCH\n" << frameWidth << "x" << frameHeight << " drawn into " << width << "x" << height << endl;
+	for (int channel = 0; channel < 4; channel++)
+		clearValues[0].color.float32[channel] = clearColor[channel];
+	pendingLists.clear();
+}
+
+void VulkanRenderDevice::submit(CommandList* const* lists, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		VulkanCommandList* list = static_cast<VulkanCommandList*>(lists[i]);
+		pendingLists.push_back(list->commandBuffer);
+		stats += list->stats;
+	}
+}
+
+void VulkanRenderDevice::endFrame()
+{
+	vkResetCommandPool(device, primaryPool, 0);
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(primaryBuffer, &beginInfo);
+
+	VkRenderPassBeginInfo renderPassBegin = {};
+	renderPassBegin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassBegin.renderPass = renderPass;
+	renderPassBegin.framebuffer = framebuffer;
+	renderPassBegin.renderArea.extent = { (uint32_t)width, (uint32_t)height };
+	renderPassBegin.clearValueCount = 2;
+	renderPassBegin.pClearValues = clearValues;
+	vkCmdBeginRenderPass(primaryBuffer, &renderPassBegin, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	if (!pendingLists.empty())
+		vkCmdExecuteCommands(primaryBuffer, (uint32_t)pendingLists.size(), pendingLists.data());
+	vkCmdEndRenderPass(primaryBuffer);
+	vkEndCommandBuffer(primaryBuffer);
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &primaryBuffer;
+	if (vulkanCheck(vkQueueSubmit(queue, 1, &submitInfo, fence), "QUEUE_SUBMIT")) {
+		vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX); // Keep lists and buffers reusable next frame.
+		vkResetFences(device, 1, &fence);
+		frameRendered = true;
+	}
+	pendingLists.clear();
+}
+
+bool VulkanRenderDevice::readPixels(int x, int y, int readWidth, int readHeight, void* rgba)
+{
+	if (!frameRendered || x < 0 || y < 0 || x + readWidth > width || y + readHeight > height)
+		return false;
+
+	VkCommandBuffer commandBuffer = beginOneShot();
+	VkBufferImageCopy region = {};
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	region.imageExtent = { (uint32_t)width, (uint32_t)height, 1 };
+	vkCmdCopyImageToBuffer(commandBuffer, colorImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer.buffer, 1, &region);
+	endOneShot(commandBuffer);
+
+	// Image row 0 is the top; readPixels rows count from the bottom like glReadPixels.
+	const unsigned char* pixels = (const unsigned char*)readbackBuffer.mapped;
+	for (int row = 0; row < readHeight; row++) {
+		int imageRow = height - 1 - (y + row);
+		memcpy((unsigned char*)rgba + (size_t)row * readWidth * 4, pixels + ((size_t)imageRow * width + x) * 4, (size_t)readWidth * 4);
+	}
+	return true;
+}
+
+#pragma endregion
+
+#pragma region Command List Implementation
+
+VulkanCommandList::VulkanCommandList(VulkanRenderDevice& owner) : device(owner)
+{
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolInfo.queueFamilyIndex = device.queueFamily;
+	vulkanCheck(vkCreateCommandPool(device.device, &poolInfo, nullptr, &pool), "CREATE_COMMAND_POOL");
+
+	VkCommandBufferAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = pool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+	allocateInfo.commandBufferCount = 1;
+	vulkanCheck(vkAllocateCommandBuffers(device.device, &allocateInfo, &commandBuffer), "ALLOCATE_COMMAND_BUFFERS");
+}
+
+VulkanCommandList::~VulkanCommandList()
+{
+	vkDestroyCommandPool(device.device, pool, nullptr); // Frees the command buffer too.
+}
+
+void VulkanCommandList::begin()
+{
+	vkResetCommandPool(device.device, pool, 0); // The pool is only ever touched by this list's thread.
+	stats = RenderStats();
+	boundPipeline = 0;
+
+	VkCommandBufferInheritanceInfo inheritance = {};
+	inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance.renderPass = device.renderPass;
+	inheritance.subpass = 0;
+	inheritance.framebuffer = device.framebuffer;
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	beginInfo.pInheritanceInfo = &inheritance;
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+	VkViewport viewport = { 0.0f, 0.0f, (float)device.width, (float)device.height, 0.0f, 1.0f };
+	VkRect2D scissor = { { 0, 0 }, { (uint32_t)device.width, (uint32_t)device.height } };
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+
+void VulkanCommandList::end()
+{
+	vkEndCommandBuffer(commandBuffer);
+}
+
+void VulkanCommandList::bindPipeline(PipelineHandle pipeline)
+{
+	stats.pipelineBinds++;
+	if (pipeline.id == boundPipeline) {
+		stats.stateChangesSkipped++;
+		return;
+	}
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, device.pipelines[pipeline.id - 1]); // All state in one call.
+	boundPipeline = pipeline.id;
+	stats.stateChanges++;
+}
+
+void VulkanCommandList::bindVertexBuffer(uint32_t binding, BufferHandle buffer, size_t offset)
+{
+	VkDeviceSize deviceOffset = offset;
+	vkCmdBindVertexBuffers(commandBuffer, binding, 1, &device.buffers[buffer.id - 1].buffer, &deviceOffset);
+	stats.bufferBinds++;
+}
+
+void VulkanCommandList::bindIndexBuffer(BufferHandle buffer)
+{
+	vkCmdBindIndexBuffer(commandBuffer, device.buffers[buffer.id - 1].buffer, 0, VK_INDEX_TYPE_UINT32);
+	stats.bufferBinds++;
+}
+
+void VulkanCommandList::bindTexture(uint32_t unit, TextureHandle texture, SamplerHandle sampler)
+{
+	if (unit != 0 || !texture.valid()) {
+		cout << "ERROR::VULKAN::TEXTURE_UNIT_UNSUPPORTED\n" << unit << endl;
+		return;
+	}
+	VkDescriptorSet set = device.getTextureSet(texture, sampler);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, device.pipelineLayout, 0, 1, &set, 0, nullptr);
+	stats.textureBinds++;
+	if (sampler.valid())
+		stats.samplerBinds++;
+}
+
+void VulkanCommandList::bindUniformBuffer(uint32_t slot, BufferHandle buffer)
+{
+	if (slot != 0 || !buffer.valid() || device.buffers[buffer.id - 1].uniformSet == VK_NULL_HANDLE) {
+		cout << "ERROR::VULKAN::UNIFORM_SLOT_UNSUPPORTED\n" << slot << endl;
+		return;
+	}
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, device.pipelineLayout, 1, 1, &device.buffers[buffer.id - 1].uniformSet, 0, nullptr);
+	stats.bufferBinds++;
+}
+
+void VulkanCommandList::setConstants(const void* data, size_t size)
+{
+	if (size > MaxConstantsSize) {
+		cout << "ERROR::RENDER_DEVICE::CONSTANTS_TOO_LARGE\n" << size << endl;
+		return;
+	}
+	vkCmdPushConstants(commandBuffer, device.pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, (uint32_t)size, data);
+}
+
+void VulkanCommandList::draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex)
+{
+	vkCmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, 0);
+	stats.drawCalls++;
+}
+
+void VulkanCommandList::drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex)
+{
+	vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, 0, 0);
+	stats.drawCalls++;
+}
+
+#pragma endregion
+
+unique_ptr<RenderDevice> createVulkanRenderDevice(int width, int height)
+{
+	unique_ptr<VulkanRenderDevice> device(new VulkanRenderDevice());
+	if (!device->init(width, height))
+		return nullptr;
+	return unique_ptr<RenderDevice>(device.release());
+}
+
+#endif
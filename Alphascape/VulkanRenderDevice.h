@@ -0,0 +1,23 @@
+#pragma once
+
+#pragma region Library Imports
+
+#include <memory> // Import unique_ptr.
+
+#include "RenderDevice.h" // Import the render device interface.
+
+#pragma endregion
+
+// The Vulkan backend of RenderDevice, compiled in when ALPHASCAPE_VULKAN is defined (link vulkan-1 / libvulkan).
+//
+// It renders headless into an offscreen width x height RGBA8 target with a 32-bit float depth buffer, which is
+// what automated runs on Mesa's lavapipe software driver need (select it with
+// VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json). Each CommandList owns its own VkCommandPool and
+// records one secondary command buffer, so lists can be recorded on separate threads without locking;
+// endFrame() executes them all inside one render pass from a primary command buffer.
+//
+// Limitations: only texture unit 0 and uniform slot 0 are bound (one combined image sampler and one uniform
+// buffer per draw), mipmaps are not generated, and all buffers live in host visible memory.
+
+// Create the device. Returns null (after printing an ERROR) if Vulkan is unavailable or not compiled in.
+std::unique_ptr<RenderDevice> createVulkanRenderDevice(int width, int height);
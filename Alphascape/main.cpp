@@ -1,7 +1,13 @@
 #pragma region Library Imports
 
+#include <cmath> // Import the C maths libraries.
 #include <cstdlib> // Import the C standard libraries.
+#include <cstring> // Import the C string libraries.
+#include <algorithm> // Import max.
 #include <iostream> // Import the IO stream libraries.
+#include <memory> // Import unique_ptr.
+#include <thread> // Import hardware_concurrency.
+#include <vector> // Import the vector container.
 
 // Define and import GLEW, the extension management system.
 #define GLEW_STATIC // Use GLEW statically.
@@ -10,6 +16,34 @@
 // Import GLFW, the modern window management system.
 #include <GLFW/glfw3.h> // Import the GLFW library.
 
+#include "BehaviorTree.h" // Import the behavior tree runtime.
+#include "CVar.h" // Import the runtime configuration variables.
+#include "FrameData.h" // Import the frame data.
+#include "FramePacer.h" // Import the frame pacer.
+#include "FrameScheduler.h" // Import the deferrable work scheduler.
+#include "GLRenderDevice.h" // Import the GL render device.
+#include "Impostor.h" // Import the impostor renderer.
+#include "IoService.h" // Import the asynchronous file reads.
+#include "Jobs.h" // Import the job system.
+#include "Lockstep.h" // Import the deterministic simulation.
+#include "Material.h" // Import the material library.
+#include "MemoryProfiler.h" // Import the memory profiler.
+#include "Network.h" // Import the snapshot networking.
+#include "OpaquePass.h" // Import the opaque pass.
+#include "Picking.h" // Import the pickers.
+#include "Pool.h" // Import the pool allocators.
+#include "Reflection.h" // Import the reflection templates.
+#include "RenderThread.h" // Import the render thread.
+#include "SaveFile.h" // Import the save files.
+#include "SceneGeometry.h" // Import the scene geometry, for CPU picking.
+#include "SoftwareRasterizer.h" // Import the software rasterizer.
+#include "StringId.h" // Import the string IDs.
+#include "TextureArray.h" // Import the texture arrays.
+#include "Threading.h" // Import the thread placement.
+#include "Transparency.h" // Import the transparency renderer.
+#include "Vegetation.h" // Import the vegetation system.
+#include "VulkanRenderDevice.h" // Import the Vulkan render device.
+
 using namespace std; // Use the standard namespace, so I don't have to reference a std::string every time.
 
 #pragma endregion
@@ -18,25 +52,41 @@ using namespace std; // Use the standard namespace, so I don't have to reference
 
 // Window dimensions
 GLfloat lastFrameTime = 0;
-GLuint WIDTH = 512, HEIGHT = 512;
-
-// Shaders
-const GLchar* vertexShaderSource = 
-"#version 330 core\n"
-"layout(location = 0) in vec3 position;\n"
-"void main()\n"
-"{\n"
-"gl_Position = vec4(position, 1.0);\n"
-"}\n\0";
-const GLchar* fragmentShaderSource =
-"#version 330 core\n"
-"out vec4 color;\n"
-"uniform vec4 ourColor;"
-"void main()\n"
-"{\n"
-"color = ourColor;\n"
-"}\n\0";
-
+GLfloat animationTime = 0; // Only advances while animating, so pausing freezes the scene.
+CVar<int> WIDTH("r_width", 512, "Window width in screen coordinates.");
+CVar<int> HEIGHT("r_height", 512, "Window height in screen coordinates.");
+int framebufferWidth = 512, framebufferHeight = 512;
+
+// Settings (see alphascape.cfg; change at runtime with the function keys)
+CVar<CVarColor> clearColor("r_clearColor", CVarColor{ { 0.529f, 0.808f, 0.980f, 1.0f } }, "Background colour (r g b [a]).");
+CVar<bool> vsync("r_vsync", true, "Wait for vertical sync when presenting (F2).");
+CVar<bool> wireframe("r_wireframe", false, "Draw the scene as lines (F1).");
+CVar<bool> depthPrePass("r_depthPrePass", false, "Lay down opaque depth first, so each pixel is shaded once.");
+CVar<bool> sortOpaque("r_sortOpaque", true, "Draw opaque geometry front to back.");
+CVar<bool> showOverdraw("r_showOverdraw", false, "Show how often each pixel is shaded (F3).");
+CVar<bool> gpuPicking("r_gpuPicking", true, "Pick clicked objects from an ID buffer, else by a CPU ray cast.");
+CVar<bool> powerSaving("sys_powerSaving", true, "Sleep while minimised, idle or in the background.");
+CVar<bool> pinThreads("sys_pinThreads", true, "Pin the render and worker threads to their own cores (threads started afterwards).");
+CVar<int> stackSampleInterval("mem_stackSampleInterval", 0, "Capture the call stack of every Nth tagged allocation (0: off).");
+CVar<bool> lockstep("sim_lockstep", false, "Run the deterministic fixed-point simulation, logging its checksum every 10 s.");
+CVar<int> lockstepTickRate("sim_tickRate", 30, "Lockstep simulation ticks per second; changing it restarts the simulation.");
+const char* configPath = "alphascape.cfg"; // Reloaded with F5.
+
+// Transparency
+TransparencyMode transparencyMode = TransparencyMode::WeightedBlended; // Toggled with T.
+
+// Frame pacing
+FramePacer framePacer; // Throttles or suspends rendering when nothing needs to be drawn.
+
+// Lockstep simulation
+LockstepClock lockstepClock(30); // Turns frame times into fixed ticks at sim_tickRate.
+LockstepWorld<Fixed> lockstepWorld(256, 1, 30); // Rebuilt at sim_tickRate when that differs.
+LockstepDesyncDetector desyncDetector; // Fed by peers' checksums once there is a session to receive them from.
+
+// Picking
+bool pickPending = false; // A click to hand to the render thread with the next frame.
+int pickX = 0, pickY = 0; // Framebuffer pixels from the bottom left.
+int pickFramesLeft = 0; // Frames to keep drawing, so the GPU pick gets read back even when idle.
 #pragma endregion
 
 #pragma region Callbacks
@@ -44,23 +94,194 @@ const GLchar* fragmentShaderSource =
 // Key Callback: Is called whenever a key is pressed/released via GLFW
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode)
 {
+	framePacer.requestRedraw(); // Input may change what is on screen.
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
 		glfwSetWindowShouldClose(window, GL_TRUE);
 	}
+	if (key == GLFW_KEY_T && action == GLFW_PRESS) { // Toggle between order-independent and sorted transparency.
+		transparencyMode = transparencyMode == TransparencyMode::WeightedBlended ? TransparencyMode::Sorted : TransparencyMode::WeightedBlended;
+		cout << "Transparency: " << (transparencyMode == TransparencyMode::WeightedBlended ? "weighted blended OIT" : "sorted") << endl;
+	}
+	if (key == GLFW_KEY_P && action == GLFW_PRESS) { // Pause or resume the animation; a paused scene is only redrawn on demand.
+		framePacer.setAnimating(!framePacer.isAnimating());
+	}
+	if (key == GLFW_KEY_F1 && action == GLFW_PRESS) { // Toggle wireframe mode.
+		wireframe.set(!wireframe);
+	}
+	if (key == GLFW_KEY_F2 && action == GLFW_PRESS) { // Toggle vertical sync.
+		vsync.set(!vsync);
+	}
+	if (key == GLFW_KEY_F3 && action == GLFW_PRESS) { // Toggle the overdraw visualisation.
+		showOverdraw.set(!showOverdraw);
+	}
+	if (key == GLFW_KEY_F5 && action == GLFW_PRESS) { // Reload the config file.
+		CVarRegistry::instance().loadFile(configPath);
+	}
+	if (key == GLFW_KEY_F6 && action == GLFW_PRESS) { // Print memory use by subsystem, and write it with call stacks to a file.
+		MemoryProfiler::instance().printReport(cout);
+		MemoryProfiler::instance().exportReport("memory_report.txt");
+	}
+}
+
+// Mouse Button Callback: Is called whenever a mouse button is pressed/released via GLFW
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+	if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS)
+		return;
+	// Cursor positions are in screen coordinates from the top left; the framebuffer may be scaled.
+	double cursorX, cursorY;
+	int windowWidth, windowHeight;
+	glfwGetCursorPos(window, &cursorX, &cursorY);
+	glfwGetWindowSize(window, &windowWidth, &windowHeight);
+	if (windowWidth <= 0 || windowHeight <= 0)
+		return;
+	int x = (int)(cursorX * framebufferWidth / windowWidth);
+	int y = framebufferHeight - 1 - (int)(cursorY * framebufferHeight / windowHeight);
+
+	if (gpuPicking) { // Picked by the render thread; the result is printed once read back.
+		pickPending = true;
+		pickX = x;
+		pickY = y;
+		pickFramesLeft = GpuPicker::ReadbackSlots + 1;
+		framePacer.requestRedraw();
+		return;
+	}
+
+	// The CPU fallback: the scene is drawn straight in clip space, so its view-projection is the identity.
+	vector<PickObject> objects;
+	for (unsigned int first = 0; first < sceneIndexCount; first += 6) {
+		PickObject object;
+		object.positions = sceneVertices;
+		object.indices = sceneIndices;
+		object.indexCount = 6;
+		object.firstIndex = first;
+		object.id = first / 6 + 1;
+		objects.push_back(object);
+	}
+	const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	Vec3 origin, direction;
+	pickRay((x + 0.5f) / framebufferWidth * 2.0f - 1.0f, (y + 0.5f) / framebufferHeight * 2.0f - 1.0f, identity, origin, direction);
+	cout << "Picked object " << rayCastPick(origin, direction, objects) << " (CPU ray cast)" << endl;
 }
 
 // Window Callback: Is called whenever the window changes size.
 void window_size_callback(GLFWwindow* window, int width, int height) {
-	WIDTH = width;
-	HEIGHT = height;
-	glfwGetFramebufferSize(window, &width, &height);
-	glViewport(0, 0, width, height);
+	WIDTH.set(width);
+	HEIGHT.set(height);
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight); // The render thread applies the viewport.
+	framePacer.requestRedraw();
+}
+
+// Iconify Callback: Is called whenever the window is minimised or restored.
+void window_iconify_callback(GLFWwindow* window, int iconified)
+{
+	framePacer.setIconified(iconified == GL_TRUE);
+}
+
+// Focus Callback: Is called whenever the window gains or loses input focus.
+void window_focus_callback(GLFWwindow* window, int focused)
+{
+	framePacer.setFocused(focused == GL_TRUE);
+}
+
+// Refresh Callback: Is called whenever the window contents need to be redrawn, e.g. after being uncovered.
+void window_refresh_callback(GLFWwindow* window)
+{
+	framePacer.requestRedraw();
 }
 
 #pragma endregion
 
-int main()
+int main(int argc, char* argv[])
 {
+	#pragma region Settings
+
+	// Load the config file, then apply command line overrides (--config <file>, --set <name>=<value>).
+	for (int i = 1; i + 1 < argc; i++) {
+		if (strcmp(argv[i], "--config") == 0)
+			configPath = argv[i + 1];
+	}
+	CVarRegistry::instance().loadFile(configPath);
+	for (int i = 1; i + 1 < argc; i++) {
+		if (strcmp(argv[i], "--set") == 0)
+			CVarRegistry::instance().setFromAssignment(argv[i + 1]);
+	}
+	CVarRegistry::instance().applyPending(); // Commit before anything reads the settings.
+	setThreadPinning(pinThreads);
+	pinThreads.onChange([](const bool& enabled) { setThreadPinning(enabled); });
+	placeCurrentThread(ThreadRole::Main);
+
+	#pragma endregion
+
+	#pragma region Software Rendering
+
+	// GL-less modes: run on the CPU without ever touching GLFW or OpenGL, then exit.
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--software") == 0) { // Render the scene and write the last frame to software.ppm.
+			runSoftwareScene(WIDTH, HEIGHT, 300, "software.ppm");
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-software") == 0) { // Stress the rasterizer with overlapping triangles.
+			runSoftwareRasterizerBenchmark(1280, 720, 10000, 20);
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-ai") == 0) { // Guards running a behavior tree, batched across the worker threads.
+			runBehaviorTreeBenchmark(1000000, 120);
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-io") == 0) { // Chunked file reads: blocking, thread pool and io_uring.
+			runIoBenchmark(256, 256);
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-jobs") == 0) { // Asset loads that wait on reads and fences, blocking and resumable.
+			runJobSystemBenchmark(2000, 4);
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-lockstep") == 0) { // Fixed-point against float simulation, and desync detection.
+			runLockstepBenchmark(10000, 600, 30);
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-memory") == 0) { // Tagged heap allocation against malloc, then the memory report.
+			runMemoryProfilerBenchmark(1000000, 4);
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-net") == 0) { // Replicate 1k entities over loopback UDP, with and without loss.
+			runNetworkBenchmark(1000, 600, 60);
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-pools") == 0) { // Particles and messages from pools against the heap, on 4 threads.
+			runPoolBenchmark(20000, 60, 4);
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-reflection") == 0) { // Generated against hand-written serializers.
+			runReflectionBenchmark(1000000);
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-save") == 0) { // Save and load a 100k entity world, binary and text.
+			runSaveBenchmark(100000);
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-scheduler") == 0) { // Deferrable work with a demand spike, budgeted and not.
+			runFrameSchedulerBenchmark(600, 2.0);
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-strings") == 0) { // Asset lookups by string and by hashed ID.
+			runStringIdBenchmark(10000, 1000000);
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-threads") == 0) { // Frame time spread of a worker per core, unpinned and pinned.
+			runThreadingBenchmark(600);
+			return 0;
+		}
+		if (strcmp(argv[i], "--vulkan-test") == 0) { // Headless Vulkan render device test (runs on lavapipe).
+			unique_ptr<RenderDevice> device = createVulkanRenderDevice(512, 512);
+			bool passed = device && runRenderDeviceTest(*device, 512, 512, max(1u, thread::hardware_concurrency()), 1000, 10);
+			return passed ? 0 : EXIT_FAILURE;
+		}
+	}
+
+	#pragma endregion
+
 	#pragma region Initialise GLFW and GLEW
 
 	// Initialise GLFW, the windowing system.
@@ -78,8 +299,25 @@ int main()
 
 	// Set the required callback functions
 	glfwSetKeyCallback(window, key_callback); // Set the key_callback.
+	glfwSetMouseButtonCallback(window, mouse_button_callback); // Set the mouse_button_callback.
 	glfwSetWindowSizeCallback(window, window_size_callback); // Set the window_size_callback.
-	//glfwSwapInterval(0);
+	glfwSetWindowIconifyCallback(window, window_iconify_callback); // Set the window_iconify_callback.
+	glfwSetWindowFocusCallback(window, window_focus_callback); // Set the window_focus_callback.
+	glfwSetWindowRefreshCallback(window, window_refresh_callback); // Set the window_refresh_callback.
+
+	// Apply setting changes made at runtime.
+	WIDTH.onChange([window](const int&) { glfwSetWindowSize(window, WIDTH, HEIGHT); }); // Ignored by GLFW if the size already matches.
+	HEIGHT.onChange([window](const int&) { glfwSetWindowSize(window, WIDTH, HEIGHT); });
+	powerSaving.onChange([](const bool& enabled) { framePacer.powerSaving = enabled; framePacer.requestRedraw(); });
+	vsync.onChange([](const bool&) { framePacer.requestRedraw(); });
+	wireframe.onChange([](const bool&) { framePacer.requestRedraw(); });
+	depthPrePass.onChange([](const bool&) { framePacer.requestRedraw(); });
+	sortOpaque.onChange([](const bool&) { framePacer.requestRedraw(); });
+	showOverdraw.onChange([](const bool&) { framePacer.requestRedraw(); });
+	clearColor.onChange([](const CVarColor&) { framePacer.requestRedraw(); });
+	stackSampleInterval.onChange([](const int& interval) { MemoryProfiler::instance().setStackSampleInterval((uint32_t)max(0, interval)); });
+	framePacer.powerSaving = powerSaving;
+	MemoryProfiler::instance().setStackSampleInterval((uint32_t)max(0, stackSampleInterval.get()));
 
 	// Tell GLEW to use a modern approach to retrieving function pointers and extensions.
 	glewExperimental = GL_TRUE;
@@ -87,139 +325,156 @@ int main()
 	// Initialize GLEW, to set up the OpenGL function pointers.
 	glewInit();
 
-	// Define the viewport dimensions
-	glViewport(0, 0, WIDTH, HEIGHT);
+	// Get the framebuffer dimensions; the renderer sets the viewport from them.
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
 
 	#pragma endregion
 
-	#pragma region Compile Shaders
-
-	// Build and compile the shader program.
-	// The vertex shader:
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER); // Create the shader.
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL); // Pass the shader source.
-	glCompileShader(vertexShader); // Compile the shader.
-	// Check for errors at compile time from OpenGL:
-	GLint success; // Declare the success variable.
-	GLchar infoLog[512]; // Declare the information log.
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success); // Get the success of the shader compilation.
-	if (!success) // If the shader compilation was not a success:
-	{
-		glGetShaderInfoLog(vertexShader, 512, NULL, infoLog); // Get the information log.
-		cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << endl; // Print the information log.
-	}
-
-	// The fragment shader:
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER); // Create the shader.
-	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL); // Pass the shader source.
-	glCompileShader(fragmentShader); // Compile the shader.
-	// Check for errors at compile time from OpenGL:
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success); // Get the success of the shader compilation.
-	if (!success) // If the shader compilation was not a success:
-	{
-		glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog); // Get the information log.
-		cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << endl; // Print the information log.
-	}
-
-	// Link the shaders.
-	GLuint shaderProgram = glCreateProgram(); // Create the shader program.
-	glAttachShader(shaderProgram, vertexShader); // Attach the vertex shader.
-	glAttachShader(shaderProgram, fragmentShader); // Attach the fragment shader.
-	glLinkProgram(shaderProgram); // Link the shader program to the OpenGL context.
-
-	// Check for errors at compile time from OpenGL:
-	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success); // Get the success of the shader linking.
-	if (!success) { // If the shader linking was not a success:
-		glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog); // Get the information log.
-		cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << endl; // Print the information log.
+	#pragma region Benchmarks
+
+	// Command line benchmark modes: run, print the results and exit.
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--bench-oit") == 0) {
+			runTransparencyBenchmark(window, 100000, 200); // 100k overlapping transparent quads.
+			glfwTerminate();
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-textures") == 0) {
+			runTextureBindingBenchmark(window, 64, 20000, 200); // 20k quads over 64 textures.
+			glfwTerminate();
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-materials") == 0) {
+			runMaterialBenchmark(window, 64, 20000, 200); // 20k draws over 64 materials.
+			glfwTerminate();
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-overdraw") == 0) {
+			runOverdrawBenchmark(window, 200, 100); // 200 overlapping quads with an expensive fragment shader.
+			glfwTerminate();
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-impostors") == 0) {
+			runImpostorBenchmark(window, 10000, 200); // 10000 trees, as geometry and as impostors beyond 40 units.
+			glfwTerminate();
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-vegetation") == 0) {
+			runVegetationBenchmark(window, 2000000, 200); // Two million grass blades.
+			glfwTerminate();
+			return 0;
+		}
+		if (strcmp(argv[i], "--bench-picking") == 0) {
+			runPickingBenchmark(window, 5000, 300); // 5000 boxes, 300 picks.
+			glfwTerminate();
+			return 0;
+		}
+		if (strcmp(argv[i], "--render-device-test") == 0) { // The same test as --vulkan-test, through the GL device.
+			bool passed;
+			{
+				GLRenderDevice device;
+				passed = runRenderDeviceTest(device, framebufferWidth, framebufferHeight, max(1u, thread::hardware_concurrency()), 1000, 10);
+			} // Delete the device's GL objects while the context is still alive.
+			glfwTerminate();
+			return passed ? 0 : EXIT_FAILURE;
+		}
+		if (strcmp(argv[i], "--no-power-saving") == 0) { // Always poll and redraw, like the original loop.
+			powerSaving.set(false);
+		}
 	}
 
-	// Delete the shaders to avoid a memory leak.
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+	CVarRegistry::instance().applyPending();
 
 	#pragma endregion
 
-	#pragma region VBO, VAO, Attribute Pointers
-
-	// Set up vertex data, buffers, and attribute pointers.
-	GLfloat vertices[] = {
-		0.2f,  0.2f, 0.0f,  // Top Right
-		0.2f, -0.8f, 0.0f,  // Bottom Right
-		-0.8f, -0.8f, 0.0f,  // Bottom Left
-		-0.8f,  0.2f, 0.0f,   // Top Left
-
-		0.8f,  0.8f, 0.0f,  // Top Right
-		0.8f, -0.2f, 0.0f,  // Bottom Right
-		-0.2f, -0.2f, 0.0f,  // Bottom Left
-		-0.2f,  0.8f, 0.0f   // Top Left
-	};
-	GLuint indices[] = {  // Set up indice data.
-		0, 1, 3,   // First triangle
-		1, 2, 3,   // Second triangle
-		4, 5, 7,
-		5, 6, 7
-	};
-	GLuint VBO, VAO, EBO; // Declare the vertex buffer object and vertex array object.
-	glGenVertexArrays(1, &VAO); // Generate 1 vertex array object.
-	glGenBuffers(1, &VBO); // Generate 1 vertex buffer object.
-	glGenBuffers(1, &EBO); // Generate 1 element buffer object.
-
-	// Bind the VAO, then bind and set the vertex buffer and attribute pointer.
-	glBindVertexArray(VAO); // Bind the vertex array object.
-
-	glBindBuffer(GL_ARRAY_BUFFER, VBO); // Bind the vertex array buffer and vertex buffer object.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW); // Load the vertices as static vertices.
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO); // Bind the EBO.
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW); // Load the indices as static indices.
-
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0); // Tell OpenGL how to interpret the vertices.
-	glEnableVertexAttribArray(0); // Enable the vertex attribute array, size 0.
-
-	// Call the attribute pointer with the previously registered VBO and EBO, so the buffer object can be unbound later.
-	glBindBuffer(GL_ARRAY_BUFFER, 0); 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-
-	glBindVertexArray(0); // Unbind the vertex array object (response to bug #2, project Deltashot).
+	#pragma region Render Thread
 
-	#pragma endregion
+	// Hand the GL context to the render thread; from here on the main thread only handles events and simulation.
+	RenderThread renderThread;
+	if (!renderThread.start(window, framebufferWidth, framebufferHeight)) {
+		glfwTerminate();
+		return EXIT_FAILURE;
+	}
 
-	// Wireframe Mode
-	// glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	#pragma endregion
 
 	#pragma region Main Loop
+	unsigned long long frameNumber = 0;
+	double lockstepTime = glfwGetTime(); // When the lockstep clock was last advanced.
 	while (!glfwWindowShouldClose(window)) // While the game window should remain open
 	{
-		glfwPollEvents(); // Check if any events have been called.
-
-		// Render everything:
+		// Check if any events have been called, sleeping while minimised, idle or in the background.
+		bool drawFrame = framePacer.waitForFrame();
+
+		// Step the lockstep simulation in whole ticks at its fixed rate, whether or not this iteration draws, so it keeps
+		// time while paused, idle or minimised; the pacer wakes at least once a tick while it runs.
+		double lockstepNow = glfwGetTime();
+		double lockstepElapsed = lockstepNow - lockstepTime;
+		lockstepTime = lockstepNow;
+		if (lockstep) {
+			lockstepClock.setTickRate(lockstepTickRate);
+			int tickRate = lockstepClock.getTickRate(); // At least 1, whatever the cvar holds.
+			if (lockstepWorld.getTickRate() != tickRate) { // The tick length is part of the simulation: start a new one.
+				lockstepWorld = LockstepWorld<Fixed>(256, 1, tickRate);
+				desyncDetector = LockstepDesyncDetector();
+			}
+			for (int ticks = lockstepClock.advance(lockstepElapsed); ticks > 0; ticks--) {
+				lockstepWorld.step(vector<LockstepInput>());
+				uint64_t checksum = lockstepWorld.computeChecksum();
+				desyncDetector.recordLocal(lockstepWorld.getTick(), checksum);
+				if (lockstepWorld.getTick() % (10 * tickRate) == 0)
+					cout << "Lockstep tick " << lockstepWorld.getTick() << " checksum " << hex << checksum << dec << endl;
+			}
+		}
+		framePacer.maxWait = lockstep ? 1.0 / lockstepClock.getTickRate() : 0.0;
+
+		if (!drawFrame)
+			continue; // Nothing to draw this time round.
+
+		// Commit setting changes made since the last frame, at the frame boundary.
+		CVarRegistry::instance().applyPending();
+
+		// Simulate the frame:
 		GLfloat timeValue = (float)glfwGetTime();
 		GLfloat timeSinceLastFrame = timeValue - lastFrameTime;
 		lastFrameTime = timeValue;
-		
-		GLfloat greenValue = (float)(sin(timeValue) / 2.0f) + 0.5f;
-		GLint vertexColorLocation = glGetUniformLocation(shaderProgram, "ourColor");
-		glUseProgram(shaderProgram);
-		glUniform4f(vertexColorLocation, greenValue, greenValue, greenValue, 1.0f);
-
-		// Set the clear colour, and clear the buffers.
-		glClearColor(0.529f, 0.808f, 0.980f, 1.0f); // Set the clear colour.
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT); // Clear the buffers.
-
-		// Draw a triangle.
-		glUseProgram(shaderProgram); // Use the shader program.
-		glBindVertexArray(VAO); // Bind the vertex array object.
-		glDrawElements(GL_TRIANGLES, sizeof(indices), GL_UNSIGNED_INT, 0); // Draw the vertices.
-		glBindVertexArray(0); // Bind to the (only) vertex array.
-
-		glfwSwapBuffers(window); // Swap the buffers.
+		if (framePacer.isAnimating())
+			animationTime += timeSinceLastFrame;
+
+		GLfloat greenValue = (float)(sin(animationTime) / 2.0f) + 0.5f;
+
+		// Hand it to the render thread, which draws it while the next frame is simulated.
+		FrameData frame;
+		frame.frameNumber = frameNumber++;
+		frame.time = timeValue;
+		frame.animationTime = animationTime;
+		frame.objectColor[0] = frame.objectColor[1] = frame.objectColor[2] = greenValue;
+		frame.objectColor[3] = 1.0f;
+		frame.framebufferWidth = framebufferWidth;
+		frame.framebufferHeight = framebufferHeight;
+		frame.transparencyMode = transparencyMode;
+		for (int channel = 0; channel < 4; channel++)
+			frame.clearColor[channel] = clearColor.get().rgba[channel];
+		frame.wireframe = wireframe;
+		frame.opaque.depthPrePass = depthPrePass;
+		frame.opaque.sort = sortOpaque ? OpaqueSortMode::FrontToBack : OpaqueSortMode::Submission;
+		frame.opaque.visualizeOverdraw = showOverdraw;
+		frame.swapInterval = vsync ? 1 : 0;
+		frame.pick = pickPending;
+		frame.pickX = pickX;
+		frame.pickY = pickY;
+		pickPending = false;
+		renderThread.submit(frame);
+		if (pickFramesLeft > 0) { // Keep drawing until the GPU pick has been read back.
+			pickFramesLeft--;
+			framePacer.requestRedraw();
+		}
 	}
 	#pragma endregion
 
 	#pragma region Clean Up
-	// Properly de-allocate all resources.
-	glDeleteVertexArrays(1, &VAO); // Delete the vertex array object.
-	glDeleteBuffers(1, &VBO); // Delete the vertex buffer object.
+	// Finish the queued frames; the render thread properly de-allocates all resources.
+	renderThread.stop();
 
 	// Terminate the game window. Return success!
 	glfwTerminate(); // Terminate the GLFW context.
@@ -0,0 +1,6 @@
+#version 450
+// Vulkan version of the opaque pass's depth-only fragment shader (OpaquePass.cpp). Compile with: glslangValidator -V depth_only.frag -o depth_only.frag.spv
+
+void main()
+{
+}
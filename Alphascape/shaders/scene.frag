@@ -0,0 +1,14 @@
+#version 450
+// Vulkan version of the scene fragment shader (Renderer.cpp). Compile with: glslangValidator -V scene.frag -o scene.frag.spv
+
+layout(push_constant) uniform Constants
+{
+	vec4 ourColor;
+};
+
+layout(location = 0) out vec4 color;
+
+void main()
+{
+	color = ourColor;
+}
@@ -0,0 +1,9 @@
+#version 450
+// Vulkan version of the scene vertex shader (Renderer.cpp). Compile with: glslangValidator -V scene.vert -o scene.vert.spv
+
+layout(location = 0) in vec3 position;
+
+void main()
+{
+	gl_Position = vec4(position.x, -position.y, position.z * 0.5 + 0.5, 1.0); // Vulkan clip space: y down, z in [0, 1].
+}